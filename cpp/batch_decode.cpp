@@ -0,0 +1,552 @@
+/**
+ * Decode many recorded sessions in one process
+ *
+ * Usage:
+ *   batch_decode --tokens FILE --lexicon FILE --lm FILE --model FILE --out DIR
+ *                [--homophones FILE --french-lm FILE] [--list FILE]
+ *                [--jobs N] [--fps F] [--vtt] [--sentence-cues] FEATURES...
+ *
+ * Each input is a feature file in the format the demo's extraction helper
+ * streams: one "DATA,<frame>,<33 values>" or "DROP,<frame>" line per frame.
+ * The CTC decoder, sequence model and sentence corrector are loaded once and
+ * shared by --jobs workers (default: hardware concurrency), each running
+ * WindowProcessor::decode_sequence on its own model clone.
+ *
+ * Files larger than an even share of the batch (total size / cores) are
+ * held back. The others are dealt largest first onto per-worker queues; a
+ * worker that runs out steals from the back of the fullest queue. The held
+ * files then run together, splitting the cores for window inference, so a
+ * long recording never decodes on one core while the rest sit idle.
+ *
+ * For every input <name>, writes <name>.txt (sentence and phonemes) and
+ * <name>.srt (or .vtt, timed on the rows of the file with DROP rows counted)
+ * to the output directory, plus batch_summary.tsv.
+ * Prints throughput in video hours per wall-clock hour (frames / --fps).
+ */
+
+#include "decoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using cued_speech::CTCDecoder;
+using cued_speech::DecoderConfig;
+using cued_speech::RecognitionResult;
+using cued_speech::SentenceCorrector;
+using cued_speech::TFLiteSequenceModel;
+using cued_speech::WindowProcessor;
+using cued_speech::kFrameFeatureSize;
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " --tokens FILE --lexicon FILE --lm FILE --model FILE --out DIR\n"
+              << "       [--homophones FILE --french-lm FILE] [--list FILE]\n"
+              << "       [--jobs N] [--fps F] [--blank-skip LOGPROB] [--token-mass P]\n"
+              << "       [--native-search] [--segment FRAMES] [--vtt] [--sentence-cues] FEATURES..."
+              << std::endl;
+}
+
+/**
+ * One input file and what came out of it
+ */
+struct Job {
+    fs::path input;
+    std::string output_name;      // Unique stem inside the output directory
+    uintmax_t size_bytes = 0;
+
+    bool ok = false;
+    std::string error;
+    int frames = 0;
+    int dropped = 0;
+    double decode_seconds = 0.0;
+    RecognitionResult result;
+};
+
+/**
+ * Read a feature file into a flat [frames x kFrameFeatureSize] block
+ *
+ * DROP lines become zero rows with a 0 in valid_mask.
+ */
+bool read_features(const fs::path& path,
+                   std::vector<float>& frames,
+                   std::vector<uint8_t>& valid_mask,
+                   std::string& error) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        error = "unable to open file";
+        return false;
+    }
+
+    frames.clear();
+    valid_mask.clear();
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line.rfind("DROP,", 0) == 0) {
+            frames.resize(frames.size() + kFrameFeatureSize, 0.0f);
+            valid_mask.push_back(0);
+            continue;
+        }
+        if (line.rfind("DATA,", 0) != 0) {
+            continue;
+        }
+
+        // Skip the frame number; rows are taken in file order
+        const size_t values_begin = line.find(',', 5);
+        if (values_begin == std::string::npos) {
+            error = "missing feature values on line " + std::to_string(line_number);
+            return false;
+        }
+
+        const size_t row = frames.size();
+        frames.resize(row + kFrameFeatureSize, 0.0f);
+        const char* cursor = line.c_str() + values_begin + 1;
+        int count = 0;
+        while (*cursor != '\0') {
+            char* end = nullptr;
+            const float value = std::strtof(cursor, &end);
+            if (count < kFrameFeatureSize) {
+                frames[row + count] = end == cursor ? 0.0f : value;
+            }
+            ++count;
+            cursor = end == cursor ? cursor : end;
+            while (*cursor != '\0' && *cursor != ',') {
+                ++cursor;
+            }
+            if (*cursor == ',') {
+                ++cursor;
+            }
+        }
+        if (count != kFrameFeatureSize) {
+            error = "expected " + std::to_string(kFrameFeatureSize) + " feature values, received " +
+                    std::to_string(count) + " on line " + std::to_string(line_number);
+            return false;
+        }
+        valid_mask.push_back(1);
+    }
+    return true;
+}
+
+/**
+ * Per-worker job queues with stealing
+ *
+ * The job set is fixed up front: owners pop from the front of their queue,
+ * thieves take from the back of the fullest other queue, and a worker
+ * finishes once every queue is empty.
+ */
+class WorkStealingQueues {
+public:
+    explicit WorkStealingQueues(size_t workers)
+        : queues_(workers) {}
+
+    void push(size_t worker, size_t job) {
+        std::lock_guard<std::mutex> lock(queues_[worker].mutex);
+        queues_[worker].jobs.push_back(job);
+    }
+
+    bool next(size_t worker, size_t& job) {
+        {
+            Queue& own = queues_[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = own.jobs.front();
+                own.jobs.pop_front();
+                return true;
+            }
+        }
+
+        // Sizes are sampled one queue at a time, so the victim may drain
+        // before we lock it again; retry until every queue is empty
+        while (true) {
+            size_t victim = queues_.size();
+            size_t victim_size = 0;
+            for (size_t i = 0; i < queues_.size(); ++i) {
+                if (i == worker) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(queues_[i].mutex);
+                if (queues_[i].jobs.size() > victim_size) {
+                    victim = i;
+                    victim_size = queues_[i].jobs.size();
+                }
+            }
+            if (victim == queues_.size()) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(queues_[victim].mutex);
+            if (!queues_[victim].jobs.empty()) {
+                job = queues_[victim].jobs.back();
+                queues_[victim].jobs.pop_back();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    size_t steals() const {
+        return steals_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> jobs;
+    };
+
+    std::vector<Queue> queues_;
+    std::atomic<size_t> steals_{0};
+};
+
+std::string join_phonemes(const std::vector<std::string>& phonemes) {
+    std::string out;
+    for (size_t i = 0; i < phonemes.size(); ++i) {
+        if (i > 0) {
+            out += ' ';
+        }
+        out += phonemes[i];
+    }
+    return out;
+}
+
+// Keep tabs and newlines out of the summary columns
+std::string tsv_field(std::string text) {
+    std::replace_if(text.begin(), text.end(), [](char ch) { return ch == '\t' || ch == '\n' || ch == '\r'; }, ' ');
+    return text;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    DecoderConfig config;
+    config.nbest = 1;
+    config.beam_size = 40;
+    config.beam_threshold = 50.0f;
+    config.lm_weight = 3.23f;
+    config.word_score = 0.0f;
+    config.sil_score = 0.0f;
+
+    std::string model_path;
+    std::string homophones_path;
+    std::string french_lm_path;
+    std::string list_path;
+    fs::path out_dir;
+    int num_workers = 0;
+    double fps = 30.0;
+    cued_speech::SubtitleOptions subtitle_options;
+    subtitle_options.word_timings = true;
+    std::vector<fs::path> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (arg == "--tokens" && has_value) {
+            config.tokens_path = argv[++i];
+        } else if (arg == "--lexicon" && has_value) {
+            config.lexicon_path = argv[++i];
+        } else if (arg == "--lm" && has_value) {
+            config.lm_path = argv[++i];
+        } else if (arg == "--model" && has_value) {
+            model_path = argv[++i];
+        } else if (arg == "--homophones" && has_value) {
+            homophones_path = argv[++i];
+        } else if (arg == "--french-lm" && has_value) {
+            french_lm_path = argv[++i];
+        } else if (arg == "--list" && has_value) {
+            list_path = argv[++i];
+        } else if (arg == "--out" && has_value) {
+            out_dir = argv[++i];
+        } else if (arg == "--jobs" && has_value) {
+            num_workers = std::atoi(argv[++i]);
+        } else if (arg == "--fps" && has_value) {
+            fps = std::atof(argv[++i]);
+        } else if (arg == "--blank-skip" && has_value) {
+            config.blank_skip_threshold = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--token-mass" && has_value) {
+            config.token_mass = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--segment" && has_value) {
+            config.segment_frames = std::atoi(argv[++i]);
+        } else if (arg == "--native-search") {
+            config.engine = cued_speech::DecoderEngine::Native;
+        } else if (arg == "--vtt") {
+            subtitle_options.format = cued_speech::SubtitleFormat::WebVTT;
+        } else if (arg == "--sentence-cues") {
+            subtitle_options.word_timings = false;
+        } else if (!arg.empty() && arg[0] != '-') {
+            inputs.emplace_back(arg);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!list_path.empty()) {
+        std::ifstream list(list_path);
+        if (!list.is_open()) {
+            std::cerr << "Failed to open input list: " << list_path << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                inputs.emplace_back(line);
+            }
+        }
+    }
+
+    if (config.tokens_path.empty() || config.lexicon_path.empty() || config.lm_path.empty() ||
+        model_path.empty() || out_dir.empty() || inputs.empty() || fps <= 0.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        fs::create_directories(out_dir);
+
+        std::vector<Job> jobs(inputs.size());
+        std::set<std::string> used_names;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            Job& job = jobs[i];
+            job.input = inputs[i];
+            std::error_code ec;
+            job.size_bytes = fs::file_size(job.input, ec);
+            if (ec) {
+                job.size_bytes = 0;
+            }
+
+            std::string name = job.input.stem().string();
+            if (!used_names.insert(name).second) {
+                name += "_" + std::to_string(i);
+                used_names.insert(name);
+            }
+            job.output_name = name;
+        }
+        // Largest files first, so the long tail is made of small files
+        std::vector<size_t> order(jobs.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return jobs[a].size_bytes > jobs[b].size_bytes;
+        });
+
+        CTCDecoder decoder(config);
+        if (!decoder.initialize()) {
+            std::cerr << "Failed to initialize CTC decoder." << std::endl;
+            return 1;
+        }
+
+        TFLiteSequenceModel model;
+        if (!model.load(model_path)) {
+            std::cerr << "Failed to load sequence model: " << model_path << std::endl;
+            return 1;
+        }
+
+        std::unique_ptr<SentenceCorrector> corrector;
+        if (!homophones_path.empty() && !french_lm_path.empty()) {
+            corrector = std::make_unique<SentenceCorrector>(homophones_path, french_lm_path);
+            if (!corrector->initialize()) {
+                std::cerr << "Warning: failed to initialize sentence corrector. Output will have phonemes only."
+                          << std::endl;
+                corrector.reset();
+            }
+        }
+
+        if (num_workers <= 0) {
+            num_workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+        const int num_cores = num_workers;
+        num_workers = std::min(num_workers, static_cast<int>(jobs.size()));
+
+        // A file above an even share of the work would keep one core busy
+        // after the others finish: hold it back to a last round, where the
+        // held files split the cores. There are fewer of them than cores.
+        uintmax_t total_bytes = 0;
+        for (const auto& job : jobs) {
+            total_bytes += job.size_bytes;
+        }
+        const uintmax_t fair_share = total_bytes / static_cast<uintmax_t>(num_cores);
+        size_t num_held = 0;
+        while (num_held < order.size() && num_cores > 1 && jobs[order[num_held]].size_bytes > fair_share) {
+            ++num_held;
+        }
+        const std::vector<size_t> held(order.begin(), order.begin() + num_held);
+        const std::vector<size_t> shared(order.begin() + num_held, order.end());
+
+        // Worker 0 runs on the loaded model, the others on clones
+        std::vector<std::unique_ptr<TFLiteSequenceModel>> clones;
+        for (int w = 1; w < num_workers; ++w) {
+            clones.push_back(model.clone());
+            if (!clones.back() || !clones.back()->is_loaded()) {
+                std::cerr << "Failed to clone sequence model for worker " << w << std::endl;
+                return 1;
+            }
+        }
+
+        std::atomic<int> jobs_left{0};
+        size_t steals = 0;
+        std::mutex print_mutex;
+
+        auto run_worker = [&](WorkStealingQueues& queues, size_t worker) {
+            TFLiteSequenceModel* worker_model = worker == 0 ? &model : clones[worker - 1].get();
+            WindowProcessor processor(&decoder, worker_model);
+            std::vector<float> frames;
+            std::vector<uint8_t> valid_mask;
+
+            size_t index = 0;
+            while (queues.next(worker, index)) {
+                Job& job = jobs[index];
+                const auto start = std::chrono::steady_clock::now();
+
+                try {
+                    if (read_features(job.input, frames, valid_mask, job.error)) {
+                        job.frames = static_cast<int>(valid_mask.size());
+                        job.dropped = static_cast<int>(std::count(valid_mask.begin(), valid_mask.end(), 0));
+
+                        // Once a round runs out of files, workers exit and
+                        // leave their cores to the windows of the files
+                        // started after that
+                        const int remaining = std::max(1, jobs_left.load());
+                        const int inference_threads = std::max(1, num_cores / remaining);
+                        job.result = processor.decode_sequence(frames.data(), job.frames, valid_mask.data(),
+                                                               inference_threads);
+                        if (corrector && !job.result.phonemes.empty()) {
+                            job.result.french_sentence = corrector->correct(job.result.phonemes);
+                        }
+
+                        std::ofstream text(out_dir / (job.output_name + ".txt"));
+                        text << job.result.french_sentence << '\n'
+                             << join_phonemes(job.result.phonemes) << '\n';
+
+                        // The file-level result covers the whole recording.
+                        // Its word timings count valid frames: time the cues
+                        // on the rows of the file, DROP rows included.
+                        std::deque<RecognitionResult> results(1, job.result);
+                        results.front().frame_number = 0;
+                        cued_speech::SubtitleOptions options = subtitle_options;
+                        options.stream_frames = cued_speech::stream_frames_of(valid_mask.data(), job.frames);
+                        const char* extension =
+                            options.format == cued_speech::SubtitleFormat::WebVTT ? ".vtt" : ".srt";
+                        job.ok = static_cast<bool>(text) &&
+                                 write_subtitles((out_dir / (job.output_name + extension)).string(),
+                                                 results, fps, options);
+                        if (!job.ok) {
+                            job.error = "failed to write output";
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    job.error = e.what();
+                }
+
+                job.decode_seconds =
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                jobs_left.fetch_sub(1);
+
+                std::lock_guard<std::mutex> lock(print_mutex);
+                if (job.ok) {
+                    std::cout << "[" << worker << "] " << job.input.string() << ": " << job.frames
+                              << " frames in " << std::fixed << std::setprecision(2) << job.decode_seconds
+                              << " s" << std::endl;
+                } else {
+                    std::cerr << "[" << worker << "] " << job.input.string() << ": " << job.error << std::endl;
+                }
+            }
+        };
+
+        // One worker per file up to num_workers, files dealt in order
+        auto run_round = [&](const std::vector<size_t>& round) {
+            const size_t round_workers = std::min(round.size(), static_cast<size_t>(num_workers));
+            if (round_workers == 0) {
+                return;
+            }
+            WorkStealingQueues queues(round_workers);
+            for (size_t i = 0; i < round.size(); ++i) {
+                queues.push(i % round_workers, round[i]);
+            }
+            jobs_left = static_cast<int>(round.size());
+
+            std::vector<std::thread> threads;
+            for (size_t w = 1; w < round_workers; ++w) {
+                threads.emplace_back(run_worker, std::ref(queues), w);
+            }
+            run_worker(queues, 0);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            steals += queues.steals();
+        };
+
+        if (!held.empty()) {
+            std::cout << "Holding back " << held.size() << " large files to share " << num_cores << " cores"
+                      << std::endl;
+        }
+        const auto wall_start = std::chrono::steady_clock::now();
+        run_round(shared);
+        run_round(held);
+        const double wall_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+        std::ofstream summary(out_dir / "batch_summary.tsv");
+        summary << "file\tstatus\tframes\tdropped\tvideo_seconds\tdecode_seconds\tphonemes\tsentence\n";
+        long long total_frames = 0;
+        int failed = 0;
+        for (const auto& job : jobs) {
+            summary << tsv_field(job.input.string()) << '\t'
+                    << (job.ok ? "ok" : tsv_field(job.error)) << '\t'
+                    << job.frames << '\t' << job.dropped << '\t'
+                    << job.frames / fps << '\t' << job.decode_seconds << '\t'
+                    << tsv_field(join_phonemes(job.result.phonemes)) << '\t'
+                    << tsv_field(job.result.french_sentence) << '\n';
+            if (job.ok) {
+                total_frames += job.frames;
+            } else {
+                ++failed;
+            }
+        }
+
+        const double video_hours = total_frames / fps / 3600.0;
+        const double wall_hours = wall_seconds / 3600.0;
+        std::cout << "\nDecoded " << (jobs.size() - failed) << " of " << jobs.size() << " files ("
+                  << failed << " failed) with " << num_workers << " workers, "
+                  << steals << " steals" << std::endl;
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Video: " << video_hours << " h (" << total_frames << " frames at " << fps << " fps)\n"
+                  << "Wall clock: " << wall_seconds << " s\n"
+                  << "Throughput: " << (wall_hours > 0.0 ? video_hours / wall_hours : 0.0)
+                  << " video hours per wall-clock hour" << std::endl;
+        return failed == 0 ? 0 : 2;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,538 @@
+/**
+ * Cued Speech Decoder - Native lexicon beam search
+ */
+
+#include "beam_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include <flashlight/lib/text/decoder/Trie.h>
+#include <flashlight/lib/text/dictionary/Dictionary.h>
+
+namespace cued_speech {
+
+namespace {
+
+constexpr double kNegativeInfinity = -std::numeric_limits<double>::infinity();
+
+inline uint64_t mix_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+} // namespace
+
+//=============================================================================
+// Lexicon Trie
+//=============================================================================
+
+std::shared_ptr<const LexiconTrie> LexiconTrie::from_flashlight(const fl::lib::text::TrieNode& root,
+                                                                int num_tokens) {
+    std::shared_ptr<LexiconTrie> trie(new LexiconTrie());
+    trie->num_tokens_ = num_tokens;
+
+    std::vector<uint8_t> used;
+    auto ensure = [&](size_t size) {
+        if (trie->base_.size() < size) {
+            size = std::max(size, trie->base_.size() * 2);
+            trie->base_.resize(size, 0);
+            trie->check_.resize(size, -1);
+            trie->max_score_.resize(size, 0.0f);
+            used.resize(size, 0);
+        }
+    };
+    ensure(static_cast<size_t>(num_tokens) + 1);
+    used[kRoot] = 1;
+
+    // Breadth first, placing each node's children at the lowest base that
+    // has all their slots free
+    std::vector<std::pair<int, int>> slot_labels;    // (slot, word)
+    std::vector<std::pair<int, const fl::lib::text::TrieNode*>> children;
+    std::deque<std::pair<const fl::lib::text::TrieNode*, int>> queue = {{&root, kRoot}};
+    size_t first_free = 1;
+
+    while (!queue.empty()) {
+        const auto [node, slot] = queue.front();
+        queue.pop_front();
+        ++trie->num_nodes_;
+
+        trie->max_score_[slot] = node->maxScore;
+        for (int label : node->labels) {
+            slot_labels.emplace_back(slot, label);
+        }
+        if (node->children.empty()) {
+            continue;
+        }
+
+        children.clear();
+        for (const auto& [token, child] : node->children) {
+            if (token < 0 || token >= num_tokens) {
+                throw std::out_of_range("Lexicon trie token " + std::to_string(token) +
+                                        " outside the vocabulary");
+            }
+            children.emplace_back(token, child.get());
+        }
+        std::sort(children.begin(), children.end());
+
+        for (;; ++first_free) {
+            ensure(first_free + 1);
+            if (!used[first_free]) {
+                break;
+            }
+        }
+        int base = std::max(1, static_cast<int>(first_free) - children.front().first);
+        for (;; ++base) {
+            ensure(static_cast<size_t>(base) + num_tokens);
+            const bool fits = std::none_of(children.begin(), children.end(), [&](const auto& child) {
+                return used[base + child.first] != 0;
+            });
+            if (fits) {
+                break;
+            }
+        }
+
+        trie->base_[slot] = base;
+        for (const auto& [token, child] : children) {
+            const int child_slot = base + token;
+            used[child_slot] = 1;
+            trie->check_[child_slot] = slot;
+            queue.emplace_back(child, child_slot);
+        }
+    }
+
+    // Labels by slot
+    const size_t num_slots = trie->base_.size();
+    trie->label_begin_.assign(num_slots + 1, 0);
+    for (const auto& [slot, label] : slot_labels) {
+        ++trie->label_begin_[slot + 1];
+    }
+    std::partial_sum(trie->label_begin_.begin(), trie->label_begin_.end(), trie->label_begin_.begin());
+    trie->labels_.resize(slot_labels.size());
+    std::vector<int32_t> fill(trie->label_begin_.begin(), trie->label_begin_.end() - 1);
+    for (const auto& [slot, label] : slot_labels) {
+        trie->labels_[fill[slot]++] = label;
+    }
+
+    return trie;
+}
+
+//=============================================================================
+// Word Language Model
+//=============================================================================
+
+WordLM::WordLM(const std::string& path, const fl::lib::text::Dictionary& words) {
+    model_.reset(lm::ngram::LoadVirtual(path.c_str()));
+    if (!model_) {
+        throw std::runtime_error("Failed to load language model " + path);
+    }
+
+    const lm::base::Vocabulary& vocab = model_->BaseVocabulary();
+    word_to_lm_.resize(words.indexSize());
+    for (size_t i = 0; i < word_to_lm_.size(); ++i) {
+        word_to_lm_[i] = vocab.Index(words.getEntry(static_cast<int>(i)));
+    }
+    end_sentence_ = vocab.EndSentence();
+}
+
+float WordLM::score(const void* in_state, int word, void* out_state) const {
+    if (word < 0 || static_cast<size_t>(word) >= word_to_lm_.size()) {
+        throw std::out_of_range("Word index " + std::to_string(word) + " outside the dictionary");
+    }
+    return model_->BaseScore(in_state, word_to_lm_[word], out_state);
+}
+
+LMStateCache::LMStateCache(std::shared_ptr<const WordLM> lm)
+    : lm_(std::move(lm)), state_size_(lm_->state_size()), table_(1024, Slot{kEmptyKey, 0, 0.0f}) {}
+
+int LMStateCache::reset() {
+    if (table_used_ > 0) {
+        std::fill(table_.begin(), table_.end(), Slot{kEmptyKey, 0, 0.0f});
+        table_used_ = 0;
+    }
+    states_.resize(state_size_);
+    lm_->begin_sentence(states_.data());
+    num_states_ = 1;
+    return 0;
+}
+
+int LMStateCache::extend(int state, int word, float& score) {
+    return lookup(state, word, score);
+}
+
+int LMStateCache::finish(int state, float& score) {
+    return lookup(state, -1, score);
+}
+
+int LMStateCache::lookup(int state, int word, float& score) {
+    const uint64_t key = (static_cast<uint64_t>(state) << 32) | static_cast<uint32_t>(word);
+    const size_t mask = table_.size() - 1;
+    size_t i = mix_key(key) & mask;
+    for (; table_[i].key != kEmptyKey; i = (i + 1) & mask) {
+        if (table_[i].key == key) {
+            score = table_[i].score;
+            return table_[i].state;
+        }
+    }
+
+    // New history: score it into a fresh state
+    const int child = num_states_;
+    states_.resize(static_cast<size_t>(child + 1) * state_size_);
+    const void* in = states_.data() + static_cast<size_t>(state) * state_size_;
+    void* out = states_.data() + static_cast<size_t>(child) * state_size_;
+    score = word < 0 ? lm_->finish(in, out) : lm_->score(in, word, out);
+    ++num_states_;
+
+    table_[i] = Slot{key, child, score};
+    if (++table_used_ * 2 > table_.size()) {
+        grow();
+    }
+    return child;
+}
+
+void LMStateCache::grow() {
+    std::vector<Slot> old(table_.size() * 2, Slot{kEmptyKey, 0, 0.0f});
+    old.swap(table_);
+    const size_t mask = table_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.key == kEmptyKey) {
+            continue;
+        }
+        size_t i = mix_key(slot.key) & mask;
+        while (table_[i].key != kEmptyKey) {
+            i = (i + 1) & mask;
+        }
+        table_[i] = slot;
+    }
+}
+
+//=============================================================================
+// Beam Search
+//=============================================================================
+
+void LexiconBeamSearch::Hypotheses::clear() {
+    score.clear();
+    am_score.clear();
+    lm_score.clear();
+    lm_state.clear();
+    lex.clear();
+    parent.clear();
+    token.clear();
+    word.clear();
+    prev_blank.clear();
+}
+
+void LexiconBeamSearch::Hypotheses::push(double score_value, double am_value, double lm_value,
+                                         int lm_state_value, int lex_value, int parent_value,
+                                         int token_value, int word_value, bool prev_blank_value) {
+    score.push_back(score_value);
+    am_score.push_back(am_value);
+    lm_score.push_back(lm_value);
+    lm_state.push_back(lm_state_value);
+    lex.push_back(lex_value);
+    parent.push_back(parent_value);
+    token.push_back(token_value);
+    word.push_back(word_value);
+    prev_blank.push_back(prev_blank_value ? 1 : 0);
+}
+
+void LexiconBeamSearch::Hypotheses::push(const Hypotheses& from, size_t i) {
+    push(from.score[i], from.am_score[i], from.lm_score[i], from.lm_state[i], from.lex[i],
+         from.parent[i], from.token[i], from.word[i], from.prev_blank[i] != 0);
+}
+
+LexiconBeamSearch::LexiconBeamSearch(const BeamSearchOptions& options,
+                                     std::shared_ptr<const LexiconTrie> trie,
+                                     std::shared_ptr<const WordLM> lm)
+    : options_(options), trie_(std::move(trie)), lm_states_(std::move(lm)) {}
+
+void LexiconBeamSearch::add_candidate(double score, double am_score, double lm_score, int lm_state,
+                                      int lex, int parent, int token, int word, bool prev_blank) {
+    if (score >= candidates_best_) {
+        candidates_best_ = score;
+    }
+    if (score >= candidates_best_ - options_.beam_threshold) {
+        candidates_.push(score, am_score, lm_score, lm_state, lex, parent, token, word, prev_blank);
+    }
+}
+
+void LexiconBeamSearch::store_candidates(bool sorted) {
+    Hypotheses& c = candidates_;
+    const double threshold = candidates_best_ - options_.beam_threshold;
+    order_.clear();
+    for (size_t i = 0; i < c.size(); ++i) {
+        if (c.score[i] >= threshold) {
+            order_.push_back(static_cast<int>(i));
+        }
+    }
+    if (order_.empty()) {
+        return;
+    }
+
+    // Candidates with the same LM state, lexicon node, token and blank flag
+    // are the same hypothesis: keep the best (or log-add their scores).
+    // Groups are found by hashing; group_next_ chains the members of each.
+    size_t table_size = 16;
+    while (table_size < 2 * order_.size()) {
+        table_size <<= 1;
+    }
+    const size_t mask = table_size - 1;
+    group_table_.assign(table_size, -1);
+    group_next_.resize(c.size());
+    group_head_.clear();
+
+    size_t merged = 0;
+    for (const int i : order_) {
+        const uint64_t key = (uint64_t(uint32_t(c.lm_state[i])) << 32) ^
+                             (uint64_t(uint32_t(c.lex[i])) << 11) ^
+                             (uint64_t(uint32_t(c.token[i])) << 1) ^ c.prev_blank[i];
+        size_t slot = mix_key(key) & mask;
+        while (true) {
+            const int g = group_table_[slot];
+            if (g < 0) {
+                group_table_[slot] = static_cast<int>(merged);
+                group_head_.push_back(i);
+                group_next_[i] = -1;
+                order_[merged++] = i;
+                break;
+            }
+            const int best = order_[g];
+            if (c.lm_state[best] == c.lm_state[i] && c.lex[best] == c.lex[i] &&
+                c.token[best] == c.token[i] && c.prev_blank[best] == c.prev_blank[i]) {
+                group_next_[i] = group_head_[g];
+                group_head_[g] = i;
+                if (c.score[i] > c.score[best]) {
+                    order_[g] = i;
+                }
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    order_.resize(merged);
+
+    if (options_.log_add) {
+        // Accumulate best first, like LexiconDecoder's sorted merge
+        for (size_t g = 0; g < merged; ++g) {
+            if (group_next_[group_head_[g]] < 0) {
+                continue;
+            }
+            group_scores_.clear();
+            for (int i = group_head_[g]; i >= 0; i = group_next_[i]) {
+                group_scores_.push_back(c.score[i]);
+            }
+            std::sort(group_scores_.begin(), group_scores_.end(), std::greater<double>());
+            double score = group_scores_[0];
+            for (size_t j = 1; j < group_scores_.size(); ++j) {
+                score += std::log1p(std::exp(group_scores_[j] - score));
+            }
+            c.score[order_[g]] = score;
+        }
+    }
+
+    const size_t keep = std::min(merged, static_cast<size_t>(std::max(options_.beam_size, 0)));
+    auto by_score = [&c](int a, int b) { return c.score[a] > c.score[b]; };
+    if (sorted) {
+        std::partial_sort(order_.begin(), order_.begin() + keep, order_.end(), by_score);
+    } else if (merged > keep) {
+        std::nth_element(order_.begin(), order_.begin() + keep, order_.end(), by_score);
+    }
+
+    for (size_t i = 0; i < keep; ++i) {
+        arena_.push(c, order_[i]);
+    }
+}
+
+int LexiconBeamSearch::select_tokens(const float* row, int N, int k) {
+    tokens_.resize(N);
+    if (k >= N) {
+        std::iota(tokens_.begin(), tokens_.end(), 0);
+        return N;
+    }
+
+    token_scratch_.assign(row, row + N);
+    std::nth_element(token_scratch_.begin(), token_scratch_.begin() + (k - 1), token_scratch_.end(),
+                     std::greater<float>());
+    const float kth = token_scratch_[k - 1];
+
+    // Branch-free compaction of the tokens above the k-th score, then ties
+    int count = 0;
+    for (int v = 0; v < N; ++v) {
+        tokens_[count] = v;
+        count += row[v] > kth ? 1 : 0;
+    }
+    for (int v = 0; v < N && count < k; ++v) {
+        if (row[v] == kth) {
+            tokens_[count++] = v;
+        }
+    }
+    return count;
+}
+
+std::vector<fl::lib::text::DecodeResult> LexiconBeamSearch::decode(const float* emissions, int T, int N,
+                                                                  const int* candidates) {
+    const LexiconTrie& trie = *trie_;
+    const int root = LexiconTrie::kRoot;
+    const int num_tokens = std::min(N, trie.num_tokens());
+    const int sil = options_.sil_idx;
+    const int blank = options_.blank_idx;
+    const int unk = options_.unk_idx;
+    const double lm_weight = options_.lm_weight;
+    const bool score_unk = options_.unk_score > kNegativeInfinity;
+    const int beam_size_token = options_.beam_size_token > 0 ? std::min(options_.beam_size_token, N) : N;
+
+    arena_.clear();
+    frame_begin_.clear();
+    arena_.push(0.0, 0.0, 0.0, lm_states_.reset(), root, -1, sil, -1, false);
+    frame_begin_.push_back(0);
+    frame_begin_.push_back(arena_.size());
+
+    for (int t = 0; t < T; ++t) {
+        const float* row = emissions + static_cast<size_t>(t) * N;
+        const int k = candidates ? std::max(1, std::min(candidates[t], beam_size_token)) : beam_size_token;
+        const int num_expanded = select_tokens(row, N, k);
+
+        candidates_.clear();
+        candidates_best_ = kNegativeInfinity;
+        const size_t end = frame_begin_[t + 1];
+        for (size_t h = frame_begin_[t]; h < end; ++h) {
+            const int parent = static_cast<int>(h);
+            const double prev_score = arena_.score[h];
+            const double prev_am = arena_.am_score[h];
+            const double prev_lm = arena_.lm_score[h];
+            const int prev_lm_state = arena_.lm_state[h];
+            const int prev_lex = arena_.lex[h];
+            const int prev_token = arena_.token[h];
+            const bool prev_blank = arena_.prev_blank[h] != 0;
+            // float like LexiconDecoder, so LM deltas round the same way
+            const float lex_max = prev_lex == root ? 0.0f : trie.max_score(prev_lex);
+
+            // (1) Extend the spelling by one of the frame's best tokens
+            for (int r = 0; r < num_expanded; ++r) {
+                const int n = tokens_[r];
+                if (n >= num_tokens) {
+                    continue;
+                }
+                const int lex = trie.child(prev_lex, n);
+                if (lex < 0) {
+                    continue;
+                }
+
+                const double am = row[n];
+                double score = prev_score + am;
+                if (n == sil) {
+                    score += options_.sil_score;
+                }
+
+                // CTC: the same token again without a blank does not extend
+                // the spelling. Like LexiconDecoder, words (and unk below)
+                // are still emitted on it, so a doubled token such as "a a"
+                // can complete a word on a repeat.
+                if ((prev_blank || n != prev_token) && trie.has_children(lex)) {
+                    const double lm = trie.max_score(lex) - lex_max;
+                    add_candidate(score + lm_weight * lm, prev_am + am, prev_lm + lm,
+                                  prev_lm_state, lex, parent, n, -1, false);
+                }
+
+                // Log probabilities are at most 0: skip the LM lookups when
+                // even that could not reach the beam
+                const bool words_in_beam =
+                    lm_weight < 0.0 || score + lm_weight * (0.0 - lex_max) + options_.word_score >=
+                                           candidates_best_ - options_.beam_threshold;
+                for (const int* label = trie.labels_begin(lex);
+                     words_in_beam && label != trie.labels_end(lex); ++label) {
+                    float word_lm = 0.0f;
+                    const int lm_state = lm_states_.extend(prev_lm_state, *label, word_lm);
+                    const double lm = word_lm - lex_max;
+                    add_candidate(score + lm_weight * lm + options_.word_score, prev_am + am, prev_lm + lm,
+                                  lm_state, root, parent, n, *label, false);
+                }
+
+                if (score_unk && trie.labels_begin(lex) == trie.labels_end(lex)) {
+                    float unk_lm = 0.0f;
+                    const int lm_state = lm_states_.extend(prev_lm_state, unk, unk_lm);
+                    const double lm = unk_lm - lex_max;
+                    add_candidate(score + lm_weight * lm + options_.unk_score, prev_am + am, prev_lm + lm,
+                                  lm_state, root, parent, n, unk, false);
+                }
+            }
+
+            // (2) Stay on the node: repeat the token, or silence at the root
+            if (!prev_blank || prev_lex == root) {
+                const int n = prev_lex == root ? sil : prev_token;
+                if (n >= 0 && n < N) {
+                    const double am = row[n];
+                    double score = prev_score + am;
+                    if (n == sil) {
+                        score += options_.sil_score;
+                    }
+                    add_candidate(score, prev_am + am, prev_lm, prev_lm_state, prev_lex, parent, n, -1, false);
+                }
+            }
+
+            // (3) Blank
+            if (blank >= 0 && blank < N) {
+                const double am = row[blank];
+                add_candidate(prev_score + am, prev_am + am, prev_lm, prev_lm_state, prev_lex, parent,
+                              blank, -1, true);
+            }
+        }
+
+        store_candidates(false);
+        frame_begin_.push_back(arena_.size());
+    }
+
+    // End of sentence, preferring hypotheses that end on a complete word
+    candidates_.clear();
+    candidates_best_ = kNegativeInfinity;
+    const size_t last_begin = frame_begin_[T];
+    const size_t last_end = frame_begin_[T + 1];
+    bool word_ending = false;
+    for (size_t h = last_begin; h < last_end; ++h) {
+        if (arena_.lex[h] == root) {
+            word_ending = true;
+            break;
+        }
+    }
+    for (size_t h = last_begin; h < last_end; ++h) {
+        if (word_ending && arena_.lex[h] != root) {
+            continue;
+        }
+        float end_lm = 0.0f;
+        const int lm_state = lm_states_.finish(arena_.lm_state[h], end_lm);
+        add_candidate(arena_.score[h] + lm_weight * end_lm, arena_.am_score[h], arena_.lm_score[h] + end_lm,
+                      lm_state, arena_.lex[h], static_cast<int>(h), sil, -1, false);
+    }
+    store_candidates(true);
+
+    // Walk each final hypothesis back to the start state
+    std::vector<fl::lib::text::DecodeResult> results;
+    results.reserve(arena_.size() - last_end);
+    for (size_t h = last_end; h < arena_.size(); ++h) {
+        fl::lib::text::DecodeResult result;
+        result.score = arena_.score[h];
+        result.amScore = arena_.am_score[h];
+        result.lmScore = arena_.lm_score[h];
+        result.words.assign(static_cast<size_t>(T) + 2, -1);
+        result.tokens.assign(static_cast<size_t>(T) + 2, -1);
+        int node = static_cast<int>(h);
+        for (int i = T + 1; i >= 0 && node >= 0; --i) {
+            result.words[i] = arena_.word[node];
+            result.tokens[i] = arena_.token[node];
+            node = arena_.parent[node];
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+} // namespace cued_speech
@@ -0,0 +1,313 @@
+/**
+ * Cued Speech Decoder - Native lexicon beam search
+ *
+ * CTC beam search constrained by a lexicon trie and scored by a word-level
+ * KenLM, equivalent to flashlight's LexiconDecoder (same expansions, scores,
+ * merging and pruning) but laid out for the per-frame loop:
+ *
+ * - the trie is a double-array, so a child lookup is two array loads
+ * - hypotheses are stored field by field in arrays that are reused from one
+ *   decode to the next, with parents as indices instead of pointers
+ * - language model states are interned in an open-addressing table keyed by
+ *   (history, word), so each extension is scored by KenLM once per decode
+ *
+ * CTCDecoder selects it with DecoderConfig::engine.
+ */
+
+#ifndef CUED_SPEECH_BEAM_SEARCH_H
+#define CUED_SPEECH_BEAM_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <flashlight/lib/text/decoder/Decoder.h>
+#include <kenlm/lm/model.hh>
+
+namespace fl {
+namespace lib {
+namespace text {
+struct TrieNode;
+class Dictionary;
+}
+}
+}
+
+namespace cued_speech {
+
+//=============================================================================
+// Lexicon Trie
+//=============================================================================
+
+/**
+ * Lexicon trie in double-array form
+ *
+ * The child of node s for token c sits at slot base(s) + c when that slot's
+ * check is s. Leaves have base 0, and every inner node's base is at least 1,
+ * so a leaf never claims a slot; the arrays are padded so no lookup needs a
+ * bounds check.
+ */
+class LexiconTrie {
+public:
+    static constexpr int kRoot = 0;
+
+    /**
+     * Convert a smeared flashlight trie
+     *
+     * @param root Root of the trie (maxScore already smeared)
+     * @param num_tokens Token vocabulary size
+     * @throws std::out_of_range for a child token outside the vocabulary
+     */
+    static std::shared_ptr<const LexiconTrie> from_flashlight(const fl::lib::text::TrieNode& root,
+                                                              int num_tokens);
+
+    /**
+     * Child of node for token, or -1
+     */
+    int child(int node, int token) const {
+        const int slot = base_[node] + token;
+        return check_[slot] == node ? slot : -1;
+    }
+
+    bool has_children(int node) const {
+        return base_[node] > 0;
+    }
+
+    float max_score(int node) const {
+        return max_score_[node];
+    }
+
+    /**
+     * Words spelled by the path to node
+     */
+    const int* labels_begin(int node) const {
+        return labels_.data() + label_begin_[node];
+    }
+    const int* labels_end(int node) const {
+        return labels_.data() + label_begin_[node + 1];
+    }
+
+    int num_nodes() const {
+        return num_nodes_;
+    }
+
+    int num_tokens() const {
+        return num_tokens_;
+    }
+
+    /**
+     * Slots allocated (nodes plus the holes of the double-array)
+     */
+    int num_slots() const {
+        return static_cast<int>(base_.size());
+    }
+
+private:
+    LexiconTrie() = default;
+
+    std::vector<int32_t> base_;
+    std::vector<int32_t> check_;              // Parent slot, -1 for free slots and the root
+    std::vector<float> max_score_;
+    std::vector<int32_t> label_begin_;        // Labels of slot s: [label_begin_[s], label_begin_[s + 1])
+    std::vector<int32_t> labels_;
+    int num_nodes_ = 0;
+    int num_tokens_ = 0;
+};
+
+//=============================================================================
+// Word Language Model
+//=============================================================================
+
+/**
+ * KenLM model addressed by word dictionary indices
+ *
+ * Any KenLM format (ARPA, probing or trie binary) is accepted. Scores are
+ * log10 probabilities, as with flashlight's KenLM wrapper.
+ */
+class WordLM {
+public:
+    /**
+     * @throws std::runtime_error if the model cannot be loaded
+     */
+    WordLM(const std::string& path, const fl::lib::text::Dictionary& words);
+
+    size_t state_size() const {
+        return model_->StateSize();
+    }
+
+    void begin_sentence(void* state) const {
+        model_->BeginSentenceWrite(state);
+    }
+
+    /**
+     * Score word (a word dictionary index) after in_state
+     *
+     * @throws std::out_of_range for an index outside the dictionary
+     */
+    float score(const void* in_state, int word, void* out_state) const;
+
+    /**
+     * Score the end of sentence after in_state
+     */
+    float finish(const void* in_state, void* out_state) const {
+        return model_->BaseScore(in_state, end_sentence_, out_state);
+    }
+
+private:
+    std::unique_ptr<lm::base::Model> model_;
+    std::vector<lm::WordIndex> word_to_lm_;
+    lm::WordIndex end_sentence_ = 0;
+};
+
+/**
+ * Language model states of one decode
+ *
+ * States form a tree of word histories: extending a state by a word always
+ * yields the same child, as in flashlight's LMState. Children and their
+ * scores are interned in an open-addressing table, so repeated extensions
+ * across hypotheses and frames cost one probe instead of a KenLM lookup.
+ */
+class LMStateCache {
+public:
+    explicit LMStateCache(std::shared_ptr<const WordLM> lm);
+
+    /**
+     * Forget every state and return the start-of-sentence state
+     */
+    int reset();
+
+    /**
+     * Child of state for word; its log10 probability goes to score
+     */
+    int extend(int state, int word, float& score);
+
+    /**
+     * End-of-sentence child of state
+     */
+    int finish(int state, float& score);
+
+    int num_states() const {
+        return num_states_;
+    }
+
+private:
+    struct Slot {
+        uint64_t key;
+        int32_t state;
+        float score;
+    };
+    static constexpr uint64_t kEmptyKey = ~uint64_t{0};
+
+    int lookup(int state, int word, float& score);
+    void grow();
+
+    std::shared_ptr<const WordLM> lm_;
+    size_t state_size_;
+    std::vector<unsigned char> states_;       // state_size_ bytes per state
+    int num_states_ = 0;
+    std::vector<Slot> table_;                 // Power-of-two size, at most half full
+    size_t table_used_ = 0;
+};
+
+//=============================================================================
+// Beam Search
+//=============================================================================
+
+/**
+ * Beam search parameters (see LexiconDecoderOptions)
+ */
+struct BeamSearchOptions {
+    int beam_size = 40;
+    int beam_size_token = -1;         // Tokens expanded per frame, -1 = all
+    double beam_threshold = 50.0;
+    double lm_weight = 0.0;
+    double word_score = 0.0;
+    double unk_score = -std::numeric_limits<double>::infinity();
+    double sil_score = 0.0;
+    bool log_add = false;
+
+    int sil_idx = -1;
+    int blank_idx = -1;
+    int unk_idx = -1;                 // Scored as a word when unk_score is finite
+};
+
+/**
+ * One decode at a time; CTCDecoder pools instances for concurrent decodes
+ */
+class LexiconBeamSearch {
+public:
+    LexiconBeamSearch(const BeamSearchOptions& options,
+                      std::shared_ptr<const LexiconTrie> trie,
+                      std::shared_ptr<const WordLM> lm);
+
+    /**
+     * Decode [T x N] log probabilities
+     *
+     * @param candidates Tokens to expand at each frame [T] (capped at
+     *                   beam_size_token), or nullptr for beam_size_token
+     * @return Final hypotheses, best first. As with LexiconDecoder, paths
+     *         have T + 2 steps: the start state, one per frame and the end.
+     */
+    std::vector<fl::lib::text::DecodeResult> decode(const float* emissions, int T, int N,
+                                                    const int* candidates = nullptr);
+
+private:
+    /**
+     * Hypotheses stored field by field
+     */
+    struct Hypotheses {
+        std::vector<double> score;
+        std::vector<double> am_score;
+        std::vector<double> lm_score;
+        std::vector<int32_t> lm_state;
+        std::vector<int32_t> lex;
+        std::vector<int32_t> parent;          // Index in the arena, -1 for the start state
+        std::vector<int32_t> token;
+        std::vector<int32_t> word;
+        std::vector<uint8_t> prev_blank;
+
+        size_t size() const {
+            return score.size();
+        }
+        void clear();
+        void push(double score, double am_score, double lm_score, int lm_state, int lex,
+                  int parent, int token, int word, bool prev_blank);
+        void push(const Hypotheses& from, size_t i);
+    };
+
+    void add_candidate(double score, double am_score, double lm_score, int lm_state, int lex,
+                       int parent, int token, int word, bool prev_blank);
+
+    /**
+     * Merge equivalent candidates and move the best beam_size to the arena
+     */
+    void store_candidates(bool sorted);
+
+    /**
+     * Indices of the k best tokens of a row
+     */
+    int select_tokens(const float* row, int N, int k);
+
+    BeamSearchOptions options_;
+    std::shared_ptr<const LexiconTrie> trie_;
+    LMStateCache lm_states_;
+
+    Hypotheses arena_;                        // Surviving hypotheses of every frame
+    std::vector<size_t> frame_begin_;         // Frame t: [frame_begin_[t], frame_begin_[t + 1])
+    Hypotheses candidates_;
+    double candidates_best_ = 0.0;
+    std::vector<int> order_;                  // Candidates kept, then the best of each group
+    std::vector<int> group_table_;            // Hash slot -> group
+    std::vector<int> group_head_;
+    std::vector<int> group_next_;
+    std::vector<double> group_scores_;
+    std::vector<int> tokens_;
+    std::vector<float> token_scratch_;
+};
+
+} // namespace cued_speech
+
+#endif // CUED_SPEECH_BEAM_SEARCH_H
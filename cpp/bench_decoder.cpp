@@ -0,0 +1,582 @@
+/**
+ * Cued Speech Decoder - Benchmark suite
+ *
+ * Micro benchmarks for the per-frame/per-window kernels and macro benchmarks
+ * that stream synthetic feature sequences through WindowProcessor. Assets
+ * come from generate_test_assets() in a temporary directory, so the suite
+ * runs offline.
+ *
+ * Results are written as JSON to cued_speech_bench.json unless
+ * --benchmark_out is given.
+ */
+
+#include "decoder.h"
+#include "frame_ring.h"
+#include "test_assets.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using cued_speech::CTCDecoder;
+using cued_speech::DecoderConfig;
+using cued_speech::FeatureExtractor;
+using cued_speech::FrameFeatures;
+using cued_speech::FrameRecord;
+using cued_speech::FrameRing;
+using cued_speech::LandmarkResults;
+using cued_speech::SentenceCorrector;
+using cued_speech::TestAssets;
+using cued_speech::TFLiteSequenceModel;
+using cued_speech::WindowProcessor;
+using cued_speech::WindowingConfig;
+
+namespace {
+
+constexpr int kLipsDim = 8;
+constexpr int kHandShapeDim = 7;
+constexpr int kHandPosDim = 18;
+
+TestAssets g_assets;
+
+DecoderConfig bench_decoder_config() {
+    DecoderConfig config;
+    config.tokens_path = g_assets.tokens_path;
+    config.lexicon_path = g_assets.lexicon_path;
+    config.lm_path = g_assets.lm_path;
+    config.nbest = 1;
+    config.beam_size = 40;
+    config.beam_threshold = 50.0f;
+    return config;
+}
+
+std::vector<float> random_logits(int frames, int vocab, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 3.0f);
+    std::vector<float> logits(static_cast<size_t>(frames) * vocab);
+    for (auto& value : logits) {
+        value = normal(rng);
+    }
+    return logits;
+}
+
+FrameFeatures random_features(std::mt19937& rng) {
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    FrameFeatures features;
+    features.lips.resize(kLipsDim);
+    features.hand_shape.resize(kHandShapeDim);
+    features.hand_position.resize(kHandPosDim);
+    for (auto& v : features.lips) v = uniform(rng);
+    for (auto& v : features.hand_shape) v = uniform(rng);
+    for (auto& v : features.hand_position) v = uniform(rng);
+    return features;
+}
+
+LandmarkResults random_landmarks(std::mt19937& rng) {
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    auto fill = [&](std::vector<cued_speech::Landmark>& points, size_t count) {
+        points.resize(count);
+        for (auto& point : points) {
+            point = {uniform(rng), uniform(rng), uniform(rng) * 0.1f};
+        }
+    };
+    LandmarkResults landmarks;
+    fill(landmarks.face_landmarks, 478);
+    fill(landmarks.hand_landmarks, 21);
+    fill(landmarks.pose_landmarks, 33);
+    return landmarks;
+}
+
+//=============================================================================
+// Micro Benchmarks
+//=============================================================================
+
+void BM_LogSoftmax(benchmark::State& state) {
+    const int frames = static_cast<int>(state.range(0));
+    const int vocab = g_assets.vocab_size;
+    const auto logits = random_logits(frames, vocab, 1);
+    std::vector<float> log_probs(logits.size());
+
+    for (auto _ : state) {
+        CTCDecoder::log_softmax(logits.data(), log_probs.data(), frames, vocab);
+        benchmark::DoNotOptimize(log_probs.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_LogSoftmax)->Arg(50)->Arg(100)->Arg(1000);
+
+/**
+ * CTC-like log posteriors: blank_percent% of frames are blank-dominated,
+ * the rest peak on a random non-blank token
+ */
+std::vector<float> peaky_log_probs(int frames, int vocab, int blank_percent, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> token_dist(1, vocab - 1);
+    std::vector<float> logits(static_cast<size_t>(frames) * vocab);
+    for (int t = 0; t < frames; ++t) {
+        float* row = logits.data() + static_cast<size_t>(t) * vocab;
+        for (int v = 0; v < vocab; ++v) {
+            row[v] = normal(rng);
+        }
+        row[percent(rng) < blank_percent ? 0 : token_dist(rng)] += 12.0f;  // <BLANK> is index 0
+    }
+    std::vector<float> log_probs(logits.size());
+    CTCDecoder::log_softmax(logits.data(), log_probs.data(), frames, vocab);
+    return log_probs;
+}
+
+// Search modes of BM_BeamSearch
+enum BeamSearchMode { kFullSearch = 0, kBlankSkip = 1, kTokenPruning = 2, kNativeEngine = 3 };
+
+void BM_BeamSearch(benchmark::State& state) {
+    const int frames = static_cast<int>(state.range(0));
+    const int blank_percent = static_cast<int>(state.range(1));
+    const int mode = static_cast<int>(state.range(2));
+    const int vocab = g_assets.vocab_size;
+
+    DecoderConfig config = bench_decoder_config();
+    CTCDecoder full_decoder(config);
+    if (mode == kBlankSkip) {
+        config.blank_skip_threshold = -0.01f;
+    } else if (mode == kTokenPruning) {
+        config.token_mass = 0.95f;
+    } else if (mode == kNativeEngine) {
+        config.engine = cued_speech::DecoderEngine::Native;
+    }
+    CTCDecoder decoder(config);
+    if (!full_decoder.initialize() || !decoder.initialize()) {
+        state.SkipWithError("decoder initialization failed");
+        return;
+    }
+
+    const auto log_probs = peaky_log_probs(frames, vocab, blank_percent, 5);
+
+    // Accuracy: phonemes and words must match the full search
+    const auto reference = full_decoder.decode_log_probs(log_probs.data(), frames, vocab);
+    const auto hypotheses = decoder.decode_log_probs(log_probs.data(), frames, vocab);
+    const bool match = !reference.empty() && !hypotheses.empty() &&
+                       full_decoder.collapse_tokens(reference[0].tokens) ==
+                           decoder.collapse_tokens(hypotheses[0].tokens) &&
+                       reference[0].words == hypotheses[0].words;
+
+    std::vector<float> reduced;
+    std::vector<int> frame_map;
+    std::vector<int> candidates(frames);
+    const int kept = decoder.skip_blank_frames(log_probs.data(), frames, vocab, reduced, frame_map);
+    decoder.count_token_candidates(log_probs.data(), frames, vocab, candidates.data());
+    const double mean_candidates =
+        static_cast<double>(std::accumulate(candidates.begin(), candidates.end(), 0)) / frames;
+
+    for (auto _ : state) {
+        auto result = decoder.decode_log_probs(log_probs.data(), frames, vocab);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(state.iterations() * frames);
+    state.counters["searched_frames"] = kept;
+    state.counters["tokens_per_frame"] = mode == kTokenPruning ? mean_candidates : vocab;
+    state.counters["matches_full"] = match ? 1 : 0;
+}
+BENCHMARK(BM_BeamSearch)
+    ->ArgNames({"frames", "blank_pct", "mode"})
+    ->Args({1000, 50, kFullSearch})
+    ->Args({1000, 50, kBlankSkip})
+    ->Args({1000, 50, kTokenPruning})
+    ->Args({1000, 50, kNativeEngine})
+    ->Args({1000, 80, kFullSearch})
+    ->Args({1000, 80, kBlankSkip})
+    ->Args({1000, 80, kTokenPruning})
+    ->Args({1000, 80, kNativeEngine})
+    ->Args({1000, 95, kFullSearch})
+    ->Args({1000, 95, kBlankSkip})
+    ->Args({1000, 95, kTokenPruning})
+    ->Args({1000, 95, kNativeEngine})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_SegmentedDecode(benchmark::State& state) {
+    const int frames = static_cast<int>(state.range(0));
+    const int threads = static_cast<int>(state.range(1));
+    const int vocab = g_assets.vocab_size;
+
+    DecoderConfig config = bench_decoder_config();
+    config.segment_frames = 300;
+    CTCDecoder decoder(config);
+    if (!decoder.initialize()) {
+        state.SkipWithError("decoder initialization failed");
+        return;
+    }
+
+    const auto log_probs = peaky_log_probs(frames, vocab, 80, 6);
+    const auto bounds = decoder.find_segments(log_probs.data(), frames, vocab);
+
+    for (auto _ : state) {
+        auto result = decoder.decode_segmented(log_probs.data(), frames, vocab, threads);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(state.iterations() * frames);
+    state.counters["segments"] = static_cast<double>(bounds.size() - 1);
+}
+BENCHMARK(BM_SegmentedDecode)
+    ->ArgNames({"frames", "threads"})
+    ->Args({10000, 1})
+    ->Args({10000, 2})
+    ->Args({10000, 4})
+    ->Args({10000, 8})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_FeatureExtract(benchmark::State& state) {
+    std::mt19937 rng(2);
+    const LandmarkResults current = random_landmarks(rng);
+    const LandmarkResults prev = random_landmarks(rng);
+    const LandmarkResults prev2 = random_landmarks(rng);
+    FeatureExtractor extractor;
+
+    for (auto _ : state) {
+        FrameFeatures features = extractor.extract(current, &prev, &prev2);
+        benchmark::DoNotOptimize(features);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FeatureExtract);
+
+void BM_IdxsToTokens(benchmark::State& state) {
+    CTCDecoder decoder(bench_decoder_config());
+    if (!decoder.initialize()) {
+        state.SkipWithError("decoder initialization failed");
+        return;
+    }
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> token_dist(0, g_assets.vocab_size - 1);
+    std::vector<int> idxs(static_cast<size_t>(state.range(0)));
+    for (auto& idx : idxs) {
+        idx = token_dist(rng);
+    }
+
+    for (auto _ : state) {
+        auto tokens = decoder.idxs_to_tokens(idxs);
+        benchmark::DoNotOptimize(tokens);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IdxsToTokens)->Arg(100)->Arg(1000);
+
+void BM_CollapseTokens(benchmark::State& state) {
+    CTCDecoder decoder(bench_decoder_config());
+    if (!decoder.initialize()) {
+        state.SkipWithError("decoder initialization failed");
+        return;
+    }
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> token_dist(0, g_assets.vocab_size - 1);
+    std::vector<int> idxs(static_cast<size_t>(state.range(0)));
+    for (auto& idx : idxs) {
+        idx = token_dist(rng);
+    }
+
+    std::vector<int> collapsed;
+    for (auto _ : state) {
+        decoder.collapse_tokens(idxs, collapsed);
+        benchmark::DoNotOptimize(collapsed.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CollapseTokens)->Arg(100)->Arg(1000);
+
+void BM_CorrectorBeamSearch(benchmark::State& state) {
+    SentenceCorrector corrector(g_assets.homophones_path, g_assets.french_lm_path);
+    if (!corrector.initialize()) {
+        state.SkipWithError("corrector initialization failed");
+        return;
+    }
+
+    const size_t length = static_cast<size_t>(state.range(0));
+    std::vector<std::vector<std::string>> lists;
+    for (size_t i = 0; i < length; ++i) {
+        lists.push_back(g_assets.homophone_groups[i % g_assets.homophone_groups.size()]);
+    }
+
+    for (auto _ : state) {
+        auto words = corrector.beam_search(lists, 20);
+        benchmark::DoNotOptimize(words);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CorrectorBeamSearch)->Arg(5)->Arg(20);
+
+void BM_RemoveAccents(benchmark::State& state) {
+    const std::string sentence =
+        "\xC3\x80 l'\xC3\xA9t\xC3\xA9, le c\xC5\x93ur du gar\xC3\xA7on \xC3\xA9tait "
+        "tr\xC3\xA8s \xC3\xA9mu pr\xC3\xA8s de la for\xC3\xAAt.";
+    std::string input;
+    for (int i = 0; i < state.range(0); ++i) {
+        input += sentence;
+    }
+
+    for (auto _ : state) {
+        auto output = cued_speech::remove_accents(input);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(input.size()));
+}
+BENCHMARK(BM_RemoveAccents)->Arg(1)->Arg(16);
+
+void BM_PushFrames(benchmark::State& state) {
+    const bool bulk = state.range(0) != 0;
+    const int num_frames = 1000;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<float> block(static_cast<size_t>(num_frames) * cued_speech::kFrameFeatureSize);
+    for (auto& v : block) {
+        v = uniform(rng);
+    }
+
+    // No model: measures ingestion only
+    WindowProcessor processor(nullptr, nullptr);
+    for (auto _ : state) {
+        processor.reset();
+        if (bulk) {
+            benchmark::DoNotOptimize(processor.push_frames(block.data(), num_frames));
+        } else {
+            for (int i = 0; i < num_frames; ++i) {
+                benchmark::DoNotOptimize(
+                    processor.push_frame(block.data() + static_cast<size_t>(i) * cued_speech::kFrameFeatureSize));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * num_frames);
+    state.SetLabel(bulk ? "bulk" : "per_frame");
+}
+BENCHMARK(BM_PushFrames)->Arg(0)->Arg(1);
+
+/**
+ * Round trip of one frame through two shared-memory rings
+ *
+ * An echo thread consumes each frame from the first ring and pushes it back
+ * through the second. Small rings wrap around on every few frames; with
+ * idle_us > 0 the echo side has gone to sleep on the futex before each frame
+ * (the idle time is not counted), so the wake-up latency is measured.
+ */
+void BM_FrameRingRoundTrip(benchmark::State& state) {
+    const uint32_t capacity = static_cast<uint32_t>(state.range(0));
+    const int idle_us = static_cast<int>(state.range(1));
+
+    const std::string name = "cued_speech_bench_ring_" + std::to_string(std::random_device{}());
+    auto ping = FrameRing::create(name + "_ping", capacity);
+    auto pong = FrameRing::create(name + "_pong", capacity);
+    auto ping_reader = ping ? FrameRing::open(name + "_ping") : nullptr;
+    auto pong_reader = pong ? FrameRing::open(name + "_pong") : nullptr;
+    if (!ping_reader || !pong_reader) {
+        state.SkipWithError("shared-memory frame rings are unavailable");
+        return;
+    }
+
+    std::thread echo([&] {
+        while (const FrameRecord* record = ping_reader->peek(-1)) {
+            pong->push(record->features, record->frame_number, record->valid != 0, -1);
+            ping_reader->release();
+        }
+        pong->close();
+    });
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    float features[cued_speech::kFrameRecordFeatures];
+    for (auto& v : features) {
+        v = uniform(rng);
+    }
+    int32_t frame_number = 0;
+    for (auto _ : state) {
+        if (idle_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(idle_us));
+        }
+        const auto start = std::chrono::steady_clock::now();
+        ping->push(features, frame_number++, true, -1);
+        const FrameRecord* record = pong_reader->peek(-1);
+        benchmark::DoNotOptimize(record);
+        pong_reader->release();
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    ping->close();
+    echo.join();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameRingRoundTrip)
+    ->ArgNames({"capacity", "idle_us"})
+    ->Args({4, 0})
+    ->Args({256, 0})
+    ->Args({256, 200})
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//=============================================================================
+// Macro Benchmarks
+//=============================================================================
+
+// Dropped frames between utterances in BM_StreamFrames; they end one with
+// endpoint_dropped_frames
+constexpr int kPauseFrames = 15;
+
+void BM_StreamFrames(benchmark::State& state) {
+    const int num_frames = static_cast<int>(state.range(0));
+    const int two_pass_margin = static_cast<int>(state.range(1));
+    const int utterance_frames = static_cast<int>(state.range(2));
+
+    CTCDecoder decoder(bench_decoder_config());
+    if (!decoder.initialize()) {
+        state.SkipWithError("decoder initialization failed");
+        return;
+    }
+    TFLiteSequenceModel model;
+    if (!model.load(g_assets.model_path)) {
+        state.SkipWithError("synthetic TFLite model failed to load");
+        return;
+    }
+
+    std::mt19937 rng(4);
+    std::vector<FrameFeatures> frames;
+    frames.reserve(num_frames);
+    for (int i = 0; i < num_frames; ++i) {
+        // Hands out of view after each utterance (invalid frames are dropped)
+        const bool pause = utterance_frames > 0 && i % (utterance_frames + kPauseFrames) >= utterance_frames;
+        frames.push_back(pause ? FrameFeatures{} : random_features(rng));
+    }
+
+    // Without endpoints every window searches the whole stream, so the cost
+    // grows with the square of its length
+    WindowingConfig windowing;
+    windowing.two_pass_margin = two_pass_margin;
+    windowing.endpoint_dropped_frames = utterance_frames > 0 ? kPauseFrames : 0;
+    WindowProcessor processor(&decoder, &model, windowing);
+    int64_t windows = 0;
+    uint64_t searched_frames = 0;
+    for (auto _ : state) {
+        processor.reset();
+        for (const auto& features : frames) {
+            if (processor.push_frame(features)) {
+                auto result = processor.process_window();
+                benchmark::DoNotOptimize(result);
+                ++windows;
+            }
+        }
+        auto result = processor.finalize();
+        benchmark::DoNotOptimize(result);
+        searched_frames += processor.stats().searched_frames;
+    }
+
+    state.SetItemsProcessed(state.iterations() * num_frames);
+    state.counters["frames_per_second"] =
+        benchmark::Counter(static_cast<double>(state.iterations()) * num_frames, benchmark::Counter::kIsRate);
+    state.counters["windows"] =
+        benchmark::Counter(static_cast<double>(windows), benchmark::Counter::kAvgIterations);
+    state.counters["searched_frames"] =
+        benchmark::Counter(static_cast<double>(searched_frames), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_StreamFrames)
+    ->ArgNames({"frames", "two_pass_margin", "utterance_frames"})
+    ->Args({1000, 0, 0})
+    ->Args({10000, 0, 0})
+    ->Args({10000, 30, 0})
+    ->Args({10000, 0, 2000})
+    ->Args({100000, 0, 2000})
+    ->Args({100000, 30, 2000})
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(1);
+
+void BM_DecodeSequence(benchmark::State& state) {
+    const int num_frames = static_cast<int>(state.range(0));
+    const int num_threads = static_cast<int>(state.range(1));
+
+    CTCDecoder decoder(bench_decoder_config());
+    if (!decoder.initialize()) {
+        state.SkipWithError("decoder initialization failed");
+        return;
+    }
+    TFLiteSequenceModel model;
+    if (!model.load(g_assets.model_path)) {
+        state.SkipWithError("synthetic TFLite model failed to load");
+        return;
+    }
+
+    std::mt19937 rng(4);
+    std::vector<FrameFeatures> frames;
+    frames.reserve(num_frames);
+    for (int i = 0; i < num_frames; ++i) {
+        frames.push_back(random_features(rng));
+    }
+
+    WindowProcessor processor(&decoder, &model);
+    for (auto _ : state) {
+        auto result = processor.decode_sequence(frames, num_threads);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(state.iterations() * num_frames);
+    state.counters["frames_per_second"] =
+        benchmark::Counter(static_cast<double>(state.iterations()) * num_frames, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_DecodeSequence)
+    ->ArgNames({"frames", "threads"})
+    ->Args({10000, 1})
+    ->Args({10000, 2})
+    ->Args({10000, 4})
+    ->Args({10000, 8})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const fs::path assets_dir =
+        fs::temp_directory_path() / ("cued_speech_bench_" + std::to_string(std::random_device{}()));
+    try {
+        g_assets = cued_speech::generate_test_assets(assets_dir.string());
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to generate benchmark assets: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Default to a JSON report for trend tracking
+    std::vector<char*> args(argv, argv + argc);
+    std::string out_flag = "--benchmark_out=cued_speech_bench.json";
+    std::string format_flag = "--benchmark_out_format=json";
+    bool has_out = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]).rfind("--benchmark_out=", 0) == 0) {
+            has_out = true;
+        }
+    }
+    if (!has_out) {
+        args.push_back(out_flag.data());
+        args.push_back(format_flag.data());
+    }
+    int args_count = static_cast<int>(args.size());
+
+    benchmark::Initialize(&args_count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    std::error_code ec;
+    fs::remove_all(assets_dir, ec);
+    return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * Cued Speech Decoder - Daemon wire protocol
+ *
+ * Messages between cued_speech_daemon and the client library travel over a
+ * Unix domain stream socket as a fixed 16-byte header followed by a payload.
+ * Every message names a session (stream) chosen by the client, so one
+ * connection multiplexes any number of streams. Both ends are on the same
+ * host, so integers and floats are sent in host byte order.
+ *
+ * Client -> daemon             Payload
+ *   Open                       -
+ *   Close                      -
+ *   Reset                      -
+ *   SetWindowing               WindowingConfig fields (see put/get_windowing)
+ *   PushFrames                 u32 count, u8 has_mask,
+ *                              count x kFrameFeatureSize f32, [count x u8 mask]
+ *   Finalize                   -
+ *
+ * Daemon -> client
+ *   Opened                     -
+ *   Result                     i32 frame_number, f32 confidence,
+ *                              phonemes, unstable_phonemes (u32 count, strings),
+ *                              string french_sentence,
+ *                              u32 count, count x (string word, i32 start, i32 end),
+ *                              phoneme_ids, unstable_phoneme_ids (u32 count,
+ *                              count x i32)
+ *                              (flags: kResultProvisional, kResultFinal,
+ *                              kResultEndpoint)
+ *   Error                      string
+ *
+ * Results are pushed as windows become ready. The final result of a stream
+ * is the Result with kResultFinal set, sent after every earlier result.
+ * Strings are a u32 length followed by the bytes.
+ */
+
+#ifndef CUED_SPEECH_DAEMON_PROTOCOL_H
+#define CUED_SPEECH_DAEMON_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace cued_speech {
+namespace protocol {
+
+constexpr uint32_t kMagic = 0x31445343;            // "CSD1"
+constexpr uint32_t kMaxPayload = 64u << 20;        // Larger messages close the connection
+constexpr int kFeatureSize = 33;                   // Floats per frame (kFrameFeatureSize)
+
+enum class MessageType : uint16_t {
+    Open = 1,
+    Close = 2,
+    Reset = 3,
+    SetWindowing = 4,
+    PushFrames = 5,
+    Finalize = 6,
+
+    Opened = 0x81,
+    Result = 0x82,
+    Error = 0x83
+};
+
+enum ResultFlags : uint16_t {
+    kResultProvisional = 1 << 0,
+    kResultFinal = 1 << 1,
+    kResultEndpoint = 1 << 2
+};
+
+struct MessageHeader {
+    uint32_t magic;
+    uint16_t type;
+    uint16_t flags;
+    uint32_t session;
+    uint32_t length;                               // Payload bytes
+};
+static_assert(sizeof(MessageHeader) == 16, "MessageHeader must be packed");
+
+/**
+ * Windowing parameters of SetWindowing, field for field
+ */
+struct WindowingParams {
+    int32_t window_size;
+    int32_t commit_size;
+    int32_t left_context;
+    uint8_t adaptive;
+    int32_t min_commit_size;
+    int32_t max_commit_size;
+    float frame_rate;
+    float low_load;
+    float high_load;
+    int32_t provisional_interval;
+    int32_t endpoint_silence_frames;
+    float endpoint_log_prob;
+    int32_t endpoint_dropped_frames;
+    int32_t two_pass_margin;
+};
+
+/**
+ * Appends a message to a byte buffer
+ *
+ * begin() writes the header with a zero length and end() patches it, so
+ * several messages can be queued back to back in one buffer.
+ */
+class MessageWriter {
+public:
+    explicit MessageWriter(std::string& out)
+        : out_(out) {}
+
+    void begin(MessageType type, uint32_t session, uint16_t flags = 0) {
+        start_ = out_.size();
+        MessageHeader header{kMagic, static_cast<uint16_t>(type), flags, session, 0};
+        out_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    void end() {
+        const uint32_t length = static_cast<uint32_t>(out_.size() - start_ - sizeof(MessageHeader));
+        std::memcpy(&out_[start_ + offsetof(MessageHeader, length)], &length, sizeof(length));
+    }
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_arithmetic<T>::value, "put() takes numbers");
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void put_bytes(const void* data, size_t size) {
+        out_.append(static_cast<const char*>(data), size);
+    }
+
+    void put_string(std::string_view text) {
+        put(static_cast<uint32_t>(text.size()));
+        out_.append(text.data(), text.size());
+    }
+
+    void put_windowing(const WindowingParams& params) {
+        put(params.window_size);
+        put(params.commit_size);
+        put(params.left_context);
+        put(params.adaptive);
+        put(params.min_commit_size);
+        put(params.max_commit_size);
+        put(params.frame_rate);
+        put(params.low_load);
+        put(params.high_load);
+        put(params.provisional_interval);
+        put(params.endpoint_silence_frames);
+        put(params.endpoint_log_prob);
+        put(params.endpoint_dropped_frames);
+        put(params.two_pass_margin);
+    }
+
+private:
+    std::string& out_;
+    size_t start_ = 0;
+};
+
+/**
+ * Reads a payload; every get fails once the payload is exhausted
+ */
+class PayloadReader {
+public:
+    PayloadReader(const char* data, size_t size)
+        : data_(data), end_(data + size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        static_assert(std::is_arithmetic<T>::value, "get() takes numbers");
+        if (remaining() < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_, sizeof(T));
+        data_ += sizeof(T);
+        return true;
+    }
+
+    // Borrow size bytes without copying
+    const char* get_bytes(size_t size) {
+        if (remaining() < size) {
+            return nullptr;
+        }
+        const char* bytes = data_;
+        data_ += size;
+        return bytes;
+    }
+
+    bool get_string(std::string& text) {
+        uint32_t size = 0;
+        if (!get(size)) {
+            return false;
+        }
+        const char* bytes = get_bytes(size);
+        if (!bytes) {
+            return false;
+        }
+        text.assign(bytes, size);
+        return true;
+    }
+
+    bool get_windowing(WindowingParams& params) {
+        return get(params.window_size) && get(params.commit_size) && get(params.left_context) &&
+               get(params.adaptive) && get(params.min_commit_size) && get(params.max_commit_size) &&
+               get(params.frame_rate) && get(params.low_load) && get(params.high_load) &&
+               get(params.provisional_interval) && get(params.endpoint_silence_frames) &&
+               get(params.endpoint_log_prob) && get(params.endpoint_dropped_frames) &&
+               get(params.two_pass_margin);
+    }
+
+    size_t remaining() const {
+        return static_cast<size_t>(end_ - data_);
+    }
+
+private:
+    const char* data_;
+    const char* end_;
+};
+
+/**
+ * Length of the first complete message in buffer, 0 if it is incomplete,
+ * or -1 if the header is invalid
+ */
+inline long long complete_message_size(const char* buffer, size_t size, MessageHeader& header) {
+    if (size < sizeof(MessageHeader)) {
+        return 0;
+    }
+    std::memcpy(&header, buffer, sizeof(header));
+    if (header.magic != kMagic || header.length > kMaxPayload) {
+        return -1;
+    }
+    const size_t total = sizeof(MessageHeader) + header.length;
+    return size < total ? 0 : static_cast<long long>(total);
+}
+
+} // namespace protocol
+} // namespace cued_speech
+
+#endif // CUED_SPEECH_DAEMON_PROTOCOL_H
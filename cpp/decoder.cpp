@@ -3,16 +3,23 @@
  */
 
 #include "decoder.h"
+#include "beam_search.h"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
-#include <iostream>
+#include <functional>
 #include <mutex>
 #include <numeric>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <limits>
 #include <utility>
 #include <cstdio>
@@ -38,11 +45,14 @@
 namespace cued_speech {
 
 struct TFLiteSequenceModel::Impl {
-    std::unique_ptr<tflite::FlatBufferModel> model;
+    std::shared_ptr<tflite::FlatBufferModel> model;  // Read-only, shared by clones
     std::unique_ptr<tflite::Interpreter> interpreter;
     tflite::ops::builtin::BuiltinOpResolver resolver;
     std::array<int, 3> input_indices{};
     int output_index = -1;
+    std::vector<int> state_input_indices;   // Inputs other than the three feature streams
+    std::vector<int> state_output_indices;  // Update of each state input (output "<input>_out")
+    std::vector<std::vector<float>> state;  // Carried between calls (empty = zeros)
     int vocab_size = 0;
     int last_sequence_length = 0;
     bool needs_allocation = true;
@@ -52,11 +62,17 @@ struct TFLiteSequenceModel::Impl {
     bool load(const std::string& model_path) {
         std::lock_guard<std::mutex> lock(mutex);
 
+        loaded = false;
+        interpreter.reset();
         model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
         if (!model) {
             return false;
         }
+        return build_interpreter();
+    }
 
+    // Create the interpreter for model and look up its tensors
+    bool build_interpreter() {
         tflite::InterpreterBuilder builder(*model, resolver);
         builder(&interpreter);
         if (!interpreter) {
@@ -64,19 +80,73 @@ struct TFLiteSequenceModel::Impl {
             return false;
         }
 
-        if (interpreter->inputs().size() != 3) {
-            throw std::runtime_error("TFLite model must have exactly 3 inputs (lips, hand_shape, hand_pos)");
+        const std::vector<int>& inputs = interpreter->inputs();
+        const std::vector<int>& outputs = interpreter->outputs();
+        if (inputs.size() < 3) {
+            throw std::runtime_error("TFLite model must have 3 inputs (lips, hand_shape, hand_pos)");
+        }
+        if (outputs.empty()) {
+            throw std::runtime_error("TFLite model must have at least one output");
         }
 
+        const std::unordered_map<int, std::string> names = tensor_names();
+        auto find_tensor = [&names](const std::vector<int>& tensors, const std::string& name) {
+            for (const int index : tensors) {
+                const auto it = names.find(index);
+                if (it != names.end() && it->second == name) {
+                    return index;
+                }
+            }
+            return -1;
+        };
+
+        // Feature streams by name, else the first three inputs
+        const char* const kFeatureNames[] = {"lips", "hand_shape", "hand_pos"};
+        bool named_features = true;
         for (int i = 0; i < 3; ++i) {
-            input_indices[i] = interpreter->inputs()[i];
+            input_indices[i] = find_tensor(inputs, kFeatureNames[i]);
+            named_features = named_features && input_indices[i] >= 0;
+        }
+        if (!named_features) {
+            for (int i = 0; i < 3; ++i) {
+                input_indices[i] = inputs[i];
+            }
         }
 
-        if (interpreter->outputs().empty()) {
-            throw std::runtime_error("TFLite model must have at least one output");
+        // Stateful streaming variant: (lips, hand_shape, hand_pos, state...) ->
+        // (logits, state...). Converters do not keep the output order, so the
+        // update of state input X is the output named X_out.
+        output_index = find_tensor(outputs, "logits");
+        state_input_indices.clear();
+        state_output_indices.clear();
+        if (inputs.size() > 3) {
+            for (const int index : inputs) {
+                if (std::find(input_indices.begin(), input_indices.end(), index) != input_indices.end()) {
+                    continue;
+                }
+                const auto it = names.find(index);
+                const std::string name = it != names.end() ? it->second : std::string();
+                const int update = name.empty() ? -1 : find_tensor(outputs, name + "_out");
+                if (update < 0 || update == output_index) {
+                    throw std::runtime_error("State input '" + name + "' has no '" + name + "_out' output");
+                }
+                state_input_indices.push_back(index);
+                state_output_indices.push_back(update);
+            }
+        }
+
+        // Without a "logits" output, the logits are the first other output
+        for (size_t i = 0; output_index < 0 && i < outputs.size(); ++i) {
+            if (std::find(state_output_indices.begin(), state_output_indices.end(), outputs[i]) ==
+                state_output_indices.end()) {
+                output_index = outputs[i];
+            }
+        }
+        if (output_index < 0) {
+            throw std::runtime_error("TFLite model has no logits output");
         }
 
-        output_index = interpreter->outputs()[0];
+        state.clear();
         needs_allocation = true;
         vocab_size = 0;
         last_sequence_length = 0;
@@ -84,22 +154,71 @@ struct TFLiteSequenceModel::Impl {
         return true;
     }
 
-    std::vector<float> infer(const std::vector<FrameFeatures>& frames, int window_size) {
+    // Name of each input and output: its signature key when the model has a
+    // signature (converted models name tensors after graph ops), else the
+    // tensor name
+    std::unordered_map<int, std::string> tensor_names() const {
+        std::unordered_map<int, std::string> names;
+        for (const auto* tensors : {&interpreter->inputs(), &interpreter->outputs()}) {
+            for (const int index : *tensors) {
+                const TfLiteTensor* tensor = interpreter->tensor(index);
+                names[index] = tensor && tensor->name ? tensor->name : "";
+            }
+        }
+        const auto keys = interpreter->signature_keys();
+        if (!keys.empty()) {
+            for (const auto& [name, index] : interpreter->signature_inputs(keys[0]->c_str())) {
+                names[static_cast<int>(index)] = name;
+            }
+            for (const auto& [name, index] : interpreter->signature_outputs(keys[0]->c_str())) {
+                names[static_cast<int>(index)] = name;
+            }
+        }
+        return names;
+    }
+
+    LogitsView infer(const std::vector<FrameFeatures>& frames, int window_size) {
+        auto fill_input = [](float* dest, int dim, const std::vector<float>& source) {
+            for (int d = 0; d < dim; ++d) {
+                dest[d] = (d < static_cast<int>(source.size())) ? source[d] : 0.0f;
+            }
+        };
+        return infer_rows(static_cast<int>(frames.size()), window_size, nullptr,
+                          [&](int t, float* lips, float* hand_shape, float* hand_pos) {
+                              const FrameFeatures& frame = frames[t];
+                              fill_input(lips, kLipsFeatures, frame.lips);
+                              fill_input(hand_shape, kHandShapeFeatures, frame.hand_shape);
+                              fill_input(hand_pos, kHandPositionFeatures, frame.hand_position);
+                          });
+    }
+
+    LogitsView infer(const float* frames, int count, int window_size, Profiler* profiler) {
+        return infer_rows(count, window_size, profiler,
+                          [frames](int t, float* lips, float* hand_shape, float* hand_pos) {
+            const float* row = frames + static_cast<size_t>(t) * kFrameFeatureSize;
+            std::copy(row, row + kHandShapeFeatures, hand_shape);
+            row += kHandShapeFeatures;
+            std::copy(row, row + kHandPositionFeatures, hand_pos);
+            row += kHandPositionFeatures;
+            std::copy(row, row + kLipsFeatures, lips);
+        });
+    }
+
+    // Run the model on count frames, each written into the input tensors by
+    // fill(t, lips, hand_shape, hand_pos), zero-padded up to window_size
+    template <typename Fill>
+    LogitsView infer_rows(int count, int window_size, [[maybe_unused]] Profiler* profiler, Fill fill) {
         std::lock_guard<std::mutex> lock(mutex);
 
         if (!loaded || !interpreter) {
             return {};
         }
 
-        const int seq_len = window_size > 0 ? window_size : static_cast<int>(frames.size());
+        const int seq_len = window_size > 0 ? window_size : count;
         if (seq_len <= 0) {
             return {};
         }
 
-        constexpr int kLipsDim = 8;
-        constexpr int kHandShapeDim = 7;
-        constexpr int kHandPosDim = 18;
-
         auto ensure_resize = [&](int input_idx, int dim) {
             TfLiteTensor* tensor = interpreter->tensor(input_idx);
             if (!tensor || !tensor->dims || tensor->dims->size != 3 || tensor->dims->data[1] != seq_len) {
@@ -108,9 +227,9 @@ struct TFLiteSequenceModel::Impl {
             }
         };
 
-        ensure_resize(input_indices[0], kLipsDim);
-        ensure_resize(input_indices[1], kHandShapeDim);
-        ensure_resize(input_indices[2], kHandPosDim);
+        ensure_resize(input_indices[0], kLipsFeatures);
+        ensure_resize(input_indices[1], kHandShapeFeatures);
+        ensure_resize(input_indices[2], kHandPositionFeatures);
 
         if (needs_allocation) {
             if (interpreter->AllocateTensors() != kTfLiteOk) {
@@ -119,33 +238,47 @@ struct TFLiteSequenceModel::Impl {
             needs_allocation = false;
         }
 
-        auto fill_input = [](float* dest, int dim, const std::vector<float>& source, int t) {
-            for (int d = 0; d < dim; ++d) {
-                float value = (d < static_cast<int>(source.size())) ? source[d] : 0.0f;
-                dest[t * dim + d] = value;
-            }
-        };
-
-        float* lips_input = interpreter->typed_input_tensor<float>(input_indices[0]);
-        float* hand_shape_input = interpreter->typed_input_tensor<float>(input_indices[1]);
-        float* hand_pos_input = interpreter->typed_input_tensor<float>(input_indices[2]);
+        float* lips_input = interpreter->typed_tensor<float>(input_indices[0]);
+        float* hand_shape_input = interpreter->typed_tensor<float>(input_indices[1]);
+        float* hand_pos_input = interpreter->typed_tensor<float>(input_indices[2]);
 
-        const FrameFeatures zero_frame{
-            std::vector<float>(kHandShapeDim, 0.0f),
-            std::vector<float>(kHandPosDim, 0.0f),
-            std::vector<float>(kLipsDim, 0.0f)
-        };
+        {
+            CUED_SPEECH_PROFILE_SCOPE(profiler, ProfileStage::WindowAssembly);
+            const int filled = std::min(count, seq_len);
+            for (int t = 0; t < filled; ++t) {
+                fill(t, lips_input + t * kLipsFeatures, hand_shape_input + t * kHandShapeFeatures,
+                     hand_pos_input + t * kHandPositionFeatures);
+            }
+            std::fill(lips_input + filled * kLipsFeatures, lips_input + seq_len * kLipsFeatures, 0.0f);
+            std::fill(hand_shape_input + filled * kHandShapeFeatures,
+                      hand_shape_input + seq_len * kHandShapeFeatures, 0.0f);
+            std::fill(hand_pos_input + filled * kHandPositionFeatures,
+                      hand_pos_input + seq_len * kHandPositionFeatures, 0.0f);
+        }
 
-        for (int t = 0; t < seq_len; ++t) {
-            const FrameFeatures& frame = (t < static_cast<int>(frames.size())) ? frames[t] : zero_frame;
+        state.resize(state_input_indices.size());
+        for (size_t i = 0; i < state_input_indices.size(); ++i) {
+            TfLiteTensor* tensor = interpreter->tensor(state_input_indices[i]);
+            float* dest = interpreter->typed_tensor<float>(state_input_indices[i]);
+            const size_t count = tensor->bytes / sizeof(float);
+            if (state[i].size() == count) {
+                std::copy(state[i].begin(), state[i].end(), dest);
+            } else {
+                std::fill(dest, dest + count, 0.0f);
+            }
+        }
 
-            fill_input(lips_input, kLipsDim, frame.lips, t);
-            fill_input(hand_shape_input, kHandShapeDim, frame.hand_shape, t);
-            fill_input(hand_pos_input, kHandPosDim, frame.hand_position, t);
+        {
+            CUED_SPEECH_PROFILE_SCOPE(profiler, ProfileStage::ModelInvoke);
+            if (interpreter->Invoke() != kTfLiteOk) {
+                throw std::runtime_error("Failed to invoke TFLite model");
+            }
         }
 
-        if (interpreter->Invoke() != kTfLiteOk) {
-            throw std::runtime_error("Failed to invoke TFLite model");
+        for (size_t i = 0; i < state_output_indices.size(); ++i) {
+            TfLiteTensor* tensor = interpreter->tensor(state_output_indices[i]);
+            const float* src = interpreter->typed_tensor<float>(state_output_indices[i]);
+            state[i].assign(src, src + tensor->bytes / sizeof(float));
         }
 
         TfLiteTensor* output = interpreter->tensor(output_index);
@@ -160,16 +293,21 @@ struct TFLiteSequenceModel::Impl {
             return {};
         }
 
-        const float* output_data = interpreter->typed_output_tensor<float>(0);
-        return std::vector<float>(
-            output_data,
-            output_data + static_cast<size_t>(last_sequence_length) * vocab_size
-        );
+        LogitsView view;
+        view.data = interpreter->typed_tensor<float>(output_index);
+        view.frames = last_sequence_length;
+        view.vocab = vocab_size;
+        return view;
     }
 
     bool is_loaded() const {
         return loaded && interpreter != nullptr;
     }
+
+    void reset_state() {
+        std::lock_guard<std::mutex> lock(mutex);
+        state.clear();
+    }
 };
 
 TFLiteSequenceModel::TFLiteSequenceModel()
@@ -181,8 +319,34 @@ bool TFLiteSequenceModel::load(const std::string& model_path) {
     return impl_ ? impl_->load(model_path) : false;
 }
 
+std::unique_ptr<TFLiteSequenceModel> TFLiteSequenceModel::clone() const {
+    auto copy = std::make_unique<TFLiteSequenceModel>();
+    if (!impl_) {
+        return copy;
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (impl_->loaded && impl_->model) {
+        copy->impl_->model = impl_->model;
+        copy->impl_->build_interpreter();
+    }
+    return copy;
+}
+
 std::vector<float> TFLiteSequenceModel::infer(const std::vector<FrameFeatures>& frames, int window_size) {
-    return impl_ ? impl_->infer(frames, window_size) : std::vector<float>{};
+    LogitsView view = infer_view(frames, window_size);
+    if (view.empty()) {
+        return {};
+    }
+    return std::vector<float>(view.data, view.data + static_cast<size_t>(view.frames) * view.vocab);
+}
+
+LogitsView TFLiteSequenceModel::infer_view(const std::vector<FrameFeatures>& frames, int window_size) {
+    return impl_ ? impl_->infer(frames, window_size) : LogitsView{};
+}
+
+LogitsView TFLiteSequenceModel::infer_view(const float* frames, int count, int window_size, Profiler* profiler) {
+    return impl_ ? impl_->infer(frames, count, window_size, profiler) : LogitsView{};
 }
 
 int TFLiteSequenceModel::vocab_size() const {
@@ -197,6 +361,16 @@ bool TFLiteSequenceModel::is_loaded() const {
     return impl_ ? impl_->is_loaded() : false;
 }
 
+bool TFLiteSequenceModel::is_stateful() const {
+    return impl_ ? !impl_->state_input_indices.empty() : false;
+}
+
+void TFLiteSequenceModel::reset_state() {
+    if (impl_) {
+        impl_->reset_state();
+    }
+}
+
 // Phoneme mappings
 const std::map<std::string, std::string> IPA_TO_LIAPHON = {
     {"a", "a"}, {"ə", "x"}, {"ɛ", "e^"}, {"œ", "x^"},
@@ -251,75 +425,93 @@ std::vector<std::string> ipa_to_liaphon(const std::string& ipa) {
 // CTCDecoder Implementation
 //=============================================================================
 
+/**
+ * Lexicon beam search that expands a different number of tokens per frame
+ *
+ * LexiconDecoder expands the beamSizeToken best tokens of every frame. Runs
+ * of frames with the same candidate count are stepped through together with
+ * beamSizeToken set to that count.
+ */
+class TokenPrunedDecoder : public fl::lib::text::LexiconDecoder {
+public:
+    using LexiconDecoder::LexiconDecoder;
+
+    std::vector<fl::lib::text::DecodeResult> decode_pruned(const float* emissions, int T, int N,
+                                                           const int* candidates) {
+        const int beam_size_token = opt_.beamSizeToken;
+        decodeBegin();
+        for (int t = 0; t < T;) {
+            int end = t + 1;
+            while (end < T && candidates[end] == candidates[t]) {
+                ++end;
+            }
+            opt_.beamSizeToken = std::max(1, std::min(candidates[t], beam_size_token));
+            decodeStep(emissions + static_cast<size_t>(t) * N, end - t, N);
+            t = end;
+        }
+        opt_.beamSizeToken = beam_size_token;
+        decodeEnd();
+        return getAllFinalHypothesis();
+    }
+};
+
 CTCDecoder::CTCDecoder(const DecoderConfig& config)
     : config_(config), blank_idx_(-1), sil_idx_(-1), unk_idx_(-1) {}
 
 CTCDecoder::~CTCDecoder() = default;
 
 bool CTCDecoder::initialize() {
-    std::cout << "Initializing CTC Decoder..." << std::endl;
+    CUED_SPEECH_LOG(LogLevel::Info, "decoder", "Initializing CTC decoder");
     
     // Load tokens
     if (!load_tokens()) {
-        std::cerr << "Failed to load tokens" << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Failed to load tokens");
         return false;
     }
     
     // Load lexicon
     if (!config_.lexicon_path.empty() && !load_lexicon()) {
-        std::cerr << "Failed to load lexicon" << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Failed to load lexicon");
         return false;
     }
     
     // Load language model
     if (!config_.lm_path.empty() && !load_lm()) {
-        std::cerr << "Failed to load language model" << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Failed to load language model");
         return false;
     }
     
     // Build trie for lexicon-based decoding
     if (!config_.lexicon_path.empty() && !build_trie()) {
-        std::cerr << "Failed to build trie" << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Failed to build trie");
         return false;
     }
     
     // Create decoder
-    using namespace fl::lib::text;
-    
-    if (!config_.lexicon_path.empty()) {
-        // Lexicon-based decoder
-        LexiconDecoderOptions options;
-        options.beamSize = config_.beam_size;
-        options.beamSizeToken = (config_.beam_size_token > 0) 
-            ? config_.beam_size_token 
-            : tokens_dict_->indexSize();
-        options.beamThreshold = config_.beam_threshold;
-        options.lmWeight = config_.lm_weight;
-        options.wordScore = config_.word_score;
-        options.unkScore = config_.unk_score;
-        options.silScore = config_.sil_score;
-        options.logAdd = config_.log_add;
-        options.criterionType = CriterionType::CTC;
-        
-        // Create KenLM wrapper
-        auto lm = std::make_shared<KenLM>(config_.lm_path, *word_dict_);
-
-        lexicon_decoder_ = std::make_unique<LexiconDecoder>(
-            options,
-            trie_,
-            lm,
-            sil_idx_,
-            blank_idx_,
-            unk_idx_,
-            std::vector<float>(),  // transitions (empty for CTC)
-            false  // isLabelUnitToken
-        );
+    if (!config_.lexicon_path.empty() && config_.engine == DecoderEngine::Native) {
+        // Native beam search over a flattened copy of the trie
+        native_lm_ = std::make_shared<WordLM>(config_.lm_path, *word_dict_);
+        native_trie_ = LexiconTrie::from_flashlight(*trie_->getRoot(), tokens_dict_->indexSize());
+
+        std::lock_guard<std::mutex> lock(lexicon_pool_mutex_);
+        native_pool_.clear();
+        native_pool_.push_back(create_native_search());
+    } else if (!config_.lexicon_path.empty()) {
+        // Lexicon-based decoder; the KenLM wrapper is shared by every
+        // pooled beam search
+        word_lm_ = std::make_shared<fl::lib::text::KenLM>(config_.lm_path, *word_dict_);
+
+        std::lock_guard<std::mutex> lock(lexicon_pool_mutex_);
+        lexicon_pool_.clear();
+        lexicon_pool_.push_back(create_lexicon_decoder());
     }
     
-    std::cout << "CTC Decoder initialized successfully!" << std::endl;
-    std::cout << "  Vocabulary size: " << get_vocab_size() << std::endl;
-    std::cout << "  Blank index: " << blank_idx_ << std::endl;
-    std::cout << "  Silence index: " << sil_idx_ << std::endl;
+    if (log_enabled(LogLevel::Info)) {
+        log_message(LogLevel::Info, "decoder", "CTC decoder initialized",
+                    {{"vocab_size", get_vocab_size()},
+                     {"blank_idx", blank_idx_},
+                     {"sil_idx", sil_idx_}});
+    }
     
     return true;
 }
@@ -328,8 +520,8 @@ bool CTCDecoder::load_tokens() {
     try {
         std::ifstream vocab_stream(config_.tokens_path);
         if (!vocab_stream.is_open()) {
-            std::cerr << "Error loading tokens: unable to open file "
-                      << config_.tokens_path << std::endl;
+            CUED_SPEECH_LOG(LogLevel::Error, "decoder",
+                            "Error loading tokens: unable to open file " << config_.tokens_path);
             return false;
         }
 
@@ -383,11 +575,34 @@ bool CTCDecoder::load_tokens() {
 
         tokens_dict_ = std::make_unique<fl::lib::text::Dictionary>(vocabulary);
         
-        // Build token mappings
-        for (int i = 0; i < tokens_dict_->indexSize(); ++i) {
-            std::string token = tokens_dict_->getEntry(i);
-            token_to_index_[token] = i;
-            index_to_token_[i] = token;
+        // Build token mappings: one buffer for all token strings (each
+        // NUL-terminated), then dense views and flags indexed by token ID
+        size_t total_chars = 0;
+        for (const auto& token : vocabulary) {
+            total_chars += token.size() + 1;
+        }
+        token_chars_.assign(total_chars, '\0');
+        index_to_token_.clear();
+        index_to_token_.reserve(vocabulary.size());
+        token_flags_.assign(vocabulary.size(), 0);
+        token_to_index_.clear();
+        token_to_index_.reserve(vocabulary.size());
+
+        size_t offset = 0;
+        for (size_t i = 0; i < vocabulary.size(); ++i) {
+            const std::string& token = vocabulary[i];
+            std::copy(token.begin(), token.end(), token_chars_.begin() + offset);
+            const std::string_view view(token_chars_.data() + offset, token.size());
+            offset += token.size() + 1;
+
+            index_to_token_.push_back(view);
+            token_to_index_.emplace(view, static_cast<int>(i));
+            if (token == "<BLANK>" || token == "<PAD>" || token == "<SOS>" || token == "<EOS>") {
+                token_flags_[i] |= kTokenDropped;
+            }
+            if (token == "_") {
+                token_flags_[i] |= kTokenSilence;
+            }
         }
         
         // Get special token indices
@@ -401,13 +616,13 @@ bool CTCDecoder::load_tokens() {
         }
         
         if (blank_idx_ < 0) {
-            std::cerr << "Warning: Blank token '" << config_.blank_token 
-                     << "' not found in vocabulary" << std::endl;
+            CUED_SPEECH_LOG(LogLevel::Warn, "decoder",
+                            "Blank token '" << config_.blank_token << "' not found in vocabulary");
         }
         
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error loading tokens: " << e.what() << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Error loading tokens: " << e.what());
         return false;
     }
 }
@@ -420,11 +635,11 @@ bool CTCDecoder::load_lexicon() {
             fl::lib::text::createWordDict(lexicon)
         );
         
-        std::cout << "Loaded lexicon with " << word_dict_->indexSize() 
-                 << " words" << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Info, "decoder",
+                        "Loaded lexicon with " << word_dict_->indexSize() << " words");
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error loading lexicon: " << e.what() << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Error loading lexicon: " << e.what());
         return false;
     }
 }
@@ -435,14 +650,14 @@ bool CTCDecoder::load_lm() {
         // We just verify the file exists
         std::ifstream lm_file(config_.lm_path);
         if (!lm_file.good()) {
-            std::cerr << "LM file not found: " << config_.lm_path << std::endl;
+            CUED_SPEECH_LOG(LogLevel::Error, "decoder", "LM file not found: " << config_.lm_path);
             return false;
         }
         
-        std::cout << "Language model file found: " << config_.lm_path << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Info, "decoder", "Language model file found: " << config_.lm_path);
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error loading LM: " << e.what() << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Error loading LM: " << e.what());
         return false;
     }
 }
@@ -471,8 +686,8 @@ bool CTCDecoder::build_trie() {
                 for (const auto& token : spelling) {
                     int token_idx = tokens_dict_->getIndex(token);
                     if (token_idx < 0) {
-                        std::cerr << "Lexicon token '" << token
-                                  << "' not found in vocabulary" << std::endl;
+                        CUED_SPEECH_LOG(LogLevel::Warn, "decoder",
+                                        "Lexicon token '" << token << "' not found in vocabulary");
                         spelling_idxs.clear();
                         break;
                     }
@@ -487,14 +702,37 @@ bool CTCDecoder::build_trie() {
         // Smear the trie
         trie_->smear(SmearingMode::MAX);
         
-        std::cout << "Trie built successfully" << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Info, "decoder", "Trie built successfully");
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error building trie: " << e.what() << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Error building trie: " << e.what());
         return false;
     }
 }
 
+namespace {
+
+/**
+ * Fewest of the limit largest values (scratch is reordered) whose weights
+ * add up to target, at most limit
+ *
+ * One partial sort per row: O(V log limit) instead of a scan per candidate.
+ */
+template <typename Weight>
+int count_covering(std::vector<float>& scratch, float target, int limit, Weight weight) {
+    std::partial_sort(scratch.begin(), scratch.begin() + limit, scratch.end(), std::greater<float>());
+    float covered = 0.0f;
+    for (int count = 1; count < limit; ++count) {
+        covered += weight(scratch[count - 1]);
+        if (covered >= target) {
+            return count;
+        }
+    }
+    return limit;
+}
+
+} // namespace
+
 void CTCDecoder::log_softmax(const float* logits, float* log_probs, int T, int V) {
     for (int t = 0; t < T; ++t) {
         const float* logit_row = logits + t * V;
@@ -518,36 +756,338 @@ void CTCDecoder::log_softmax(const float* logits, float* log_probs, int T, int V
     }
 }
 
+void CTCDecoder::log_softmax(const float* logits, float* log_probs, int T, int V,
+                             float mass, int max_candidates, int* candidates) {
+    const int limit = std::max(1, std::min(max_candidates, V));
+    std::vector<float> exps(V);
+    for (int t = 0; t < T; ++t) {
+        const float* logit_row = logits + t * V;
+        float* log_prob_row = log_probs + t * V;
+
+        float max_logit = *std::max_element(logit_row, logit_row + V);
+
+        float sum_exp = 0.0f;
+        for (int v = 0; v < V; ++v) {
+            exps[v] = std::exp(logit_row[v] - max_logit);
+            sum_exp += exps[v];
+        }
+
+        // Counted on the softmax exponentials themselves
+        candidates[t] = count_covering(exps, mass * sum_exp, limit, [](float e) { return e; });
+
+        float log_sum = std::log(sum_exp);
+        for (int v = 0; v < V; ++v) {
+            log_prob_row[v] = logit_row[v] - max_logit - log_sum;
+        }
+    }
+}
+
+void CTCDecoder::count_token_candidates(const float* log_probs, int T, int V, int* candidates) const {
+    const int limit = std::max(1, max_token_candidates(V));
+    const float mass = config_.token_mass;
+    std::vector<float> row(V);
+    for (int t = 0; t < T; ++t) {
+        const float* log_prob_row = log_probs + static_cast<size_t>(t) * V;
+        // Sorting in log space keeps the order; only the covering prefix is
+        // exponentiated
+        std::copy(log_prob_row, log_prob_row + V, row.begin());
+        candidates[t] = count_covering(row, mass, limit, [](float log_prob) { return std::exp(log_prob); });
+    }
+}
+
+int CTCDecoder::max_token_candidates(int V) const {
+    return config_.beam_size_token > 0 ? std::min(config_.beam_size_token, V) : V;
+}
+
 std::vector<CTCHypothesis> CTCDecoder::decode(const float* logits, int T, int V) {
     // Apply log softmax
     std::vector<float> log_probs(T * V);
+    if (config_.token_mass < 1.0f) {
+        std::vector<int> candidates(T);
+        log_softmax(logits, log_probs.data(), T, V, config_.token_mass, max_token_candidates(V), candidates.data());
+        return decode_log_probs(log_probs.data(), T, V, candidates.data());
+    }
     log_softmax(logits, log_probs.data(), T, V);
     
     return decode_log_probs(log_probs.data(), T, V);
 }
 
-std::vector<CTCHypothesis> CTCDecoder::decode_log_probs(const float* log_probs, int T, int V) {
+std::unique_ptr<TokenPrunedDecoder> CTCDecoder::create_lexicon_decoder() const {
+    using namespace fl::lib::text;
+
+    LexiconDecoderOptions options;
+    options.beamSize = config_.beam_size;
+    options.beamSizeToken = (config_.beam_size_token > 0) 
+        ? config_.beam_size_token 
+        : tokens_dict_->indexSize();
+    options.beamThreshold = config_.beam_threshold;
+    options.lmWeight = config_.lm_weight;
+    options.wordScore = config_.word_score;
+    options.unkScore = config_.unk_score;
+    options.silScore = config_.sil_score;
+    options.logAdd = config_.log_add;
+    options.criterionType = CriterionType::CTC;
+
+    return std::make_unique<TokenPrunedDecoder>(
+        options,
+        trie_,
+        word_lm_,
+        sil_idx_,
+        blank_idx_,
+        unk_idx_,
+        std::vector<float>(),  // transitions (empty for CTC)
+        false  // isLabelUnitToken
+    );
+}
+
+std::unique_ptr<LexiconBeamSearch> CTCDecoder::create_native_search() const {
+    BeamSearchOptions options;
+    options.beam_size = config_.beam_size;
+    options.beam_size_token = (config_.beam_size_token > 0)
+        ? config_.beam_size_token
+        : tokens_dict_->indexSize();
+    options.beam_threshold = config_.beam_threshold;
+    options.lm_weight = config_.lm_weight;
+    options.word_score = config_.word_score;
+    options.unk_score = config_.unk_score;
+    options.sil_score = config_.sil_score;
+    options.log_add = config_.log_add;
+    options.sil_idx = sil_idx_;
+    options.blank_idx = blank_idx_;
+    options.unk_idx = unk_idx_;
+
+    return std::make_unique<LexiconBeamSearch>(options, native_trie_, native_lm_);
+}
+
+int CTCDecoder::skip_blank_frames(const float* log_probs, int T, int V,
+                                  std::vector<float>& reduced, std::vector<int>& frame_map) const {
+    reduced.clear();
+    frame_map.clear();
+    if (blank_idx_ < 0 || blank_idx_ >= V || T <= 0) {
+        return T;
+    }
+
+    const float threshold = config_.blank_skip_threshold;
+    frame_map.reserve(T);
+    bool in_run = false;
+    for (int t = 0; t < T; ++t) {
+        const bool blank = log_probs[static_cast<size_t>(t) * V + blank_idx_] > threshold;
+        if (!blank || !in_run) {
+            frame_map.push_back(t);
+        }
+        in_run = blank;
+    }
+
+    const int kept = static_cast<int>(frame_map.size());
+    if (kept == T) {
+        frame_map.clear();
+        return T;
+    }
+
+    reduced.resize(static_cast<size_t>(kept) * V);
+    for (int i = 0; i < kept; ++i) {
+        const float* row = log_probs + static_cast<size_t>(frame_map[i]) * V;
+        std::copy(row, row + V, reduced.begin() + static_cast<size_t>(i) * V);
+    }
+    return kept;
+}
+
+float CTCDecoder::silence_log_prob(const float* row, int V) const {
+    const float neg_inf = -std::numeric_limits<float>::infinity();
+    const float blank = blank_idx_ >= 0 && blank_idx_ < V ? row[blank_idx_] : neg_inf;
+    const float sil = sil_idx_ >= 0 && sil_idx_ < V ? row[sil_idx_] : neg_inf;
+    const float high = std::max(blank, sil);
+    if (high == neg_inf) {
+        return neg_inf;
+    }
+    return high + std::log1p(std::exp(std::min(blank, sil) - high));
+}
+
+std::vector<int> CTCDecoder::find_segments(const float* log_probs, int T, int V) const {
+    std::vector<int> bounds = {0};
+    const int min_frames = config_.segment_frames;
+    const int min_run = std::max(1, config_.segment_silence_frames);
+    if (min_frames > 0) {
+        // Cut in the middle of each long enough silent run; a run that
+        // reaches the end is trailing silence and is never cut
+        int run_start = -1;
+        for (int t = 0; t < T; ++t) {
+            if (silence_log_prob(log_probs + static_cast<size_t>(t) * V, V) > config_.segment_log_prob) {
+                if (run_start < 0) {
+                    run_start = t;
+                }
+                continue;
+            }
+            if (run_start >= 0 && t - run_start >= min_run) {
+                const int cut = run_start + (t - run_start) / 2;
+                if (cut - bounds.back() >= min_frames) {
+                    bounds.push_back(cut);
+                }
+            }
+            run_start = -1;
+        }
+    }
+    bounds.push_back(T);
+    return bounds;
+}
+
+namespace {
+
+/**
+ * Append the words, word frames, timesteps and score of a hypothesis whose
+ * frames start at first_frame (the caller splices the tokens)
+ */
+void append_hypothesis(CTCHypothesis& into, const CTCHypothesis& part, int first_frame) {
+    into.words.insert(into.words.end(), part.words.begin(), part.words.end());
+    for (const int frame : part.word_start_frames) {
+        into.word_start_frames.push_back(first_frame + frame);
+    }
+    for (const int frame : part.word_end_frames) {
+        into.word_end_frames.push_back(first_frame + frame);
+    }
+    for (const int step : part.timesteps) {
+        into.timesteps.push_back(first_frame + step);
+    }
+    into.score += part.score;
+}
+
+/**
+ * Stretch a beam search path over kept rows back to the original T frames
+ *
+ * Paths have a start and an end step around the frames. Each kept row stands
+ * for the frames up to the next kept row, and repeating its token over them
+ * leaves the collapsed path unchanged; a word stays on the first of them.
+ */
+void expand_path(std::vector<int>& tokens, std::vector<int>& words,
+                 const std::vector<int>& frame_map, int T) {
+    const size_t kept = frame_map.size();
+    if (tokens.size() != kept + 2 || words.size() != kept + 2) {
+        return;
+    }
+
+    std::vector<int> full_tokens(static_cast<size_t>(T) + 2);
+    std::vector<int> full_words(static_cast<size_t>(T) + 2, -1);
+    full_tokens.front() = tokens.front();
+    full_words.front() = words.front();
+    for (size_t i = 0; i < kept; ++i) {
+        const int first = frame_map[i];
+        const int last = i + 1 < kept ? frame_map[i + 1] : T;
+        std::fill(full_tokens.begin() + first + 1, full_tokens.begin() + last + 1, tokens[i + 1]);
+        full_words[first + 1] = words[i + 1];
+    }
+    full_tokens.back() = tokens.back();
+    full_words.back() = words.back();
+
+    tokens.swap(full_tokens);
+    words.swap(full_words);
+}
+
+/**
+ * Take an idle beam search from pool, or nullptr if all are in use
+ */
+template <typename Search>
+std::unique_ptr<Search> borrow_search(std::mutex& mutex, std::vector<std::unique_ptr<Search>>& pool) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pool.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<Search> search = std::move(pool.back());
+    pool.pop_back();
+    return search;
+}
+
+template <typename Search>
+void return_search(std::mutex& mutex, std::vector<std::unique_ptr<Search>>& pool,
+                   std::unique_ptr<Search> search) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pool.push_back(std::move(search));
+}
+
+} // namespace
+
+std::vector<CTCHypothesis> CTCDecoder::decode_log_probs(const float* log_probs, int T, int V,
+                                                        const int* candidates) {
     std::vector<CTCHypothesis> results;
     
-    if (!lexicon_decoder_) {
-        std::cerr << "Decoder not initialized" << std::endl;
+    if (!word_lm_ && !native_lm_) {
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Decoder not initialized");
         return results;
     }
     
     try {
-        // Run decoder
-        auto decoder_results = lexicon_decoder_->decode(log_probs, T, V);
+        // Search only the frames that are not blank-dominated
+        std::vector<float> reduced;
+        std::vector<int> frame_map;
+        const int kept = config_.blank_skip_threshold < 0.0f
+            ? skip_blank_frames(log_probs, T, V, reduced, frame_map)
+            : T;
+        const float* rows = kept < T ? reduced.data() : log_probs;
+
+        // Per-frame token candidates, following the kept rows
+        std::vector<int> row_candidates;
+        if (config_.token_mass < 1.0f) {
+            if (!candidates) {
+                row_candidates.resize(T);
+                count_token_candidates(log_probs, T, V, row_candidates.data());
+                candidates = row_candidates.data();
+            }
+            if (kept < T) {
+                std::vector<int> kept_candidates(kept);
+                for (int i = 0; i < kept; ++i) {
+                    kept_candidates[i] = candidates[frame_map[i]];
+                }
+                row_candidates.swap(kept_candidates);
+                candidates = row_candidates.data();
+            }
+        }
+
+        // Run decoder on an idle beam search, creating one when all are in use
+        std::vector<fl::lib::text::DecodeResult> decoder_results;
+        if (native_lm_) {
+            auto search = borrow_search(lexicon_pool_mutex_, native_pool_);
+            if (!search) {
+                search = create_native_search();
+            }
+            decoder_results = search->decode(rows, kept, V, config_.token_mass < 1.0f ? candidates : nullptr);
+            return_search(lexicon_pool_mutex_, native_pool_, std::move(search));
+        } else {
+            auto lexicon_decoder = borrow_search(lexicon_pool_mutex_, lexicon_pool_);
+            if (!lexicon_decoder) {
+                lexicon_decoder = create_lexicon_decoder();
+            }
+            decoder_results = config_.token_mass < 1.0f
+                ? lexicon_decoder->decode_pruned(rows, kept, V, candidates)
+                : lexicon_decoder->decode(rows, kept, V);
+            return_search(lexicon_pool_mutex_, lexicon_pool_, std::move(lexicon_decoder));
+        }
         
         // Convert results to our format
-        for (const auto& result : decoder_results) {
+        for (auto& result : decoder_results) {
+            if (kept < T) {
+                expand_path(result.tokens, result.words, frame_map, T);
+            }
+
             CTCHypothesis hyp;
             hyp.tokens = result.tokens;
             hyp.score = result.score;
             
-            // Convert word indices to strings
-            for (int word_idx : result.words) {
+            // Convert word indices to strings. Position i of the path is
+            // frame i - 1 (position 0 is the start state, the last one the
+            // end-of-sentence step).
+            int span_start = -1;
+            for (size_t i = 0; i < result.words.size(); ++i) {
+                const int frame = std::max(0, std::min(static_cast<int>(i) - 1, T - 1));
+                const int token = i < result.tokens.size() ? result.tokens[i] : -1;
+                if (span_start < 0 && token >= 0 && token != blank_idx_ && token != sil_idx_) {
+                    span_start = frame;
+                }
+
+                const int word_idx = result.words[i];
                 if (word_idx >= 0 && word_idx < static_cast<int>(word_dict_->indexSize())) {
                     hyp.words.push_back(word_dict_->getEntry(word_idx));
+                    hyp.word_start_frames.push_back(span_start >= 0 ? span_start : frame);
+                    hyp.word_end_frames.push_back(frame);
+                    span_start = -1;
                 }
             }
             
@@ -558,51 +1098,152 @@ std::vector<CTCHypothesis> CTCDecoder::decode_log_probs(const float* log_probs,
             }
         }
     } catch (const std::exception& e) {
-        std::cerr << "Decoding error: " << e.what() << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "decoder", "Decoding error: " << e.what());
     }
     
     return results;
 }
 
-std::vector<std::string> CTCDecoder::idxs_to_tokens(const std::vector<int>& indices) {
-    std::vector<std::string> tokens;
-    tokens.reserve(indices.size());
+std::vector<std::string> CTCDecoder::idxs_to_tokens(const std::vector<int>& indices) const {
+    std::vector<int> collapsed;
+    collapse_tokens(indices, collapsed);
 
-    for (int idx : indices) {
-        tokens.push_back(idx_to_token(idx));
+    std::vector<std::string> tokens;
+    tokens.reserve(collapsed.size());
+    for (int idx : collapsed) {
+        tokens.emplace_back(index_to_token_[idx]);
     }
+    return tokens;
+}
 
-    if (tokens.size() >= 2) {
-        tokens.erase(tokens.begin());
-        tokens.pop_back();
+void CTCDecoder::collapse_tokens(const std::vector<int>& indices, std::vector<int>& out) const {
+    out.clear();
+
+    // The first and last steps are the decoder's start and end states
+    size_t begin = 0;
+    size_t end = indices.size();
+    if (end >= 2) {
+        ++begin;
+        --end;
     }
 
-    std::vector<std::string> filtered;
-    filtered.reserve(tokens.size());
-    for (const auto& token : tokens) {
-        if (token.empty()) {
+    const uint8_t* flags = token_flags_.data();
+    const size_t vocab_size = token_flags_.size();
+    for (size_t i = begin; i < end; ++i) {
+        const int idx = indices[i];
+        if (static_cast<size_t>(idx) >= vocab_size || (flags[idx] & kTokenDropped)) {
             continue;
         }
-        if (token == "<BLANK>" || token == "<PAD>" ||
-            token == "<SOS>" || token == "<EOS>") {
-            continue;
+        // Repeats merge across dropped tokens, as in the string pipeline
+        if (out.empty() || out.back() != idx) {
+            out.push_back(idx);
         }
-        filtered.push_back(token);
     }
 
-    std::vector<std::string> deduped;
-    deduped.reserve(filtered.size());
-    for (const auto& token : filtered) {
-        if (deduped.empty() || deduped.back() != token) {
-            deduped.push_back(token);
-        }
+    while (!out.empty() && (flags[out.back()] & kTokenSilence)) {
+        out.pop_back();
     }
+}
+
+std::vector<int> CTCDecoder::collapse_tokens(const std::vector<int>& indices) const {
+    std::vector<int> collapsed;
+    collapse_tokens(indices, collapsed);
+    return collapsed;
+}
 
-    while (!deduped.empty() && deduped.back() == "_") {
-        deduped.pop_back();
+std::vector<CTCHypothesis> CTCDecoder::decode_segmented(const float* log_probs, int T, int V,
+                                                        int num_threads, const int* candidates) {
+    const std::vector<int> bounds = find_segments(log_probs, T, V);
+    const size_t num_segments = bounds.size() - 1;
+    if (num_segments <= 1) {
+        return decode_log_probs(log_probs, T, V, candidates);
+    }
+
+    // Segments only share the pooled beam searches, so they decode in any
+    // order; longest first keeps the threads evenly loaded
+    std::vector<size_t> order(num_segments);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&bounds](size_t a, size_t b) {
+        return bounds[a + 1] - bounds[a] > bounds[b + 1] - bounds[b];
+    });
+
+    std::vector<std::vector<CTCHypothesis>> segment_results(num_segments);
+    std::atomic<size_t> next_segment{0};
+    auto decode_segments = [&] {
+        for (size_t n = next_segment++; n < num_segments; n = next_segment++) {
+            const size_t i = order[n];
+            const int start = bounds[i];
+            segment_results[i] = decode_log_probs(log_probs + static_cast<size_t>(start) * V,
+                                                  bounds[i + 1] - start, V,
+                                                  candidates ? candidates + start : nullptr);
+        }
+    };
+
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    const size_t workers = std::min(num_segments, static_cast<size_t>(num_threads));
+    std::vector<std::exception_ptr> errors(workers);
+    auto worker = [&](size_t w) {
+        try {
+            decode_segments();
+        } catch (...) {
+            errors[w] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t w = 1; w < workers; ++w) {
+        try {
+            threads.emplace_back(worker, w);
+        } catch (const std::system_error& e) {
+            // The started workers and this thread take the remaining segments
+            CUED_SPEECH_LOG(LogLevel::Warn, "decoder",
+                            "Could not start worker thread " << w << ": " << e.what());
+            break;
+        }
     }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    CUED_SPEECH_LOG(LogLevel::Debug, "decoder",
+                    "Decoded " << T << " frames in " << num_segments << " segments on " << threads.size() + 1
+                               << " threads");
+
+    // Stitch the best paths. Each path is [start, frames..., end]: keep the
+    // first start and the last end.
+    CTCHypothesis stitched;
+    stitched.score = 0.0f;
+    stitched.tokens.reserve(static_cast<size_t>(T) + 2);
+    for (size_t i = 0; i < num_segments; ++i) {
+        const int start = bounds[i];
+        const int frames = bounds[i + 1] - start;
+        if (segment_results[i].empty() ||
+            segment_results[i][0].tokens.size() != static_cast<size_t>(frames) + 2) {
+            CUED_SPEECH_LOG(LogLevel::Error, "decoder",
+                            "Segment " << i << " (frames " << start << "-" << start + frames - 1
+                            << ") failed to decode");
+            return {};
+        }
 
-    return deduped;
+        const CTCHypothesis& part = segment_results[i][0];
+        if (i == 0) {
+            stitched.tokens.push_back(part.tokens.front());
+        }
+        stitched.tokens.insert(stitched.tokens.end(), part.tokens.begin() + 1, part.tokens.end() - 1);
+        if (i + 1 == num_segments) {
+            stitched.tokens.push_back(part.tokens.back());
+        }
+        append_hypothesis(stitched, part, start);
+    }
+    return {std::move(stitched)};
 }
 
 int CTCDecoder::get_vocab_size() const {
@@ -618,18 +1259,29 @@ int CTCDecoder::token_to_idx(const std::string& token) const {
 }
 
 std::string CTCDecoder::idx_to_token(int idx) const {
-    auto it = index_to_token_.find(idx);
-    if (it != index_to_token_.end()) {
-        return it->second;
+    return std::string(token_view(idx));
+}
+
+std::string_view CTCDecoder::token_view(int idx) const {
+    if (idx < 0 || static_cast<size_t>(idx) >= index_to_token_.size()) {
+        return {};
     }
-    return "";
+    return index_to_token_[idx];
+}
+
+const DecoderConfig& CTCDecoder::config() const {
+    return config_;
 }
 
 //=============================================================================
 // FeatureExtractor Implementation
 //=============================================================================
 
-FeatureExtractor::FeatureExtractor() {}
+FeatureExtractor::FeatureExtractor() : profiler_(nullptr) {}
+
+void FeatureExtractor::set_profiler(Profiler* profiler) {
+    profiler_ = profiler;
+}
 
 float FeatureExtractor::scalar_distance(float x1, float y1, float z1,
                                        float x2, float y2, float z2) {
@@ -723,6 +1375,7 @@ FrameFeatures FeatureExtractor::extract(
     const LandmarkResults& landmarks,
     const LandmarkResults* prev_landmarks,
     const LandmarkResults* prev2_landmarks) {
+    CUED_SPEECH_PROFILE_SCOPE(profiler_, ProfileStage::FeatureExtraction);
     FrameFeatures invalid;
 
     const auto get_face = [](const LandmarkResults& data, int idx, float& x, float& y, float& z) {
@@ -918,219 +1571,807 @@ FrameFeatures FeatureExtractor::extract(
 }
 
 //=============================================================================
-// WindowProcessor Implementation
+// WindowingPolicy Implementation
 //=============================================================================
 
-WindowProcessor::WindowProcessor(CTCDecoder* decoder, TFLiteSequenceModel* sequence_model)
-    : decoder_(decoder),
-      sequence_model_(sequence_model),
+WindowingPolicy::WindowingPolicy(const WindowingConfig& config)
+    : config_(config),
+      commit_size_(config.commit_size),
+      committed_(0),
       chunk_idx_(0),
-      next_window_needed_(WINDOW_SIZE),
-      frame_count_(0),
-      effective_vocab_size_(decoder ? decoder->get_vocab_size() : 0),
-      total_frames_seen_(0),
-      chunks_processed_(0) {}
+      streaming_(false) {
+    if (config_.window_size <= 0 || config_.commit_size <= 0 || config_.left_context < 0) {
+        throw std::invalid_argument("Window and commit sizes must be positive");
+    }
+    if (config_.left_context + config_.commit_size > config_.window_size) {
+        throw std::invalid_argument("left_context + commit_size must not exceed window_size");
+    }
+    if (config_.mode == WindowingMode::Adaptive) {
+        if (config_.min_commit_size <= 0 ||
+            config_.min_commit_size > config_.max_commit_size ||
+            config_.left_context + config_.max_commit_size > config_.window_size) {
+            throw std::invalid_argument("Invalid adaptive commit size bounds");
+        }
+        commit_size_ = std::clamp(commit_size_, config_.min_commit_size, config_.max_commit_size);
+    }
+    if (config_.endpoint_silence_frames < 0 || config_.endpoint_dropped_frames < 0) {
+        throw std::invalid_argument("Endpoint frame counts must not be negative");
+    }
+    if (config_.two_pass_margin < 0) {
+        throw std::invalid_argument("two_pass_margin must not be negative");
+    }
+}
 
-void WindowProcessor::reset() {
-    valid_features_.clear();
-    all_logits_.clear();
+void WindowingPolicy::reset() {
+    commit_size_ = config_.commit_size;
+    if (config_.mode == WindowingMode::Adaptive) {
+        commit_size_ = std::clamp(commit_size_, config_.min_commit_size, config_.max_commit_size);
+    }
+    committed_ = 0;
     chunk_idx_ = 0;
-    next_window_needed_ = WINDOW_SIZE;
-    frame_count_ = 0;
-    effective_vocab_size_ = decoder_ ? decoder_->get_vocab_size() : 0;
-    total_frames_seen_ = 0;
-    chunks_processed_ = 0;
 }
 
-bool WindowProcessor::push_frame(const FrameFeatures& features) {
-    total_frames_seen_++;
+void WindowingPolicy::restart() {
+    committed_ = 0;
+    chunk_idx_ = 0;
+}
 
-    if (!features.is_valid()) {
-        return false;
-    }
-    
-    valid_features_.push_back(features);
-    frame_count_++;
-    
-    return valid_features_.size() >= next_window_needed_;
+void WindowingPolicy::set_streaming(bool streaming) {
+    streaming_ = streaming;
 }
 
-RecognitionResult WindowProcessor::process_window() {
-    RecognitionResult result;
-    result.frame_number = frame_count_;
-    result.confidence = 0.0f;
+bool WindowingPolicy::streaming() const {
+    return streaming_;
+}
 
-    if (!sequence_model_ || !sequence_model_->is_loaded()) {
-        return result;
+int WindowingPolicy::next_commit_length() const {
+    // The second window only commits left_context frames so that later
+    // windows start on commit_size boundaries (matches the Python schedule).
+    if (!streaming_ && chunk_idx_ == 1 && config_.left_context > 0) {
+        return std::min(config_.left_context, commit_size_);
     }
+    return commit_size_;
+}
 
-    const int num_valid = static_cast<int>(valid_features_.size());
-    if (num_valid < next_window_needed_) {
-        return result;
+int WindowingPolicy::next_window_start() const {
+    if (streaming_) {
+        return committed_;
     }
+    return std::max(0, committed_ - config_.left_context);
+}
 
-    int window_start = 0;
-    int window_end = 0;
-    int commit_start = 0;
-    int commit_end = 0;
-
-    if (chunk_idx_ == 0) {
-        window_start = 0;
-        window_end = std::min(WINDOW_SIZE - 1, num_valid - 1);
-        commit_start = 0;
-        commit_end = std::min(COMMIT_SIZE - 1, num_valid - 1);
-        next_window_needed_ = LEFT_CONTEXT + WINDOW_SIZE;
-    } else if (chunk_idx_ == 1) {
-        window_start = LEFT_CONTEXT;
-        window_end = std::min(window_start + WINDOW_SIZE - 1, num_valid - 1);
-        commit_start = COMMIT_SIZE;
-        commit_end = std::min(commit_start + LEFT_CONTEXT - 1, num_valid - 1);
-        next_window_needed_ = COMMIT_SIZE + WINDOW_SIZE;
-    } else {
-        window_start = COMMIT_SIZE * (chunk_idx_ - 1);
-        window_end = std::min(window_start + WINDOW_SIZE - 1, num_valid - 1);
-        commit_start = window_start + LEFT_CONTEXT;
-        commit_end = std::min(commit_start + COMMIT_SIZE - 1, num_valid - 1);
-        next_window_needed_ = COMMIT_SIZE * chunk_idx_ + WINDOW_SIZE;
-    }
-
-    std::cout << "[Valid frames: " << num_valid << "] Chunk " << chunk_idx_
-              << ": window=[" << window_start << ", " << window_end
-              << "], commit=[" << commit_start << ", " << commit_end << "]" << std::endl;
-
-    int window_vocab_size = 0;
-    auto committed_logits = process_single_window(
-        window_start,
-        window_end,
-        commit_start,
-        commit_end,
-        window_vocab_size);
-
-    if (committed_logits.empty()) {
-        chunk_idx_++;
-        return result;
-    }
+int WindowingPolicy::frames_needed() const {
+    return next_window_start() + (streaming_ ? commit_size_ : config_.window_size);
+}
 
-    if (window_vocab_size > 0) {
-        if (effective_vocab_size_ <= 0) {
-            effective_vocab_size_ = window_vocab_size;
-        } else if (effective_vocab_size_ != window_vocab_size) {
-            effective_vocab_size_ = window_vocab_size;
-        }
-    }
+WindowPlan WindowingPolicy::next_window(int num_valid) const {
+    WindowPlan plan;
+    plan.window_start = next_window_start();
+    plan.window_end = std::min(frames_needed() - 1, num_valid - 1);
+    plan.commit_start = committed_;
+    plan.commit_end = std::min(committed_ + next_commit_length() - 1, num_valid - 1);
+    return plan;
+}
 
-    if (effective_vocab_size_ <= 0) {
-        chunk_idx_++;
-        return result;
-    }
+WindowPlan WindowingPolicy::final_window(int num_valid) const {
+    WindowPlan plan;
+    plan.window_start = next_window_start();
+    plan.window_end = num_valid - 1;
+    plan.commit_start = committed_;
+    plan.commit_end = num_valid - 1;
+    return plan;
+}
 
-    all_logits_.push_back(std::move(committed_logits));
+void WindowingPolicy::advance(const WindowPlan& plan) {
+    committed_ = std::max(committed_, plan.commit_end + 1);
+    ++chunk_idx_;
+}
 
-    int vocab_size = decoder_ ? decoder_->get_vocab_size() : 0;
-    if (vocab_size <= 0) {
-        vocab_size = effective_vocab_size_;
+void WindowingPolicy::report_cost(double seconds, int committed_frames) {
+    if (config_.mode != WindowingMode::Adaptive || committed_frames <= 0 || config_.frame_rate <= 0.0f) {
+        return;
     }
 
-    if (vocab_size <= 0) {
-        chunk_idx_++;
-        return result;
-    }
+    // Fraction of the real-time budget spent on the committed frames
+    const double budget = committed_frames / static_cast<double>(config_.frame_rate);
+    const double load = seconds / budget;
+    const int step = std::max(1, commit_size_ / 4);
 
-    int total_frames = 0;
-    for (const auto& logits : all_logits_) {
-        if (!logits.empty()) {
-            total_frames += static_cast<int>(logits.size() / vocab_size);
+    if (load < config_.low_load) {
+        commit_size_ = std::max(config_.min_commit_size, commit_size_ - step);
+    } else if (load > config_.high_load) {
+        commit_size_ = std::min(config_.max_commit_size, commit_size_ + step);
+    }
+}
+
+int WindowingPolicy::window_size() const {
+    return config_.window_size;
+}
+
+int WindowingPolicy::left_context() const {
+    return config_.left_context;
+}
+
+int WindowingPolicy::commit_size() const {
+    return commit_size_;
+}
+
+int WindowingPolicy::committed_frames() const {
+    return committed_;
+}
+
+int WindowingPolicy::chunk_index() const {
+    return chunk_idx_;
+}
+
+const WindowingConfig& WindowingPolicy::config() const {
+    return config_;
+}
+
+//=============================================================================
+// WindowProcessor Implementation
+//=============================================================================
+
+namespace {
+
+// first_frame: valid frames of the stream before the decoded utterance
+std::vector<WordTiming> word_timings_of(const CTCHypothesis& hypothesis, int first_frame) {
+    std::vector<WordTiming> timings;
+    timings.reserve(hypothesis.words.size());
+    for (size_t i = 0; i < hypothesis.words.size() && i < hypothesis.word_end_frames.size(); ++i) {
+        timings.push_back({hypothesis.words[i],
+                           first_frame + hypothesis.word_start_frames[i],
+                           first_frame + hypothesis.word_end_frames[i]});
+    }
+    return timings;
+}
+
+std::vector<std::string> token_strings(const CTCDecoder& decoder,
+                                       std::vector<int>::const_iterator begin,
+                                       std::vector<int>::const_iterator end) {
+    std::vector<std::string> tokens;
+    tokens.reserve(static_cast<size_t>(end - begin));
+    for (auto it = begin; it != end; ++it) {
+        tokens.emplace_back(decoder.token_view(*it));
+    }
+    return tokens;
+}
+
+} // namespace
+
+WindowProcessor::WindowProcessor(CTCDecoder* decoder, TFLiteSequenceModel* sequence_model)
+    : WindowProcessor(decoder, sequence_model,
+                      decoder ? decoder->config().windowing : WindowingConfig()) {}
+
+WindowProcessor::WindowProcessor(CTCDecoder* decoder,
+                                 TFLiteSequenceModel* sequence_model,
+                                 const WindowingConfig& windowing)
+    : decoder_(decoder),
+      sequence_model_(sequence_model),
+      policy_(windowing),
+      log_prob_frames_(0),
+      frame_count_(0),
+      effective_vocab_size_(decoder ? decoder->get_vocab_size() : 0),
+      total_frames_seen_(0),
+      chunks_processed_(0),
+      provisional_results_(0),
+      last_output_valid_(0),
+      utterance_start_(0),
+      finished_windows_(0),
+      silent_run_(0),
+      dropped_run_(0),
+      cut_scan_frames_(0),
+      silent_run_start_(-1),
+      stable_frames_(0),
+      searched_frames_(0),
+      beam_searched_frames_(0) {
+    policy_.set_streaming(sequence_model_ && sequence_model_->is_stateful());
+}
+
+void WindowProcessor::reset() {
+    valid_frames_.clear();
+    log_probs_.clear();
+    token_candidates_.clear();
+    log_prob_frames_ = 0;
+    policy_.reset();
+    policy_.set_streaming(sequence_model_ && sequence_model_->is_stateful());
+    if (sequence_model_) {
+        sequence_model_->reset_state();
+    }
+    frame_count_ = 0;
+    effective_vocab_size_ = decoder_ ? decoder_->get_vocab_size() : 0;
+    total_frames_seen_ = 0;
+    chunks_processed_ = 0;
+    provisional_results_ = 0;
+    last_output_valid_ = 0;
+    utterance_start_ = 0;
+    finished_windows_ = 0;
+    silent_run_ = 0;
+    dropped_run_ = 0;
+    endpoints_.clear();
+    reset_two_pass();
+    beam_searched_frames_ = 0;
+    last_hypothesis_ = CTCHypothesis();
+}
+
+void WindowProcessor::set_windowing(const WindowingConfig& windowing) {
+    policy_ = WindowingPolicy(windowing);
+    reset();
+}
+
+const WindowingPolicy& WindowProcessor::windowing() const {
+    return policy_;
+}
+
+bool WindowProcessor::push_frame(const FrameFeatures& features) {
+    total_frames_seen_++;
+
+    if (!features.is_valid()) {
+        note_dropped_frame();
+        return !endpoints_.empty();
+    }
+    
+    valid_frames_.insert(valid_frames_.end(), features.hand_shape.begin(), features.hand_shape.end());
+    valid_frames_.insert(valid_frames_.end(), features.hand_position.begin(), features.hand_position.end());
+    valid_frames_.insert(valid_frames_.end(), features.lips.begin(), features.lips.end());
+    frame_count_++;
+    dropped_run_ = 0;
+    
+    return utterance_end() >= policy_.frames_needed() || !endpoints_.empty() || provisional_due();
+}
+
+bool WindowProcessor::push_frame(const float* features) {
+    total_frames_seen_++;
+    valid_frames_.insert(valid_frames_.end(), features, features + kFrameFeatureSize);
+    frame_count_++;
+    dropped_run_ = 0;
+
+    return utterance_end() >= policy_.frames_needed() || !endpoints_.empty() || provisional_due();
+}
+
+int WindowProcessor::push_frames(const float* frames, int count, const uint8_t* valid_mask) {
+    if (count <= 0) {
+        return ready_windows();
+    }
+
+    auto append = [this, frames](int first, int last) {
+        valid_frames_.insert(valid_frames_.end(),
+                             frames + static_cast<size_t>(first) * kFrameFeatureSize,
+                             frames + static_cast<size_t>(last) * kFrameFeatureSize);
+        frame_count_ += last - first;
+    };
+
+    total_frames_seen_ += count;
+    if (!valid_mask) {
+        append(0, count);
+        dropped_run_ = 0;
+        return ready_windows();
+    }
+
+    // Copy runs of valid frames
+    valid_frames_.reserve(valid_frames_.size() + static_cast<size_t>(count) * kFrameFeatureSize);
+    int run_start = -1;
+    for (int i = 0; i < count; ++i) {
+        if (valid_mask[i]) {
+            if (run_start < 0) {
+                run_start = i;
+            }
+            dropped_run_ = 0;
+        } else {
+            if (run_start >= 0) {
+                append(run_start, i);
+                run_start = -1;
+            }
+            note_dropped_frame();
         }
     }
+    if (run_start >= 0) {
+        append(run_start, count);
+    }
+    return ready_windows();
+}
+
+int WindowProcessor::ready_windows() const {
+    const int num_valid = utterance_end();
+    WindowingPolicy policy = policy_;
+    int windows = 0;
+    while (num_valid >= policy.frames_needed()) {
+        policy.advance(policy.next_window(num_valid));
+        ++windows;
+    }
+    if (!endpoints_.empty()) {
+        return windows + 1;
+    }
+    if (windows == 0 && provisional_due()) {
+        return 1;
+    }
+    return windows;
+}
+
+bool WindowProcessor::provisional_due() const {
+    const int interval = policy_.config().provisional_interval;
+    const int num_valid = utterance_end();
+    // A stateful model cannot run speculatively without consuming its state
+    return interval > 0 &&
+           !policy_.streaming() &&
+           num_valid > policy_.committed_frames() &&
+           num_valid - last_output_valid_ >= interval;
+}
+
+RecognitionResult WindowProcessor::process_window() {
+    RecognitionResult result;
+    result.frame_number = frame_count_;
+    result.confidence = 0.0f;
 
-    if (total_frames <= 0) {
-        chunk_idx_++;
+    if (!sequence_model_ || !sequence_model_->is_loaded()) {
         return result;
     }
 
-    std::vector<float> full_logits;
-    full_logits.reserve(static_cast<size_t>(total_frames) * vocab_size);
-    for (const auto& logits : all_logits_) {
-        full_logits.insert(full_logits.end(), logits.begin(), logits.end());
+    const int num_valid = utterance_end();
+    if (num_valid < policy_.frames_needed()) {
+        if (!endpoints_.empty()) {
+            return end_utterance();
+        }
+        return provisional_due() ? process_provisional() : result;
     }
 
-    std::cout << "  Full accumulated logits shape: [" << total_frames
-              << " x " << vocab_size << "]" << std::endl;
+    last_output_valid_ = num_valid;
+    const auto started = std::chrono::steady_clock::now();
+    const int chunk_idx = policy_.chunk_index();
+    const WindowPlan plan = policy_.next_window(num_valid);
+    policy_.advance(plan);
 
-    auto hypotheses = decoder_->decode(full_logits.data(), total_frames, vocab_size);
+    if (log_enabled(LogLevel::Debug)) {
+        log_message(LogLevel::Debug, "stream", "Processing window",
+                    {{"chunk", chunk_idx},
+                     {"valid_frames", num_valid},
+                     {"window_start", plan.window_start},
+                     {"window_end", plan.window_end},
+                     {"commit_start", plan.commit_start},
+                     {"commit_end", plan.commit_end}});
+    }
+
+    LogitsView committed_logits = process_single_window(
+        plan.window_start,
+        plan.window_end,
+        plan.commit_start,
+        plan.commit_end);
+
+    if (!append_log_probs(committed_logits)) {
+        return result;
+    }
+    const bool silence_endpoint = update_silent_run(log_prob_frames_ - committed_logits.frames);
+
+    CUED_SPEECH_LOG(LogLevel::Trace, "stream",
+                    "Accumulated logits shape: [" << log_prob_frames_ << " x " << effective_vocab_size_ << "]");
+
+    // The result that ends an utterance searches all of it
+    auto hypotheses = silence_endpoint ? decode_buffered() : decode_streaming(true);
     if (!hypotheses.empty()) {
-        result.phonemes = decoder_->idxs_to_tokens(hypotheses[0].tokens);
+        result.phoneme_ids = decoder_->collapse_tokens(hypotheses[0].tokens);
+        result.phonemes = token_strings(*decoder_, result.phoneme_ids.begin(), result.phoneme_ids.end());
+        result.word_timings = word_timings_of(hypotheses[0], utterance_start_);
         result.confidence = hypotheses[0].score;
+        last_hypothesis_ = std::move(hypotheses[0]);
 
-        std::cout << "  Decoded sentence after chunk " << chunk_idx_ << ": ";
-        for (const auto& token : result.phonemes) {
-            std::cout << token << ' ';
+        if (log_enabled(LogLevel::Trace)) {
+            std::string sentence;
+            for (const auto& token : result.phonemes) {
+                if (!sentence.empty()) {
+                    sentence += ' ';
+                }
+                sentence += token;
+            }
+            log_message(LogLevel::Trace, "stream", "Decoded sentence",
+                        {{"chunk", chunk_idx}, {"tokens", sentence}});
         }
-        std::cout << std::endl;
 
         ++chunks_processed_;
     }
 
-    chunk_idx_++;
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    policy_.report_cost(elapsed.count(), plan.commit_end - plan.commit_start + 1);
+
+    if (silence_endpoint) {
+        // The utterance ends at the last committed frame. A history that is
+        // silent throughout is dropped without reporting an endpoint.
+        result.endpoint = silent_run_ < log_prob_frames_;
+        CUED_SPEECH_LOG(LogLevel::Debug, "stream",
+                        "Silence endpoint after " << log_prob_frames_ << " frames"
+                        << (result.endpoint ? "" : " (no speech)"));
+        start_utterance(policy_.committed_frames());
+    }
+
     return result;
 }
 
-std::vector<float> WindowProcessor::process_single_window(
+RecognitionResult WindowProcessor::process_provisional() {
+    RecognitionResult result;
+    result.frame_number = frame_count_;
+    result.confidence = 0.0f;
+    result.provisional = true;
+
+    const int num_valid = utterance_end();
+    last_output_valid_ = num_valid;
+
+    const WindowPlan plan = policy_.final_window(num_valid);
+    if (plan.commit_start > plan.commit_end) {
+        return result;
+    }
+
+    LogitsView tail_logits = process_single_window(
+        plan.window_start,
+        plan.window_end,
+        plan.commit_start,
+        plan.commit_end);
+
+    // The speculative tail is appended after the committed rows and dropped
+    // again once decoded.
+    const int committed_frames = log_prob_frames_;
+    if (!append_log_probs(tail_logits)) {
+        return result;
+    }
+
+    auto hypotheses = decode_streaming(false);
+    log_prob_frames_ = committed_frames;
+    log_probs_.resize(static_cast<size_t>(committed_frames) * effective_vocab_size_);
+    if (!token_candidates_.empty()) {
+        token_candidates_.resize(committed_frames);
+    }
+    if (first_pass_.size() > static_cast<size_t>(committed_frames)) {
+        first_pass_.resize(committed_frames);
+    }
+
+    if (hypotheses.empty()) {
+        return result;
+    }
+    ++provisional_results_;
+
+    // Split the best path at the last committed frame: the collapsed prefix
+    // path is a prefix of the collapsed full path.
+    const auto& path = hypotheses[0].tokens;
+    const std::vector<int> ids = decoder_->collapse_tokens(path);
+
+    size_t stable_count = 0;
+    if (committed_frames > 0 && path.size() >= 2) {
+        const size_t prefix_len = std::min(path.size() - 1, static_cast<size_t>(committed_frames) + 1);
+        std::vector<int> prefix(path.begin(), path.begin() + prefix_len);
+        prefix.push_back(path.back());
+        stable_count = std::min(decoder_->collapse_tokens(prefix).size(), ids.size());
+    }
+
+    const auto split = ids.begin() + static_cast<std::ptrdiff_t>(stable_count);
+    result.phoneme_ids.assign(ids.begin(), split);
+    result.unstable_phoneme_ids.assign(split, ids.end());
+    result.phonemes = token_strings(*decoder_, ids.begin(), split);
+    result.unstable_phonemes = token_strings(*decoder_, split, ids.end());
+    result.confidence = hypotheses[0].score;
+    return result;
+}
+
+LogitsView WindowProcessor::process_single_window(
     int window_start,
     int window_end,
     int commit_start,
-    int commit_end,
-    int& out_vocab_size) {
-
-    out_vocab_size = 0;
+    int commit_end) {
 
-    if (!sequence_model_ || !sequence_model_->is_loaded() || window_end < window_start) {
+    if (!sequence_model_) {
         return {};
     }
+    return infer_window(*sequence_model_, {window_start, window_end, commit_start, commit_end}, &profiler_);
+}
 
-    const int window_size_actual = window_end - window_start + 1;
-    if (window_size_actual <= 0) {
+LogitsView WindowProcessor::infer_window(TFLiteSequenceModel& model,
+                                         const WindowPlan& plan,
+                                         Profiler* profiler) const {
+    if (!model.is_loaded() || plan.window_end < plan.window_start) {
         return {};
     }
 
-    std::vector<FrameFeatures> padded_features;
-    padded_features.reserve(WINDOW_SIZE);
-    for (int idx = window_start; idx <= window_end; ++idx) {
-        padded_features.push_back(valid_features_[idx]);
-    }
-    if (static_cast<int>(padded_features.size()) < WINDOW_SIZE) {
-        FrameFeatures zero;
-        zero.hand_shape.assign(7, 0.0f);
-        zero.hand_position.assign(18, 0.0f);
-        zero.lips.assign(8, 0.0f);
-        padded_features.resize(WINDOW_SIZE, zero);
+    const int window_size_actual = plan.window_end - plan.window_start + 1;
+    if (window_size_actual <= 0) {
+        return {};
     }
 
-    auto window_logits = sequence_model_->infer(padded_features, WINDOW_SIZE);
-    out_vocab_size = sequence_model_->vocab_size();
-    const int seq_len = sequence_model_->last_sequence_length();
-
-    if (window_logits.empty() || out_vocab_size <= 0 || seq_len <= 0) {
+    // Stateful models see exactly the new frames; padding would pollute the state
+    const int window_size = policy_.streaming() ? window_size_actual : policy_.window_size();
+    // Rows go from the flat frame buffer straight into the input tensors
+    const LogitsView window_logits = model.infer_view(
+        valid_frames_.data() + static_cast<size_t>(plan.window_start) * kFrameFeatureSize,
+        window_size_actual, window_size, profiler);
+    if (window_logits.empty()) {
         return {};
     }
 
-    int commit_start_rel = commit_start - window_start;
-    int commit_end_rel = commit_end - window_start;
+    int commit_start_rel = plan.commit_start - plan.window_start;
+    int commit_end_rel = plan.commit_end - plan.window_start;
     commit_start_rel = std::max(commit_start_rel, 0);
-    commit_end_rel = std::min(commit_end_rel, seq_len - 1);
+    commit_end_rel = std::min(commit_end_rel, window_logits.frames - 1);
 
     if (commit_start_rel > commit_end_rel) {
         return {};
     }
 
-    std::vector<float> committed_logits;
-    committed_logits.reserve(static_cast<size_t>(commit_end_rel - commit_start_rel + 1) * out_vocab_size);
-    for (int t = commit_start_rel; t <= commit_end_rel; ++t) {
-        const float* row = window_logits.data() + static_cast<size_t>(t) * out_vocab_size;
-        committed_logits.insert(committed_logits.end(), row, row + out_vocab_size);
+    return window_logits.rows(commit_start_rel, commit_end_rel);
+}
+
+bool WindowProcessor::append_log_probs(const LogitsView& logits) {
+    if (logits.empty()) {
+        return false;
+    }
+
+    if (effective_vocab_size_ != logits.vocab) {
+        // Rows already buffered were laid out for another vocabulary
+        log_probs_.clear();
+        token_candidates_.clear();
+        log_prob_frames_ = 0;
+        reset_two_pass();
+        effective_vocab_size_ = logits.vocab;
+    }
+
+    CUED_SPEECH_PROFILE_SCOPE(&profiler_, ProfileStage::LogSoftmax);
+    const size_t offset = log_probs_.size();
+    log_probs_.resize(offset + static_cast<size_t>(logits.frames) * logits.vocab);
+    const DecoderConfig& config = decoder_->config();
+    if (config.token_mass < 1.0f) {
+        // Count token candidates in the same pass
+        token_candidates_.resize(static_cast<size_t>(log_prob_frames_) + logits.frames);
+        CTCDecoder::log_softmax(logits.data, log_probs_.data() + offset, logits.frames, logits.vocab,
+                                config.token_mass, decoder_->max_token_candidates(logits.vocab),
+                                token_candidates_.data() + log_prob_frames_);
+    } else {
+        CTCDecoder::log_softmax(logits.data, log_probs_.data() + offset, logits.frames, logits.vocab);
     }
+    log_prob_frames_ += logits.frames;
+    return true;
+}
 
-    return committed_logits;
+const int* WindowProcessor::buffered_candidates() const {
+    return token_candidates_.size() == static_cast<size_t>(log_prob_frames_)
+        ? token_candidates_.data()
+        : nullptr;
+}
+
+std::vector<CTCHypothesis> WindowProcessor::decode_buffered() {
+    CUED_SPEECH_PROFILE_SCOPE(&profiler_, ProfileStage::BeamSearch);
+    beam_searched_frames_ += log_prob_frames_;
+    return decoder_->decode_log_probs(log_probs_.data(), log_prob_frames_, effective_vocab_size_,
+                                      buffered_candidates());
+}
+
+std::vector<CTCHypothesis> WindowProcessor::decode_buffered_segments(int num_threads) {
+    CUED_SPEECH_PROFILE_SCOPE(&profiler_, ProfileStage::BeamSearch);
+    beam_searched_frames_ += log_prob_frames_;
+    return decoder_->decode_segmented(log_probs_.data(), log_prob_frames_, effective_vocab_size_,
+                                      num_threads, buffered_candidates());
+}
+
+std::vector<CTCHypothesis> WindowProcessor::decode_streaming(bool committed) {
+    if (policy_.config().two_pass_margin <= 0) {
+        return decode_buffered();
+    }
+    return decode_two_pass(committed);
+}
+
+std::vector<CTCHypothesis> WindowProcessor::decode_two_pass(bool committed) {
+    CUED_SPEECH_PROFILE_SCOPE(&profiler_, ProfileStage::BeamSearch);
+    const int T = log_prob_frames_;
+    const int V = effective_vocab_size_;
+
+    // First pass: greedy token of each new row
+    const int first_new = std::min(static_cast<int>(first_pass_.size()), T);
+    first_pass_.resize(T);
+    for (int t = first_new; t < T; ++t) {
+        const float* row = log_probs_.data() + static_cast<size_t>(t) * V;
+        first_pass_[t] = static_cast<int>(std::max_element(row, row + V) - row);
+    }
+
+    if (committed) {
+        advance_stable_prefix();
+    }
+
+    // Rows the first pass finds blank or silent cannot add a word: extend
+    // the last search over them instead of searching again
+    const int blank = decoder_->token_to_idx(decoder_->config().blank_token);
+    const int sil = decoder_->token_to_idx(decoder_->config().sil_token);
+    bool reuse = searched_frames_ > stable_frames_ && searched_frames_ <= T;
+    for (int t = searched_frames_; reuse && t < T; ++t) {
+        reuse = first_pass_[t] == blank || first_pass_[t] == sil;
+    }
+
+    CTCHypothesis open;
+    if (reuse) {
+        open = open_;
+        open.tokens.insert(open.tokens.end() - 1, first_pass_.begin() + searched_frames_, first_pass_.begin() + T);
+    } else {
+        const int frames = T - stable_frames_;
+        const int* candidates = buffered_candidates();
+        auto hypotheses = decoder_->decode_log_probs(log_probs_.data() + static_cast<size_t>(stable_frames_) * V,
+                                                     frames, V,
+                                                     candidates ? candidates + stable_frames_ : nullptr);
+        beam_searched_frames_ += frames;
+        if (hypotheses.empty()) {
+            return {};
+        }
+        open = std::move(hypotheses[0]);
+    }
+    if (committed) {
+        open_ = open;
+        searched_frames_ = T;
+    }
+
+    if (stable_frames_ == 0) {
+        return {std::move(open)};
+    }
+
+    // Splice the search after the stable prefix, whose path already has the
+    // start step
+    CTCHypothesis spliced = stable_;
+    spliced.tokens.insert(spliced.tokens.end(), open.tokens.begin() + 1, open.tokens.end());
+    append_hypothesis(spliced, open, stable_frames_);
+    return {std::move(spliced)};
+}
+
+void WindowProcessor::advance_stable_prefix() {
+    const int T = log_prob_frames_;
+    const int V = effective_vocab_size_;
+    const DecoderConfig& config = decoder_->config();
+    const int min_run = std::max(1, config.segment_silence_frames);
+
+    // Cut in the middle of each long enough silent run, as find_segments()
+    // does; a run still open at the end may grow and is not cut yet
+    for (; cut_scan_frames_ < T; ++cut_scan_frames_) {
+        const int t = cut_scan_frames_;
+        const float* row = log_probs_.data() + static_cast<size_t>(t) * V;
+        if (decoder_->silence_log_prob(row, V) > config.segment_log_prob) {
+            if (silent_run_start_ < 0) {
+                silent_run_start_ = t;
+            }
+            continue;
+        }
+        if (silent_run_start_ >= 0 && t - silent_run_start_ >= min_run) {
+            cuts_.push_back(silent_run_start_ + (t - silent_run_start_) / 2);
+        }
+        silent_run_start_ = -1;
+    }
+
+    // Take the last cut that leaves two_pass_margin rows of context
+    int cut = stable_frames_;
+    const int limit = T - policy_.config().two_pass_margin;
+    while (!cuts_.empty() && cuts_.front() <= limit) {
+        cut = cuts_.front();
+        cuts_.pop_front();
+    }
+    if (cut <= stable_frames_) {
+        return;
+    }
+
+    // The rows before the cut are searched once more on their own, so the
+    // prefix is the best path of that segment with its own score
+    const int frames = cut - stable_frames_;
+    const int* candidates = buffered_candidates();
+    auto hypotheses = decoder_->decode_log_probs(log_probs_.data() + static_cast<size_t>(stable_frames_) * V,
+                                                 frames, V,
+                                                 candidates ? candidates + stable_frames_ : nullptr);
+    beam_searched_frames_ += frames;
+    if (hypotheses.empty() || hypotheses[0].tokens.size() != static_cast<size_t>(frames) + 2) {
+        CUED_SPEECH_LOG(LogLevel::Warn, "stream",
+                        "Two-pass prefix (frames " << stable_frames_ << "-" << cut - 1
+                        << ") failed to decode; keeping it in the search");
+        return;
+    }
+
+    const CTCHypothesis& part = hypotheses[0];
+    if (stable_frames_ == 0) {
+        stable_ = CTCHypothesis();
+        stable_.tokens.push_back(part.tokens.front());
+    }
+    stable_.tokens.insert(stable_.tokens.end(), part.tokens.begin() + 1, part.tokens.end() - 1);
+    append_hypothesis(stable_, part, stable_frames_);
+    stable_frames_ = cut;
+    searched_frames_ = 0;  // open_ started before the cut
+
+    CUED_SPEECH_LOG(LogLevel::Trace, "stream",
+                    "Two-pass prefix now " << stable_frames_ << " of " << T << " frames");
+}
+
+void WindowProcessor::reset_two_pass() {
+    first_pass_.clear();
+    cuts_.clear();
+    cut_scan_frames_ = 0;
+    silent_run_start_ = -1;
+    stable_ = CTCHypothesis();
+    stable_frames_ = 0;
+    open_ = CTCHypothesis();
+    searched_frames_ = 0;
+}
+
+void WindowProcessor::note_dropped_frame() {
+    const int limit = policy_.config().endpoint_dropped_frames;
+    if (limit <= 0 || ++dropped_run_ != limit) {
+        return;
+    }
+    // Only end an utterance that has frames since the previous endpoint
+    const int end = buffered_frames();
+    if (end > (endpoints_.empty() ? 0 : endpoints_.back())) {
+        endpoints_.push_back(end);
+    }
+}
+
+bool WindowProcessor::update_silent_run(int first_row) {
+    const WindowingConfig& windowing = policy_.config();
+    if (windowing.endpoint_silence_frames <= 0) {
+        return false;
+    }
+
+    const int V = effective_vocab_size_;
+    for (int t = std::max(first_row, 0); t < log_prob_frames_; ++t) {
+        const float* row = log_probs_.data() + static_cast<size_t>(t) * V;
+        const bool silent = decoder_->silence_log_prob(row, V) > windowing.endpoint_log_prob;
+        silent_run_ = silent ? silent_run_ + 1 : 0;
+    }
+    return silent_run_ >= windowing.endpoint_silence_frames;
+}
+
+RecognitionResult WindowProcessor::end_utterance() {
+    RecognitionResult result;
+    result.frame_number = frame_count_;
+    result.confidence = 0.0f;
+    result.endpoint = true;
+
+    // Commit the rest of the utterance as finalize() would
+    const int end = endpoints_.front();
+    const WindowPlan plan = policy_.final_window(end);
+    if (plan.commit_start <= plan.commit_end &&
+        (policy_.streaming() || plan.window_end - plan.window_start + 1 >= policy_.left_context())) {
+        policy_.advance(plan);
+        append_log_probs(process_single_window(
+            plan.window_start,
+            plan.window_end,
+            plan.commit_start,
+            plan.commit_end));
+    }
+
+    if (log_prob_frames_ > 0) {
+        auto hypotheses = decode_buffered();
+        if (!hypotheses.empty()) {
+            result.phoneme_ids = decoder_->collapse_tokens(hypotheses[0].tokens);
+            result.phonemes = token_strings(*decoder_, result.phoneme_ids.begin(), result.phoneme_ids.end());
+            result.word_timings = word_timings_of(hypotheses[0], utterance_start_);
+            result.confidence = hypotheses[0].score;
+            last_hypothesis_ = std::move(hypotheses[0]);
+
+            ++chunks_processed_;
+        }
+    }
+
+    CUED_SPEECH_LOG(LogLevel::Debug, "stream",
+                    "Hand-absence endpoint after " << end << " frames");
+    endpoints_.pop_front();
+    start_utterance(end);
+    return result;
+}
+
+void WindowProcessor::start_utterance(int frames) {
+    valid_frames_.erase(valid_frames_.begin(),
+                        valid_frames_.begin() + static_cast<size_t>(frames) * kFrameFeatureSize);
+    for (int& endpoint : endpoints_) {
+        endpoint -= frames;
+    }
+    utterance_start_ += frames;
+    last_output_valid_ = std::max(0, last_output_valid_ - frames);
+
+    log_probs_.clear();
+    token_candidates_.clear();
+    log_prob_frames_ = 0;
+    silent_run_ = 0;
+    reset_two_pass();
+
+    finished_windows_ += policy_.chunk_index();
+    policy_.restart();
+    if (sequence_model_) {
+        sequence_model_->reset_state();
+    }
 }
 
 RecognitionResult WindowProcessor::finalize() {
@@ -1142,106 +2383,179 @@ RecognitionResult WindowProcessor::finalize() {
         return result;
     }
 
-    const int num_valid = static_cast<int>(valid_features_.size());
+    const int num_valid = buffered_frames();
     if (num_valid == 0) {
         return result;
     }
 
-    int frames_committed = 0;
-    if (chunk_idx_ == 0) {
-        frames_committed = 0;
-    } else if (chunk_idx_ == 1) {
-        frames_committed = COMMIT_SIZE;
-    } else {
-        frames_committed = COMMIT_SIZE + LEFT_CONTEXT + (chunk_idx_ - 2) * COMMIT_SIZE;
-    }
-
-    if (frames_committed >= num_valid) {
+    if (policy_.committed_frames() >= num_valid) {
         return result;
     }
 
-    int window_start = 0;
-    int window_end = num_valid - 1;
-    int commit_start = 0;
-    int commit_end = num_valid - 1;
-
-    if (chunk_idx_ == 0) {
-        window_start = 0;
-        window_end = num_valid - 1;
-        commit_start = 0;
-        commit_end = num_valid - 1;
-    } else if (chunk_idx_ == 1) {
-        window_start = LEFT_CONTEXT;
-        window_end = num_valid - 1;
-        commit_start = COMMIT_SIZE;
-        commit_end = num_valid - 1;
-    } else {
-        window_start = COMMIT_SIZE * (chunk_idx_ - 1);
-        window_end = num_valid - 1;
-        commit_start = window_start + LEFT_CONTEXT;
-        commit_end = num_valid - 1;
-    }
+    const WindowPlan plan = policy_.final_window(num_valid);
 
-    if (window_end - window_start + 1 < LEFT_CONTEXT) {
+    if (!policy_.streaming() && plan.window_end - plan.window_start + 1 < policy_.left_context()) {
         return result;
     }
+    policy_.advance(plan);
 
-    int window_vocab_size = 0;
-    auto committed_logits = process_single_window(
-        window_start,
-        window_end,
-        commit_start,
-        commit_end,
-        window_vocab_size);
+    LogitsView committed_logits = process_single_window(
+        plan.window_start,
+        plan.window_end,
+        plan.commit_start,
+        plan.commit_end);
 
-    if (committed_logits.empty()) {
+    if (!append_log_probs(committed_logits)) {
         return result;
     }
 
-    if (window_vocab_size > 0) {
-        if (effective_vocab_size_ <= 0) {
-            effective_vocab_size_ = window_vocab_size;
-        } else if (effective_vocab_size_ != window_vocab_size) {
-            effective_vocab_size_ = window_vocab_size;
-        }
-    }
+    auto hypotheses = decode_buffered();
+    if (!hypotheses.empty()) {
+        result.phoneme_ids = decoder_->collapse_tokens(hypotheses[0].tokens);
+        result.phonemes = token_strings(*decoder_, result.phoneme_ids.begin(), result.phoneme_ids.end());
+        result.word_timings = word_timings_of(hypotheses[0], utterance_start_);
+        result.confidence = hypotheses[0].score;
+        last_hypothesis_ = std::move(hypotheses[0]);
 
-    if (effective_vocab_size_ <= 0) {
-        return result;
+        ++chunks_processed_;
     }
 
-    all_logits_.push_back(std::move(committed_logits));
+    return result;
+}
 
-    int vocab_size = decoder_ ? decoder_->get_vocab_size() : 0;
-    if (vocab_size <= 0) {
-        vocab_size = effective_vocab_size_;
+RecognitionResult WindowProcessor::decode_sequence(const std::vector<FrameFeatures>& features,
+                                                   int num_threads) {
+    reset();
+    for (const auto& frame : features) {
+        push_frame(frame);
     }
+    return decode_buffered_sequence(num_threads);
+}
+
+RecognitionResult WindowProcessor::decode_sequence(const float* frames,
+                                                   int count,
+                                                   const uint8_t* valid_mask,
+                                                   int num_threads) {
+    reset();
+    push_frames(frames, count, valid_mask);
+    return decode_buffered_sequence(num_threads);
+}
 
-    if (vocab_size <= 0) {
+RecognitionResult WindowProcessor::decode_buffered_sequence(int num_threads) {
+    RecognitionResult result;
+    result.frame_number = frame_count_;
+    result.confidence = 0.0f;
+
+    // Offline decodes are one utterance
+    endpoints_.clear();
+
+    const int num_valid = buffered_frames();
+    if (!sequence_model_ || !sequence_model_->is_loaded() || num_valid == 0) {
         return result;
     }
 
-    int total_frames = 0;
-    for (const auto& logits : all_logits_) {
-        if (!logits.empty()) {
-            total_frames += static_cast<int>(logits.size() / vocab_size);
+    // Same schedule as process_window() on every full window, then finalize()
+    std::vector<WindowPlan> plans;
+    while (num_valid >= policy_.frames_needed()) {
+        const WindowPlan plan = policy_.next_window(num_valid);
+        policy_.advance(plan);
+        plans.push_back(plan);
+    }
+    if (policy_.committed_frames() < num_valid) {
+        const WindowPlan plan = policy_.final_window(num_valid);
+        if (policy_.streaming() || plan.window_end - plan.window_start + 1 >= policy_.left_context()) {
+            policy_.advance(plan);
+            plans.push_back(plan);
         }
     }
 
-    if (total_frames <= 0) {
-        return result;
+    // Committed logits per window; windows only read the frame buffer
+    std::vector<std::vector<float>> window_logits(plans.size());
+    std::vector<int> window_vocab(plans.size(), 0);
+    auto run_window = [&](TFLiteSequenceModel& model, size_t i, Profiler* profiler) {
+        const LogitsView view = infer_window(model, plans[i], profiler);
+        if (!view.empty()) {
+            window_logits[i].assign(view.data, view.data + static_cast<size_t>(view.frames) * view.vocab);
+            window_vocab[i] = view.vocab;
+        }
+    };
+
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
     }
+    const size_t workers = policy_.streaming()
+        ? 1
+        : std::min(plans.size(), static_cast<size_t>(num_threads));
 
-    std::vector<float> full_logits;
-    full_logits.reserve(static_cast<size_t>(total_frames) * vocab_size);
-    for (const auto& logits : all_logits_) {
-        full_logits.insert(full_logits.end(), logits.begin(), logits.end());
+    if (workers <= 1) {
+        for (size_t i = 0; i < plans.size(); ++i) {
+            run_window(*sequence_model_, i, &profiler_);
+        }
+    } else {
+        std::atomic<size_t> next_window{0};
+        std::vector<std::exception_ptr> errors(workers);
+        auto worker = [&](size_t w) {
+            try {
+                // Worker 0 (this thread) reuses the stream's model, the others a clone
+                std::unique_ptr<TFLiteSequenceModel> clone;
+                if (w > 0) {
+                    clone = sequence_model_->clone();
+                }
+                TFLiteSequenceModel& model = clone ? *clone : *sequence_model_;
+                for (size_t i = next_window++; i < plans.size(); i = next_window++) {
+                    run_window(model, i, nullptr);
+                }
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t w = 1; w < workers; ++w) {
+            try {
+                threads.emplace_back(worker, w);
+            } catch (const std::system_error& e) {
+                // The started workers and this thread take the remaining windows
+                CUED_SPEECH_LOG(LogLevel::Warn, "stream",
+                                "Could not start worker thread " << w << ": " << e.what());
+                break;
+            }
+        }
+        worker(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    CUED_SPEECH_LOG(LogLevel::Debug, "stream",
+                    "Offline decode ran " << plans.size() << " windows on " << workers << " threads");
+
+    for (size_t i = 0; i < plans.size(); ++i) {
+        if (window_logits[i].empty()) {
+            continue;
+        }
+        LogitsView view;
+        view.data = window_logits[i].data();
+        view.vocab = window_vocab[i];
+        view.frames = static_cast<int>(window_logits[i].size() / window_vocab[i]);
+        append_log_probs(view);
+    }
+    if (log_prob_frames_ == 0) {
+        return result;
     }
 
-    auto hypotheses = decoder_->decode(full_logits.data(), total_frames, vocab_size);
+    auto hypotheses = decode_buffered_segments(num_threads);
     if (!hypotheses.empty()) {
-        result.phonemes = decoder_->idxs_to_tokens(hypotheses[0].tokens);
+        result.phoneme_ids = decoder_->collapse_tokens(hypotheses[0].tokens);
+        result.phonemes = token_strings(*decoder_, result.phoneme_ids.begin(), result.phoneme_ids.end());
+        result.word_timings = word_timings_of(hypotheses[0], utterance_start_);
         result.confidence = hypotheses[0].score;
+        last_hypothesis_ = std::move(hypotheses[0]);
 
         ++chunks_processed_;
     }
@@ -1250,7 +2564,15 @@ RecognitionResult WindowProcessor::finalize() {
 }
 
 int WindowProcessor::valid_frame_count() const {
-    return static_cast<int>(valid_features_.size());
+    return frame_count_;
+}
+
+int WindowProcessor::buffered_frames() const {
+    return static_cast<int>(valid_frames_.size() / kFrameFeatureSize);
+}
+
+int WindowProcessor::utterance_end() const {
+    return endpoints_.empty() ? buffered_frames() : endpoints_.front();
 }
 
 int WindowProcessor::total_frames_seen() const {
@@ -1258,20 +2580,50 @@ int WindowProcessor::total_frames_seen() const {
 }
 
 int WindowProcessor::dropped_frame_count() const {
-    return total_frames_seen_ - static_cast<int>(valid_features_.size());
+    return total_frames_seen_ - valid_frame_count();
 }
 
 int WindowProcessor::chunks_processed() const {
     return chunks_processed_;
 }
 
+StreamStats WindowProcessor::stats() const {
+    StreamStats stats;
+    for (int i = 0; i < kProfileStageCount; ++i) {
+        stats.stages[i] = profiler_.latency(static_cast<ProfileStage>(i));
+    }
+    stats.frames_pushed = total_frames_seen_;
+    stats.frames_dropped = dropped_frame_count();
+    stats.windows_processed = finished_windows_ + policy_.chunk_index();
+    stats.decodes = chunks_processed_;
+    stats.provisional_results = provisional_results_;
+    stats.searched_frames = beam_searched_frames_;
+    return stats;
+}
+
+void WindowProcessor::reset_stats() {
+    profiler_.reset();
+}
+
+Profiler* WindowProcessor::profiler() {
+    return &profiler_;
+}
+
+const CTCHypothesis& WindowProcessor::last_hypothesis() const {
+    return last_hypothesis_;
+}
+
 //=============================================================================
 // SentenceCorrector Implementation
 //=============================================================================
 
 SentenceCorrector::SentenceCorrector(const std::string& homophones_path,
                                    const std::string& kenlm_path)
-    : homophones_path_(homophones_path), kenlm_path_(kenlm_path) {}
+    : homophones_path_(homophones_path), kenlm_path_(kenlm_path), profiler_(nullptr) {}
+
+void SentenceCorrector::set_profiler(Profiler* profiler) {
+    profiler_.store(profiler, std::memory_order_release);
+}
 
 namespace {
 bool parse_homophone_line(const std::string& line,
@@ -1346,7 +2698,7 @@ bool SentenceCorrector::initialize() {
 
     std::ifstream file(homophones_path_);
     if (!file.is_open()) {
-        std::cerr << "Failed to open homophones file: " << homophones_path_ << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "corrector", "Failed to open homophones file: " << homophones_path_);
         return false;
     }
 
@@ -1365,7 +2717,7 @@ bool SentenceCorrector::initialize() {
     try {
         kenlm_model_ = std::make_unique<lm::ngram::Model>(kenlm_path_.c_str());
     } catch (const std::exception& e) {
-        std::cerr << "Failed to load KenLM model: " << e.what() << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "corrector", "Failed to load KenLM model: " << e.what());
         return false;
     }
 
@@ -1373,6 +2725,7 @@ bool SentenceCorrector::initialize() {
 }
 
 std::string SentenceCorrector::correct(const std::vector<std::string>& liaphon_phonemes) {
+    CUED_SPEECH_PROFILE_SCOPE(profiler_.load(std::memory_order_acquire), ProfileStage::Correction);
     if (!kenlm_model_) {
         return {};
     }
@@ -1500,46 +2853,316 @@ std::vector<std::string> SentenceCorrector::beam_search(
     return beams.front().words;
 }
 
-namespace {
 std::string remove_accents(const std::string& input) {
-    static const std::unordered_map<std::string, std::string> replacements = {
-        {"\xC3\x80", "A"}, {"\xC3\x81", "A"}, {"\xC3\x82", "A"}, {"\xC3\x83", "A"},
-        {"\xC3\x84", "A"}, {"\xC3\x87", "C"}, {"\xC3\x88", "E"}, {"\xC3\x89", "E"},
-        {"\xC3\x8A", "E"}, {"\xC3\x8B", "E"}, {"\xC3\x8E", "I"}, {"\xC3\x8F", "I"},
-        {"\xC3\x94", "O"}, {"\xC3\x96", "O"}, {"\xC3\x99", "U"}, {"\xC3\x9B", "U"},
-        {"\xC3\x9C", "U"}, {"\xC3\xA0", "a"}, {"\xC3\xA1", "a"}, {"\xC3\xA2", "a"},
-        {"\xC3\xA3", "a"}, {"\xC3\xA4", "a"}, {"\xC3\xA7", "c"}, {"\xC3\xA8", "e"},
-        {"\xC3\xA9", "e"}, {"\xC3\xAA", "e"}, {"\xC3\xAB", "e"}, {"\xC3\xAE", "i"},
-        {"\xC3\xAF", "i"}, {"\xC3\xB4", "o"}, {"\xC3\xB6", "o"}, {"\xC3\xB9", "u"},
-        {"\xC3\xBB", "u"}, {"\xC3\xBC", "u"}, {"\xC5\x92", "OE"}, {"\xC5\x93", "oe"}
+    return fold_to_ascii(input);
+}
+
+//=============================================================================
+// Subtitle Video Writer
+//=============================================================================
+
+namespace {
+
+/**
+ * Subtitle rendered once per text change and blended into every frame
+ *
+ * The outline and text are drawn onto a black canvas the size of the text
+ * box, with a matching coverage mask. The canvas is then the premultiplied
+ * colour, and the mask is stored inverted and repeated per channel so the
+ * per-frame blend is one flat byte loop over the box that the compiler
+ * vectorises.
+ */
+class SubtitleOverlay {
+public:
+    void apply(cv::Mat& frame, const std::shared_ptr<const std::string>& text) {
+        if (text != text_ || frame.size() != frame_size_) {
+            render(text, frame.size());
+        }
+        if (box_.empty()) {
+            return;
+        }
+
+        const int row_bytes = box_.width * 3;
+        for (int row = 0; row < box_.height; ++row) {
+            uint8_t* dst = frame.ptr<uint8_t>(box_.y + row) + box_.x * 3;
+            const uint8_t* color = color_.ptr<uint8_t>(origin_.y + row) + origin_.x * 3;
+            const uint8_t* inv_alpha = inv_alpha_.ptr<uint8_t>(origin_.y + row) + origin_.x * 3;
+            for (int i = 0; i < row_bytes; ++i) {
+                // dst * inv_alpha / 255, rounded, without a division
+                const uint32_t scaled = static_cast<uint32_t>(dst[i]) * inv_alpha[i] + 128;
+                const uint32_t blended = color[i] + ((scaled + (scaled >> 8)) >> 8);
+                dst[i] = static_cast<uint8_t>(blended > 255 ? 255 : blended);
+            }
+        }
+    }
+
+private:
+    void render(const std::shared_ptr<const std::string>& text, cv::Size frame_size) {
+        text_ = text;
+        frame_size_ = frame_size;
+        box_ = cv::Rect();
+        if (!text || text->empty()) {
+            return;
+        }
+
+        int baseline = 0;
+        const int font = cv::FONT_HERSHEY_SIMPLEX;
+        const double font_scale = 1.0;
+        const int thickness = 2;
+        const int margin = thickness + 2;  // Outline stroke and anti-aliasing
+        const cv::Size text_size = cv::getTextSize(*text, font, font_scale, thickness, &baseline);
+        const int x = (frame_size.width - text_size.width) / 2;
+        const int y = static_cast<int>(frame_size.height * 0.9);
+
+        const cv::Size canvas_size(text_size.width + 2 * margin,
+                                   text_size.height + baseline + 2 * margin);
+        const cv::Point pen(margin, margin + text_size.height);
+        cv::Mat color(canvas_size, CV_8UC3, cv::Scalar(0, 0, 0));
+        cv::Mat coverage(canvas_size, CV_8UC1, cv::Scalar(0));
+
+        // The black outline leaves the colour canvas unchanged but covers the mask
+        cv::putText(coverage, *text, pen, font, font_scale, cv::Scalar(255), thickness + 2, cv::LINE_AA);
+        cv::putText(color, *text, pen, font, font_scale,
+                    cv::Scalar(255, 255, 255), thickness, cv::LINE_AA);
+
+        inv_alpha_.create(canvas_size.height, canvas_size.width, CV_8UC3);
+        for (int row = 0; row < canvas_size.height; ++row) {
+            const uint8_t* alpha = coverage.ptr<uint8_t>(row);
+            uint8_t* inv = inv_alpha_.ptr<uint8_t>(row);
+            for (int col = 0; col < canvas_size.width; ++col) {
+                inv[3 * col] = inv[3 * col + 1] = inv[3 * col + 2] = static_cast<uint8_t>(255 - alpha[col]);
+            }
+        }
+        color_ = color;
+
+        // Clip the box to the frame, remembering where it starts in the canvas
+        const cv::Rect placed(x - pen.x, y - pen.y, canvas_size.width, canvas_size.height);
+        box_ = placed & cv::Rect(0, 0, frame_size.width, frame_size.height);
+        origin_ = cv::Point(box_.x - placed.x, box_.y - placed.y);
+    }
+
+    std::shared_ptr<const std::string> text_;
+    cv::Size frame_size_;
+    cv::Rect box_;          // Blended region of the frame
+    cv::Point origin_;      // Top-left of box_ within the canvases
+    cv::Mat color_;         // CV_8UC3, premultiplied subtitle colour
+    cv::Mat inv_alpha_;     // CV_8UC3, 255 - coverage for each channel
+};
+
+} // namespace
+
+std::string subtitle_text(const RecognitionResult& result) {
+    if (!result.french_sentence.empty()) {
+        return remove_accents(result.french_sentence);
+    }
+
+    std::string text;
+    for (const auto& phoneme : result.phonemes) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text.append(phoneme);
+    }
+    return text;
+}
+
+struct SubtitleVideoWriter::Impl {
+    struct QueuedFrame {
+        cv::Mat image;
+        std::shared_ptr<const std::string> text;
     };
 
-    std::string output;
-    for (size_t i = 0; i < input.size();) {
-        bool replaced = false;
-        for (const auto& kv : replacements) {
-            const auto& key = kv.first;
-            if (input.compare(i, key.size(), key) == 0) {
-                output.append(kv.second);
-                i += key.size();
-                replaced = true;
-                break;
+    VideoWriterConfig config;
+    cv::VideoWriter writer;
+    cv::Size size;
+    std::string output_path;
+
+    std::shared_ptr<const std::string> text = std::make_shared<const std::string>();
+
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<QueuedFrame> queue;
+    bool open = false;
+    bool stopping = false;
+    std::thread encoder;
+
+    VideoWriterStats stats;
+    std::chrono::steady_clock::time_point opened_at;
+
+    SubtitleOverlay overlay;  // Encoder thread only
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            not_empty.wait(lock, [this] { return !queue.empty() || stopping; });
+            if (queue.empty()) {
+                break;  // stopping and drained
             }
+
+            QueuedFrame item = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            not_full.notify_one();
+
+            const auto started = std::chrono::steady_clock::now();
+            overlay.apply(item.image, item.text);
+            writer.write(item.image);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+            lock.lock();
+            stats.encode_seconds += elapsed.count();
+            ++stats.frames_written;
         }
-        if (!replaced) {
-            output.push_back(input[i]);
-            ++i;
+    }
+};
+
+SubtitleVideoWriter::SubtitleVideoWriter(const VideoWriterConfig& config)
+    : impl_(std::make_unique<Impl>()) {
+    impl_->config = config;
+    if (impl_->config.queue_capacity < 1) {
+        impl_->config.queue_capacity = 1;
+    }
+}
+
+SubtitleVideoWriter::~SubtitleVideoWriter() {
+    close();
+}
+
+bool SubtitleVideoWriter::open(const std::string& output_path, double fps, int width, int height) {
+    close();
+
+    const std::string& codec = impl_->config.codec;
+    if (codec.size() != 4) {
+        CUED_SPEECH_LOG(LogLevel::Error, "video", "Codec must be a four-character code: " << codec);
+        return false;
+    }
+
+    impl_->size = cv::Size(width & ~1, height & ~1);
+    if (impl_->size.width <= 0 || impl_->size.height <= 0) {
+        CUED_SPEECH_LOG(LogLevel::Error, "video", "Invalid video size " << width << "x" << height);
+        return false;
+    }
+
+    const int fourcc = cv::VideoWriter::fourcc(codec[0], codec[1], codec[2], codec[3]);
+    const int api = impl_->config.backend == VideoBackend::FFmpeg ? cv::CAP_FFMPEG : cv::CAP_ANY;
+    if (!impl_->writer.open(output_path, api, fourcc, fps > 0.0 ? fps : 30.0, impl_->size)) {
+        CUED_SPEECH_LOG(LogLevel::Error, "video",
+                        "Failed to open VideoWriter: " << output_path << " (codec " << codec << ")");
+        return false;
+    }
+
+    impl_->output_path = output_path;
+    impl_->queue.clear();
+    impl_->stats = VideoWriterStats();
+    impl_->opened_at = std::chrono::steady_clock::now();
+    impl_->stopping = false;
+    impl_->open = true;
+    impl_->encoder = std::thread(&Impl::run, impl_.get());
+    return true;
+}
+
+bool SubtitleVideoWriter::is_open() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->open;
+}
+
+void SubtitleVideoWriter::set_subtitle(const RecognitionResult& result) {
+    set_text(subtitle_text(result));
+}
+
+void SubtitleVideoWriter::set_text(const std::string& text) {
+    auto shared = std::make_shared<const std::string>(text);
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->text = std::move(shared);
+}
+
+bool SubtitleVideoWriter::write_frame(const uint8_t* bgr, int width, int height, size_t stride) {
+    if (!bgr || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // Copy on the caller's thread; the caller may reuse its buffer at once
+    const cv::Mat view(height, width, CV_8UC3, const_cast<uint8_t*>(bgr),
+                       stride > 0 ? stride : static_cast<size_t>(width) * 3);
+    Impl::QueuedFrame item;
+    if (view.size() == impl_->size) {
+        item.image = view.clone();
+    } else if (view.cols >= impl_->size.width && view.rows >= impl_->size.height &&
+               view.cols - impl_->size.width <= 1 && view.rows - impl_->size.height <= 1) {
+        item.image = view(cv::Rect(0, 0, impl_->size.width, impl_->size.height)).clone();
+    } else {
+        cv::resize(view, item.image, impl_->size);
+    }
+
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    if (!impl_->open) {
+        return false;
+    }
+
+    if (static_cast<int>(impl_->queue.size()) >= impl_->config.queue_capacity) {
+        const auto started = std::chrono::steady_clock::now();
+        impl_->not_full.wait(lock, [this] {
+            return static_cast<int>(impl_->queue.size()) < impl_->config.queue_capacity;
+        });
+        const std::chrono::duration<double> waited = std::chrono::steady_clock::now() - started;
+        impl_->stats.blocked_seconds += waited.count();
+        if (!impl_->open) {
+            return false;
         }
     }
-    return output;
+
+    item.text = impl_->text;
+    impl_->queue.push_back(std::move(item));
+    impl_->stats.max_queue_depth = std::max(impl_->stats.max_queue_depth,
+                                            static_cast<int>(impl_->queue.size()));
+    lock.unlock();
+    impl_->not_empty.notify_one();
+    return true;
 }
+
+void SubtitleVideoWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (!impl_->open) {
+            return;
+        }
+        impl_->open = false;
+        impl_->stopping = true;
+    }
+    impl_->not_empty.notify_one();
+    if (impl_->encoder.joinable()) {
+        impl_->encoder.join();
+    }
+    impl_->writer.release();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - impl_->opened_at;
+    impl_->stats.elapsed_seconds = elapsed.count();
+    impl_->stats.frames_per_second = elapsed.count() > 0.0
+        ? static_cast<double>(impl_->stats.frames_written) / elapsed.count()
+        : 0.0;
+
+    if (log_enabled(LogLevel::Info)) {
+        log_message(LogLevel::Info, "video", "Subtitled video written",
+                    {{"path", impl_->output_path},
+                     {"frames", impl_->stats.frames_written},
+                     {"fps", impl_->stats.frames_per_second},
+                     {"encode_seconds", impl_->stats.encode_seconds},
+                     {"blocked_seconds", impl_->stats.blocked_seconds}});
+    }
+}
+
+VideoWriterStats SubtitleVideoWriter::stats() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->stats;
 }
 
 bool write_subtitled_video(
     const std::string& input_path,
     const std::deque<RecognitionResult>& recognition_results,
     const std::string& output_path,
-    double fps) {
+    double fps,
+    const VideoWriterConfig& config) {
 
     std::vector<RecognitionResult> results(recognition_results.begin(), recognition_results.end());
     std::sort(results.begin(), results.end(),
@@ -1549,7 +3172,7 @@ bool write_subtitled_video(
 
     cv::VideoCapture cap(input_path);
     if (!cap.isOpened()) {
-        std::cerr << "Failed to open video: " << input_path << std::endl;
+        CUED_SPEECH_LOG(LogLevel::Error, "video", "Failed to open video: " << input_path);
         return false;
     }
 
@@ -1558,28 +3181,16 @@ bool write_subtitled_video(
         video_fps = 30.0;
     }
 
-    int width = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
-    int height = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
-    width &= ~1;
-    height &= ~1;
-
-    cv::VideoWriter writer(
-        output_path,
-        cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
-        video_fps,
-        cv::Size(width, height));
+    const int width = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
+    const int height = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
 
-    if (!writer.isOpened()) {
-        std::cerr << "Failed to open VideoWriter: " << output_path << std::endl;
+    SubtitleVideoWriter writer(config);
+    if (!writer.open(output_path, video_fps, width, height)) {
         cap.release();
         return false;
     }
 
     size_t result_index = 0;
-    int next_frame_update = results.empty() ? std::numeric_limits<int>::max()
-                                            : results.front().frame_number;
-    std::string current_text;
-
     int frame_num = 0;
     cv::Mat frame;
     while (cap.read(frame)) {
@@ -1588,48 +3199,235 @@ bool write_subtitled_video(
             break;
         }
 
-        if (frame_num >= next_frame_update && result_index < results.size()) {
-            const auto& entry = results[result_index];
-            if (!entry.french_sentence.empty()) {
-                current_text = remove_accents(entry.french_sentence);
-            } else if (!entry.phonemes.empty()) {
-                current_text.clear();
-                for (size_t i = 0; i < entry.phonemes.size(); ++i) {
-                    if (i > 0) {
-                        current_text.push_back(' ');
-                    }
-                    current_text.append(entry.phonemes[i]);
-                }
+        if (result_index < results.size() && frame_num >= results[result_index].frame_number) {
+            const std::string text = subtitle_text(results[result_index]);
+            if (!text.empty()) {
+                writer.set_text(text);
             }
-
             ++result_index;
-            next_frame_update = (result_index < results.size())
-                ? results[result_index].frame_number
-                : std::numeric_limits<int>::max();
         }
 
-        if (!current_text.empty()) {
-            int baseline = 0;
-            const int font = cv::FONT_HERSHEY_SIMPLEX;
-            double font_scale = 1.0;
-            int thickness = 2;
-            cv::Size text_size = cv::getTextSize(current_text, font, font_scale, thickness, &baseline);
-            int x = (width - text_size.width) / 2;
-            int y = static_cast<int>(height * 0.9);
+        writer.write_frame(frame.data, frame.cols, frame.rows, frame.step);
+    }
+
+    writer.close();
+    cap.release();
+
+    return true;
+}
 
-            cv::putText(frame, current_text, cv::Point(x, y), font, font_scale,
-                        cv::Scalar(0, 0, 0), thickness + 2, cv::LINE_AA);
-            cv::putText(frame, current_text, cv::Point(x, y), font, font_scale,
-                        cv::Scalar(255, 255, 255), thickness, cv::LINE_AA);
+//=============================================================================
+// Subtitle Export
+//=============================================================================
+
+namespace {
+
+struct SubtitleCue {
+    double start;
+    double end;
+    std::string text;
+};
+
+std::string format_timestamp(double seconds, char millis_separator) {
+    const long long total_ms = std::llround(std::max(0.0, seconds) * 1000.0);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%02lld:%02lld:%02lld%c%03lld",
+                  total_ms / 3600000, (total_ms / 60000) % 60, (total_ms / 1000) % 60,
+                  millis_separator, total_ms % 1000);
+    return buffer;
+}
+
+std::string sentence_text(const RecognitionResult& result) {
+    if (!result.french_sentence.empty()) {
+        return result.french_sentence;
+    }
+
+    std::string text;
+    for (const auto& phoneme : result.phonemes) {
+        if (!text.empty()) {
+            text.push_back(' ');
         }
+        text.append(phoneme);
+    }
+    return text;
+}
 
-        writer.write(frame);
+std::vector<std::string> split_words(const std::string& text) {
+    std::vector<std::string> words;
+    std::istringstream iss(text);
+    std::string word;
+    while (iss >> word) {
+        words.push_back(word);
     }
+    return words;
+}
 
-    writer.release();
-    cap.release();
+/**
+ * Stream frame of a valid frame (see SubtitleOptions::stream_frames)
+ */
+int stream_frame(const std::vector<int>& stream_frames, int frame) {
+    if (stream_frames.empty() || frame < 0) {
+        return frame;
+    }
+    const int last = static_cast<int>(stream_frames.size()) - 1;
+    return frame <= last ? stream_frames[frame] : stream_frames[last] + (frame - last);
+}
 
-    return true;
+/**
+ * Stream frame count up to and including the frame_number-th valid frame
+ */
+int stream_frame_number(const std::vector<int>& stream_frames, int frame_number) {
+    return frame_number > 0 ? stream_frame(stream_frames, frame_number - 1) + 1 : frame_number;
+}
+
+std::vector<SubtitleCue> sentence_cues(const std::vector<const RecognitionResult*>& results,
+                                       double fps,
+                                       double last_cue_seconds,
+                                       const std::vector<int>& stream_frames) {
+    std::vector<SubtitleCue> cues;
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::string text = sentence_text(*results[i]);
+        if (text.empty()) {
+            continue;
+        }
+
+        // Frame numbers are 1-based counts: result k is shown from frame k on
+        const int first = stream_frame_number(stream_frames, results[i]->frame_number);
+        const double start = std::max(0, first - 1) / fps;
+        double end = start + last_cue_seconds;
+        for (size_t j = i + 1; j < results.size(); ++j) {
+            if (!sentence_text(*results[j]).empty()) {
+                end = std::max(0, stream_frame_number(stream_frames, results[j]->frame_number) - 1) / fps;
+                break;
+            }
+        }
+        if (end > start) {
+            cues.push_back({start, end, std::move(text)});
+        }
+    }
+    return cues;
+}
+
+std::vector<SubtitleCue> word_cues(const std::vector<const RecognitionResult*>& results,
+                                   double fps,
+                                   const std::vector<int>& stream_frames) {
+    struct TimedWord {
+        int start_frame;
+        int end_frame;
+        std::string text;
+    };
+
+    // Each result re-decodes from some frame on; its words replace the
+    // previously collected ones from that frame.
+    std::vector<TimedWord> words;
+    for (const auto* result : results) {
+        const auto& timings = result->word_timings;
+        if (timings.empty()) {
+            continue;
+        }
+
+        const auto french = split_words(result->french_sentence);
+        const bool use_french = french.size() == timings.size();
+
+        const int first_frame = timings.front().start_frame;
+        while (!words.empty() && words.back().end_frame >= first_frame) {
+            words.pop_back();
+        }
+        for (size_t i = 0; i < timings.size(); ++i) {
+            words.push_back({timings[i].start_frame, timings[i].end_frame,
+                             use_french ? french[i] : timings[i].word});
+        }
+    }
+
+    std::vector<SubtitleCue> cues;
+    cues.reserve(words.size());
+    for (auto& word : words) {
+        cues.push_back({stream_frame(stream_frames, word.start_frame) / fps,
+                        (stream_frame(stream_frames, word.end_frame) + 1) / fps,
+                        std::move(word.text)});
+    }
+    return cues;
+}
+
+} // namespace
+
+std::vector<int> stream_frames_of(const uint8_t* valid_mask, int count) {
+    std::vector<int> frames;
+    frames.reserve(std::max(0, count));
+    for (int i = 0; i < count; ++i) {
+        if (valid_mask[i]) {
+            frames.push_back(i);
+        }
+    }
+    return frames;
+}
+
+std::string format_subtitles(
+    const std::deque<RecognitionResult>& results,
+    double fps,
+    const SubtitleOptions& options) {
+
+    if (fps <= 0.0) {
+        fps = 30.0;
+    }
+
+    std::vector<const RecognitionResult*> ordered;
+    ordered.reserve(results.size());
+    for (const auto& result : results) {
+        ordered.push_back(&result);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const RecognitionResult* a, const RecognitionResult* b) {
+                         return a->frame_number < b->frame_number;
+                     });
+
+    bool has_timings = false;
+    for (const auto* result : ordered) {
+        has_timings = has_timings || !result->word_timings.empty();
+    }
+
+    const auto cues = options.word_timings && has_timings
+        ? word_cues(ordered, fps, options.stream_frames)
+        : sentence_cues(ordered, fps, options.last_cue_seconds, options.stream_frames);
+
+    const bool vtt = options.format == SubtitleFormat::WebVTT;
+    const char separator = vtt ? '.' : ',';
+
+    std::string out;
+    out.reserve(cues.size() * 64 + 8);
+    if (vtt) {
+        out += "WEBVTT\n\n";
+    }
+    for (size_t i = 0; i < cues.size(); ++i) {
+        if (!vtt) {
+            out += std::to_string(i + 1);
+            out += '\n';
+        }
+        out += format_timestamp(cues[i].start, separator);
+        out += " --> ";
+        out += format_timestamp(cues[i].end, separator);
+        out += '\n';
+        out += cues[i].text;
+        out += "\n\n";
+    }
+    return out;
+}
+
+bool write_subtitles(
+    const std::string& path,
+    const std::deque<RecognitionResult>& results,
+    double fps,
+    const SubtitleOptions& options) {
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        CUED_SPEECH_LOG(LogLevel::Error, "subtitles", "Failed to open subtitle file: " << path);
+        return false;
+    }
+
+    const std::string text = format_subtitles(results, fps, options);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return static_cast<bool>(out);
 }
 
 } // namespace cued_speech
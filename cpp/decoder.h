@@ -9,16 +9,24 @@
 #ifndef CUED_SPEECH_DECODER_H
 #define CUED_SPEECH_DECODER_H
 
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <map>
 #include <deque>
 #include <unordered_map>
 #include <limits>
+#include <mutex>
 
 #include <kenlm/lm/model.hh>
 
+#include "logging.h"
+#include "profiling.h"
+#include "transliteration.h"
+
 // Forward declarations
 namespace fl {
 namespace lib {
@@ -27,18 +35,66 @@ class LexiconDecoder;
 class LexiconFreeDecoder;
 class Dictionary;
 class Trie;
+class LM;
 }
 }
 }
 
 namespace cued_speech {
 
-// Constants
+class TokenPrunedDecoder;
+class LexiconBeamSearch;
+class LexiconTrie;
+class WordLM;
+
+// Default windowing constants (see WindowingConfig)
 constexpr int WINDOW_SIZE = 100;
 constexpr int COMMIT_SIZE = 50;
 constexpr int LEFT_CONTEXT = 25;
 constexpr int RIGHT_CONTEXT = 25;
 
+/**
+ * How the commit size of the overlap-save windowing evolves over a stream
+ */
+enum class WindowingMode {
+    Fixed,     // Always commit commit_size frames per window
+    Adaptive   // Shrink commit size when idle (latency), grow it under load (throughput)
+};
+
+/**
+ * Overlap-save windowing parameters
+ *
+ * Each window feeds window_size frames to the sequence model: left_context
+ * frames already committed, then the commit range, then right context.
+ * left_context + max commit size must fit in window_size.
+ */
+struct WindowingConfig {
+    int window_size = WINDOW_SIZE;
+    int commit_size = COMMIT_SIZE;
+    int left_context = LEFT_CONTEXT;
+
+    WindowingMode mode = WindowingMode::Fixed;
+    int min_commit_size = 10;         // Adaptive lower bound
+    int max_commit_size = COMMIT_SIZE; // Adaptive upper bound
+    float frame_rate = 30.0f;         // Used to turn window cost into a real-time load
+    float low_load = 0.25f;           // Shrink commit below this fraction of real time
+    float high_load = 0.75f;          // Grow commit above this fraction of real time
+
+    int provisional_interval = 0;     // Valid frames between provisional results (0 = off)
+
+    // Utterance endpointing (streaming): an endpoint decodes the utterance,
+    // flags the result and starts the next utterance with empty history
+    int endpoint_silence_frames = 0;  // Committed blank/silence frames that end an utterance (0 = off)
+    float endpoint_log_prob = -0.1f;  // Blank + silence log-prob above which a frame is silent
+    int endpoint_dropped_frames = 0;  // Consecutive dropped frames that end an utterance (0 = off)
+
+    // Two-pass streaming: a greedy pass over every window, and the beam
+    // search only over the frames after the last cut at confident silence
+    // (segment_silence_frames, segment_log_prob) at least this many frames
+    // before the newest committed frame
+    int two_pass_margin = 0;          // Frames of context searched again before new frames (0 = off)
+};
+
 /**
  * Hypothesis returned by the decoder
  */
@@ -47,6 +103,16 @@ struct CTCHypothesis {
     std::vector<std::string> words;    // Decoded words
     float score;                        // Hypothesis score
     std::vector<int> timesteps;        // Token timesteps
+    std::vector<int> word_start_frames; // First non-blank frame of each word
+    std::vector<int> word_end_frames;   // Frame at which each word was emitted
+};
+
+/**
+ * Lexicon beam search implementation
+ */
+enum class DecoderEngine {
+    Flashlight,  // flashlight-text LexiconDecoder
+    Native       // LexiconBeamSearch (same results, flat cache-friendly layout)
 };
 
 /**
@@ -67,12 +133,31 @@ struct DecoderConfig {
     float unk_score = -std::numeric_limits<float>::infinity();
     float sil_score = 0.0f;
     bool log_add = false;
+    float blank_skip_threshold = 0.0f; // Merge runs of frames with blank log-prob above this (0 = off)
+    float token_mass = 1.0f;          // Expand the fewest tokens covering this probability mass (1 = off)
+    DecoderEngine engine = DecoderEngine::Flashlight;
+
+    // Offline decodes (decode_segmented) split long inputs at silence and
+    // decode the segments concurrently
+    int segment_frames = 0;           // Shortest segment cut at silence (0 = off)
+    int segment_silence_frames = 10;  // Silent frames in a row where a segment may end
+    float segment_log_prob = -0.05f;  // Blank + silence log-prob above which a frame is silent
     
     std::string blank_token = "<BLANK>";
     std::string sil_token = "_";
     std::string unk_word = "<UNK>";
+
+    WindowingConfig windowing;        // Default windowing for streams on this decoder
 };
 
+/**
+ * Layout of a frame in flat feature buffers: hand_shape, hand_position, lips
+ */
+constexpr int kHandShapeFeatures = 7;
+constexpr int kHandPositionFeatures = 18;
+constexpr int kLipsFeatures = 8;
+constexpr int kFrameFeatureSize = kHandShapeFeatures + kHandPositionFeatures + kLipsFeatures;
+
 /**
  * Feature extraction result for a single frame
  */
@@ -104,26 +189,97 @@ struct LandmarkResults {
     std::vector<Landmark> pose_landmarks;
 };
 
+/**
+ * Frame span of a decoded word (valid-frame indices, inclusive)
+ */
+struct WordTiming {
+    std::string word;
+    int start_frame;
+    int end_frame;
+};
+
 /**
  * Recognition result for a decoded segment
  */
 struct RecognitionResult {
     int frame_number;
-    std::vector<std::string> phonemes;
+    std::vector<std::string> phonemes;           // Committed prefix
     std::string french_sentence;
     float confidence;
+    std::vector<std::string> unstable_phonemes;  // Speculative tail (provisional only)
+    bool provisional = false;                    // Decoded from a zero-padded partial window
+    std::vector<WordTiming> word_timings;        // Lexicon words of the decode (not provisional)
+    std::vector<int> phoneme_ids;                // Token indices of phonemes
+    std::vector<int> unstable_phoneme_ids;       // Token indices of unstable_phonemes
+    bool endpoint = false;                       // Last result of an utterance
 };
 
+/**
+ * Non-owning view of row-major [frames x vocab] logits
+ */
+struct LogitsView {
+    const float* data = nullptr;
+    int frames = 0;
+    int vocab = 0;
+
+    bool empty() const {
+        return data == nullptr || frames <= 0 || vocab <= 0;
+    }
+
+    /**
+     * Sub-view of rows [first, last]
+     */
+    LogitsView rows(int first, int last) const {
+        return {data + static_cast<size_t>(first) * vocab, last - first + 1, vocab};
+    }
+};
+
+/**
+ * TFLite sequence model (lips, hand_shape, hand_pos) -> logits
+ *
+ * Inputs and outputs are matched by signature key (or tensor name when the
+ * model has no signature): "lips", "hand_shape", "hand_pos" and "logits",
+ * falling back to the first three inputs and the first output.
+ *
+ * A model with more than three inputs is a stateful streaming variant: each
+ * extra input X is a recurrent state tensor whose updated value is the
+ * output named X_out. The state is carried between infer() calls until
+ * reset_state(), so only new frames need to be fed.
+ */
 class TFLiteSequenceModel {
 public:
     TFLiteSequenceModel();
     ~TFLiteSequenceModel();
 
     bool load(const std::string& model_path);
+
+    /**
+     * New model with its own interpreter over the same loaded flatbuffer,
+     * for running inference on several threads (unloaded if this model is)
+     */
+    std::unique_ptr<TFLiteSequenceModel> clone() const;
+
     std::vector<float> infer(const std::vector<FrameFeatures>& frames, int window_size);
+
+    /**
+     * Like infer(), but returns a view onto the interpreter output tensor.
+     * The view is invalidated by the next call on this model.
+     */
+    LogitsView infer_view(const std::vector<FrameFeatures>& frames, int window_size);
+
+    /**
+     * infer_view() on count frames in flat layout (kFrameFeatureSize floats
+     * each), copied straight into the input tensors; rows from count up to
+     * window_size are zero. The copy and the invocation are recorded as
+     * WindowAssembly and ModelInvoke when profiler is given.
+     */
+    LogitsView infer_view(const float* frames, int count, int window_size, Profiler* profiler = nullptr);
+
     int vocab_size() const;
     int last_sequence_length() const;
     bool is_loaded() const;
+    bool is_stateful() const;
+    void reset_state();
 
 private:
     struct Impl;
@@ -173,12 +329,74 @@ public:
     /**
      * Decode from log probabilities
      * 
+     * Safe to call from several threads at once: each call borrows its own
+     * beam search (sharing the trie and language model) from a pool.
+     *
+     * With token_mass below 1, each frame only expands its candidate count
+     * of best tokens (at most beam_size_token).
+     *
      * @param log_probs 2D array [T x V] in log space
      * @param T Number of time steps
      * @param V Vocabulary size
+     * @param candidates Tokens to expand per frame [T] from the pruning
+     *                   log_softmax, or nullptr to count them here
      * @return Vector of hypotheses (size = nbest)
      */
-    std::vector<CTCHypothesis> decode_log_probs(const float* log_probs, int T, int V);
+    std::vector<CTCHypothesis> decode_log_probs(const float* log_probs, int T, int V,
+                                                const int* candidates = nullptr);
+
+    /**
+     * Merge runs of blank-dominated frames before beam search
+     *
+     * Each run of consecutive frames whose blank log-probability exceeds
+     * config().blank_skip_threshold is reduced to its first frame. One blank
+     * frame is enough to separate repeated tokens, so the collapsed output of
+     * a path is unchanged. decode_log_probs applies this itself and maps the
+     * hypotheses back to the original frames.
+     *
+     * @param log_probs 2D array [T x V] in log space
+     * @param reduced Kept rows [T' x V] (left empty if every frame is kept)
+     * @param frame_map Original frame of each kept row
+     * @return T', the number of kept rows
+     */
+    int skip_blank_frames(const float* log_probs, int T, int V,
+                          std::vector<float>& reduced, std::vector<int>& frame_map) const;
+
+    /**
+     * Log-probability that a frame is blank or silence ("_")
+     *
+     * @param row Log probabilities of one frame [V]
+     */
+    float silence_log_prob(const float* row, int V) const;
+
+    /**
+     * Split log probabilities into segments at confident silence
+     *
+     * A segment ends in the middle of a run of at least
+     * segment_silence_frames frames whose silence_log_prob exceeds
+     * segment_log_prob, once it is segment_frames long. A cut inside such a
+     * run cannot split a token or a word.
+     *
+     * @return Segment boundaries: 0, the cut frames, then T (just 0 and T
+     *         when segmentation is off or finds no cut)
+     */
+    std::vector<int> find_segments(const float* log_probs, int T, int V) const;
+
+    /**
+     * Decode long log probabilities segment by segment
+     *
+     * The segments of find_segments() are decoded concurrently (each with
+     * its own beam search and a fresh language model context) and their
+     * best paths stitched in order: tokens, words, word frames and
+     * timesteps are in frames of the whole input and the score is the sum.
+     * Without cuts this is decode_log_probs().
+     *
+     * @param num_threads Decoding threads (0 = hardware concurrency)
+     * @param candidates Tokens to expand per frame [T], or nullptr
+     * @return The stitched best hypothesis (empty if a segment failed)
+     */
+    std::vector<CTCHypothesis> decode_segmented(const float* log_probs, int T, int V, int num_threads,
+                                                const int* candidates = nullptr);
     
     /**
      * Convert token indices to token strings
@@ -186,7 +404,20 @@ public:
      * @param indices Vector of token indices
      * @return Vector of token strings
      */
-    std::vector<std::string> idxs_to_tokens(const std::vector<int>& indices);
+    std::vector<std::string> idxs_to_tokens(const std::vector<int>& indices) const;
+
+    /**
+     * Collapse token indices to phone token indices
+     *
+     * Applies the idxs_to_tokens rules (drop the first and last step, blanks,
+     * <PAD>, <SOS>, <EOS> and unknown indices, merge repeats, trim trailing
+     * silence) on integer IDs without building strings.
+     *
+     * @param indices Vector of token indices
+     * @param out Collapsed indices (cleared first)
+     */
+    void collapse_tokens(const std::vector<int>& indices, std::vector<int>& out) const;
+    std::vector<int> collapse_tokens(const std::vector<int>& indices) const;
     
     /**
      * Get vocabulary size
@@ -203,11 +434,69 @@ public:
      */
     std::string idx_to_token(int idx) const;
 
+    /**
+     * Get token string from index without copying ("" if out of range)
+     *
+     * The view is NUL-terminated and valid for the lifetime of the decoder,
+     * so data() can be handed out as a C string.
+     */
+    std::string_view token_view(int idx) const;
+
+    /**
+     * Get the configuration the decoder was created with
+     */
+    const DecoderConfig& config() const;
+
+    /**
+     * Apply log softmax to logits, row by row
+     *
+     * @param logits Input [T x V]
+     * @param log_probs Output [T x V], may not alias logits
+     */
+    static void log_softmax(const float* logits, float* log_probs, int T, int V);
+
+    /**
+     * Apply log softmax and count each frame's token candidates
+     *
+     * A frame's candidates are its fewest best tokens whose probabilities
+     * add up to mass. Counting reuses the exponentials of the softmax and
+     * partially sorts each row once (O(V log max_candidates)).
+     *
+     * @param logits Input [T x V]
+     * @param log_probs Output [T x V], may not alias logits
+     * @param mass Probability mass to cover, in (0, 1]
+     * @param max_candidates Upper bound of a count
+     * @param candidates Output [T]
+     */
+    static void log_softmax(const float* logits, float* log_probs, int T, int V,
+                            float mass, int max_candidates, int* candidates);
+
+    /**
+     * Count each frame's token candidates from log probabilities
+     *
+     * Same counts as the pruning log_softmax, using config().token_mass.
+     *
+     * @param log_probs 2D array [T x V] in log space
+     * @param candidates Output [T]
+     */
+    void count_token_candidates(const float* log_probs, int T, int V, int* candidates) const;
+
+    /**
+     * Tokens a frame may expand at most (beam_size_token, or V)
+     */
+    int max_token_candidates(int V) const;
+
 private:
     DecoderConfig config_;
     
-    // Decoder components
-    std::unique_ptr<fl::lib::text::LexiconDecoder> lexicon_decoder_;
+    // Decoder components. LexiconDecoder keeps its beams between steps, so
+    // idle ones are pooled and concurrent decodes each take their own.
+    std::shared_ptr<fl::lib::text::LM> word_lm_;
+    std::mutex lexicon_pool_mutex_;
+    std::vector<std::unique_ptr<TokenPrunedDecoder>> lexicon_pool_;
+    std::vector<std::unique_ptr<LexiconBeamSearch>> native_pool_;   // DecoderEngine::Native
+    std::shared_ptr<const LexiconTrie> native_trie_;
+    std::shared_ptr<const WordLM> native_lm_;
     std::unique_ptr<fl::lib::text::Dictionary> tokens_dict_;
     std::unique_ptr<fl::lib::text::Dictionary> word_dict_;
     std::shared_ptr<fl::lib::text::Trie> trie_;
@@ -218,9 +507,18 @@ private:
     int sil_idx_;
     int unk_idx_;
     
-    // Token mappings
-    std::map<std::string, int> token_to_index_;
-    std::map<int, std::string> index_to_token_;
+    // Per-token flags used by collapse_tokens
+    enum TokenFlag : uint8_t {
+        kTokenDropped = 1 << 0,   // <BLANK>, <PAD>, <SOS>, <EOS>
+        kTokenSilence = 1 << 1    // "_"
+    };
+
+    // Token mappings: dense views into token_chars_ (NUL-separated),
+    // indexed by token ID
+    std::vector<char> token_chars_;
+    std::vector<std::string_view> index_to_token_;
+    std::vector<uint8_t> token_flags_;
+    std::unordered_map<std::string_view, int> token_to_index_;
     
     /**
      * Load tokens from file
@@ -241,11 +539,16 @@ private:
      * Build trie structure for lexicon-based decoding
      */
     bool build_trie();
-    
+
     /**
-     * Apply log softmax to logits
+     * Create a lexicon beam search over trie_ and word_lm_
      */
-    void log_softmax(const float* logits, float* log_probs, int T, int V);
+    std::unique_ptr<TokenPrunedDecoder> create_lexicon_decoder() const;
+
+    /**
+     * Create a native beam search over native_trie_ and native_lm_
+     */
+    std::unique_ptr<LexiconBeamSearch> create_native_search() const;
 };
 
 /**
@@ -271,7 +574,14 @@ public:
         const LandmarkResults* prev2_landmarks = nullptr
     );
 
+    /**
+     * Record extraction latency into a profiler (nullptr to stop)
+     */
+    void set_profiler(Profiler* profiler);
+
 private:
+    Profiler* profiler_;
+
     // Feature extraction helper functions
     float scalar_distance(float x1, float y1, float z1, 
                          float x2, float y2, float z2);
@@ -286,6 +596,94 @@ private:
                    float x3, float y3, float z3);
 };
 
+/**
+ * Frame ranges of one overlap-save window (inclusive, in valid-frame indices)
+ */
+struct WindowPlan {
+    int window_start = 0;
+    int window_end = -1;
+    int commit_start = 0;
+    int commit_end = -1;
+};
+
+/**
+ * Overlap-save windowing schedule
+ *
+ * Tracks how many frames have been committed and plans the next window from
+ * that position, so the commit size may change between windows. With the
+ * default configuration the schedule is identical to the Python decoder.
+ */
+class WindowingPolicy {
+public:
+    /**
+     * @throws std::invalid_argument if the sizes are inconsistent
+     */
+    explicit WindowingPolicy(const WindowingConfig& config = WindowingConfig());
+
+    /**
+     * Restart the schedule for a new stream
+     */
+    void reset();
+
+    /**
+     * Restart the schedule at frame 0 for the next utterance of the stream,
+     * keeping the adapted commit size
+     */
+    void restart();
+
+    /**
+     * Switch to stateful streaming: windows hold only the commit range, with
+     * no left or right context, since the model carries its own state.
+     */
+    void set_streaming(bool streaming);
+    bool streaming() const;
+
+    /**
+     * Number of valid frames required before the next window can run
+     */
+    int frames_needed() const;
+
+    /**
+     * Plan the next full window given the number of valid frames
+     */
+    WindowPlan next_window(int num_valid) const;
+
+    /**
+     * Plan the window that commits every remaining frame at end of stream
+     */
+    WindowPlan final_window(int num_valid) const;
+
+    /**
+     * Mark a planned window as committed and advance the schedule
+     */
+    void advance(const WindowPlan& plan);
+
+    /**
+     * Feed back the wall-clock cost of the last window (adaptive mode)
+     *
+     * @param seconds Time spent processing the window
+     * @param committed_frames Frames committed by that window
+     */
+    void report_cost(double seconds, int committed_frames);
+
+    int window_size() const;
+    int left_context() const;
+    int commit_size() const;
+    int committed_frames() const;
+    int chunk_index() const;
+    const WindowingConfig& config() const;
+
+private:
+    WindowingConfig config_;
+    int commit_size_;
+    int committed_;
+    int chunk_idx_;
+    bool streaming_;
+
+    int next_commit_length() const;
+    int next_window_start() const;
+};
+
 /**
  * Overlap-Save Window Processor
  * 
@@ -293,25 +691,81 @@ private:
  */
 class WindowProcessor {
 public:
+    /**
+     * Use the windowing from the decoder configuration
+     */
     WindowProcessor(CTCDecoder* decoder, TFLiteSequenceModel* sequence_model);
+
+    WindowProcessor(CTCDecoder* decoder,
+                    TFLiteSequenceModel* sequence_model,
+                    const WindowingConfig& windowing);
     
     /**
      * Reset the processor for a new stream
      */
     void reset();
+
+    /**
+     * Replace the windowing configuration and reset the stream
+     */
+    void set_windowing(const WindowingConfig& windowing);
+
+    const WindowingPolicy& windowing() const;
     
     /**
      * Push a new frame of features
      * 
      * @param features Frame features
-     * @return true if a window is ready to process
+     * @return true if a window (or a provisional update) is ready to process
      */
     bool push_frame(const FrameFeatures& features);
+
+    /**
+     * Push a frame given as kFrameFeatureSize floats in flat layout
+     *
+     * @return true if a window (or a provisional update) is ready to process
+     */
+    bool push_frame(const float* features);
+
+    /**
+     * Push a contiguous [count x kFrameFeatureSize] block of frames
+     *
+     * Valid frames are appended with bulk copies; frames whose valid_mask
+     * entry is 0 count as seen but are dropped.
+     *
+     * @param valid_mask Per-frame flags, or nullptr if all frames are valid
+     * @return ready_windows() after the block
+     */
+    int push_frames(const float* frames, int count, const uint8_t* valid_mask = nullptr);
+
+    /**
+     * Number of full windows process_window() can run on the buffered
+     * frames of the current utterance (predicted with the current commit
+     * size) plus one for a pending endpoint, or 1 if there is neither but a
+     * provisional update is due
+     */
+    int ready_windows() const;
     
     /**
      * Process current window and get decoded result
+     *
+     * When no full window is ready but a provisional update is due, runs the
+     * model on the zero-padded partial window and returns a provisional
+     * result whose uncommitted tail is in unstable_phonemes.
+     *
+     * With endpointing configured, the result that ends an utterance (a
+     * committed run of endpoint_silence_frames silent frames, or
+     * endpoint_dropped_frames dropped frames in a row) has endpoint set.
+     * Later results only cover the frames after it, so the cost of a window
+     * depends on the length of the current utterance, not of the stream.
+     * Word timings stay in valid frames since the start of the stream.
+     *
+     * With two_pass_margin set, a window whose new frames the greedy pass
+     * finds blank or silent reuses the previous beam search, and otherwise
+     * only the frames after the last silence cut are searched again and
+     * spliced after the best path before it. Results that close an
+     * utterance (an endpoint, finalize()) still search all of it.
      * 
-     * @param tflite_model_runner Function to run TFLite model on features
      * @return Recognition result (empty if no update)
      */
     RecognitionResult process_window();
@@ -321,35 +775,211 @@ public:
      */
     RecognitionResult finalize();
 
+    /**
+     * Decode a whole pre-recorded sequence in one call
+     *
+     * Plans the windows streaming would run (every full window, then the
+     * final one), runs the sequence model on them concurrently on clones of
+     * the model, stitches the committed logits and runs the beam search
+     * (segmented, see CTCDecoder::decode_segmented). Unless segment_frames
+     * is set, the result matches the last streaming result for the same
+     * frames.
+     * Adaptive windowing uses the current commit size throughout, and
+     * stateful models run their windows in order on one thread.
+     *
+     * Resets the stream first; the frames stay buffered afterwards. The
+     * sequence is decoded as one utterance (no endpointing).
+     *
+     * @param features Frames in order (invalid frames are dropped)
+     * @param num_threads Inference threads (0 = hardware concurrency)
+     */
+    RecognitionResult decode_sequence(const std::vector<FrameFeatures>& features, int num_threads = 0);
+
+    /**
+     * decode_sequence() on a flat [count x kFrameFeatureSize] block
+     * (see push_frames)
+     */
+    RecognitionResult decode_sequence(const float* frames,
+                                      int count,
+                                      const uint8_t* valid_mask = nullptr,
+                                      int num_threads = 0);
+
     int valid_frame_count() const;
     int total_frames_seen() const;
     int dropped_frame_count() const;
     int chunks_processed() const;
 
+    /**
+     * Stage latencies and counters for this stream
+     *
+     * Latency histograms survive reset(); counters describe the current
+     * sequence. Latencies stay empty unless built with ENABLE_PROFILING.
+     */
+    StreamStats stats() const;
+    void reset_stats();
+
+    /**
+     * Profiler of this stream, e.g. to share with a FeatureExtractor or
+     * SentenceCorrector feeding it
+     */
+    Profiler* profiler();
+
+    /**
+     * Best path of the last committed decode (a full window, an endpoint,
+     * finalize() or decode_sequence()), empty before the first: tokens has
+     * one step per committed frame of the utterance plus the start and end
+     * steps, and frames count from the start of the utterance
+     */
+    const CTCHypothesis& last_hypothesis() const;
+
 private:
     CTCDecoder* decoder_;
     TFLiteSequenceModel* sequence_model_;
+    WindowingPolicy policy_;
     
-    std::deque<FrameFeatures> valid_features_;
-    std::vector<std::vector<float>> all_logits_;  // Accumulated committed logits
+    std::vector<float> valid_frames_;  // Valid frames [frames x kFrameFeatureSize]
+    std::vector<float> log_probs_;  // Committed log-probs for the stream [frames x vocab]
+    std::vector<int> token_candidates_;  // Tokens to expand per committed frame (token_mass < 1)
+    int log_prob_frames_;
     
-    int chunk_idx_;
-    int next_window_needed_;
     int frame_count_;
     int effective_vocab_size_;
     int total_frames_seen_;
     int chunks_processed_;
+    int provisional_results_;
+    int last_output_valid_;   // Valid frame count at the last window or provisional result
+    Profiler profiler_;
+
+    // Endpointing
+    int utterance_start_;      // Valid frames of the stream before the buffered utterance
+    int finished_windows_;     // Windows run for earlier utterances
+    int silent_run_;           // Trailing committed frames that are blank or silence
+    int dropped_run_;          // Frames dropped in a row
+    std::deque<int> endpoints_;  // Buffered frame counts where hand absence ends an utterance
+
+    // Two-pass decoding
+    std::vector<int> first_pass_;  // Greedy token of each log-prob row
+    std::deque<int> cuts_;     // Rows where the search may restart, in the middle of silent runs
+    int cut_scan_frames_;      // Rows scanned for silent runs
+    int silent_run_start_;     // First row of the silent run being scanned, or -1
+    CTCHypothesis stable_;     // Best path of the rows before stable_frames_ (start step, no end)
+    int stable_frames_;
+    CTCHypothesis open_;       // Last search over rows [stable_frames_, searched_frames_)
+    int searched_frames_;      // 0 if open_ is not usable
+    uint64_t beam_searched_frames_;
+    CTCHypothesis last_hypothesis_;  // See last_hypothesis()
     
+    bool provisional_due() const;
+
+    /**
+     * Frames in valid_frames_ (the current utterance and any after it)
+     */
+    int buffered_frames() const;
+
     /**
-     * Process a single window
+     * Frames of the current utterance: up to the first pending endpoint
      */
-    std::vector<float> process_single_window(
+    int utterance_end() const;
+
+    /**
+     * Count a dropped frame towards endpoint_dropped_frames
+     */
+    void note_dropped_frame();
+
+    /**
+     * Extend silent_run_ over the log-probs appended from first_row
+     *
+     * @return true once the run reaches endpoint_silence_frames
+     */
+    bool update_silent_run(int first_row);
+
+    /**
+     * Finish the utterance at the first pending endpoint
+     */
+    RecognitionResult end_utterance();
+
+    /**
+     * Drop the first frames of the buffer and the decoder history, and
+     * restart windowing for the next utterance
+     */
+    void start_utterance(int frames);
+
+    /**
+     * Plan, infer and decode every buffered frame (decode_sequence)
+     */
+    RecognitionResult decode_buffered_sequence(int num_threads);
+
+    /**
+     * Run one planned window through model and return its committed rows
+     * (a view into the model's output, valid until its next call)
+     */
+    LogitsView infer_window(TFLiteSequenceModel& model, const WindowPlan& plan, Profiler* profiler) const;
+
+    /**
+     * Decode committed logits plus the speculative tail of the partial window
+     */
+    RecognitionResult process_provisional();
+
+    /**
+     * Run the model on a window and return a view of its commit rows
+     *
+     * The view points into the interpreter output and is only valid until
+     * the next inference.
+     */
+    LogitsView process_single_window(
         int window_start,
         int window_end,
         int commit_start,
-        int commit_end,
-        int& out_vocab_size
+        int commit_end
     );
+
+    /**
+     * Log-softmax logits straight into the end of log_probs_
+     *
+     * @return false if there is nothing to append
+     */
+    bool append_log_probs(const LogitsView& logits);
+
+    /**
+     * Token candidates of the buffered log-probs, or nullptr
+     */
+    const int* buffered_candidates() const;
+
+    /**
+     * Beam search over the buffered log-probs
+     */
+    std::vector<CTCHypothesis> decode_buffered();
+
+    /**
+     * decode_buffered() in segments (CTCDecoder::decode_segmented)
+     */
+    std::vector<CTCHypothesis> decode_buffered_segments(int num_threads);
+
+    /**
+     * decode_buffered(), or decode_two_pass() when two_pass_margin is set
+     */
+    std::vector<CTCHypothesis> decode_streaming(bool committed);
+
+    /**
+     * Greedy pass over the new rows, then the beam search over the rows
+     * after the last cut (or the previous search extended over new blank
+     * or silent rows), spliced after stable_
+     *
+     * @param committed false for a provisional decode, whose rows are
+     *                  dropped again: cuts and open_ are left alone
+     */
+    std::vector<CTCHypothesis> decode_two_pass(bool committed);
+
+    /**
+     * Move the rows before the last cut at least two_pass_margin rows
+     * before the end into stable_
+     */
+    void advance_stable_prefix();
+
+    /**
+     * Forget the two-pass state (new stream, utterance or vocabulary)
+     */
+    void reset_two_pass();
 };
 
 /**
@@ -381,20 +1011,34 @@ public:
      */
     std::string correct(const std::vector<std::string>& liaphon_phonemes);
 
-private:
-    std::string homophones_path_;
-    std::string kenlm_path_;
-    
-    std::map<std::string, std::vector<std::string>> ipa_to_homophones_;
-    std::unique_ptr<lm::ngram::Model> kenlm_model_;
-    
+    /**
+     * Record correction latency into a profiler (nullptr to stop)
+     *
+     * The profiler must outlive the attachment. Swapping it is safe while
+     * another thread corrects, but the Profiler itself is not synchronized:
+     * only correct from the thread that records into it.
+     */
+    void set_profiler(Profiler* profiler);
+
     /**
      * Beam search over homophones
+     *
+     * @param homophone_lists Candidate words for each position
+     * @param beam_width Number of hypotheses kept per position
+     * @return Best-scoring word sequence (empty if not initialized)
      */
     std::vector<std::string> beam_search(
         const std::vector<std::vector<std::string>>& homophone_lists,
         int beam_width = 20
     );
+
+private:
+    std::string homophones_path_;
+    std::string kenlm_path_;
+    std::atomic<Profiler*> profiler_;
+    
+    std::map<std::string, std::vector<std::string>> ipa_to_homophones_;
+    std::unique_ptr<lm::ngram::Model> kenlm_model_;
 };
 
 /**
@@ -413,11 +1057,164 @@ std::string liaphon_to_ipa(const std::vector<std::string>& liaphon);
  */
 std::vector<std::string> ipa_to_liaphon(const std::string& ipa);
 
+/**
+ * Replace accented Latin letters and ligatures with their ASCII base
+ * (subtitle rendering only supports ASCII); see fold_to_ascii()
+ */
+std::string remove_accents(const std::string& input);
+
+/**
+ * Video encoder backend
+ */
+enum class VideoBackend {
+    Any,        // Let OpenCV choose
+    FFmpeg      // Force OpenCV's FFmpeg backend (FFV1, H.264, ...)
+};
+
+/**
+ * Output settings for SubtitleVideoWriter
+ */
+struct VideoWriterConfig {
+    std::string codec = "MJPG";      // FourCC, e.g. "MJPG", "FFV1" (.mkv/.avi), "avc1" (.mp4)
+    VideoBackend backend = VideoBackend::Any;
+    int queue_capacity = 32;         // Frames buffered ahead of the encoder
+};
+
+/**
+ * Encoder throughput
+ */
+struct VideoWriterStats {
+    uint64_t frames_written = 0;
+    double encode_seconds = 0.0;     // Time spent in rendering + encoding
+    double blocked_seconds = 0.0;    // Time producers waited on a full queue
+    double elapsed_seconds = 0.0;    // open() to close()
+    double frames_per_second = 0.0;  // frames_written / elapsed_seconds
+    int max_queue_depth = 0;
+};
+
+/**
+ * Streaming subtitle renderer
+ *
+ * Frames are fed as they are decoded and handed to an encoder thread
+ * through a bounded queue; subtitle text is drawn on that thread, so the
+ * capture loop only pays for a frame copy. write_frame() blocks while the
+ * queue is full.
+ */
+class SubtitleVideoWriter {
+public:
+    explicit SubtitleVideoWriter(const VideoWriterConfig& config = VideoWriterConfig());
+    ~SubtitleVideoWriter();
+
+    SubtitleVideoWriter(const SubtitleVideoWriter&) = delete;
+    SubtitleVideoWriter& operator=(const SubtitleVideoWriter&) = delete;
+
+    /**
+     * Open the output and start the encoder thread
+     *
+     * Odd dimensions are rounded down to even ones.
+     */
+    bool open(const std::string& output_path, double fps, int width, int height);
+    bool is_open() const;
+
+    /**
+     * Show the result's French sentence (or phonemes) from the next frame on
+     */
+    void set_subtitle(const RecognitionResult& result);
+    void set_text(const std::string& text);
+
+    /**
+     * Queue one 8-bit BGR frame (copied; resized if it does not match open())
+     *
+     * @param stride Bytes per row (0 means width * 3)
+     */
+    bool write_frame(const uint8_t* bgr, int width, int height, size_t stride = 0);
+
+    /**
+     * Drain the queue, stop the encoder thread and close the file
+     */
+    void close();
+
+    VideoWriterStats stats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Subtitle shown for a result: the French sentence without accents, or the
+ * phonemes separated by spaces
+ */
+std::string subtitle_text(const RecognitionResult& result);
+
+/**
+ * Subtitle sidecar format
+ */
+enum class SubtitleFormat {
+    SRT,
+    WebVTT
+};
+
+/**
+ * Options for format_subtitles()
+ */
+struct SubtitleOptions {
+    SubtitleFormat format = SubtitleFormat::SRT;
+    bool word_timings = false;       // One cue per word where results carry timings
+    double last_cue_seconds = 3.0;   // Duration of the final sentence cue
+
+    // Stream frame (0-based) of each valid frame, in order; empty when no
+    // frame was dropped. See format_subtitles().
+    std::vector<int> stream_frames;
+};
+
+/**
+ * SubtitleOptions::stream_frames of a stream of count frames whose
+ * valid_mask entry is 0 for each dropped frame
+ */
+std::vector<int> stream_frames_of(const uint8_t* valid_mask, int count);
+
+/**
+ * Render results as SRT or WebVTT
+ *
+ * Each result is shown from its frame_number until the next result, like
+ * write_subtitled_video. With word_timings, words are timed from
+ * RecognitionResult::word_timings, later results replacing the words they
+ * re-decode; the French sentence is used when it has one word per timing.
+ * Text keeps its accents (sidecar files are UTF-8).
+ *
+ * WindowProcessor counts frame numbers and word timings in valid frames. If
+ * the stream dropped frames, pass options.stream_frames so cues are timed
+ * on the stream; frames past its end keep their distance to its last entry.
+ *
+ * @param fps Frame rate of the stream
+ */
+std::string format_subtitles(
+    const std::deque<RecognitionResult>& results,
+    double fps,
+    const SubtitleOptions& options = SubtitleOptions());
+
+/**
+ * Write format_subtitles() output to path
+ */
+bool write_subtitles(
+    const std::string& path,
+    const std::deque<RecognitionResult>& results,
+    double fps,
+    const SubtitleOptions& options = SubtitleOptions());
+
+/**
+ * Re-read input_path and write it with subtitles to output_path
+ *
+ * Prefer feeding a SubtitleVideoWriter during decoding, which avoids
+ * decoding the input twice.
+ */
 bool write_subtitled_video(
     const std::string& input_path,
     const std::deque<RecognitionResult>& recognition_results,
     const std::string& output_path,
-    double fps);
+    double fps,
+    const VideoWriterConfig& config = VideoWriterConfig());
 
 } // namespace cued_speech
 
@@ -4,19 +4,27 @@
 
 #include "decoder_c_api.h"
 #include "decoder.h"
+#include "frame_ring.h"
 
+#include <algorithm>
 #include <cstring>
+#include <deque>
 #include <limits>
 #include <string>
 #include <vector>
 #include <memory>
-#include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 using cued_speech::CTCDecoder;
-using cued_speech::FrameFeatures;
+using cued_speech::DecoderEngine;
+using cued_speech::FrameRing;
 using cued_speech::SentenceCorrector;
+using cued_speech::SubtitleVideoWriter;
 using cued_speech::TFLiteSequenceModel;
+using cued_speech::VideoBackend;
 using cued_speech::WindowProcessor;
+using cued_speech::WindowingMode;
 using cued_speech::ipa_to_liaphon;
 using cued_speech::liaphon_to_ipa;
 
@@ -25,9 +33,45 @@ thread_local std::string g_last_error;
 
 void set_last_error(const std::string& error) {
     g_last_error = error;
-    std::cerr << "Error: " << error << std::endl;
+    cued_speech::log_message(cued_speech::LogLevel::Error, "c_api", error);
 }
 
+namespace {
+
+/**
+ * Forwards log records to a C callback
+ */
+class CallbackLogSink : public cued_speech::LogSink {
+public:
+    CallbackLogSink(LogCallback callback, void* user_data)
+        : callback_(callback), user_data_(user_data) {}
+
+    void write(const cued_speech::LogRecord& record) override {
+        std::vector<const char*> keys;
+        std::vector<const char*> values;
+        keys.reserve(record.fields.size());
+        values.reserve(record.fields.size());
+        for (const auto& field : record.fields) {
+            keys.push_back(field.key.c_str());
+            values.push_back(field.value.c_str());
+        }
+
+        callback_(static_cast<::LogLevel>(record.level),
+                  record.component.c_str(),
+                  record.message.c_str(),
+                  keys.data(),
+                  values.data(),
+                  static_cast<int>(keys.size()),
+                  user_data_);
+    }
+
+private:
+    LogCallback callback_;
+    void* user_data_;
+};
+
+} // namespace
+
 //=============================================================================
 // Helper Functions
 //=============================================================================
@@ -50,6 +94,54 @@ char** copy_string_vector(const std::vector<std::string>& vec) {
     return result;
 }
 
+::RecognitionResult* copy_recognition_result(const cued_speech::RecognitionResult& result) {
+    auto c_result = new ::RecognitionResult;
+    c_result->frame_number = result.frame_number;
+    c_result->phonemes_length = result.phonemes.size();
+    c_result->phonemes = copy_string_vector(result.phonemes);
+    c_result->french_sentence = result.french_sentence.empty()
+        ? nullptr
+        : copy_string(result.french_sentence);
+    c_result->confidence = result.confidence;
+    c_result->unstable_phonemes_length = result.unstable_phonemes.size();
+    c_result->unstable_phonemes = copy_string_vector(result.unstable_phonemes);
+    c_result->provisional = result.provisional;
+    c_result->endpoint = result.endpoint;
+    c_result->word_timings_length = result.word_timings.size();
+    c_result->word_timings = nullptr;
+    if (!result.word_timings.empty()) {
+        c_result->word_timings = new ::WordTiming[result.word_timings.size()];
+        for (size_t i = 0; i < result.word_timings.size(); ++i) {
+            c_result->word_timings[i].word = copy_string(result.word_timings[i].word);
+            c_result->word_timings[i].start_frame = result.word_timings[i].start_frame;
+            c_result->word_timings[i].end_frame = result.word_timings[i].end_frame;
+        }
+    }
+    return c_result;
+}
+
+cued_speech::RecognitionResult to_cpp_result(const ::RecognitionResult& result) {
+    cued_speech::RecognitionResult cpp_result;
+    cpp_result.frame_number = result.frame_number;
+    cpp_result.confidence = result.confidence;
+    cpp_result.provisional = result.provisional;
+    cpp_result.endpoint = result.endpoint;
+    if (result.french_sentence) {
+        cpp_result.french_sentence = result.french_sentence;
+    }
+    for (int i = 0; i < result.phonemes_length; ++i) {
+        cpp_result.phonemes.push_back(result.phonemes[i]);
+    }
+    for (int i = 0; i < result.unstable_phonemes_length; ++i) {
+        cpp_result.unstable_phonemes.push_back(result.unstable_phonemes[i]);
+    }
+    for (int i = 0; i < result.word_timings_length; ++i) {
+        const auto& timing = result.word_timings[i];
+        cpp_result.word_timings.push_back({timing.word ? timing.word : "", timing.start_frame, timing.end_frame});
+    }
+    return cpp_result;
+}
+
 //=============================================================================
 // Decoder Configuration
 //=============================================================================
@@ -69,12 +161,38 @@ char** copy_string_vector(const std::vector<std::string>& vec) {
     config.unk_score = -std::numeric_limits<float>::infinity();
     config.sil_score = 0.0f;
     config.log_add = false;
+    config.blank_skip_threshold = 0.0f;
+    config.token_mass = 1.0f;
+    config.native_search = false;
+    config.segment_frames = 0;
+    config.segment_silence_frames = 10;
+    config.segment_log_prob = -0.05f;
     config.blank_token = "<BLANK>";
     config.sil_token = "_";
     config.unk_word = "<UNK>";
     return config;
 }
 
+::WindowingConfig windowing_config_default() {
+    cued_speech::WindowingConfig defaults;
+    ::WindowingConfig config;
+    config.window_size = defaults.window_size;
+    config.commit_size = defaults.commit_size;
+    config.left_context = defaults.left_context;
+    config.adaptive = defaults.mode == WindowingMode::Adaptive;
+    config.min_commit_size = defaults.min_commit_size;
+    config.max_commit_size = defaults.max_commit_size;
+    config.frame_rate = defaults.frame_rate;
+    config.low_load = defaults.low_load;
+    config.high_load = defaults.high_load;
+    config.provisional_interval = defaults.provisional_interval;
+    config.endpoint_silence_frames = defaults.endpoint_silence_frames;
+    config.endpoint_log_prob = defaults.endpoint_log_prob;
+    config.endpoint_dropped_frames = defaults.endpoint_dropped_frames;
+    config.two_pass_margin = defaults.two_pass_margin;
+    return config;
+}
+
 //=============================================================================
 // Decoder Lifecycle
 //=============================================================================
@@ -100,6 +218,12 @@ DecoderHandle decoder_create(const DecoderConfig* config) {
         cpp_config.unk_score = config->unk_score;
         cpp_config.sil_score = config->sil_score;
         cpp_config.log_add = config->log_add;
+        cpp_config.blank_skip_threshold = config->blank_skip_threshold;
+        cpp_config.token_mass = config->token_mass;
+        cpp_config.engine = config->native_search ? DecoderEngine::Native : DecoderEngine::Flashlight;
+        cpp_config.segment_frames = config->segment_frames;
+        cpp_config.segment_silence_frames = config->segment_silence_frames;
+        cpp_config.segment_log_prob = config->segment_log_prob;
         cpp_config.blank_token = config->blank_token;
         cpp_config.sil_token = config->sil_token;
         cpp_config.unk_word = config->unk_word;
@@ -145,15 +269,37 @@ const char* decoder_idx_to_token(DecoderHandle handle, int idx) {
     
     try {
         auto decoder = static_cast<CTCDecoder*>(handle);
-        static thread_local std::string token_buffer;
-        token_buffer = decoder->idx_to_token(idx);
-        return token_buffer.c_str();
+        if (idx < 0 || idx >= decoder->get_vocab_size()) {
+            return nullptr;
+        }
+        // Token views are NUL-terminated and owned by the decoder
+        return decoder->token_view(idx).data();
     } catch (const std::exception& e) {
         set_last_error(std::string("Exception in decoder_idx_to_token: ") + e.what());
         return nullptr;
     }
 }
 
+int decoder_get_token_table(DecoderHandle handle, const char** tokens, int capacity) {
+    if (!handle || (capacity > 0 && !tokens)) {
+        set_last_error("Invalid arguments to decoder_get_token_table");
+        return -1;
+    }
+
+    try {
+        auto decoder = static_cast<CTCDecoder*>(handle);
+        const int vocab_size = decoder->get_vocab_size();
+        const int count = std::min(vocab_size, capacity);
+        for (int i = 0; i < count; ++i) {
+            tokens[i] = decoder->token_view(i).data();
+        }
+        return vocab_size;
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in decoder_get_token_table: ") + e.what());
+        return -1;
+    }
+}
+
 int decoder_token_to_idx(DecoderHandle handle, const char* token) {
     if (!handle || !token) {
         return -1;
@@ -308,8 +454,116 @@ struct StreamContext {
     CTCDecoder* decoder;
     std::unique_ptr<TFLiteSequenceModel> sequence_model;
     std::unique_ptr<WindowProcessor> processor;
+
+    // Backing storage of the pooled result (stream_*_pooled)
+    cued_speech::RecognitionResult pooled_source;
+    ::RecognitionResult pooled_result{};
+    std::vector<char*> pooled_phonemes;
+    std::vector<char*> pooled_unstable_phonemes;
+    std::vector<::WordTiming> pooled_word_timings;
 };
 
+namespace {
+
+// Stream each corrector records into (corrector_attach_stream). Correctors
+// are detached when their stream is destroyed and re-pointed when it gets a
+// new processor, so none keeps a freed Profiler*.
+std::mutex g_attached_mutex;
+std::unordered_map<SentenceCorrector*, StreamContext*> g_attached_streams;
+
+void detach_correctors(StreamContext* ctx) {
+    std::lock_guard<std::mutex> lock(g_attached_mutex);
+    for (auto it = g_attached_streams.begin(); it != g_attached_streams.end();) {
+        if (it->second == ctx) {
+            it->first->set_profiler(nullptr);
+            it = g_attached_streams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void reattach_correctors(StreamContext* ctx) {
+    std::lock_guard<std::mutex> lock(g_attached_mutex);
+    for (auto& [corrector, stream] : g_attached_streams) {
+        if (stream == ctx) {
+            corrector->set_profiler(ctx->processor->profiler());
+        }
+    }
+}
+
+// Point the pooled C result at ctx->pooled_source; vectors keep their capacity
+const ::RecognitionResult* pool_result(StreamContext* ctx, cued_speech::RecognitionResult&& result) {
+    ctx->pooled_source = std::move(result);
+    const auto& src = ctx->pooled_source;
+    auto& dst = ctx->pooled_result;
+
+    auto point_at = [](const std::vector<std::string>& strings, std::vector<char*>& pointers) {
+        pointers.clear();
+        for (const auto& str : strings) {
+            pointers.push_back(const_cast<char*>(str.c_str()));
+        }
+        return pointers.empty() ? nullptr : pointers.data();
+    };
+
+    dst.frame_number = src.frame_number;
+    dst.confidence = src.confidence;
+    dst.provisional = src.provisional;
+    dst.endpoint = src.endpoint;
+    dst.phonemes = point_at(src.phonemes, ctx->pooled_phonemes);
+    dst.phonemes_length = static_cast<int>(src.phonemes.size());
+    dst.unstable_phonemes = point_at(src.unstable_phonemes, ctx->pooled_unstable_phonemes);
+    dst.unstable_phonemes_length = static_cast<int>(src.unstable_phonemes.size());
+    dst.french_sentence = src.french_sentence.empty()
+        ? nullptr
+        : const_cast<char*>(src.french_sentence.c_str());
+
+    ctx->pooled_word_timings.clear();
+    for (const auto& timing : src.word_timings) {
+        ctx->pooled_word_timings.push_back(
+            {const_cast<char*>(timing.word.c_str()), timing.start_frame, timing.end_frame});
+    }
+    dst.word_timings = ctx->pooled_word_timings.empty() ? nullptr : ctx->pooled_word_timings.data();
+    dst.word_timings_length = static_cast<int>(ctx->pooled_word_timings.size());
+    return &dst;
+}
+
+// Copy as many IDs as fit; false if some did not
+bool copy_ids(const std::vector<int>& ids, int* buffer, int capacity) {
+    const int count = std::min(static_cast<int>(ids.size()), std::max(capacity, 0));
+    if (count > 0) {
+        std::memcpy(buffer, ids.data(), static_cast<size_t>(count) * sizeof(int));
+    }
+    return count == static_cast<int>(ids.size());
+}
+
+bool write_token_result(const cued_speech::RecognitionResult& src,
+                        int* tokens, int tokens_capacity,
+                        int* unstable_tokens, int unstable_capacity,
+                        ::TokenResult* result) {
+    const bool tokens_fit = copy_ids(src.phoneme_ids, tokens, tokens_capacity);
+    const bool unstable_fit = copy_ids(src.unstable_phoneme_ids, unstable_tokens, unstable_capacity);
+
+    result->frame_number = src.frame_number;
+    result->confidence = src.confidence;
+    result->provisional = src.provisional;
+    result->tokens_length = static_cast<int>(src.phoneme_ids.size());
+    result->unstable_tokens_length = static_cast<int>(src.unstable_phoneme_ids.size());
+    result->truncated = !tokens_fit || !unstable_fit;
+    result->endpoint = src.endpoint;
+    return true;
+}
+
+bool valid_id_buffers(const int* tokens, int tokens_capacity,
+                      const int* unstable_tokens, int unstable_capacity,
+                      const ::TokenResult* result) {
+    return result &&
+           (tokens_capacity <= 0 || tokens) &&
+           (unstable_capacity <= 0 || unstable_tokens);
+}
+
+} // namespace
+
 StreamHandle stream_create(DecoderHandle decoder_handle) {
     if (!decoder_handle) {
         set_last_error("Invalid decoder handle");
@@ -343,6 +597,7 @@ bool stream_load_tflite_model(StreamHandle handle, const char* model_path) {
         if (!ctx->sequence_model) {
             ctx->sequence_model = std::make_unique<TFLiteSequenceModel>();
             ctx->processor = std::make_unique<WindowProcessor>(ctx->decoder, ctx->sequence_model.get());
+            reattach_correctors(ctx);
         }
         if (!ctx->sequence_model->load(model_path)) {
             set_last_error("Failed to load TFLite sequence model");
@@ -356,9 +611,43 @@ bool stream_load_tflite_model(StreamHandle handle, const char* model_path) {
     }
 }
 
+bool stream_set_windowing(StreamHandle handle, const WindowingConfig* config) {
+    if (!handle || !config) {
+        set_last_error("Invalid arguments to stream_set_windowing");
+        return false;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+
+        cued_speech::WindowingConfig cpp_config;
+        cpp_config.window_size = config->window_size;
+        cpp_config.commit_size = config->commit_size;
+        cpp_config.left_context = config->left_context;
+        cpp_config.mode = config->adaptive ? WindowingMode::Adaptive : WindowingMode::Fixed;
+        cpp_config.min_commit_size = config->min_commit_size;
+        cpp_config.max_commit_size = config->max_commit_size;
+        cpp_config.frame_rate = config->frame_rate;
+        cpp_config.low_load = config->low_load;
+        cpp_config.high_load = config->high_load;
+        cpp_config.provisional_interval = config->provisional_interval;
+        cpp_config.endpoint_silence_frames = config->endpoint_silence_frames;
+        cpp_config.endpoint_log_prob = config->endpoint_log_prob;
+        cpp_config.endpoint_dropped_frames = config->endpoint_dropped_frames;
+        cpp_config.two_pass_margin = config->two_pass_margin;
+
+        ctx->processor->set_windowing(cpp_config);
+        return true;
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_set_windowing: ") + e.what());
+        return false;
+    }
+}
+
 void stream_destroy(StreamHandle handle) {
     if (handle) {
         auto ctx = static_cast<StreamContext*>(handle);
+        detach_correctors(ctx);
         delete ctx;
     }
 }
@@ -384,13 +673,7 @@ bool stream_push_frame(StreamHandle handle, const float* features) {
     
     try {
         auto ctx = static_cast<StreamContext*>(handle);
-        
-        FrameFeatures frame;
-        frame.hand_shape.assign(features, features + 7);
-        frame.hand_position.assign(features + 7, features + 25);
-        frame.lips.assign(features + 25, features + 33);
-        
-        return ctx->processor->push_frame(frame);
+        return ctx->processor->push_frame(features);
         
     } catch (const std::exception& e) {
         set_last_error(std::string("Exception in stream_push_frame: ") + e.what());
@@ -398,6 +681,59 @@ bool stream_push_frame(StreamHandle handle, const float* features) {
     }
 }
 
+int stream_push_frames(StreamHandle handle, const float* frames, int count, const uint8_t* valid_mask) {
+    if (!handle || count < 0 || (count > 0 && !frames)) {
+        set_last_error("Invalid arguments to stream_push_frames");
+        return -1;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        return ctx->processor->push_frames(frames, count, valid_mask);
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_push_frames: ") + e.what());
+        return -1;
+    }
+}
+
+int stream_push_frames_process(
+    StreamHandle handle,
+    const float* frames,
+    int count,
+    const uint8_t* valid_mask,
+    ResultCallback callback,
+    void* user_data) {
+
+    if (!handle || count < 0 || (count > 0 && !frames)) {
+        set_last_error("Invalid arguments to stream_push_frames_process");
+        return -1;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        WindowProcessor& processor = *ctx->processor;
+        int processed = 0;
+        for (int i = 0; i < count; ++i) {
+            const float* row = frames + static_cast<size_t>(i) * cued_speech::kFrameFeatureSize;
+            // A dropped frame may complete a hand-absence endpoint
+            const bool ready = valid_mask && !valid_mask[i]
+                ? processor.push_frames(row, 1, valid_mask + i) > 0
+                : processor.push_frame(row);
+            if (ready) {
+                const ::RecognitionResult* result = pool_result(ctx, processor.process_window());
+                if (callback) {
+                    callback(result, user_data);
+                }
+                ++processed;
+            }
+        }
+        return processed;
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_push_frames_process: ") + e.what());
+        return -1;
+    }
+}
+
 RecognitionResult* stream_process_window(StreamHandle handle) {
     if (!handle) {
         set_last_error("Invalid stream handle");
@@ -407,17 +743,7 @@ RecognitionResult* stream_process_window(StreamHandle handle) {
     try {
         auto ctx = static_cast<StreamContext*>(handle);
         auto result = ctx->processor->process_window();
-
-        auto c_result = new ::RecognitionResult;
-        c_result->frame_number = result.frame_number;
-        c_result->phonemes_length = result.phonemes.size();
-        c_result->phonemes = copy_string_vector(result.phonemes);
-        c_result->french_sentence = result.french_sentence.empty()
-            ? nullptr
-            : copy_string(result.french_sentence);
-        c_result->confidence = result.confidence;
-
-        return c_result;
+        return copy_recognition_result(result);
     } catch (const std::exception& e) {
         set_last_error(std::string("Exception in stream_process_window: ") + e.what());
         return nullptr;
@@ -433,23 +759,78 @@ RecognitionResult* stream_finalize(StreamHandle handle) {
     try {
         auto ctx = static_cast<StreamContext*>(handle);
         auto result = ctx->processor->finalize();
+        return copy_recognition_result(result);
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_finalize: ") + e.what());
+        return nullptr;
+    }
+}
+
+RecognitionResult* stream_decode_sequence(
+    StreamHandle handle,
+    const float* frames,
+    int count,
+    const uint8_t* valid_mask,
+    int num_threads) {
 
-        auto c_result = new ::RecognitionResult;
-        c_result->frame_number = result.frame_number;
-        c_result->phonemes_length = result.phonemes.size();
-        c_result->phonemes = copy_string_vector(result.phonemes);
-        c_result->french_sentence = result.french_sentence.empty()
-            ? nullptr
-            : copy_string(result.french_sentence);
-        c_result->confidence = result.confidence;
+    if (!handle || count < 0 || (count > 0 && !frames)) {
+        set_last_error("Invalid arguments to stream_decode_sequence");
+        return nullptr;
+    }
 
-        return c_result;
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        auto result = ctx->processor->decode_sequence(frames, count, valid_mask, num_threads);
+        return copy_recognition_result(result);
     } catch (const std::exception& e) {
-        set_last_error(std::string("Exception in stream_finalize: ") + e.what());
+        set_last_error(std::string("Exception in stream_decode_sequence: ") + e.what());
         return nullptr;
     }
 }
 
+bool stream_get_stats(StreamHandle handle, ::StreamStats* stats) {
+    if (!handle || !stats) {
+        set_last_error("Invalid arguments to stream_get_stats");
+        return false;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        const cued_speech::StreamStats cpp_stats = ctx->processor->stats();
+
+        static_assert(PROFILE_STAGE_COUNT == cued_speech::kProfileStageCount,
+                      "C and C++ profile stages must match");
+        for (int i = 0; i < PROFILE_STAGE_COUNT; ++i) {
+            const auto& src = cpp_stats.stages[i];
+            stats->stages[i].count = src.count;
+            stats->stages[i].total_us = src.total_us;
+            stats->stages[i].p50_us = src.p50_us;
+            stats->stages[i].p95_us = src.p95_us;
+            stats->stages[i].p99_us = src.p99_us;
+            stats->stages[i].max_us = src.max_us;
+        }
+        stats->frames_pushed = cpp_stats.frames_pushed;
+        stats->frames_dropped = cpp_stats.frames_dropped;
+        stats->windows_processed = cpp_stats.windows_processed;
+        stats->decodes = cpp_stats.decodes;
+        stats->provisional_results = cpp_stats.provisional_results;
+        stats->searched_frames = cpp_stats.searched_frames;
+        stats->profiling_enabled = cpp_stats.profiling_enabled;
+        return true;
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_get_stats: ") + e.what());
+        return false;
+    }
+}
+
+void stream_reset_stats(StreamHandle handle) {
+    if (!handle) {
+        return;
+    }
+
+    static_cast<StreamContext*>(handle)->processor->reset_stats();
+}
+
 void stream_free_result(::RecognitionResult* result) {
     if (!result) {
         return;
@@ -465,10 +846,231 @@ void stream_free_result(::RecognitionResult* result) {
     if (result->french_sentence) {
         delete[] result->french_sentence;
     }
+
+    if (result->unstable_phonemes) {
+        for (int i = 0; i < result->unstable_phonemes_length; ++i) {
+            delete[] result->unstable_phonemes[i];
+        }
+        delete[] result->unstable_phonemes;
+    }
+
+    if (result->word_timings) {
+        for (int i = 0; i < result->word_timings_length; ++i) {
+            delete[] result->word_timings[i].word;
+        }
+        delete[] result->word_timings;
+    }
     
     delete result;
 }
 
+//=============================================================================
+// Allocation-Free Results
+//=============================================================================
+
+bool stream_process_window_ids(
+    StreamHandle handle,
+    int* tokens,
+    int tokens_capacity,
+    int* unstable_tokens,
+    int unstable_capacity,
+    ::TokenResult* result) {
+
+    if (!handle || !valid_id_buffers(tokens, tokens_capacity, unstable_tokens, unstable_capacity, result)) {
+        set_last_error("Invalid arguments to stream_process_window_ids");
+        return false;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        return write_token_result(ctx->processor->process_window(),
+                                  tokens, tokens_capacity, unstable_tokens, unstable_capacity, result);
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_process_window_ids: ") + e.what());
+        return false;
+    }
+}
+
+bool stream_finalize_ids(
+    StreamHandle handle,
+    int* tokens,
+    int tokens_capacity,
+    int* unstable_tokens,
+    int unstable_capacity,
+    ::TokenResult* result) {
+
+    if (!handle || !valid_id_buffers(tokens, tokens_capacity, unstable_tokens, unstable_capacity, result)) {
+        set_last_error("Invalid arguments to stream_finalize_ids");
+        return false;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        return write_token_result(ctx->processor->finalize(),
+                                  tokens, tokens_capacity, unstable_tokens, unstable_capacity, result);
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_finalize_ids: ") + e.what());
+        return false;
+    }
+}
+
+const ::RecognitionResult* stream_process_window_pooled(StreamHandle handle) {
+    if (!handle) {
+        set_last_error("Invalid stream handle");
+        return nullptr;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        return pool_result(ctx, ctx->processor->process_window());
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_process_window_pooled: ") + e.what());
+        return nullptr;
+    }
+}
+
+const ::RecognitionResult* stream_finalize_pooled(StreamHandle handle) {
+    if (!handle) {
+        set_last_error("Invalid stream handle");
+        return nullptr;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        return pool_result(ctx, ctx->processor->finalize());
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_finalize_pooled: ") + e.what());
+        return nullptr;
+    }
+}
+
+//=============================================================================
+// Shared-Memory Frame Ring
+//=============================================================================
+
+FrameRingHandle frame_ring_create(const char* name, int capacity) {
+    if (!name || capacity <= 0) {
+        set_last_error("Invalid arguments to frame_ring_create");
+        return nullptr;
+    }
+
+    try {
+        auto ring = FrameRing::create(name, static_cast<uint32_t>(capacity));
+        if (!ring) {
+            set_last_error("Failed to create frame ring");
+            return nullptr;
+        }
+        return ring.release();
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in frame_ring_create: ") + e.what());
+        return nullptr;
+    }
+}
+
+FrameRingHandle frame_ring_open(const char* name) {
+    if (!name) {
+        set_last_error("Invalid arguments to frame_ring_open");
+        return nullptr;
+    }
+
+    try {
+        auto ring = FrameRing::open(name);
+        if (!ring) {
+            set_last_error("Failed to open frame ring");
+            return nullptr;
+        }
+        return ring.release();
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in frame_ring_open: ") + e.what());
+        return nullptr;
+    }
+}
+
+void frame_ring_destroy(FrameRingHandle handle) {
+    if (handle) {
+        delete static_cast<FrameRing*>(handle);
+    }
+}
+
+float* frame_ring_reserve(FrameRingHandle handle, int timeout_ms) {
+    if (!handle) {
+        set_last_error("Invalid frame ring handle");
+        return nullptr;
+    }
+
+    cued_speech::FrameRecord* record = static_cast<FrameRing*>(handle)->reserve(timeout_ms);
+    return record ? record->features : nullptr;
+}
+
+void frame_ring_commit(FrameRingHandle handle, int frame_number, bool valid) {
+    if (handle) {
+        static_cast<FrameRing*>(handle)->commit(frame_number, valid);
+    }
+}
+
+bool frame_ring_push(FrameRingHandle handle, const float* features, int frame_number, bool valid, int timeout_ms) {
+    if (!handle) {
+        set_last_error("Invalid frame ring handle");
+        return false;
+    }
+    return static_cast<FrameRing*>(handle)->push(features, frame_number, valid, timeout_ms);
+}
+
+void frame_ring_close(FrameRingHandle handle) {
+    if (handle) {
+        static_cast<FrameRing*>(handle)->close();
+    }
+}
+
+bool frame_ring_finished(FrameRingHandle handle) {
+    return handle && static_cast<FrameRing*>(handle)->finished();
+}
+
+int stream_consume_ring(
+    StreamHandle handle,
+    FrameRingHandle ring_handle,
+    int max_frames,
+    int timeout_ms,
+    ResultCallback callback,
+    void* user_data) {
+
+    if (!handle || !ring_handle || max_frames < 0) {
+        set_last_error("Invalid arguments to stream_consume_ring");
+        return -1;
+    }
+
+    try {
+        auto ctx = static_cast<StreamContext*>(handle);
+        auto ring = static_cast<FrameRing*>(ring_handle);
+        WindowProcessor& processor = *ctx->processor;
+
+        // Wait for the first frame only; then take what is already there
+        int consumed = 0;
+        while (consumed < max_frames) {
+            const cued_speech::FrameRecord* record = ring->peek(consumed == 0 ? timeout_ms : 0);
+            if (!record) {
+                break;
+            }
+            const uint8_t invalid = 0;
+            const bool ready = record->valid
+                ? processor.push_frame(record->features)
+                : processor.push_frames(record->features, 1, &invalid) > 0;
+            ring->release();
+            if (ready) {
+                const ::RecognitionResult* result = pool_result(ctx, processor.process_window());
+                if (callback) {
+                    callback(result, user_data);
+                }
+            }
+            ++consumed;
+        }
+        return consumed;
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in stream_consume_ring: ") + e.what());
+        return -1;
+    }
+}
+
 //=============================================================================
 // Sentence Correction
 //=============================================================================
@@ -502,7 +1104,12 @@ CorrectorHandle corrector_create(
 
 void corrector_destroy(CorrectorHandle handle) {
     if (handle) {
-        delete static_cast<SentenceCorrector*>(handle);
+        auto corrector = static_cast<SentenceCorrector*>(handle);
+        {
+            std::lock_guard<std::mutex> lock(g_attached_mutex);
+            g_attached_streams.erase(corrector);
+        }
+        delete corrector;
     }
 }
 
@@ -533,10 +1140,241 @@ char* corrector_correct(
     }
 }
 
+void corrector_attach_stream(CorrectorHandle handle, StreamHandle stream) {
+    if (!handle) {
+        return;
+    }
+
+    auto corrector = static_cast<SentenceCorrector*>(handle);
+    auto ctx = static_cast<StreamContext*>(stream);
+    std::lock_guard<std::mutex> lock(g_attached_mutex);
+    if (ctx) {
+        g_attached_streams[corrector] = ctx;
+        corrector->set_profiler(ctx->processor->profiler());
+    } else {
+        g_attached_streams.erase(corrector);
+        corrector->set_profiler(nullptr);
+    }
+}
+
 void corrector_free_string(char* str) {
     delete[] str;
 }
 
+//=============================================================================
+// Subtitled Video Output
+//=============================================================================
+
+VideoWriterConfig video_writer_config_default() {
+    ::VideoWriterConfig config;
+    config.codec = "MJPG";
+    config.use_ffmpeg = false;
+    config.queue_capacity = 32;
+    return config;
+}
+
+VideoWriterHandle video_writer_create(
+    const ::VideoWriterConfig* config,
+    const char* output_path,
+    double fps,
+    int width,
+    int height) {
+
+    if (!output_path) {
+        set_last_error("Invalid output path to video_writer_create");
+        return nullptr;
+    }
+
+    try {
+        cued_speech::VideoWriterConfig cpp_config;
+        if (config) {
+            if (config->codec) {
+                cpp_config.codec = config->codec;
+            }
+            cpp_config.backend = config->use_ffmpeg ? VideoBackend::FFmpeg : VideoBackend::Any;
+            cpp_config.queue_capacity = config->queue_capacity;
+        }
+
+        auto writer = std::make_unique<SubtitleVideoWriter>(cpp_config);
+        if (!writer->open(output_path, fps, width, height)) {
+            set_last_error(std::string("Failed to open video writer: ") + output_path);
+            return nullptr;
+        }
+        return writer.release();
+
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in video_writer_create: ") + e.what());
+        return nullptr;
+    }
+}
+
+void video_writer_set_text(VideoWriterHandle handle, const char* text) {
+    if (!handle) {
+        return;
+    }
+
+    static_cast<SubtitleVideoWriter*>(handle)->set_text(text ? text : "");
+}
+
+void video_writer_set_result(VideoWriterHandle handle, const ::RecognitionResult* result) {
+    if (!handle || !result) {
+        return;
+    }
+
+    try {
+        static_cast<SubtitleVideoWriter*>(handle)->set_subtitle(to_cpp_result(*result));
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in video_writer_set_result: ") + e.what());
+    }
+}
+
+bool video_writer_write_frame(
+    VideoWriterHandle handle,
+    const uint8_t* bgr,
+    int width,
+    int height,
+    int stride) {
+
+    if (!handle || !bgr || stride < 0) {
+        set_last_error("Invalid arguments to video_writer_write_frame");
+        return false;
+    }
+
+    try {
+        return static_cast<SubtitleVideoWriter*>(handle)->write_frame(
+            bgr, width, height, static_cast<size_t>(stride));
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in video_writer_write_frame: ") + e.what());
+        return false;
+    }
+}
+
+void video_writer_close(VideoWriterHandle handle, ::VideoWriterStats* stats) {
+    if (!handle) {
+        return;
+    }
+
+    auto writer = static_cast<SubtitleVideoWriter*>(handle);
+    writer->close();
+
+    if (stats) {
+        const auto cpp_stats = writer->stats();
+        stats->frames_written = cpp_stats.frames_written;
+        stats->encode_seconds = cpp_stats.encode_seconds;
+        stats->blocked_seconds = cpp_stats.blocked_seconds;
+        stats->elapsed_seconds = cpp_stats.elapsed_seconds;
+        stats->frames_per_second = cpp_stats.frames_per_second;
+        stats->max_queue_depth = cpp_stats.max_queue_depth;
+    }
+}
+
+void video_writer_destroy(VideoWriterHandle handle) {
+    if (handle) {
+        delete static_cast<SubtitleVideoWriter*>(handle);
+    }
+}
+
+//=============================================================================
+// Subtitle Export
+//=============================================================================
+
+SubtitleOptions subtitle_options_default() {
+    ::SubtitleOptions options;
+    options.format = SUBTITLE_FORMAT_SRT;
+    options.word_timings = false;
+    options.last_cue_seconds = 3.0;
+    options.stream_frames = nullptr;
+    options.num_stream_frames = 0;
+    return options;
+}
+
+namespace {
+
+bool to_cpp_subtitles(const ::RecognitionResult* const* results,
+                      int num_results,
+                      const ::SubtitleOptions* options,
+                      std::deque<cued_speech::RecognitionResult>& cpp_results,
+                      cued_speech::SubtitleOptions& cpp_options) {
+    if ((!results && num_results > 0) || num_results < 0) {
+        return false;
+    }
+
+    for (int i = 0; i < num_results; ++i) {
+        if (results[i]) {
+            cpp_results.push_back(to_cpp_result(*results[i]));
+        }
+    }
+
+    if (options) {
+        cpp_options.format = options->format == SUBTITLE_FORMAT_WEBVTT
+            ? cued_speech::SubtitleFormat::WebVTT
+            : cued_speech::SubtitleFormat::SRT;
+        cpp_options.word_timings = options->word_timings;
+        cpp_options.last_cue_seconds = options->last_cue_seconds;
+        if (options->stream_frames && options->num_stream_frames > 0) {
+            cpp_options.stream_frames.assign(options->stream_frames,
+                                             options->stream_frames + options->num_stream_frames);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+char* subtitles_format(
+    const ::RecognitionResult* const* results,
+    int num_results,
+    double fps,
+    const ::SubtitleOptions* options) {
+
+    try {
+        std::deque<cued_speech::RecognitionResult> cpp_results;
+        cued_speech::SubtitleOptions cpp_options;
+        if (!to_cpp_subtitles(results, num_results, options, cpp_results, cpp_options)) {
+            set_last_error("Invalid arguments to subtitles_format");
+            return nullptr;
+        }
+        return copy_string(cued_speech::format_subtitles(cpp_results, fps, cpp_options));
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in subtitles_format: ") + e.what());
+        return nullptr;
+    }
+}
+
+bool subtitles_write(
+    const char* path,
+    const ::RecognitionResult* const* results,
+    int num_results,
+    double fps,
+    const ::SubtitleOptions* options) {
+
+    if (!path) {
+        set_last_error("Invalid path to subtitles_write");
+        return false;
+    }
+
+    try {
+        std::deque<cued_speech::RecognitionResult> cpp_results;
+        cued_speech::SubtitleOptions cpp_options;
+        if (!to_cpp_subtitles(results, num_results, options, cpp_results, cpp_options)) {
+            set_last_error("Invalid arguments to subtitles_write");
+            return false;
+        }
+        if (!cued_speech::write_subtitles(path, cpp_results, fps, cpp_options)) {
+            set_last_error(std::string("Failed to write subtitles: ") + path);
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        set_last_error(std::string("Exception in subtitles_write: ") + e.what());
+        return false;
+    }
+}
+
+void subtitles_free_string(char* str) {
+    delete[] str;
+}
+
 //=============================================================================
 // Utility Functions
 //=============================================================================
@@ -567,6 +1405,32 @@ char** phoneme_ipa_to_liaphon(const char* ipa, int* num_phonemes) {
     return copy_string_vector(liaphon);
 }
 
+void decoder_set_log_callback(LogCallback callback, void* user_data, ::LogLevel min_level, bool async) {
+    try {
+        if (!callback) {
+            cued_speech::set_log_sink(nullptr);
+            return;
+        }
+
+        static_assert(LOG_LEVEL_OFF == static_cast<int>(cued_speech::LogLevel::Off),
+                      "C and C++ log levels must match");
+
+        std::shared_ptr<cued_speech::LogSink> sink =
+            std::make_shared<CallbackLogSink>(callback, user_data);
+        if (async) {
+            sink = std::make_shared<cued_speech::AsyncLogSink>(std::move(sink));
+        }
+        cued_speech::set_log_level(static_cast<cued_speech::LogLevel>(min_level));
+        cued_speech::set_log_sink(std::move(sink));
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Exception in decoder_set_log_callback: ") + e.what();
+    }
+}
+
+void decoder_set_log_level(::LogLevel level) {
+    cued_speech::set_log_level(static_cast<cued_speech::LogLevel>(level));
+}
+
 void decoder_free_string_array(char** strings, int count) {
     if (!strings) {
         return;
@@ -36,6 +36,12 @@ typedef struct {
     float unk_score;
     float sil_score;
     bool log_add;
+    float blank_skip_threshold; // Merge runs of frames with blank log-prob above this (0 = off)
+    float token_mass;           // Expand the fewest tokens covering this probability mass (1 = off)
+    bool native_search;         // Built-in lexicon beam search instead of flashlight's (same results)
+    int segment_frames;         // stream_decode_sequence: shortest segment cut at silence (0 = off)
+    int segment_silence_frames; // Silent frames in a row where a segment may end
+    float segment_log_prob;     // Blank + silence log-prob above which a frame is silent
     
     const char* blank_token;
     const char* sil_token;
@@ -47,6 +53,35 @@ typedef struct {
  */
 DecoderConfig decoder_config_default();
 
+/**
+ * Overlap-save windowing configuration for a stream
+ */
+typedef struct {
+    int window_size;          // Frames fed to the sequence model per window
+    int commit_size;          // Frames committed per window
+    int left_context;         // Committed frames repeated as left context
+    
+    bool adaptive;            // Adapt commit size to the measured load
+    int min_commit_size;
+    int max_commit_size;
+    float frame_rate;         // Input frame rate used to measure load
+    float low_load;           // Shrink commit below this real-time fraction
+    float high_load;          // Grow commit above this real-time fraction
+    
+    int provisional_interval; // Valid frames between provisional results (0 = off)
+
+    int endpoint_silence_frames; // Committed blank/silence frames that end an utterance (0 = off)
+    float endpoint_log_prob;     // Blank + silence log-prob above which a frame is silent
+    int endpoint_dropped_frames; // Consecutive dropped frames that end an utterance (0 = off)
+
+    int two_pass_margin;      // Beam search only after the last silence this many frames back (0 = off)
+} WindowingConfig;
+
+/**
+ * Default windowing configuration (100/50/25, fixed)
+ */
+WindowingConfig windowing_config_default();
+
 /**
  * Hypothesis result
  */
@@ -60,17 +95,124 @@ typedef struct {
     int timesteps_length;
 } Hypothesis;
 
+/**
+ * Frame span of a decoded word (valid-frame indices, inclusive)
+ */
+typedef struct {
+    char* word;
+    int start_frame;
+    int end_frame;
+} WordTiming;
+
 /**
  * Recognition result
  */
 typedef struct {
     int frame_number;
-    char** phonemes;          // NULL-terminated strings
+    char** phonemes;          // NULL-terminated strings (committed prefix)
     int phonemes_length;
     char* french_sentence;    // NULL-terminated string (can be NULL)
     float confidence;
+    char** unstable_phonemes; // Speculative tail, may still change (can be NULL)
+    int unstable_phonemes_length;
+    bool provisional;         // true if decoded from a partial window
+    WordTiming* word_timings; // Decoded lexicon words with frame spans (can be NULL)
+    int word_timings_length;
+    bool endpoint;            // Last result of an utterance; later results start after it
 } RecognitionResult;
 
+/**
+ * Recognition result as token IDs (see stream_process_window_ids)
+ *
+ * IDs index the table from decoder_get_token_table. When a buffer is too
+ * small, truncated is set and the lengths give the sizes needed; the buffers
+ * hold the first IDs that fit.
+ */
+typedef struct {
+    int frame_number;
+    float confidence;
+    bool provisional;
+    int tokens_length;          // Committed phone token IDs
+    int unstable_tokens_length; // Speculative tail token IDs
+    bool truncated;
+    bool endpoint;              // Last result of an utterance
+} TokenResult;
+
+/**
+ * Instrumented pipeline stages (index into StreamStats.stages)
+ */
+typedef enum {
+    PROFILE_STAGE_FEATURE_EXTRACTION = 0,
+    PROFILE_STAGE_WINDOW_ASSEMBLY = 1,
+    PROFILE_STAGE_MODEL_INVOKE = 2,
+    PROFILE_STAGE_LOG_SOFTMAX = 3,
+    PROFILE_STAGE_BEAM_SEARCH = 4,
+    PROFILE_STAGE_CORRECTION = 5,
+    PROFILE_STAGE_COUNT = 6
+} ProfileStage;
+
+/**
+ * Latency summary of one stage, in microseconds
+ */
+typedef struct {
+    uint64_t count;
+    double total_us;
+    double p50_us;
+    double p95_us;
+    double p99_us;
+    double max_us;
+} StageLatency;
+
+/**
+ * Per-stream latency histograms and counters
+ */
+typedef struct {
+    StageLatency stages[PROFILE_STAGE_COUNT];
+    uint64_t frames_pushed;
+    uint64_t frames_dropped;
+    uint64_t windows_processed;
+    uint64_t decodes;
+    uint64_t provisional_results;
+    uint64_t searched_frames; // Log-prob rows run through the beam search
+    bool profiling_enabled;   // false if built without ENABLE_PROFILING
+} StreamStats;
+
+/**
+ * Receives a result decoded inline by stream_push_frames_process
+ *
+ * The result is pooled (see stream_process_window_pooled) and only valid
+ * during the call.
+ */
+typedef void (*ResultCallback)(const RecognitionResult* result, void* user_data);
+
+/**
+ * Log severity, in increasing order
+ */
+typedef enum {
+    LOG_LEVEL_TRACE = 0,
+    LOG_LEVEL_DEBUG = 1,
+    LOG_LEVEL_INFO = 2,
+    LOG_LEVEL_WARN = 3,
+    LOG_LEVEL_ERROR = 4,
+    LOG_LEVEL_OFF = 5
+} LogLevel;
+
+/**
+ * Receives one log record
+ *
+ * All pointers are only valid during the call. field_keys/field_values hold
+ * num_fields structured key/value pairs (e.g. "chunk" / "3").
+ */
+typedef void (*LogCallback)(
+    LogLevel level,
+    const char* component,
+    const char* message,
+    const char* const* field_keys,
+    const char* const* field_values,
+    int num_fields,
+    void* user_data
+);
+
 //=============================================================================
 // Decoder Lifecycle
 //=============================================================================
@@ -107,6 +249,21 @@ int decoder_get_vocab_size(DecoderHandle handle);
  */
 const char* decoder_idx_to_token(DecoderHandle handle, int idx);
 
+/**
+ * Export the whole token table at once
+ *
+ * Fills tokens[i] with the string of token i for i < min(capacity,
+ * vocabulary size). The strings belong to the decoder (caller must NOT free)
+ * and stay valid until decoder_destroy, so FFI callers can cache them and
+ * map IDs to strings without further calls.
+ *
+ * @param handle Decoder handle
+ * @param[out] tokens Array of capacity string pointers (can be NULL to query)
+ * @param capacity Size of tokens
+ * @return Vocabulary size, or -1 on error
+ */
+int decoder_get_token_table(DecoderHandle handle, const char** tokens, int capacity);
+
 /**
  * Convert token string to index
  * 
@@ -185,6 +342,17 @@ StreamHandle stream_create(DecoderHandle decoder_handle);
  */
 bool stream_load_tflite_model(StreamHandle handle, const char* model_path);
 
+/**
+ * Change the windowing of a stream
+ *
+ * Resets the stream; call before pushing frames.
+ *
+ * @param handle Stream handle
+ * @param config Windowing configuration
+ * @return true on success, false if the configuration is invalid
+ */
+bool stream_set_windowing(StreamHandle handle, const WindowingConfig* config);
+
 /**
  * Destroy a streaming session
  * 
@@ -214,10 +382,53 @@ void stream_reset(StreamHandle handle);
  */
 bool stream_push_frame(StreamHandle handle, const float* features);
 
+/**
+ * Push a contiguous block of frames
+ *
+ * frames holds count rows of 33 floats in the stream_push_frame layout.
+ * Frames whose valid_mask entry is 0 are counted but dropped (e.g. no hand
+ * detected). One call replaces count stream_push_frame calls; the block is
+ * copied in bulk.
+ *
+ * @param handle Stream handle
+ * @param frames Feature rows [count x 33]
+ * @param count Number of frames
+ * @param valid_mask Per-frame validity flags [count], or NULL if all are valid
+ * @return Number of windows ready to process (call stream_process_window
+ *         that many times), or -1 on error
+ */
+int stream_push_frames(StreamHandle handle, const float* frames, int count, const uint8_t* valid_mask);
+
+/**
+ * Push a block of frames and decode each window as soon as it is ready
+ *
+ * Equivalent to calling stream_push_frame for every frame and
+ * stream_process_window whenever it returns true, without crossing the FFI
+ * boundary per frame.
+ *
+ * @param handle Stream handle
+ * @param frames Feature rows [count x 33]
+ * @param count Number of frames
+ * @param valid_mask Per-frame validity flags [count], or NULL if all are valid
+ * @param callback Called with each result (can be NULL to discard results)
+ * @param user_data Passed to callback
+ * @return Number of windows processed, or -1 on error
+ */
+int stream_push_frames_process(
+    StreamHandle handle,
+    const float* frames,
+    int count,
+    const uint8_t* valid_mask,
+    ResultCallback callback,
+    void* user_data
+);
+
 /**
  * Process current window and get partial result
  *
- * This should be called when stream_push_frame returns true.
+ * This should be called when stream_push_frame returns true. With a
+ * provisional interval configured, results between window commits have
+ * provisional set and carry their uncommitted tail in unstable_phonemes.
  *
  * @param handle Stream handle
  * @return Recognition result (caller must free with stream_free_result)
@@ -232,6 +443,48 @@ RecognitionResult* stream_process_window(StreamHandle handle);
  */
 RecognitionResult* stream_finalize(StreamHandle handle);
 
+/**
+ * Decode a whole pre-recorded sequence at once
+ *
+ * Resets the stream, runs the sequence model on all windows in parallel and
+ * decodes once. The result matches the final result of pushing the same
+ * frames one by one. Frames use the stream_push_frames layout.
+ *
+ * @param handle Stream handle
+ * @param frames Feature rows [count x 33]
+ * @param count Number of frames
+ * @param valid_mask Per-frame validity flags [count], or NULL if all are valid
+ * @param num_threads Inference threads (0 = one per core)
+ * @return Recognition result (caller must free with stream_free_result)
+ */
+RecognitionResult* stream_decode_sequence(
+    StreamHandle handle,
+    const float* frames,
+    int count,
+    const uint8_t* valid_mask,
+    int num_threads
+);
+
+/**
+ * Get latency percentiles and counters for a stream
+ *
+ * Stage latencies are only collected when the library is built with
+ * ENABLE_PROFILING; counters are always available. Correction latency is
+ * recorded when a corrector is attached with corrector_attach_stream.
+ *
+ * @param handle Stream handle
+ * @param[out] stats Filled with the current statistics
+ * @return true on success
+ */
+bool stream_get_stats(StreamHandle handle, StreamStats* stats);
+
+/**
+ * Clear the latency histograms of a stream
+ *
+ * @param handle Stream handle
+ */
+void stream_reset_stats(StreamHandle handle);
+
 /**
  * Free recognition result
  * 
@@ -239,6 +492,161 @@ RecognitionResult* stream_finalize(StreamHandle handle);
  */
 void stream_free_result(RecognitionResult* result);
 
+//=============================================================================
+// Allocation-Free Results
+//=============================================================================
+
+/**
+ * Process the current window, writing token IDs into caller buffers
+ *
+ * Same decode as stream_process_window, but nothing is allocated for the
+ * caller: IDs go to tokens/unstable_tokens and the rest to result.
+ *
+ * @param handle Stream handle
+ * @param[out] tokens Buffer for committed phone token IDs (can be NULL if capacity is 0)
+ * @param tokens_capacity Size of tokens
+ * @param[out] unstable_tokens Buffer for the speculative tail (can be NULL if capacity is 0)
+ * @param unstable_capacity Size of unstable_tokens
+ * @param[out] result Frame number, confidence, flags and lengths
+ * @return true on success
+ */
+bool stream_process_window_ids(
+    StreamHandle handle,
+    int* tokens,
+    int tokens_capacity,
+    int* unstable_tokens,
+    int unstable_capacity,
+    TokenResult* result
+);
+
+/**
+ * Finalize the stream, writing token IDs into caller buffers
+ *
+ * @see stream_process_window_ids
+ */
+bool stream_finalize_ids(
+    StreamHandle handle,
+    int* tokens,
+    int tokens_capacity,
+    int* unstable_tokens,
+    int unstable_capacity,
+    TokenResult* result
+);
+
+/**
+ * Process the current window into the stream's pooled result
+ *
+ * The returned result is owned by the stream and stays valid until the next
+ * pooled call on the stream (including stream_push_frames_process) or
+ * stream_destroy; copy what you need before
+ * then and do NOT pass it to stream_free_result. Its arrays only grow, so
+ * steady-state streaming allocates nothing for results.
+ *
+ * @param handle Stream handle
+ * @return Pooled recognition result, or NULL on error
+ */
+const RecognitionResult* stream_process_window_pooled(StreamHandle handle);
+
+/**
+ * Finalize the stream into the stream's pooled result
+ *
+ * @see stream_process_window_pooled
+ */
+const RecognitionResult* stream_finalize_pooled(StreamHandle handle);
+
+//=============================================================================
+// Shared-Memory Frame Ring
+//=============================================================================
+
+/**
+ * Opaque handle for a shared-memory frame ring
+ *
+ * A single-producer/single-consumer ring of 33-float frames in POSIX shared
+ * memory, for a capture process feeding a decoder process. Not available
+ * on Android or Windows (create/open return NULL).
+ */
+typedef void* FrameRingHandle;
+
+/**
+ * Create the ring name for the producer, replacing a stale one
+ *
+ * @param name Shared-memory name, e.g. "cued_speech_frames"
+ * @param capacity Frames, rounded up to a power of two
+ * @return Ring handle, or NULL on failure
+ */
+FrameRingHandle frame_ring_create(const char* name, int capacity);
+
+/**
+ * Open an existing ring for the consumer
+ */
+FrameRingHandle frame_ring_open(const char* name);
+
+/**
+ * Unmap the ring; the creator also closes and removes it
+ */
+void frame_ring_destroy(FrameRingHandle handle);
+
+/**
+ * Producer: next free frame (33 floats) to fill in place
+ *
+ * @param timeout_ms Milliseconds to wait while the ring is full
+ *                   (0 = don't wait, -1 = forever)
+ * @return Frame to fill, then publish with frame_ring_commit; NULL on timeout
+ */
+float* frame_ring_reserve(FrameRingHandle handle, int timeout_ms);
+
+/**
+ * Producer: publish the frame returned by frame_ring_reserve
+ *
+ * @param valid false for a dropped frame (features ignored)
+ */
+void frame_ring_commit(FrameRingHandle handle, int frame_number, bool valid);
+
+/**
+ * Producer: copy one frame into the ring (reserve + commit)
+ *
+ * @param features 33 floats, or NULL for a dropped frame
+ * @return false on timeout
+ */
+bool frame_ring_push(FrameRingHandle handle, const float* features, int frame_number, bool valid, int timeout_ms);
+
+/**
+ * Producer: mark the end of the stream
+ */
+void frame_ring_close(FrameRingHandle handle);
+
+/**
+ * Consumer: true once the producer closed the ring and every frame was read
+ */
+bool frame_ring_finished(FrameRingHandle handle);
+
+/**
+ * Feed frames from a ring into a stream and decode ready windows
+ *
+ * Frames are passed to the stream straight from shared memory and
+ * released as they are consumed. Like stream_push_frames_process, each
+ * window is decoded as soon as it is ready and handed to callback (pooled
+ * result, see stream_process_window_pooled).
+ *
+ * @param handle Stream handle
+ * @param ring Ring opened with frame_ring_open
+ * @param max_frames Most frames to consume in this call
+ * @param timeout_ms Milliseconds to wait for the first frame
+ *                   (0 = don't wait, -1 = forever)
+ * @param callback Called with each result (can be NULL to discard results)
+ * @param user_data Passed to callback
+ * @return Frames consumed (0 on timeout or once the ring is finished),
+ *         or -1 on error
+ */
+int stream_consume_ring(
+    StreamHandle handle,
+    FrameRingHandle ring,
+    int max_frames,
+    int timeout_ms,
+    ResultCallback callback,
+    void* user_data
+);
+
 //=============================================================================
 // Sentence Correction
 //=============================================================================
@@ -281,6 +689,20 @@ char* corrector_correct(
     int num_phonemes
 );
 
+/**
+ * Record correction latency into a stream's statistics
+ *
+ * The corrector records into the stream until it is detached, attached to
+ * another stream, or the stream is destroyed (stream_destroy detaches it).
+ * Do not destroy the stream while the corrector is inside corrector_correct.
+ * The stream's statistics are not synchronized: an attached corrector must
+ * only be used from the thread that drives the stream.
+ *
+ * @param handle Corrector handle
+ * @param stream Stream handle, or NULL to detach
+ */
+void corrector_attach_stream(CorrectorHandle handle, StreamHandle stream);
+
 /**
  * Free string returned by corrector_correct
  * 
@@ -288,6 +710,159 @@ char* corrector_correct(
  */
 void corrector_free_string(char* str);
 
+//=============================================================================
+// Subtitled Video Output
+//=============================================================================
+
+/**
+ * Opaque handle for a streaming subtitle video writer
+ */
+typedef void* VideoWriterHandle;
+
+/**
+ * Video output settings
+ */
+typedef struct {
+    const char* codec;          // FourCC, e.g. "MJPG", "FFV1" (.mkv/.avi), "avc1" (.mp4)
+    bool use_ffmpeg;            // Force OpenCV's FFmpeg backend
+    int queue_capacity;         // Frames buffered ahead of the encoder thread
+} VideoWriterConfig;
+
+/**
+ * Encoder throughput
+ */
+typedef struct {
+    uint64_t frames_written;
+    double encode_seconds;
+    double blocked_seconds;
+    double elapsed_seconds;
+    double frames_per_second;
+    int max_queue_depth;
+} VideoWriterStats;
+
+/**
+ * Get default video writer configuration (MJPG, 32 queued frames)
+ */
+VideoWriterConfig video_writer_config_default();
+
+/**
+ * Open an output video; frames are encoded on a background thread
+ *
+ * @param config Output settings (NULL for defaults)
+ * @param output_path Output file
+ * @param fps Frame rate
+ * @param width Frame width (rounded down to even)
+ * @param height Frame height (rounded down to even)
+ * @return Writer handle, or NULL on failure
+ */
+VideoWriterHandle video_writer_create(
+    const VideoWriterConfig* config,
+    const char* output_path,
+    double fps,
+    int width,
+    int height
+);
+
+/**
+ * Set the subtitle drawn on subsequent frames (NULL or "" clears it)
+ */
+void video_writer_set_text(VideoWriterHandle handle, const char* text);
+
+/**
+ * Set the subtitle from a recognition result (French sentence, or phonemes)
+ */
+void video_writer_set_result(VideoWriterHandle handle, const RecognitionResult* result);
+
+/**
+ * Queue one 8-bit BGR frame; the buffer is copied before returning
+ *
+ * Blocks while the encoder queue is full.
+ *
+ * @param stride Bytes per row (0 means width * 3)
+ */
+bool video_writer_write_frame(
+    VideoWriterHandle handle,
+    const uint8_t* bgr,
+    int width,
+    int height,
+    int stride
+);
+
+/**
+ * Flush queued frames and close the file
+ *
+ * @param[out] stats Throughput of the finished file (may be NULL)
+ */
+void video_writer_close(VideoWriterHandle handle, VideoWriterStats* stats);
+
+/**
+ * Destroy a writer (closes it first if needed)
+ */
+void video_writer_destroy(VideoWriterHandle handle);
+
+//=============================================================================
+// Subtitle Export
+//=============================================================================
+
+typedef enum {
+    SUBTITLE_FORMAT_SRT = 0,
+    SUBTITLE_FORMAT_WEBVTT = 1
+} SubtitleFormat;
+
+/**
+ * Subtitle export options
+ */
+typedef struct {
+    SubtitleFormat format;
+    bool word_timings;          // One cue per word where results carry timings
+    double last_cue_seconds;    // Duration of the final sentence cue
+    const int* stream_frames;   // Stream frame of each valid frame, or NULL if none was dropped
+    int num_stream_frames;      // Entries in stream_frames
+} SubtitleOptions;
+
+/**
+ * Get default subtitle options (SRT, sentence cues, 3 s final cue)
+ */
+SubtitleOptions subtitle_options_default();
+
+/**
+ * Render recognition results as SRT or WebVTT
+ *
+ * Each result is shown from its frame_number until the next one. No video
+ * is read or encoded. Streams count frame numbers and word timings in valid
+ * frames; set options->stream_frames if frames were dropped.
+ *
+ * @param results Results from stream_process_window/stream_finalize
+ * @param num_results Number of results
+ * @param fps Frame rate of the stream
+ * @param options Export options (NULL for defaults)
+ * @return UTF-8 subtitle text (caller must free with subtitles_free_string)
+ */
+char* subtitles_format(
+    const RecognitionResult* const* results,
+    int num_results,
+    double fps,
+    const SubtitleOptions* options
+);
+
+/**
+ * Write subtitles_format() output to a file
+ *
+ * @return true on success
+ */
+bool subtitles_write(
+    const char* path,
+    const RecognitionResult* const* results,
+    int num_results,
+    double fps,
+    const SubtitleOptions* options
+);
+
+/**
+ * Free string returned by subtitles_format
+ */
+void subtitles_free_string(char* str);
+
 //=============================================================================
 // Utility Functions
 //=============================================================================
@@ -299,6 +874,29 @@ void corrector_free_string(char* str);
  */
 const char* decoder_get_last_error();
 
+/**
+ * Route library log records to a callback
+ *
+ * Logging is off until a callback is set. With async = true records are
+ * queued in a bounded ring buffer (new records are dropped when it is full)
+ * and the callback runs on a dedicated background thread, so decoding
+ * threads never wait on it. With async = false the callback runs on the
+ * logging thread and must be thread-safe.
+ *
+ * @param callback Callback, or NULL to disable logging
+ * @param user_data Passed back to every call
+ * @param min_level Records below this level are discarded
+ * @param async Deliver from a background thread
+ */
+void decoder_set_log_callback(LogCallback callback, void* user_data, LogLevel min_level, bool async);
+
+/**
+ * Change the minimum level of the installed log callback
+ *
+ * @param level Records below this level are discarded
+ */
+void decoder_set_log_level(LogLevel level);
+
 /**
  * Convert LIAPHON phonemes to IPA string
  * 
@@ -0,0 +1,694 @@
+/**
+ * Client library for cued_speech_daemon - Implementation
+ */
+
+#include "decoder_client.h"
+#include "daemon_protocol.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace protocol = cued_speech::protocol;
+using protocol::MessageType;
+
+namespace {
+
+// Thread-local error message
+thread_local std::string g_client_error;
+
+void set_client_error(const std::string& error) {
+    g_client_error = error;
+}
+
+struct ClientConnection;
+
+/**
+ * Result handed out by the library: the C result and the token IDs behind
+ * it (see client_result_ids). Standard layout, so a pointer to result is a
+ * pointer to the whole.
+ */
+struct ClientResult {
+    ::RecognitionResult result;
+    int* phoneme_ids;
+    int phoneme_ids_length;
+    int* unstable_phoneme_ids;
+    int unstable_phoneme_ids_length;
+};
+static_assert(std::is_standard_layout<ClientResult>::value, "ClientResult must start with its result");
+
+struct ClientStream {
+    ClientConnection* connection = nullptr;
+    uint32_t id = 0;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool opened = false;
+    bool failed = false;                       // Open refused or connection lost
+    bool finalizing = false;
+    bool final_ready = false;
+    bool closed = false;                       // Destroyed: late results are freed, not queued
+    std::string error;
+    std::deque<::RecognitionResult*> results;
+    ::RecognitionResult* final_result = nullptr;
+
+    // Held while the reader thread runs the callback
+    std::mutex callback_mutex;
+    ResultCallback callback = nullptr;
+    void* user_data = nullptr;
+};
+
+struct ClientConnection {
+    int fd = -1;
+    std::mutex write_mutex;
+    std::thread reader;
+
+    std::mutex streams_mutex;
+    std::unordered_map<uint32_t, std::shared_ptr<ClientStream>> streams;
+    uint32_t next_session = 1;
+    bool connected = true;                     // Guarded by streams_mutex
+};
+
+char* copy_string(const std::string& str) {
+    char* result = new char[str.size() + 1];
+    std::memcpy(result, str.c_str(), str.size() + 1);
+    return result;
+}
+
+bool read_strings(protocol::PayloadReader& reader, char**& strings, int& length) {
+    uint32_t count = 0;
+    if (!reader.get(count) || count > reader.remaining() / sizeof(uint32_t)) {
+        return false;
+    }
+    length = static_cast<int>(count);
+    strings = count > 0 ? new char*[count]() : nullptr;
+    std::string text;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!reader.get_string(text)) {
+            return false;
+        }
+        strings[i] = copy_string(text);
+    }
+    return true;
+}
+
+bool read_ids(protocol::PayloadReader& reader, int*& ids, int& length) {
+    uint32_t count = 0;
+    if (!reader.get(count) || count > reader.remaining() / sizeof(int32_t)) {
+        return false;
+    }
+    length = static_cast<int>(count);
+    ids = count > 0 ? new int[count]() : nullptr;
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t id = 0;
+        if (!reader.get(id)) {
+            return false;
+        }
+        ids[i] = id;
+    }
+    return true;
+}
+
+::RecognitionResult* decode_result(protocol::PayloadReader& reader, uint16_t flags) {
+    auto owner = new ClientResult{};
+    ::RecognitionResult* result = &owner->result;
+    result->provisional = (flags & protocol::kResultProvisional) != 0;
+    result->endpoint = (flags & protocol::kResultEndpoint) != 0;
+
+    int32_t frame_number = 0;
+    std::string sentence;
+    uint32_t timings = 0;
+    bool ok = reader.get(frame_number) && reader.get(result->confidence) &&
+              read_strings(reader, result->phonemes, result->phonemes_length) &&
+              read_strings(reader, result->unstable_phonemes, result->unstable_phonemes_length) &&
+              reader.get_string(sentence) && reader.get(timings) &&
+              timings <= reader.remaining() / (sizeof(uint32_t) + 2 * sizeof(int32_t));
+    result->frame_number = frame_number;
+    if (ok) {
+        result->french_sentence = sentence.empty() ? nullptr : copy_string(sentence);
+        result->word_timings = timings > 0 ? new ::WordTiming[timings]() : nullptr;
+        result->word_timings_length = static_cast<int>(timings);
+        std::string word;
+        for (uint32_t i = 0; i < timings && ok; ++i) {
+            int32_t start = 0;
+            int32_t end = 0;
+            ok = reader.get_string(word) && reader.get(start) && reader.get(end);
+            result->word_timings[i] = {ok ? copy_string(word) : nullptr, start, end};
+        }
+        ok = ok && read_ids(reader, owner->phoneme_ids, owner->phoneme_ids_length) &&
+             read_ids(reader, owner->unstable_phoneme_ids, owner->unstable_phoneme_ids_length);
+    }
+    if (!ok) {
+        client_free_result(result);
+        return nullptr;
+    }
+    return result;
+}
+
+bool send_all(ClientConnection* connection, const std::string& bytes) {
+    std::lock_guard<std::mutex> lock(connection->write_mutex);
+    size_t sent_total = 0;
+    while (sent_total < bytes.size()) {
+        const ssize_t sent = ::send(connection->fd, bytes.data() + sent_total,
+                                    bytes.size() - sent_total, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            set_client_error(std::string("Failed to send to daemon: ") + std::strerror(errno));
+            return false;
+        }
+        sent_total += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool send_message(ClientStream* stream, MessageType type) {
+    std::string bytes;
+    protocol::MessageWriter writer(bytes);
+    writer.begin(type, stream->id);
+    writer.end();
+    return send_all(stream->connection, bytes);
+}
+
+// False (with the error set) once the stream cannot be used
+bool stream_usable(ClientStream* stream) {
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    if (stream->failed) {
+        set_client_error(stream->error);
+        return false;
+    }
+    return true;
+}
+
+void dispatch(ClientConnection* connection, const protocol::MessageHeader& header, const char* payload) {
+    std::shared_ptr<ClientStream> stream;
+    {
+        std::lock_guard<std::mutex> lock(connection->streams_mutex);
+        auto it = connection->streams.find(header.session);
+        if (it == connection->streams.end()) {
+            return;  // Destroyed meanwhile
+        }
+        stream = it->second;
+    }
+
+    protocol::PayloadReader reader(payload, header.length);
+    switch (static_cast<MessageType>(header.type)) {
+        case MessageType::Opened: {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->opened = true;
+            break;
+        }
+
+        case MessageType::Error: {
+            std::string message;
+            reader.get_string(message);
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->error = "Daemon error: " + message;
+            if (!stream->opened) {
+                stream->failed = true;
+            }
+            if (stream->finalizing) {
+                stream->final_ready = true;
+            }
+            break;
+        }
+
+        case MessageType::Result: {
+            ::RecognitionResult* result = decode_result(reader, header.flags);
+            if (!result) {
+                std::lock_guard<std::mutex> lock(stream->mutex);
+                stream->error = "Malformed result from daemon";
+                break;
+            }
+
+            if (header.flags & protocol::kResultFinal) {
+                std::lock_guard<std::mutex> lock(stream->mutex);
+                if (stream->closed) {
+                    client_free_result(result);
+                    return;
+                }
+                client_free_result(stream->final_result);
+                stream->final_result = result;
+                stream->final_ready = true;
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> callback_lock(stream->callback_mutex);
+                if (stream->callback) {
+                    stream->callback(result, stream->user_data);
+                    client_free_result(result);
+                    return;
+                }
+            }
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            if (stream->closed) {
+                // client_stream_destroy already drained the queue
+                client_free_result(result);
+                return;
+            }
+            stream->results.push_back(result);
+            break;
+        }
+
+        default:
+            return;
+    }
+    stream->changed.notify_all();
+}
+
+void reader_loop(ClientConnection* connection) {
+    std::string incoming;
+    std::vector<char> buffer(64 * 1024);
+
+    while (true) {
+        const ssize_t received = ::recv(connection->fd, buffer.data(), buffer.size(), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        incoming.append(buffer.data(), static_cast<size_t>(received));
+
+        size_t offset = 0;
+        long long size = 0;
+        protocol::MessageHeader header;
+        while ((size = protocol::complete_message_size(incoming.data() + offset,
+                                                       incoming.size() - offset, header)) > 0) {
+            dispatch(connection, header, incoming.data() + offset + sizeof(header));
+            offset += static_cast<size_t>(size);
+        }
+        if (size < 0) {
+            break;
+        }
+        incoming.erase(0, offset);
+    }
+
+    // Wake everyone waiting on a stream of this connection
+    std::lock_guard<std::mutex> lock(connection->streams_mutex);
+    connection->connected = false;
+    for (auto& entry : connection->streams) {
+        auto& stream = entry.second;
+        {
+            std::lock_guard<std::mutex> stream_lock(stream->mutex);
+            stream->failed = true;
+            stream->final_ready = true;
+            if (stream->error.empty()) {
+                stream->error = "Connection to daemon lost";
+            }
+        }
+        stream->changed.notify_all();
+    }
+}
+
+} // namespace
+
+//=============================================================================
+// Connection
+//=============================================================================
+
+ClientHandle client_connect(const char* socket_path) {
+    sockaddr_un address{};
+    if (!socket_path || std::strlen(socket_path) >= sizeof(address.sun_path)) {
+        set_client_error("Invalid arguments to client_connect");
+        return nullptr;
+    }
+
+    try {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            set_client_error(std::string("socket() failed: ") + std::strerror(errno));
+            return nullptr;
+        }
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socket_path);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            set_client_error(std::string("Failed to connect to ") + socket_path + ": " + std::strerror(errno));
+            ::close(fd);
+            return nullptr;
+        }
+
+        auto connection = new ClientConnection;
+        connection->fd = fd;
+        connection->reader = std::thread(reader_loop, connection);
+        return connection;
+    } catch (const std::exception& e) {
+        set_client_error(std::string("Exception in client_connect: ") + e.what());
+        return nullptr;
+    }
+}
+
+void client_disconnect(ClientHandle handle) {
+    if (!handle) {
+        return;
+    }
+
+    auto connection = static_cast<ClientConnection*>(handle);
+    ::shutdown(connection->fd, SHUT_RDWR);
+    if (connection->reader.joinable()) {
+        connection->reader.join();
+    }
+    ::close(connection->fd);
+    delete connection;
+}
+
+//=============================================================================
+// Streaming
+//=============================================================================
+
+ClientStreamHandle client_stream_create(ClientHandle client) {
+    if (!client) {
+        set_client_error("Invalid connection handle");
+        return nullptr;
+    }
+
+    try {
+        auto connection = static_cast<ClientConnection*>(client);
+        auto stream = std::make_shared<ClientStream>();
+        stream->connection = connection;
+        {
+            std::lock_guard<std::mutex> lock(connection->streams_mutex);
+            if (!connection->connected) {
+                set_client_error("Connection to daemon lost");
+                return nullptr;
+            }
+            stream->id = connection->next_session++;
+            connection->streams.emplace(stream->id, stream);
+        }
+
+        bool opened = send_message(stream.get(), MessageType::Open);
+        if (opened) {
+            std::unique_lock<std::mutex> lock(stream->mutex);
+            stream->changed.wait(lock, [&] { return stream->opened || stream->failed; });
+            opened = stream->opened && !stream->failed;
+            if (!opened) {
+                set_client_error(stream->error);
+            }
+        }
+
+        if (!opened) {
+            std::lock_guard<std::mutex> lock(connection->streams_mutex);
+            connection->streams.erase(stream->id);
+            return nullptr;
+        }
+        return stream.get();
+    } catch (const std::exception& e) {
+        set_client_error(std::string("Exception in client_stream_create: ") + e.what());
+        return nullptr;
+    }
+}
+
+void client_stream_destroy(ClientStreamHandle handle) {
+    if (!handle) {
+        return;
+    }
+
+    auto stream = static_cast<ClientStream*>(handle);
+    {
+        std::lock_guard<std::mutex> lock(stream->callback_mutex);
+        stream->callback = nullptr;
+    }
+    send_message(stream, MessageType::Close);
+
+    std::shared_ptr<ClientStream> owned;
+    {
+        std::lock_guard<std::mutex> lock(stream->connection->streams_mutex);
+        auto it = stream->connection->streams.find(stream->id);
+        if (it != stream->connection->streams.end()) {
+            owned = std::move(it->second);
+            stream->connection->streams.erase(it);
+        }
+    }
+
+    // The reader thread may still hold the stream with a result decoded;
+    // once closed is set it frees results instead of queuing them
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    stream->closed = true;
+    for (auto* result : stream->results) {
+        client_free_result(result);
+    }
+    stream->results.clear();
+    client_free_result(stream->final_result);
+    stream->final_result = nullptr;
+}
+
+bool client_stream_set_windowing(ClientStreamHandle handle, const WindowingConfig* config) {
+    if (!handle || !config) {
+        set_client_error("Invalid arguments to client_stream_set_windowing");
+        return false;
+    }
+
+    auto stream = static_cast<ClientStream*>(handle);
+    if (!stream_usable(stream)) {
+        return false;
+    }
+
+    protocol::WindowingParams params{};
+    params.window_size = config->window_size;
+    params.commit_size = config->commit_size;
+    params.left_context = config->left_context;
+    params.adaptive = config->adaptive ? 1 : 0;
+    params.min_commit_size = config->min_commit_size;
+    params.max_commit_size = config->max_commit_size;
+    params.frame_rate = config->frame_rate;
+    params.low_load = config->low_load;
+    params.high_load = config->high_load;
+    params.provisional_interval = config->provisional_interval;
+    params.endpoint_silence_frames = config->endpoint_silence_frames;
+    params.endpoint_log_prob = config->endpoint_log_prob;
+    params.endpoint_dropped_frames = config->endpoint_dropped_frames;
+    params.two_pass_margin = config->two_pass_margin;
+
+    std::string bytes;
+    protocol::MessageWriter writer(bytes);
+    writer.begin(MessageType::SetWindowing, stream->id);
+    writer.put_windowing(params);
+    writer.end();
+    return send_all(stream->connection, bytes);
+}
+
+void client_stream_reset(ClientStreamHandle handle) {
+    if (!handle) {
+        return;
+    }
+
+    auto stream = static_cast<ClientStream*>(handle);
+    if (!stream_usable(stream) || !send_message(stream, MessageType::Reset)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    for (auto* result : stream->results) {
+        client_free_result(result);
+    }
+    stream->results.clear();
+}
+
+void client_stream_set_callback(ClientStreamHandle handle, ResultCallback callback, void* user_data) {
+    if (!handle) {
+        return;
+    }
+
+    auto stream = static_cast<ClientStream*>(handle);
+    std::lock_guard<std::mutex> lock(stream->callback_mutex);
+    stream->callback = callback;
+    stream->user_data = user_data;
+}
+
+bool client_stream_push_frame(ClientStreamHandle handle, const float* features) {
+    if (!handle || !features) {
+        set_client_error("Invalid arguments to client_stream_push_frame");
+        return false;
+    }
+    return client_stream_push_frames(handle, features, 1, nullptr) == 1;
+}
+
+int client_stream_push_frames(ClientStreamHandle handle, const float* frames, int count, const uint8_t* valid_mask) {
+    if (!handle || count < 0 || (count > 0 && !frames)) {
+        set_client_error("Invalid arguments to client_stream_push_frames");
+        return -1;
+    }
+
+    auto stream = static_cast<ClientStream*>(handle);
+    if (!stream_usable(stream)) {
+        return -1;
+    }
+
+    try {
+        // Split batches that would exceed the daemon's message limit
+        const size_t frame_bytes = sizeof(float) * protocol::kFeatureSize;
+        const int max_batch = static_cast<int>((protocol::kMaxPayload - 16) / (frame_bytes + 1));
+        std::string bytes;
+        for (int first = 0; first < count; first += max_batch) {
+            const int batch = std::min(count - first, max_batch);
+            bytes.clear();
+            protocol::MessageWriter writer(bytes);
+            writer.begin(MessageType::PushFrames, stream->id);
+            writer.put(static_cast<uint32_t>(batch));
+            writer.put(static_cast<uint8_t>(valid_mask ? 1 : 0));
+            writer.put_bytes(frames + static_cast<size_t>(first) * protocol::kFeatureSize, batch * frame_bytes);
+            if (valid_mask) {
+                writer.put_bytes(valid_mask + first, static_cast<size_t>(batch));
+            }
+            writer.end();
+            if (!send_all(stream->connection, bytes)) {
+                return -1;
+            }
+        }
+        return count;
+    } catch (const std::exception& e) {
+        set_client_error(std::string("Exception in client_stream_push_frames: ") + e.what());
+        return -1;
+    }
+}
+
+RecognitionResult* client_stream_poll_result(ClientStreamHandle handle, int timeout_ms) {
+    if (!handle) {
+        set_client_error("Invalid stream handle");
+        return nullptr;
+    }
+
+    auto stream = static_cast<ClientStream*>(handle);
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    auto ready = [&] { return !stream->results.empty() || stream->failed; };
+    if (timeout_ms < 0) {
+        stream->changed.wait(lock, ready);
+    } else if (timeout_ms > 0) {
+        stream->changed.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    }
+
+    if (stream->results.empty()) {
+        if (stream->failed) {
+            set_client_error(stream->error);
+        }
+        return nullptr;
+    }
+    ::RecognitionResult* result = stream->results.front();
+    stream->results.pop_front();
+    return result;
+}
+
+RecognitionResult* client_stream_finalize(ClientStreamHandle handle) {
+    if (!handle) {
+        set_client_error("Invalid stream handle");
+        return nullptr;
+    }
+
+    auto stream = static_cast<ClientStream*>(handle);
+    if (!stream_usable(stream)) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->finalizing = true;
+        stream->final_ready = false;
+    }
+
+    if (!send_message(stream, MessageType::Finalize)) {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->finalizing = false;
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    stream->changed.wait(lock, [&] { return stream->final_ready; });
+    stream->finalizing = false;
+    ::RecognitionResult* result = stream->final_result;
+    stream->final_result = nullptr;
+    if (!result) {
+        set_client_error(stream->error);
+    }
+    return result;
+}
+
+bool client_result_ids(const ::RecognitionResult* result,
+                       int* tokens,
+                       int tokens_capacity,
+                       int* unstable_tokens,
+                       int unstable_capacity,
+                       ::TokenResult* token_result) {
+    if (!result || !token_result || (tokens_capacity > 0 && !tokens) ||
+        (unstable_capacity > 0 && !unstable_tokens)) {
+        set_client_error("Invalid arguments to client_result_ids");
+        return false;
+    }
+
+    // Copy as many IDs as fit; false if some did not
+    auto copy_ids = [](const int* ids, int length, int* buffer, int capacity) {
+        const int count = std::min(length, std::max(capacity, 0));
+        if (count > 0) {
+            std::memcpy(buffer, ids, static_cast<size_t>(count) * sizeof(int));
+        }
+        return count == length;
+    };
+
+    const auto owner = reinterpret_cast<const ClientResult*>(result);
+    const bool tokens_fit = copy_ids(owner->phoneme_ids, owner->phoneme_ids_length, tokens, tokens_capacity);
+    const bool unstable_fit = copy_ids(owner->unstable_phoneme_ids, owner->unstable_phoneme_ids_length,
+                                       unstable_tokens, unstable_capacity);
+
+    token_result->frame_number = result->frame_number;
+    token_result->confidence = result->confidence;
+    token_result->provisional = result->provisional;
+    token_result->tokens_length = owner->phoneme_ids_length;
+    token_result->unstable_tokens_length = owner->unstable_phoneme_ids_length;
+    token_result->truncated = !tokens_fit || !unstable_fit;
+    token_result->endpoint = result->endpoint;
+    return true;
+}
+
+void client_free_result(::RecognitionResult* result) {
+    if (!result) {
+        return;
+    }
+
+    if (result->phonemes) {
+        for (int i = 0; i < result->phonemes_length; ++i) {
+            delete[] result->phonemes[i];
+        }
+        delete[] result->phonemes;
+    }
+
+    if (result->french_sentence) {
+        delete[] result->french_sentence;
+    }
+
+    if (result->unstable_phonemes) {
+        for (int i = 0; i < result->unstable_phonemes_length; ++i) {
+            delete[] result->unstable_phonemes[i];
+        }
+        delete[] result->unstable_phonemes;
+    }
+
+    if (result->word_timings) {
+        for (int i = 0; i < result->word_timings_length; ++i) {
+            delete[] result->word_timings[i].word;
+        }
+        delete[] result->word_timings;
+    }
+
+    auto owner = reinterpret_cast<ClientResult*>(result);
+    delete[] owner->phoneme_ids;
+    delete[] owner->unstable_phoneme_ids;
+    delete owner;
+}
+
+const char* client_get_last_error() {
+    return g_client_error.c_str();
+}
@@ -0,0 +1,150 @@
+/**
+ * Client library for cued_speech_daemon
+ *
+ * Mirrors the stream_* functions of decoder_c_api.h against a daemon that
+ * hosts the decoder, language model and sequence model, so local processes
+ * share one warm instance instead of loading their own. The library only
+ * needs a Unix domain socket; it does not link the decoder.
+ *
+ * Streams of one connection are multiplexed over its socket. Results are
+ * pushed by the daemon as windows are decoded: set a callback to receive
+ * them on the connection's reader thread, or fetch them with
+ * client_stream_poll_result.
+ */
+
+#ifndef CUED_SPEECH_DECODER_CLIENT_H
+#define CUED_SPEECH_DECODER_CLIENT_H
+
+#include "decoder_c_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opaque handle types
+typedef void* ClientHandle;
+typedef void* ClientStreamHandle;
+
+//=============================================================================
+// Connection
+//=============================================================================
+
+/**
+ * Connect to a daemon listening on socket_path
+ *
+ * @return Connection handle or NULL on failure
+ */
+ClientHandle client_connect(const char* socket_path);
+
+/**
+ * Close the connection and free it
+ *
+ * Streams of the connection must be destroyed first.
+ */
+void client_disconnect(ClientHandle handle);
+
+//=============================================================================
+// Streaming (see the stream_* functions of decoder_c_api.h)
+//=============================================================================
+
+/**
+ * Open a stream on the daemon (stream_create + stream_load_tflite_model)
+ *
+ * Blocks until the daemon has created the stream.
+ *
+ * @return Stream handle or NULL on failure
+ */
+ClientStreamHandle client_stream_create(ClientHandle client);
+
+/**
+ * Close the stream on the daemon and free the handle
+ *
+ * No callback runs for the stream once this returns.
+ */
+void client_stream_destroy(ClientStreamHandle handle);
+
+/**
+ * Replace the stream's windowing configuration and reset it
+ */
+bool client_stream_set_windowing(ClientStreamHandle handle, const WindowingConfig* config);
+
+/**
+ * Reset the stream for a new utterance; queued results are discarded
+ */
+void client_stream_reset(ClientStreamHandle handle);
+
+/**
+ * Receive results as they are pushed
+ *
+ * The callback runs on the connection's reader thread and must not block;
+ * the result is only valid during the call. Pass NULL to go back to
+ * client_stream_poll_result. The final result of client_stream_finalize is
+ * never passed to the callback.
+ */
+void client_stream_set_callback(ClientStreamHandle handle, ResultCallback callback, void* user_data);
+
+/**
+ * Send one frame of kFrameFeatureSize (33) features
+ *
+ * Unlike stream_push_frame, windows are decoded by the daemon as soon as
+ * they are ready; their results arrive asynchronously.
+ *
+ * @return true if the frame was sent
+ */
+bool client_stream_push_frame(ClientStreamHandle handle, const float* features);
+
+/**
+ * Send count frames in one message (see stream_push_frames)
+ *
+ * @return count, or -1 on error
+ */
+int client_stream_push_frames(ClientStreamHandle handle, const float* frames, int count, const uint8_t* valid_mask);
+
+/**
+ * Take the oldest pushed result
+ *
+ * @param timeout_ms Milliseconds to wait for one (0 = don't wait, -1 = forever)
+ * @return Result (free with client_free_result), or NULL if none arrived
+ */
+RecognitionResult* client_stream_poll_result(ClientStreamHandle handle, int timeout_ms);
+
+/**
+ * Decode the remaining frames and wait for the final result
+ *
+ * Results pushed before it are still delivered (callback or poll) first.
+ *
+ * @return Final result (free with client_free_result), or NULL on error
+ */
+RecognitionResult* client_stream_finalize(ClientStreamHandle handle);
+
+/**
+ * Token IDs of a result from the client library (see TokenResult)
+ *
+ * Works on results from client_stream_poll_result, client_stream_finalize
+ * and the callback. IDs index the daemon's token table; buffers are filled
+ * as by stream_process_window_ids.
+ *
+ * @return true on success
+ */
+bool client_result_ids(const RecognitionResult* result,
+                       int* tokens,
+                       int tokens_capacity,
+                       int* unstable_tokens,
+                       int unstable_capacity,
+                       TokenResult* token_result);
+
+/**
+ * Free a result returned by the client library
+ */
+void client_free_result(RecognitionResult* result);
+
+/**
+ * Last error of the calling thread
+ */
+const char* client_get_last_error();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CUED_SPEECH_DECODER_CLIENT_H
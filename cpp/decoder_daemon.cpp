@@ -0,0 +1,787 @@
+/**
+ * Multi-stream decoding daemon
+ *
+ * Usage:
+ *   cued_speech_daemon --socket PATH --tokens FILE --lexicon FILE --lm FILE --model FILE
+ *                      [--homophones FILE --french-lm FILE] [--workers N]
+ *                      [--max-sessions N]
+ *
+ * Loads the CTC decoder (lexicon trie and KenLM), the sequence model and the
+ * sentence corrector once and serves streams from any number of local
+ * processes over a Unix domain socket (protocol in daemon_protocol.h; clients
+ * use decoder_client.h). Each stream gets a WindowProcessor on its own clone
+ * of the sequence model, which shares the loaded flatbuffer.
+ *
+ * One epoll thread accepts connections, reads and parses messages and
+ * writes queued replies. Requests are queued per session and run by
+ * --workers threads (default: hardware concurrency), one request batch per
+ * session at a time so every stream sees its messages in order. Results are
+ * pushed to the client as soon as a window is decoded; final results are
+ * corrected to French when a corrector is loaded.
+ *
+ * SIGINT or SIGTERM stops the daemon and removes the socket file.
+ */
+
+#include "daemon_protocol.h"
+#include "decoder.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::DecoderConfig;
+using cued_speech::RecognitionResult;
+using cued_speech::SentenceCorrector;
+using cued_speech::TFLiteSequenceModel;
+using cued_speech::WindowProcessor;
+using cued_speech::WindowingMode;
+using cued_speech::LogLevel;
+using cued_speech::log_enabled;
+using cued_speech::log_message;
+
+namespace protocol = cued_speech::protocol;
+using protocol::MessageType;
+
+static_assert(protocol::kFeatureSize == cued_speech::kFrameFeatureSize,
+              "Protocol frame size must match the decoder");
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " --socket PATH --tokens FILE --lexicon FILE --lm FILE --model FILE\n"
+              << "       [--homophones FILE --french-lm FILE] [--workers N] [--max-sessions N]"
+              << std::endl;
+}
+
+struct Connection;
+
+/**
+ * One client stream
+ *
+ * pending and scheduled are guarded by Daemon::work_mutex_; the decoding
+ * state is only touched by the worker that has the session scheduled.
+ */
+struct Session {
+    uint32_t id = 0;
+    std::shared_ptr<Connection> connection;
+
+    struct Request {
+        MessageType type;
+        std::string payload;
+    };
+    std::deque<Request> pending;
+    bool scheduled = false;
+
+    std::unique_ptr<TFLiteSequenceModel> model;
+    std::unique_ptr<WindowProcessor> processor;
+};
+
+/**
+ * One client socket
+ *
+ * Only the event loop reads, writes and closes fd. Workers append replies to
+ * outgoing under out_mutex and ask the loop to flush.
+ */
+struct Connection {
+    int fd = -1;
+    std::string incoming;
+    std::unordered_map<uint32_t, std::shared_ptr<Session>> sessions;  // Event loop only
+
+    std::mutex out_mutex;
+    std::string outgoing;
+    bool closed = false;                                              // Guarded by out_mutex
+    bool want_write = false;                                          // EPOLLOUT registered
+};
+
+class Daemon {
+public:
+    Daemon(CTCDecoder& decoder, TFLiteSequenceModel& model, SentenceCorrector* corrector, size_t max_sessions)
+        : decoder_(decoder), model_(model), corrector_(corrector), max_sessions_(max_sessions) {}
+
+    ~Daemon() {
+        for (int fd : {listen_fd_, epoll_fd_, wake_fd_, signal_fd_}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        if (!socket_path_.empty()) {
+            ::unlink(socket_path_.c_str());
+        }
+    }
+
+    bool listen(const std::string& path);
+    void run(int num_workers);
+
+private:
+    CTCDecoder& decoder_;
+    TFLiteSequenceModel& model_;
+    SentenceCorrector* corrector_;
+    size_t max_sessions_;
+
+    std::string socket_path_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;       // eventfd: workers have output to flush
+    int signal_fd_ = -1;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+    size_t session_count_ = 0;
+
+    // Session work queue
+    std::mutex work_mutex_;
+    std::condition_variable work_ready_;
+    std::deque<std::shared_ptr<Session>> ready_sessions_;
+    bool stopping_ = false;
+
+    // Connections with output queued by workers
+    std::mutex flush_mutex_;
+    std::vector<std::shared_ptr<Connection>> flush_queue_;
+
+    void accept_connections();
+    bool read_connection(const std::shared_ptr<Connection>& connection);
+    bool handle_message(const std::shared_ptr<Connection>& connection,
+                        const protocol::MessageHeader& header,
+                        const char* payload);
+    void close_connection(const std::shared_ptr<Connection>& connection);
+    void flush(const std::shared_ptr<Connection>& connection);
+    void flush_queued();
+
+    void enqueue(const std::shared_ptr<Session>& session, MessageType type, std::string payload);
+    void worker_loop();
+    void run_request(Session& session, Session::Request& request, std::string& out);
+    void send(const std::shared_ptr<Connection>& connection, std::string&& bytes);
+};
+
+void encode_result(protocol::MessageWriter& writer, uint32_t session, const RecognitionResult& result, bool final) {
+    uint16_t flags = final ? protocol::kResultFinal : 0;
+    if (result.provisional) {
+        flags |= protocol::kResultProvisional;
+    }
+    if (result.endpoint) {
+        flags |= protocol::kResultEndpoint;
+    }
+    writer.begin(MessageType::Result, session, flags);
+    writer.put(static_cast<int32_t>(result.frame_number));
+    writer.put(result.confidence);
+    writer.put(static_cast<uint32_t>(result.phonemes.size()));
+    for (const auto& phoneme : result.phonemes) {
+        writer.put_string(phoneme);
+    }
+    writer.put(static_cast<uint32_t>(result.unstable_phonemes.size()));
+    for (const auto& phoneme : result.unstable_phonemes) {
+        writer.put_string(phoneme);
+    }
+    writer.put_string(result.french_sentence);
+    writer.put(static_cast<uint32_t>(result.word_timings.size()));
+    for (const auto& timing : result.word_timings) {
+        writer.put_string(timing.word);
+        writer.put(static_cast<int32_t>(timing.start_frame));
+        writer.put(static_cast<int32_t>(timing.end_frame));
+    }
+    for (const auto* ids : {&result.phoneme_ids, &result.unstable_phoneme_ids}) {
+        writer.put(static_cast<uint32_t>(ids->size()));
+        for (const int id : *ids) {
+            writer.put(static_cast<int32_t>(id));
+        }
+    }
+    writer.end();
+}
+
+void encode_error(protocol::MessageWriter& writer, uint32_t session, const std::string& message) {
+    writer.begin(MessageType::Error, session);
+    writer.put_string(message);
+    writer.end();
+}
+
+//=============================================================================
+// Event Loop
+//=============================================================================
+
+bool Daemon::listen(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return false;
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A stale socket file from a previous run would make bind() fail
+    ::unlink(path.c_str());
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd_, SOMAXCONN) != 0) {
+        std::cerr << "Failed to listen on " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    socket_path_ = path;
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    ::pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    signal_fd_ = ::signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0 || signal_fd_ < 0) {
+        std::cerr << "Failed to create event loop: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    for (int fd : {listen_fd_, wake_fd_, signal_fd_}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+    return true;
+}
+
+void Daemon::run(int num_workers) {
+    // Workers inherit the blocked signal mask from listen()
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&Daemon::worker_loop, this);
+    }
+
+    std::vector<epoll_event> events(64);
+    bool running = true;
+    while (running) {
+        const int count = ::epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "epoll_wait() failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                accept_connections();
+            } else if (fd == wake_fd_) {
+                uint64_t value = 0;
+                while (::read(wake_fd_, &value, sizeof(value)) > 0) {
+                }
+                flush_queued();
+            } else if (fd == signal_fd_) {
+                running = false;
+            } else {
+                auto it = connections_.find(fd);
+                if (it == connections_.end()) {
+                    continue;
+                }
+                auto connection = it->second;
+                bool open = true;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    open = read_connection(connection);
+                }
+                if (open && (events[i].events & EPOLLOUT)) {
+                    flush(connection);
+                }
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(work_mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    auto remaining = connections_;
+    for (auto& entry : remaining) {
+        close_connection(entry.second);
+    }
+}
+
+void Daemon::accept_connections() {
+    while (true) {
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                CUED_SPEECH_LOG(LogLevel::Warn, "daemon", "accept() failed: " << std::strerror(errno));
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        connections_[fd] = std::move(connection);
+        CUED_SPEECH_LOG(LogLevel::Debug, "daemon", "Client connected (fd " << fd << ")");
+    }
+}
+
+bool Daemon::read_connection(const std::shared_ptr<Connection>& connection) {
+    char buffer[64 * 1024];
+    while (true) {
+        const ssize_t received = ::recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection->incoming.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        // Orderly shutdown or error
+        close_connection(connection);
+        return false;
+    }
+
+    size_t offset = 0;
+    while (true) {
+        protocol::MessageHeader header;
+        const long long size = protocol::complete_message_size(
+            connection->incoming.data() + offset, connection->incoming.size() - offset, header);
+        if (size == 0) {
+            break;
+        }
+        if (size < 0 || !handle_message(connection, header,
+                                         connection->incoming.data() + offset + sizeof(header))) {
+            CUED_SPEECH_LOG(LogLevel::Warn, "daemon", "Protocol error, closing client (fd " << connection->fd << ")");
+            close_connection(connection);
+            return false;
+        }
+        offset += static_cast<size_t>(size);
+    }
+    connection->incoming.erase(0, offset);
+    return true;
+}
+
+bool Daemon::handle_message(const std::shared_ptr<Connection>& connection,
+                            const protocol::MessageHeader& header,
+                            const char* payload) {
+    const auto type = static_cast<MessageType>(header.type);
+    auto it = connection->sessions.find(header.session);
+
+    if (type == MessageType::Open) {
+        std::string reply;
+        protocol::MessageWriter writer(reply);
+        if (it != connection->sessions.end()) {
+            encode_error(writer, header.session, "Session already open");
+        } else if (session_count_ >= max_sessions_) {
+            encode_error(writer, header.session, "Too many sessions");
+        } else {
+            auto session = std::make_shared<Session>();
+            session->id = header.session;
+            session->connection = connection;
+            connection->sessions.emplace(header.session, session);
+            ++session_count_;
+            enqueue(session, type, std::string());
+            return true;
+        }
+        send(connection, std::move(reply));
+        flush(connection);
+        return true;
+    }
+
+    if (it == connection->sessions.end()) {
+        std::string reply;
+        protocol::MessageWriter writer(reply);
+        encode_error(writer, header.session, "Unknown session");
+        send(connection, std::move(reply));
+        flush(connection);
+        return true;
+    }
+
+    switch (type) {
+        case MessageType::Close:
+            enqueue(it->second, type, std::string());
+            connection->sessions.erase(it);
+            --session_count_;
+            return true;
+        case MessageType::Reset:
+        case MessageType::SetWindowing:
+        case MessageType::PushFrames:
+        case MessageType::Finalize:
+            enqueue(it->second, type, std::string(payload, header.length));
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Daemon::close_connection(const std::shared_ptr<Connection>& connection) {
+    {
+        std::lock_guard<std::mutex> lock(connection->out_mutex);
+        if (connection->closed) {
+            return;
+        }
+        connection->closed = true;
+        connection->outgoing.clear();
+    }
+
+    // Sessions still queued finish their current batch and are dropped
+    for (auto& entry : connection->sessions) {
+        enqueue(entry.second, MessageType::Close, std::string());
+    }
+    session_count_ -= connection->sessions.size();
+    connection->sessions.clear();
+
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    connections_.erase(connection->fd);
+    CUED_SPEECH_LOG(LogLevel::Debug, "daemon", "Client disconnected (fd " << connection->fd << ")");
+}
+
+void Daemon::flush(const std::shared_ptr<Connection>& connection) {
+    std::unique_lock<std::mutex> lock(connection->out_mutex);
+    if (connection->closed) {
+        return;
+    }
+
+    size_t sent_total = 0;
+    bool failed = false;
+    while (sent_total < connection->outgoing.size()) {
+        const ssize_t sent = ::send(connection->fd, connection->outgoing.data() + sent_total,
+                                    connection->outgoing.size() - sent_total, MSG_NOSIGNAL);
+        if (sent > 0) {
+            sent_total += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            failed = sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK;
+            break;
+        }
+    }
+    connection->outgoing.erase(0, sent_total);
+    const bool want_write = !connection->outgoing.empty();
+    lock.unlock();
+
+    if (failed) {
+        close_connection(connection);
+        return;
+    }
+
+    // Wait for EPOLLOUT only while a reply is partly sent
+    if (want_write != connection->want_write) {
+        connection->want_write = want_write;
+        epoll_event event{};
+        event.events = want_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.fd = connection->fd;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection->fd, &event);
+    }
+}
+
+void Daemon::flush_queued() {
+    std::vector<std::shared_ptr<Connection>> queued;
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        queued.swap(flush_queue_);
+    }
+    for (auto& connection : queued) {
+        flush(connection);
+    }
+}
+
+void Daemon::send(const std::shared_ptr<Connection>& connection, std::string&& bytes) {
+    std::lock_guard<std::mutex> lock(connection->out_mutex);
+    if (!connection->closed) {
+        connection->outgoing += bytes;
+    }
+}
+
+//=============================================================================
+// Workers
+//=============================================================================
+
+void Daemon::enqueue(const std::shared_ptr<Session>& session, MessageType type, std::string payload) {
+    {
+        std::lock_guard<std::mutex> lock(work_mutex_);
+        session->pending.push_back({type, std::move(payload)});
+        if (session->scheduled) {
+            return;
+        }
+        session->scheduled = true;
+        ready_sessions_.push_back(session);
+    }
+    work_ready_.notify_one();
+}
+
+void Daemon::worker_loop() {
+    std::deque<Session::Request> batch;
+    std::string out;
+
+    while (true) {
+        std::shared_ptr<Session> session;
+        {
+            std::unique_lock<std::mutex> lock(work_mutex_);
+            work_ready_.wait(lock, [this] { return stopping_ || !ready_sessions_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            session = std::move(ready_sessions_.front());
+            ready_sessions_.pop_front();
+            batch.swap(session->pending);
+        }
+
+        out.clear();
+        for (auto& request : batch) {
+            try {
+                run_request(*session, request, out);
+            } catch (const std::exception& e) {
+                protocol::MessageWriter writer(out);
+                encode_error(writer, session->id, std::string("Exception in daemon: ") + e.what());
+            }
+        }
+        batch.clear();
+
+        if (!out.empty()) {
+            send(session->connection, std::move(out));
+            {
+                std::lock_guard<std::mutex> lock(flush_mutex_);
+                flush_queue_.push_back(session->connection);
+            }
+            const uint64_t one = 1;
+            ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+            (void)written;
+        }
+
+        std::lock_guard<std::mutex> lock(work_mutex_);
+        if (session->pending.empty()) {
+            session->scheduled = false;
+        } else {
+            ready_sessions_.push_back(std::move(session));
+            work_ready_.notify_one();
+        }
+    }
+}
+
+void Daemon::run_request(Session& session, Session::Request& request, std::string& out) {
+    protocol::MessageWriter writer(out);
+
+    if (request.type == MessageType::Open) {
+        session.model = model_.clone();
+        if (!session.model || !session.model->is_loaded()) {
+            encode_error(writer, session.id, "Failed to create sequence model");
+            return;
+        }
+        session.processor = std::make_unique<WindowProcessor>(&decoder_, session.model.get());
+        writer.begin(MessageType::Opened, session.id);
+        writer.end();
+        return;
+    }
+    if (request.type == MessageType::Close) {
+        session.processor.reset();
+        session.model.reset();
+        return;
+    }
+    if (!session.processor) {
+        // Open failed; its error was already sent
+        return;
+    }
+
+    WindowProcessor& processor = *session.processor;
+    protocol::PayloadReader reader(request.payload.data(), request.payload.size());
+    switch (request.type) {
+        case MessageType::Reset:
+            processor.reset();
+            break;
+
+        case MessageType::SetWindowing: {
+            protocol::WindowingParams params{};
+            if (!reader.get_windowing(params)) {
+                encode_error(writer, session.id, "Malformed SetWindowing");
+                break;
+            }
+            cued_speech::WindowingConfig config;
+            config.window_size = params.window_size;
+            config.commit_size = params.commit_size;
+            config.left_context = params.left_context;
+            config.mode = params.adaptive ? WindowingMode::Adaptive : WindowingMode::Fixed;
+            config.min_commit_size = params.min_commit_size;
+            config.max_commit_size = params.max_commit_size;
+            config.frame_rate = params.frame_rate;
+            config.low_load = params.low_load;
+            config.high_load = params.high_load;
+            config.provisional_interval = params.provisional_interval;
+            config.endpoint_silence_frames = params.endpoint_silence_frames;
+            config.endpoint_log_prob = params.endpoint_log_prob;
+            config.endpoint_dropped_frames = params.endpoint_dropped_frames;
+            config.two_pass_margin = params.two_pass_margin;
+            processor.set_windowing(config);
+            break;
+        }
+
+        case MessageType::PushFrames: {
+            uint32_t count = 0;
+            uint8_t has_mask = 0;
+            const char* frames = nullptr;
+            const char* mask = nullptr;
+            const size_t frame_bytes = sizeof(float) * protocol::kFeatureSize;
+            if (reader.get(count) && reader.get(has_mask) && count <= protocol::kMaxPayload / frame_bytes) {
+                frames = reader.get_bytes(count * frame_bytes);
+                mask = has_mask ? reader.get_bytes(count) : nullptr;
+            }
+            if (!frames || (has_mask && !mask)) {
+                encode_error(writer, session.id, "Malformed PushFrames");
+                break;
+            }
+
+            // Same loop as stream_push_frames_process: decode each window as
+            // soon as it is ready and push its result
+            float row[protocol::kFeatureSize];
+            for (uint32_t i = 0; i < count; ++i) {
+                std::memcpy(row, frames + i * frame_bytes, frame_bytes);
+                const uint8_t invalid = 0;
+                const bool ready = mask && !mask[i]
+                    ? processor.push_frames(row, 1, &invalid) > 0
+                    : processor.push_frame(row);
+                if (ready) {
+                    encode_result(writer, session.id, processor.process_window(), false);
+                }
+            }
+            break;
+        }
+
+        case MessageType::Finalize: {
+            RecognitionResult result = processor.finalize();
+            if (corrector_ && !result.phonemes.empty()) {
+                result.french_sentence = corrector_->correct(result.phonemes);
+            }
+            encode_result(writer, session.id, result, true);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    DecoderConfig config;
+    config.nbest = 1;
+    config.beam_size = 40;
+    config.beam_threshold = 50.0f;
+    config.lm_weight = 3.23f;
+    config.word_score = 0.0f;
+    config.sil_score = 0.0f;
+
+    std::string socket_path;
+    std::string model_path;
+    std::string homophones_path;
+    std::string french_lm_path;
+    int num_workers = 0;
+    int max_sessions = 1024;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (arg == "--socket" && has_value) {
+            socket_path = argv[++i];
+        } else if (arg == "--tokens" && has_value) {
+            config.tokens_path = argv[++i];
+        } else if (arg == "--lexicon" && has_value) {
+            config.lexicon_path = argv[++i];
+        } else if (arg == "--lm" && has_value) {
+            config.lm_path = argv[++i];
+        } else if (arg == "--model" && has_value) {
+            model_path = argv[++i];
+        } else if (arg == "--homophones" && has_value) {
+            homophones_path = argv[++i];
+        } else if (arg == "--french-lm" && has_value) {
+            french_lm_path = argv[++i];
+        } else if (arg == "--workers" && has_value) {
+            num_workers = std::atoi(argv[++i]);
+        } else if (arg == "--max-sessions" && has_value) {
+            max_sessions = std::atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (socket_path.empty() || config.tokens_path.empty() || config.lexicon_path.empty() ||
+        config.lm_path.empty() || model_path.empty() || max_sessions <= 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        CTCDecoder decoder(config);
+        if (!decoder.initialize()) {
+            std::cerr << "Failed to initialize CTC decoder." << std::endl;
+            return 1;
+        }
+
+        TFLiteSequenceModel model;
+        if (!model.load(model_path)) {
+            std::cerr << "Failed to load sequence model: " << model_path << std::endl;
+            return 1;
+        }
+
+        std::unique_ptr<SentenceCorrector> corrector;
+        if (!homophones_path.empty() && !french_lm_path.empty()) {
+            corrector = std::make_unique<SentenceCorrector>(homophones_path, french_lm_path);
+            if (!corrector->initialize()) {
+                std::cerr << "Warning: failed to initialize sentence corrector. Results will have phonemes only."
+                          << std::endl;
+                corrector.reset();
+            }
+        }
+
+        if (num_workers <= 0) {
+            num_workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+
+        Daemon daemon(decoder, model, corrector.get(), static_cast<size_t>(max_sessions));
+        if (!daemon.listen(socket_path)) {
+            return 1;
+        }
+        if (log_enabled(LogLevel::Info)) {
+            log_message(LogLevel::Info, "daemon", "Listening",
+                        {{"socket", socket_path}, {"workers", num_workers}});
+        }
+        daemon.run(num_workers);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -163,6 +163,11 @@ int main(int argc, char** argv) {
             return 1;
         }
 
+        // The demo mirrors the Python script's per-chunk trace on stderr
+        cued_speech::set_log_level(cued_speech::LogLevel::Trace);
+        cued_speech::set_log_sink(std::make_shared<cued_speech::AsyncLogSink>(
+            std::make_shared<cued_speech::ConsoleLogSink>()));
+
         DecoderConfig config;
         config.lexicon_path = lexicon_path.string();
         config.tokens_path = tokens_path.string();
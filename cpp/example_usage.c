@@ -14,6 +14,17 @@
 #include <string.h>
 #include <math.h>
 
+static void print_log(LogLevel level, const char* component, const char* message,
+                      const char* const* field_keys, const char* const* field_values,
+                      int num_fields, void* user_data) {
+    (void)user_data;
+    fprintf(stderr, "[%d] %s: %s", (int)level, component, message);
+    for (int i = 0; i < num_fields; i++) {
+        fprintf(stderr, " %s=%s", field_keys[i], field_values[i]);
+    }
+    fprintf(stderr, "\n");
+}
+
 int main(int argc, char** argv) {
     if (argc < 4) {
         fprintf(stderr, "Usage: %s <lexicon> <tokens> <lm> [model.tflite]\n", argv[0]);
@@ -27,6 +38,9 @@ int main(int argc, char** argv) {
     
     printf("=== Cued Speech Decoder Example ===\n\n");
     
+    // Library diagnostics are silent unless a log callback is installed
+    decoder_set_log_callback(print_log, NULL, LOG_LEVEL_INFO, false);
+    
     // =====================================================================
     // 1. Create and Initialize Decoder
     // =====================================================================
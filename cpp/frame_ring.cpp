@@ -0,0 +1,374 @@
+/**
+ * Cued Speech Decoder - Shared-memory frame ring
+ */
+
+#include "frame_ring.h"
+#include "decoder.h"
+#include "logging.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if !defined(_WIN32) && !defined(__ANDROID__)
+#define CUED_SPEECH_HAS_SHM 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define CUED_SPEECH_HAS_SHM 0
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+static_assert(cued_speech::kFrameRecordFeatures == cued_speech::kFrameFeatureSize,
+              "Frame records must hold one decoder frame");
+
+namespace cued_speech {
+
+namespace {
+
+constexpr uint32_t kRingMagic = 0x474E5246;   // "FRNG"
+constexpr uint32_t kRingVersion = 1;
+constexpr int kSpinIterations = 4000;         // A few microseconds before sleeping
+
+using Word = std::atomic<uint32_t>;
+using Counter = std::atomic<uint64_t>;
+static_assert(Word::is_always_lock_free && Counter::is_always_lock_free,
+              "Shared-memory atomics must be lock-free");
+
+} // namespace
+
+/**
+ * Header at the start of the mapping; records follow at records_offset
+ *
+ * head and tail count records written and released. head_word and tail_word
+ * mirror their low 32 bits as futex words.
+ */
+struct FrameRingShared {
+    Word magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t record_size;
+    uint64_t records_offset;
+
+    alignas(64) Counter head;
+    Word head_word;
+    Word consumer_waiting;
+
+    alignas(64) Counter tail;
+    Word tail_word;
+    Word producer_waiting;
+
+    alignas(64) Word closed;
+};
+
+namespace {
+
+void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Sleep while word == expected (or until woken / the deadline)
+void wait_on(Word& word, uint32_t expected, std::chrono::steady_clock::time_point deadline, bool forever) {
+#if defined(__linux__)
+    timespec timeout{};
+    timespec* timeout_ptr = nullptr;
+    if (!forever) {
+        const auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            return;
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+        timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+        timeout_ptr = &timeout;
+    }
+    // Not FUTEX_PRIVATE_FLAG: the word is shared between processes
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeout_ptr, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    (void)forever;
+    if (std::chrono::steady_clock::now() < deadline || forever) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+#endif
+}
+
+void wake(Word& word) {
+#if defined(__linux__)
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+/**
+ * Wait until ready() holds, spinning first and then sleeping on word
+ *
+ * current() gives the futex value that means "nothing changed yet"; waiting
+ * is announced through the waiting flag so the other side only issues a
+ * wake-up syscall when someone sleeps.
+ */
+template <typename Ready, typename Current>
+bool wait_until(Ready ready, Current current, Word& word, Word& waiting, Word& closed, int timeout_ms) {
+    if (ready()) {
+        return true;
+    }
+    if (timeout_ms == 0) {
+        return false;
+    }
+
+    for (int i = 0; i < kSpinIterations; ++i) {
+        cpu_relax();
+        if (ready()) {
+            return true;
+        }
+    }
+
+    const bool forever = timeout_ms < 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(forever ? 0 : timeout_ms);
+    while (true) {
+        const uint32_t expected = current();
+        waiting.store(1, std::memory_order_seq_cst);
+        if (ready() || closed.load(std::memory_order_acquire)) {
+            waiting.store(0, std::memory_order_relaxed);
+            return ready();
+        }
+        wait_on(word, expected, deadline, forever);
+        waiting.store(0, std::memory_order_relaxed);
+        if (ready()) {
+            return true;
+        }
+        if (!forever && std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+    }
+}
+
+uint32_t round_up_pow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value && result < (1u << 30)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+std::string shm_name(const std::string& name) {
+    return !name.empty() && name[0] == '/' ? name : "/" + name;
+}
+
+} // namespace
+
+std::unique_ptr<FrameRing> FrameRing::create(const std::string& name, uint32_t capacity) {
+#if CUED_SPEECH_HAS_SHM
+    if (name.empty() || capacity == 0) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "Invalid frame ring name or capacity");
+        return nullptr;
+    }
+
+    capacity = round_up_pow2(capacity);
+    const uint64_t records_offset = (sizeof(FrameRingShared) + 63) & ~uint64_t(63);
+    const size_t size = static_cast<size_t>(records_offset + uint64_t(capacity) * sizeof(FrameRecord));
+    const std::string path = shm_name(name);
+
+    // A ring left behind by a crashed producer is replaced
+    ::shm_unlink(path.c_str());
+    const int fd = ::shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "shm_open(" << path << ") failed: " << std::strerror(errno));
+        return nullptr;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "ftruncate failed: " << std::strerror(errno));
+        ::close(fd);
+        ::shm_unlink(path.c_str());
+        return nullptr;
+    }
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "mmap failed: " << std::strerror(errno));
+        ::shm_unlink(path.c_str());
+        return nullptr;
+    }
+
+    // The mapping is zero-filled; construct the header and publish the magic last
+    auto shared = new (memory) FrameRingShared();
+    shared->version = kRingVersion;
+    shared->capacity = capacity;
+    shared->record_size = sizeof(FrameRecord);
+    shared->records_offset = records_offset;
+    shared->magic.store(kRingMagic, std::memory_order_release);
+
+    std::unique_ptr<FrameRing> ring(new FrameRing());
+    ring->shared_ = shared;
+    ring->records_ = reinterpret_cast<FrameRecord*>(static_cast<char*>(memory) + records_offset);
+    ring->mapped_size_ = size;
+    ring->name_ = path;
+    ring->owner_ = true;
+    return ring;
+#else
+    (void)name;
+    (void)capacity;
+    CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "Shared-memory frame rings are not supported on this platform");
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<FrameRing> FrameRing::open(const std::string& name) {
+#if CUED_SPEECH_HAS_SHM
+    const std::string path = shm_name(name);
+    const int fd = ::shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "shm_open(" << path << ") failed: " << std::strerror(errno));
+        return nullptr;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FrameRingShared)) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "Frame ring " << path << " is not initialized");
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "mmap failed: " << std::strerror(errno));
+        return nullptr;
+    }
+
+    auto shared = static_cast<FrameRingShared*>(memory);
+    const bool valid = shared->magic.load(std::memory_order_acquire) == kRingMagic &&
+                       shared->version == kRingVersion &&
+                       shared->record_size == sizeof(FrameRecord) &&
+                       shared->capacity > 0 &&
+                       shared->records_offset + uint64_t(shared->capacity) * sizeof(FrameRecord) <= size;
+    if (!valid) {
+        CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "Frame ring " << path << " has an incompatible layout");
+        ::munmap(memory, size);
+        return nullptr;
+    }
+
+    std::unique_ptr<FrameRing> ring(new FrameRing());
+    ring->shared_ = shared;
+    ring->records_ = reinterpret_cast<FrameRecord*>(static_cast<char*>(memory) + shared->records_offset);
+    ring->mapped_size_ = size;
+    ring->name_ = path;
+    return ring;
+#else
+    (void)name;
+    CUED_SPEECH_LOG(LogLevel::Error, "frame_ring", "Shared-memory frame rings are not supported on this platform");
+    return nullptr;
+#endif
+}
+
+FrameRing::~FrameRing() {
+#if CUED_SPEECH_HAS_SHM
+    if (shared_) {
+        if (owner_) {
+            close();
+            ::shm_unlink(name_.c_str());
+        }
+        ::munmap(shared_, mapped_size_);
+    }
+#endif
+}
+
+FrameRecord* FrameRing::reserve(int timeout_ms) {
+    FrameRingShared& s = *shared_;
+    const uint64_t head = s.head.load(std::memory_order_relaxed);
+    auto has_space = [&] { return head - s.tail.load(std::memory_order_acquire) < s.capacity; };
+    auto tail_word = [&] { return s.tail_word.load(std::memory_order_acquire); };
+    if (!wait_until(has_space, tail_word, s.tail_word, s.producer_waiting, s.closed, timeout_ms)) {
+        return nullptr;
+    }
+
+    reserved_ = head;
+    FrameRecord* record = &records_[head & (s.capacity - 1)];
+    record->sequence = head;
+    return record;
+}
+
+void FrameRing::commit(int32_t frame_number, bool valid) {
+    FrameRingShared& s = *shared_;
+    FrameRecord& record = records_[reserved_ & (s.capacity - 1)];
+    record.frame_number = frame_number;
+    record.valid = valid ? 1 : 0;
+
+    const uint64_t head = reserved_ + 1;
+    s.head.store(head, std::memory_order_seq_cst);
+    s.head_word.store(static_cast<uint32_t>(head), std::memory_order_seq_cst);
+    if (s.consumer_waiting.load(std::memory_order_seq_cst)) {
+        wake(s.head_word);
+    }
+}
+
+bool FrameRing::push(const float* features, int32_t frame_number, bool valid, int timeout_ms) {
+    FrameRecord* record = reserve(timeout_ms);
+    if (!record) {
+        return false;
+    }
+    if (valid && features) {
+        std::memcpy(record->features, features, sizeof(record->features));
+    }
+    commit(frame_number, valid && features);
+    return true;
+}
+
+void FrameRing::close() {
+    FrameRingShared& s = *shared_;
+    s.closed.store(1, std::memory_order_seq_cst);
+    // Bump the futex word so a sleeping consumer sees a change
+    s.head_word.fetch_add(0x80000000u, std::memory_order_seq_cst);
+    wake(s.head_word);
+}
+
+const FrameRecord* FrameRing::peek(int timeout_ms) {
+    FrameRingShared& s = *shared_;
+    const uint64_t tail = s.tail.load(std::memory_order_relaxed);
+    auto has_data = [&] { return s.head.load(std::memory_order_acquire) != tail; };
+    auto head_word = [&] { return s.head_word.load(std::memory_order_acquire); };
+    if (!wait_until(has_data, head_word, s.head_word, s.consumer_waiting, s.closed, timeout_ms)) {
+        return nullptr;
+    }
+    return &records_[tail & (s.capacity - 1)];
+}
+
+void FrameRing::release() {
+    FrameRingShared& s = *shared_;
+    const uint64_t tail = s.tail.load(std::memory_order_relaxed) + 1;
+    s.tail.store(tail, std::memory_order_seq_cst);
+    s.tail_word.store(static_cast<uint32_t>(tail), std::memory_order_seq_cst);
+    if (s.producer_waiting.load(std::memory_order_seq_cst)) {
+        wake(s.tail_word);
+    }
+}
+
+size_t FrameRing::available() const {
+    return static_cast<size_t>(shared_->head.load(std::memory_order_acquire) -
+                               shared_->tail.load(std::memory_order_acquire));
+}
+
+bool FrameRing::finished() const {
+    return shared_->closed.load(std::memory_order_acquire) && available() == 0;
+}
+
+uint32_t FrameRing::capacity() const {
+    return shared_->capacity;
+}
+
+} // namespace cued_speech
@@ -0,0 +1,131 @@
+/**
+ * Cued Speech Decoder - Shared-memory frame ring
+ *
+ * Single-producer/single-consumer ring of fixed-size frame records in POSIX
+ * shared memory, for handing landmark features from a capture process to a
+ * decoder process without a pipe. The producer writes records in place and
+ * publishes them with one release store; the consumer reads them where they
+ * are. A waiting side spins briefly and then sleeps on a futex in the shared
+ * header (polling where futexes are unavailable), so a hot consumer picks a
+ * frame up within the spin and an idle one costs no CPU.
+ */
+
+#ifndef CUED_SPEECH_FRAME_RING_H
+#define CUED_SPEECH_FRAME_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace cued_speech {
+
+constexpr int kFrameRecordFeatures = 33;  // kFrameFeatureSize
+
+/**
+ * One frame in the ring
+ */
+struct FrameRecord {
+    uint64_t sequence;                        // Position in the stream (0, 1, 2, ...)
+    int32_t frame_number;                     // Producer's frame number
+    uint32_t valid;                           // 0 = dropped frame, features unused
+    float features[kFrameRecordFeatures];     // hand_shape, hand_position, lips
+};
+
+struct FrameRingShared;
+
+/**
+ * Mapping of a shared-memory frame ring
+ *
+ * The creator is the producer and the opener the consumer; each side must
+ * be used by one thread at a time. Waits take a timeout in milliseconds
+ * (0 = don't wait, negative = forever).
+ */
+class FrameRing {
+public:
+    /**
+     * Create the ring name (replacing a stale one) for the producer
+     *
+     * @param capacity Records, rounded up to a power of two
+     * @return Ring, or nullptr on failure (logged)
+     */
+    static std::unique_ptr<FrameRing> create(const std::string& name, uint32_t capacity);
+
+    /**
+     * Map an existing ring for the consumer
+     */
+    static std::unique_ptr<FrameRing> open(const std::string& name);
+
+    ~FrameRing();
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    //=========================================================================
+    // Producer
+    //=========================================================================
+
+    /**
+     * Next free record, to be filled and then published with commit()
+     *
+     * @return Record, or nullptr if the ring stayed full until the timeout
+     */
+    FrameRecord* reserve(int timeout_ms);
+
+    /**
+     * Publish the reserved record
+     */
+    void commit(int32_t frame_number, bool valid);
+
+    /**
+     * reserve(), copy features (unless invalid) and commit()
+     */
+    bool push(const float* features, int32_t frame_number, bool valid, int timeout_ms);
+
+    /**
+     * Mark the end of the stream; the consumer drains what is left
+     */
+    void close();
+
+    //=========================================================================
+    // Consumer
+    //=========================================================================
+
+    /**
+     * Oldest unread record, valid until release()
+     *
+     * @return Record, or nullptr on timeout or once the ring is finished
+     */
+    const FrameRecord* peek(int timeout_ms);
+
+    /**
+     * Hand the oldest record back to the producer
+     */
+    void release();
+
+    /**
+     * Records published and not yet released
+     */
+    size_t available() const;
+
+    /**
+     * true once the producer closed the ring and every record was released
+     */
+    bool finished() const;
+
+    uint32_t capacity() const;
+
+private:
+    FrameRing() = default;
+
+    FrameRingShared* shared_ = nullptr;
+    FrameRecord* records_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::string name_;
+    bool owner_ = false;
+    uint64_t reserved_ = 0;                   // Producer: sequence of the reserved record
+};
+
+} // namespace cued_speech
+
+#endif // CUED_SPEECH_FRAME_RING_H
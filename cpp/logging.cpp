@@ -0,0 +1,199 @@
+/**
+ * Cued Speech Decoder - Structured logging
+ */
+
+#include "logging.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace cued_speech {
+
+namespace {
+
+std::shared_ptr<LogSink> g_sink;
+std::atomic<bool> g_has_sink{false};
+std::atomic<int> g_level{static_cast<int>(LogLevel::Info)};
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+const char* log_level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+        case LogLevel::Off: break;
+    }
+    return "OFF";
+}
+
+std::string format_log_record(const LogRecord& record) {
+    std::string line;
+    line.reserve(32 + record.component.size() + record.message.size());
+    line += '[';
+    line += log_level_name(record.level);
+    line += "] ";
+    if (!record.component.empty()) {
+        line += record.component;
+        line += ": ";
+    }
+    line += record.message;
+    for (const auto& field : record.fields) {
+        line += ' ';
+        line += field.key;
+        line += '=';
+        line += field.value;
+    }
+    return line;
+}
+
+//=============================================================================
+// Sinks
+//=============================================================================
+
+void ConsoleLogSink::write(const LogRecord& record) {
+    const std::string line = format_log_record(record);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cerr << line << '\n';
+}
+
+void ConsoleLogSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cerr.flush();
+}
+
+AsyncLogSink::AsyncLogSink(std::shared_ptr<LogSink> target, size_t capacity)
+    : target_(std::move(target)), ring_(capacity > 0 ? capacity : 1) {
+    worker_ = std::thread(&AsyncLogSink::run, this);
+}
+
+AsyncLogSink::~AsyncLogSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    not_empty_.notify_one();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    if (target_) {
+        target_->flush();
+    }
+}
+
+void AsyncLogSink::write(const LogRecord& record) {
+    // Allocate outside the lock; the slot only takes over the buffers
+    LogRecord copy = record;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size_ == ring_.size()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring_[(head_ + size_) % ring_.size()] = std::move(copy);
+        ++size_;
+    }
+    not_empty_.notify_one();
+}
+
+void AsyncLogSink::flush() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        drained_.wait(lock, [this] { return size_ == 0 && !busy_; });
+    }
+    if (target_) {
+        target_->flush();
+    }
+}
+
+uint64_t AsyncLogSink::dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void AsyncLogSink::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        not_empty_.wait(lock, [this] { return size_ > 0 || stopping_; });
+        if (size_ == 0) {
+            break;  // stopping and drained
+        }
+
+        LogRecord record = std::move(ring_[head_]);
+        head_ = (head_ + 1) % ring_.size();
+        --size_;
+        busy_ = true;
+        lock.unlock();
+
+        if (target_) {
+            target_->write(record);
+        }
+
+        lock.lock();
+        busy_ = false;
+        if (size_ == 0) {
+            drained_.notify_all();
+        }
+    }
+}
+
+//=============================================================================
+// Global Sink
+//=============================================================================
+
+void set_log_sink(std::shared_ptr<LogSink> sink) {
+    const bool has_sink = static_cast<bool>(sink);
+    auto previous = std::atomic_exchange(&g_sink, std::move(sink));
+    g_has_sink.store(has_sink, std::memory_order_release);
+    if (previous) {
+        previous->flush();
+    }
+}
+
+std::shared_ptr<LogSink> log_sink() {
+    return std::atomic_load(&g_sink);
+}
+
+void set_log_level(LogLevel level) {
+    g_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel log_level() {
+    return static_cast<LogLevel>(g_level.load(std::memory_order_relaxed));
+}
+
+bool log_enabled(LogLevel level) {
+    return level != LogLevel::Off &&
+           static_cast<int>(level) >= g_level.load(std::memory_order_relaxed) &&
+           g_has_sink.load(std::memory_order_acquire);
+}
+
+void log_message(LogLevel level,
+                 const char* component,
+                 std::string message,
+                 std::vector<LogField> fields) {
+    if (!log_enabled(level)) {
+        return;
+    }
+
+    auto sink = std::atomic_load(&g_sink);
+    if (!sink) {
+        return;
+    }
+
+    LogRecord record;
+    record.level = level;
+    record.component = component ? component : "";
+    record.message = std::move(message);
+    record.fields = std::move(fields);
+    record.timestamp_us = now_us();
+    sink->write(record);
+}
+
+} // namespace cued_speech
@@ -0,0 +1,186 @@
+/**
+ * Cued Speech Decoder - Structured logging
+ *
+ * Library diagnostics go through a process-wide LogSink. The default sink
+ * discards everything, so a decoder that nobody listens to does no console
+ * I/O and does not even format its messages.
+ */
+
+#ifndef CUED_SPEECH_LOGGING_H
+#define CUED_SPEECH_LOGGING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cued_speech {
+
+/**
+ * Log severity, in increasing order
+ */
+enum class LogLevel : int {
+    Trace = 0,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+const char* log_level_name(LogLevel level);
+
+/**
+ * Key/value pair attached to a log record
+ */
+struct LogField {
+    std::string key;
+    std::string value;
+
+    LogField(std::string k, std::string v) : key(std::move(k)), value(std::move(v)) {}
+    LogField(std::string k, const char* v) : key(std::move(k)), value(v ? v : "") {}
+
+    template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    LogField(std::string k, T v) : key(std::move(k)) {
+        std::ostringstream oss;
+        oss << v;
+        value = oss.str();
+    }
+};
+
+/**
+ * One log event
+ */
+struct LogRecord {
+    LogLevel level = LogLevel::Info;
+    std::string component;          // "decoder", "stream", "model", ...
+    std::string message;
+    std::vector<LogField> fields;
+    int64_t timestamp_us = 0;       // system clock, microseconds since epoch
+};
+
+/**
+ * "[WARN] decoder: message key=value ..." (no trailing newline)
+ */
+std::string format_log_record(const LogRecord& record);
+
+/**
+ * Destination for log records
+ *
+ * write() may be called concurrently from every thread that drives a
+ * decoder or stream.
+ */
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void write(const LogRecord& record) = 0;
+    virtual void flush() {}
+};
+
+/**
+ * Discards everything (the default)
+ */
+class NullLogSink : public LogSink {
+public:
+    void write(const LogRecord&) override {}
+};
+
+/**
+ * Writes formatted records to stderr, synchronously
+ *
+ * Meant for tools and debugging; wrap it in an AsyncLogSink to keep the
+ * console off the decoding threads.
+ */
+class ConsoleLogSink : public LogSink {
+public:
+    void write(const LogRecord& record) override;
+    void flush() override;
+
+private:
+    std::mutex mutex_;
+};
+
+/**
+ * Hands records to a background thread through a bounded ring buffer
+ *
+ * write() copies the record before taking the lock and only moves it into
+ * the ring under it; the wrapped sink runs on the worker thread. When the ring is full new records are dropped and
+ * counted instead of blocking the caller. Destruction drains the ring.
+ */
+class AsyncLogSink : public LogSink {
+public:
+    explicit AsyncLogSink(std::shared_ptr<LogSink> target, size_t capacity = 1024);
+    ~AsyncLogSink() override;
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    void write(const LogRecord& record) override;
+
+    /**
+     * Block until every queued record has been written
+     */
+    void flush() override;
+
+    uint64_t dropped() const;
+
+private:
+    void run();
+
+    std::shared_ptr<LogSink> target_;
+    std::vector<LogRecord> ring_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    bool busy_ = false;
+    bool stopping_ = false;
+    std::atomic<uint64_t> dropped_{0};
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable drained_;
+    std::thread worker_;
+};
+
+/**
+ * Install the process-wide sink (nullptr restores the no-op sink)
+ */
+void set_log_sink(std::shared_ptr<LogSink> sink);
+std::shared_ptr<LogSink> log_sink();
+
+/**
+ * Records below this level are discarded before formatting (default: Info)
+ */
+void set_log_level(LogLevel level);
+LogLevel log_level();
+
+/**
+ * True if a record at this level would reach a sink
+ */
+bool log_enabled(LogLevel level);
+
+void log_message(LogLevel level,
+                 const char* component,
+                 std::string message,
+                 std::vector<LogField> fields = {});
+
+} // namespace cued_speech
+
+/**
+ * Stream-style logging that skips formatting when the level is disabled:
+ *   CUED_SPEECH_LOG(LogLevel::Warn, "decoder", "missing token " << token);
+ */
+#define CUED_SPEECH_LOG(level, component, expr)                                  \
+    do {                                                                         \
+        if (::cued_speech::log_enabled(level)) {                                 \
+            std::ostringstream cued_speech_log_stream_;                          \
+            cued_speech_log_stream_ << expr;                                     \
+            ::cued_speech::log_message(level, component, cued_speech_log_stream_.str()); \
+        }                                                                        \
+    } while (0)
+
+#endif // CUED_SPEECH_LOGGING_H
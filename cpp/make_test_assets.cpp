@@ -0,0 +1,94 @@
+/**
+ * Generate synthetic decoder assets
+ *
+ * Usage:
+ *   make_test_assets --out DIR [--phones N] [--words N] [--min-length N]
+ *                    [--max-length N] [--homophones N] [--lm-order 1|2]
+ *                    [--arpa] [--seed N]
+ *
+ * Writes phonelist.csv, lexicon.txt, kenlm_ipa.binary, homophones_dico.jsonl,
+ * kenlm_fr.binary and cuedspeech_model.tflite (same roles as the downloaded
+ * assets). --arpa keeps the language models in ARPA format.
+ */
+
+#include "test_assets.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " --out DIR [--phones N] [--words N] [--min-length N]\n"
+              << "       [--max-length N] [--homophones N] [--lm-order 1|2] [--arpa] [--seed N]"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    cued_speech::TestAssetConfig config;
+    std::string out_dir;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next_int = [&](int& value) {
+            if (i + 1 >= argc) {
+                return false;
+            }
+            value = std::atoi(argv[++i]);
+            return true;
+        };
+
+        bool ok = true;
+        if (arg == "--out" && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else if (arg == "--phones") {
+            ok = next_int(config.num_phones);
+        } else if (arg == "--words") {
+            ok = next_int(config.num_words);
+        } else if (arg == "--min-length") {
+            ok = next_int(config.min_word_length);
+        } else if (arg == "--max-length") {
+            ok = next_int(config.max_word_length);
+        } else if (arg == "--homophones") {
+            ok = next_int(config.homophone_group_size);
+        } else if (arg == "--lm-order") {
+            ok = next_int(config.lm_order);
+        } else if (arg == "--arpa") {
+            config.binary_lm = false;
+        } else if (arg == "--seed") {
+            int seed = 0;
+            ok = next_int(seed);
+            config.seed = static_cast<uint32_t>(seed);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (out_dir.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        const auto assets = cued_speech::generate_test_assets(out_dir, config);
+        std::cout << "tokens:     " << assets.tokens_path << " (" << assets.vocab_size << " entries)\n"
+                  << "lexicon:    " << assets.lexicon_path << " (" << assets.words.size() << " words)\n"
+                  << "lm:         " << assets.lm_path << '\n'
+                  << "homophones: " << assets.homophones_path << '\n'
+                  << "french lm:  " << assets.french_lm_path << '\n'
+                  << "model:      " << assets.model_path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to generate assets: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * Cued Speech Decoder - Latency instrumentation
+ */
+
+#include "profiling.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cued_speech {
+
+const char* profile_stage_name(ProfileStage stage) {
+    switch (stage) {
+        case ProfileStage::FeatureExtraction: return "feature_extraction";
+        case ProfileStage::WindowAssembly: return "window_assembly";
+        case ProfileStage::ModelInvoke: return "model_invoke";
+        case ProfileStage::LogSoftmax: return "log_softmax";
+        case ProfileStage::BeamSearch: return "beam_search";
+        case ProfileStage::Correction: return "correction";
+        case ProfileStage::Count: break;
+    }
+    return "unknown";
+}
+
+//=============================================================================
+// LatencyHistogram Implementation
+//=============================================================================
+
+void LatencyHistogram::record(double us) {
+    int bucket = 0;
+    if (us > 1.0) {
+        bucket = static_cast<int>(std::ceil(4.0 * std::log2(us)));
+        bucket = std::min(bucket, kBuckets - 1);
+    }
+    ++buckets_[bucket];
+    ++count_;
+    total_us_ += us;
+    max_us_ = std::max(max_us_, us);
+}
+
+double LatencyHistogram::percentile(double q) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+
+    const uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_)));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank && buckets_[i] > 0) {
+            return std::min(std::exp2(i / 4.0), max_us_);
+        }
+    }
+    return max_us_;
+}
+
+StageLatency LatencyHistogram::summary() const {
+    StageLatency latency;
+    latency.count = count_;
+    latency.total_us = total_us_;
+    latency.p50_us = percentile(0.50);
+    latency.p95_us = percentile(0.95);
+    latency.p99_us = percentile(0.99);
+    latency.max_us = max_us_;
+    return latency;
+}
+
+void LatencyHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    total_us_ = 0.0;
+    max_us_ = 0.0;
+}
+
+//=============================================================================
+// Profiler Implementation
+//=============================================================================
+
+#if CUED_SPEECH_PROFILING
+
+void Profiler::record(ProfileStage stage, double us) {
+    histograms_[static_cast<int>(stage)].record(us);
+}
+
+StageLatency Profiler::latency(ProfileStage stage) const {
+    return histograms_[static_cast<int>(stage)].summary();
+}
+
+void Profiler::reset() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+#endif
+
+} // namespace cued_speech
@@ -0,0 +1,154 @@
+/**
+ * Cued Speech Decoder - Latency instrumentation
+ *
+ * Per-stage monotonic-clock timers feeding fixed-size latency histograms.
+ * Timers only exist when built with CUED_SPEECH_PROFILING=1 (CMake option
+ * ENABLE_PROFILING); otherwise CUED_SPEECH_PROFILE_SCOPE expands to nothing
+ * and Profiler has no state.
+ */
+
+#ifndef CUED_SPEECH_PROFILING_H
+#define CUED_SPEECH_PROFILING_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#ifndef CUED_SPEECH_PROFILING
+#define CUED_SPEECH_PROFILING 0
+#endif
+
+namespace cued_speech {
+
+/**
+ * Instrumented pipeline stages
+ */
+enum class ProfileStage : int {
+    FeatureExtraction = 0,
+    WindowAssembly,
+    ModelInvoke,
+    LogSoftmax,
+    BeamSearch,
+    Correction,
+    Count
+};
+
+constexpr int kProfileStageCount = static_cast<int>(ProfileStage::Count);
+
+const char* profile_stage_name(ProfileStage stage);
+
+/**
+ * Latency summary of one stage, in microseconds
+ */
+struct StageLatency {
+    uint64_t count = 0;
+    double total_us = 0.0;
+    double p50_us = 0.0;
+    double p95_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+};
+
+/**
+ * Per-stream latency and counter snapshot
+ */
+struct StreamStats {
+    std::array<StageLatency, kProfileStageCount> stages{};
+    uint64_t frames_pushed = 0;
+    uint64_t frames_dropped = 0;
+    uint64_t windows_processed = 0;
+    uint64_t decodes = 0;
+    uint64_t provisional_results = 0;
+    uint64_t searched_frames = 0;       // Log-prob rows run through the beam search
+    bool profiling_enabled = CUED_SPEECH_PROFILING != 0;
+};
+
+/**
+ * Log-scale latency histogram (quarter-octave buckets from 1 us to ~14 s,
+ * the last bucket being open-ended)
+ *
+ * Percentiles are resolved to the upper edge of their bucket, i.e. within
+ * about 19% of the true value. Recording never allocates.
+ */
+class LatencyHistogram {
+public:
+    void record(double us);
+    double percentile(double q) const;
+    StageLatency summary() const;
+    void reset();
+
+private:
+    static constexpr int kBuckets = 96;
+
+    std::array<uint64_t, kBuckets> buckets_{};
+    uint64_t count_ = 0;
+    double total_us_ = 0.0;
+    double max_us_ = 0.0;
+};
+
+/**
+ * Collects stage latencies for one stream
+ *
+ * Not thread-safe: a profiler belongs to the thread driving its stream.
+ */
+class Profiler {
+public:
+#if CUED_SPEECH_PROFILING
+    void record(ProfileStage stage, double us);
+    StageLatency latency(ProfileStage stage) const;
+    void reset();
+#else
+    void record(ProfileStage, double) {}
+    StageLatency latency(ProfileStage) const { return {}; }
+    void reset() {}
+#endif
+
+    static constexpr bool enabled() { return CUED_SPEECH_PROFILING != 0; }
+
+private:
+#if CUED_SPEECH_PROFILING
+    std::array<LatencyHistogram, kProfileStageCount> histograms_;
+#endif
+};
+
+#if CUED_SPEECH_PROFILING
+
+/**
+ * Records the lifetime of the enclosing scope into a profiler (may be null)
+ */
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(Profiler* profiler, ProfileStage stage)
+        : profiler_(profiler), stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedStageTimer() {
+        if (profiler_) {
+            const std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start_;
+            profiler_->record(stage_, elapsed.count());
+        }
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    Profiler* profiler_;
+    ProfileStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#define CUED_SPEECH_PROFILE_CONCAT_(a, b) a##b
+#define CUED_SPEECH_PROFILE_CONCAT(a, b) CUED_SPEECH_PROFILE_CONCAT_(a, b)
+#define CUED_SPEECH_PROFILE_SCOPE(profiler, stage) \
+    ::cued_speech::ScopedStageTimer CUED_SPEECH_PROFILE_CONCAT(profile_scope_, __LINE__)((profiler), (stage))
+
+#else
+
+#define CUED_SPEECH_PROFILE_SCOPE(profiler, stage) ((void)0)
+
+#endif
+
+} // namespace cued_speech
+
+#endif // CUED_SPEECH_PROFILING_H
@@ -0,0 +1,396 @@
+/**
+ * Cued Speech Decoder - Synthetic test assets
+ */
+
+#include "test_assets.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <kenlm/lm/model.hh>
+
+#include "flatbuffers/flatbuffers.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace cued_speech {
+
+namespace {
+
+constexpr int kLipsDim = 8;
+constexpr int kHandShapeDim = 7;
+constexpr int kHandPosDim = 18;
+
+const char* const kSpecialTokens[] = {"<BLANK>", "<UNK>", "<SOS>", "<EOS>", "<PAD>", "_"};
+
+std::ofstream open_output(const std::string& path, std::ios::openmode mode = std::ios::out) {
+    std::ofstream out(path, mode);
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to write " + path);
+    }
+    return out;
+}
+
+} // namespace
+
+//=============================================================================
+// Language Models
+//=============================================================================
+
+void write_test_arpa(const std::string& path, const std::vector<std::string>& words, int order) {
+    if (order < 1 || order > 2) {
+        throw std::invalid_argument("Test ARPA order must be 1 or 2");
+    }
+
+    auto out = open_output(path);
+    const double unigram = -std::log10(static_cast<double>(words.size() + 2));
+    const double bigram = std::log10(0.5);
+    const double backoff = std::log10(0.5);
+    const bool bigrams = order == 2 && !words.empty();
+
+    auto unigram_line = [&](double logprob, const std::string& word) {
+        out << logprob << '\t' << word;
+        if (bigrams) {
+            out << '\t' << backoff;
+        }
+        out << '\n';
+    };
+
+    out << "\\data\\\n";
+    out << "ngram 1=" << words.size() + 3 << '\n';
+    if (bigrams) {
+        out << "ngram 2=" << words.size() + 1 << '\n';
+    }
+    out << "\n\\1-grams:\n";
+    unigram_line(-99.0, "<s>");
+    out << unigram << "\t</s>\n";
+    out << unigram << "\t<unk>\n";
+    for (const auto& word : words) {
+        unigram_line(unigram, word);
+    }
+
+    if (bigrams) {
+        // A chain <s> w0 w1 ... wN </s> gives the search something to prefer
+        out << "\n\\2-grams:\n";
+        out << bigram << "\t<s> " << words.front() << '\n';
+        for (size_t i = 0; i + 1 < words.size(); ++i) {
+            out << bigram << '\t' << words[i] << ' ' << words[i + 1] << '\n';
+        }
+        out << bigram << '\t' << words.back() << " </s>\n";
+    }
+
+    out << "\n\\end\\\n";
+}
+
+void convert_arpa_to_binary(const std::string& arpa_path, const std::string& binary_path) {
+    lm::ngram::Config config;
+    config.write_mmap = binary_path.c_str();
+    config.write_method = lm::ngram::Config::WRITE_AFTER;
+    config.messages = nullptr;
+
+    // Loading an ARPA file with write_mmap set writes the probing binary
+    lm::ngram::Model model(arpa_path.c_str(), config);
+}
+
+//=============================================================================
+// Acoustic Model
+//=============================================================================
+
+void write_test_tflite_model(const std::string& path, int vocab_size, uint32_t seed) {
+    if (vocab_size <= 0) {
+        throw std::invalid_argument("Test model vocabulary must not be empty");
+    }
+
+    flatbuffers::FlatBufferBuilder fbb;
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<float> weights(static_cast<size_t>(vocab_size) * kLipsDim);
+    for (auto& w : weights) {
+        w = normal(rng);
+    }
+    std::vector<float> bias(vocab_size, 0.0f);
+    bias[0] = 2.0f;  // <BLANK>
+
+    auto float_buffer = [&](const std::vector<float>& values) {
+        return tflite::CreateBuffer(fbb, fbb.CreateVector(
+            reinterpret_cast<const uint8_t*>(values.data()), values.size() * sizeof(float)));
+    };
+    std::vector<flatbuffers::Offset<tflite::Buffer>> buffers = {
+        tflite::CreateBuffer(fbb),  // Buffer 0 is the empty sentinel
+        float_buffer(weights),
+        float_buffer(bias),
+    };
+
+    auto tensor = [&](const char* name, std::vector<int32_t> shape, std::vector<int32_t> signature,
+                      uint32_t buffer) {
+        return tflite::CreateTensor(fbb, fbb.CreateVector(shape), tflite::TensorType_FLOAT32, buffer,
+                                    fbb.CreateString(name), 0, false, 0, fbb.CreateVector(signature));
+    };
+    std::vector<flatbuffers::Offset<tflite::Tensor>> tensors = {
+        tensor("lips", {1, 1, kLipsDim}, {1, -1, kLipsDim}, 0),
+        tensor("hand_shape", {1, 1, kHandShapeDim}, {1, -1, kHandShapeDim}, 0),
+        tensor("hand_pos", {1, 1, kHandPosDim}, {1, -1, kHandPosDim}, 0),
+        tensor("weights", {vocab_size, kLipsDim}, {vocab_size, kLipsDim}, 1),
+        tensor("bias", {vocab_size}, {vocab_size}, 2),
+        tensor("logits", {1, 1, vocab_size}, {1, -1, vocab_size}, 0),
+    };
+
+    const std::vector<int32_t> op_inputs = {0, 3, 4};
+    const std::vector<int32_t> op_outputs = {5};
+    auto options = tflite::CreateFullyConnectedOptions(
+        fbb, tflite::ActivationFunctionType_NONE,
+        tflite::FullyConnectedOptionsWeightsFormat_DEFAULT, true /* keep_num_dims */);
+    std::vector<flatbuffers::Offset<tflite::Operator>> operators = {
+        tflite::CreateOperator(fbb, 0, fbb.CreateVector(op_inputs), fbb.CreateVector(op_outputs),
+                               tflite::BuiltinOptions_FullyConnectedOptions, options.Union()),
+    };
+
+    const std::vector<int32_t> graph_inputs = {0, 1, 2};
+    const std::vector<int32_t> graph_outputs = {5};
+    std::vector<flatbuffers::Offset<tflite::SubGraph>> subgraphs = {
+        tflite::CreateSubGraph(fbb, fbb.CreateVector(tensors), fbb.CreateVector(graph_inputs),
+                               fbb.CreateVector(graph_outputs), fbb.CreateVector(operators),
+                               fbb.CreateString("main")),
+    };
+
+    std::vector<flatbuffers::Offset<tflite::OperatorCode>> opcodes = {
+        tflite::CreateOperatorCode(fbb, tflite::BuiltinOperator_FULLY_CONNECTED, 0, 1,
+                                   tflite::BuiltinOperator_FULLY_CONNECTED),
+    };
+
+    auto model = tflite::CreateModel(fbb, TFLITE_SCHEMA_VERSION, fbb.CreateVector(opcodes),
+                                     fbb.CreateVector(subgraphs), fbb.CreateString("cued_speech_test_model"),
+                                     fbb.CreateVector(buffers));
+    fbb.Finish(model, tflite::ModelIdentifier());
+
+    auto out = open_output(path, std::ios::out | std::ios::binary);
+    out.write(reinterpret_cast<const char*>(fbb.GetBufferPointer()), fbb.GetSize());
+}
+
+void write_test_stateful_tflite_model(const std::string& path, int vocab_size, uint32_t seed,
+                                      bool with_state) {
+    if (vocab_size <= 0) {
+        throw std::invalid_argument("Test model vocabulary must not be empty");
+    }
+
+    flatbuffers::FlatBufferBuilder fbb;
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 0.5f);
+    std::vector<float> weights(static_cast<size_t>(vocab_size) * kLipsDim);
+    for (auto& w : weights) {
+        w = normal(rng);
+    }
+    std::vector<float> bias(vocab_size, 0.0f);
+    bias[0] = 2.0f;  // <BLANK>
+    const std::vector<int32_t> time_axis = {1};
+
+    auto raw_buffer = [&](const void* data, size_t bytes) {
+        return tflite::CreateBuffer(fbb, fbb.CreateVector(static_cast<const uint8_t*>(data), bytes));
+    };
+    std::vector<flatbuffers::Offset<tflite::Buffer>> buffers = {
+        tflite::CreateBuffer(fbb),  // Buffer 0 is the empty sentinel
+        raw_buffer(weights.data(), weights.size() * sizeof(float)),
+        raw_buffer(bias.data(), bias.size() * sizeof(float)),
+        raw_buffer(time_axis.data(), time_axis.size() * sizeof(int32_t)),
+    };
+
+    std::vector<flatbuffers::Offset<tflite::Tensor>> tensors;
+    auto tensor = [&](const char* name, std::vector<int32_t> shape, std::vector<int32_t> signature,
+                      uint32_t buffer, tflite::TensorType type = tflite::TensorType_FLOAT32) {
+        tensors.push_back(tflite::CreateTensor(fbb, fbb.CreateVector(shape), type, buffer,
+                                               fbb.CreateString(name), 0, false, 0,
+                                               fbb.CreateVector(signature)));
+        return static_cast<int32_t>(tensors.size() - 1);
+    };
+    const int32_t lips = tensor("lips", {1, 1, kLipsDim}, {1, -1, kLipsDim}, 0);
+    const int32_t hand_shape = tensor("hand_shape", {1, 1, kHandShapeDim}, {1, -1, kHandShapeDim}, 0);
+    const int32_t hand_pos = tensor("hand_pos", {1, 1, kHandPosDim}, {1, -1, kHandPosDim}, 0);
+    const int32_t weights_tensor = tensor("weights", {vocab_size, kLipsDim}, {vocab_size, kLipsDim}, 1);
+    const int32_t bias_tensor = tensor("bias", {vocab_size}, {vocab_size}, 2);
+    const int32_t axis = tensor("time_axis", {}, {}, 3, tflite::TensorType_INT32);  // Scalar
+    const int32_t running_sum = tensor("running_sum", {1, 1, kLipsDim}, {1, -1, kLipsDim}, 0);
+    const int32_t logits = tensor("logits", {1, 1, vocab_size}, {1, -1, vocab_size}, 0);
+
+    enum Opcode : uint32_t { kCumsum, kAdd, kSum, kFullyConnected };
+    std::vector<flatbuffers::Offset<tflite::Operator>> operators;
+    auto op = [&](Opcode opcode, std::vector<int32_t> inputs, std::vector<int32_t> outputs,
+                  tflite::BuiltinOptions type, flatbuffers::Offset<void> options) {
+        operators.push_back(tflite::CreateOperator(fbb, opcode, fbb.CreateVector(inputs),
+                                                   fbb.CreateVector(outputs), type, options));
+    };
+    op(kCumsum, {lips, axis}, {running_sum}, tflite::BuiltinOptions_CumsumOptions,
+       tflite::CreateCumsumOptions(fbb).Union());
+
+    std::vector<int32_t> graph_inputs = {lips, hand_shape, hand_pos};
+    std::vector<int32_t> graph_outputs = {running_sum, logits};
+    int32_t hidden = running_sum;
+    if (with_state) {
+        const int32_t state = tensor("state", {1, 1, kLipsDim}, {1, 1, kLipsDim}, 0);
+        hidden = tensor("hidden", {1, 1, kLipsDim}, {1, -1, kLipsDim}, 0);
+        const int32_t chunk_sum = tensor("chunk_sum", {1, 1, kLipsDim}, {1, 1, kLipsDim}, 0);
+        const int32_t state_out = tensor("state_out", {1, 1, kLipsDim}, {1, 1, kLipsDim}, 0);
+
+        op(kAdd, {running_sum, state}, {hidden}, tflite::BuiltinOptions_AddOptions,
+           tflite::CreateAddOptions(fbb).Union());
+        op(kSum, {lips, axis}, {chunk_sum}, tflite::BuiltinOptions_ReducerOptions,
+           tflite::CreateReducerOptions(fbb, true /* keep_dims */).Union());
+        op(kAdd, {state, chunk_sum}, {state_out}, tflite::BuiltinOptions_AddOptions,
+           tflite::CreateAddOptions(fbb).Union());
+
+        graph_inputs.push_back(state);
+        graph_outputs = {state_out, logits};
+    }
+    op(kFullyConnected, {hidden, weights_tensor, bias_tensor}, {logits},
+       tflite::BuiltinOptions_FullyConnectedOptions,
+       tflite::CreateFullyConnectedOptions(
+           fbb, tflite::ActivationFunctionType_NONE,
+           tflite::FullyConnectedOptionsWeightsFormat_DEFAULT, true /* keep_num_dims */).Union());
+
+    std::vector<flatbuffers::Offset<tflite::SubGraph>> subgraphs = {
+        tflite::CreateSubGraph(fbb, fbb.CreateVector(tensors), fbb.CreateVector(graph_inputs),
+                               fbb.CreateVector(graph_outputs), fbb.CreateVector(operators),
+                               fbb.CreateString("main")),
+    };
+
+    // Same order as Opcode. Codes above 127 only fit the wide builtin_code.
+    std::vector<flatbuffers::Offset<tflite::OperatorCode>> opcodes = {
+        tflite::CreateOperatorCode(fbb, tflite::BuiltinOperator_PLACEHOLDER_FOR_GREATER_OP_CODES, 0, 1,
+                                   tflite::BuiltinOperator_CUMSUM),
+        tflite::CreateOperatorCode(fbb, tflite::BuiltinOperator_ADD, 0, 1, tflite::BuiltinOperator_ADD),
+        tflite::CreateOperatorCode(fbb, tflite::BuiltinOperator_SUM, 0, 1, tflite::BuiltinOperator_SUM),
+        tflite::CreateOperatorCode(fbb, tflite::BuiltinOperator_FULLY_CONNECTED, 0, 1,
+                                   tflite::BuiltinOperator_FULLY_CONNECTED),
+    };
+
+    auto model = tflite::CreateModel(fbb, TFLITE_SCHEMA_VERSION, fbb.CreateVector(opcodes),
+                                     fbb.CreateVector(subgraphs),
+                                     fbb.CreateString("cued_speech_test_stateful_model"),
+                                     fbb.CreateVector(buffers));
+    fbb.Finish(model, tflite::ModelIdentifier());
+
+    auto out = open_output(path, std::ios::out | std::ios::binary);
+    out.write(reinterpret_cast<const char*>(fbb.GetBufferPointer()), fbb.GetSize());
+}
+
+//=============================================================================
+// Asset Set
+//=============================================================================
+
+TestAssets generate_test_assets(const std::string& dir, const TestAssetConfig& config) {
+    if (config.num_phones <= 0 || config.num_words <= 0) {
+        throw std::invalid_argument("Test assets need at least one phone and one word");
+    }
+    if (config.min_word_length <= 0 || config.max_word_length < config.min_word_length) {
+        throw std::invalid_argument("Invalid test word length range");
+    }
+    if (config.homophone_group_size <= 0) {
+        throw std::invalid_argument("Homophone groups must not be empty");
+    }
+    if (config.unique_spellings) {
+        double spellings = 0.0;
+        for (int length = config.min_word_length; length <= config.max_word_length; ++length) {
+            spellings += std::pow(static_cast<double>(config.num_phones), length);
+        }
+        if (spellings < 2.0 * config.num_words) {
+            throw std::invalid_argument("Too few phones and lengths for unique test spellings");
+        }
+    }
+
+    namespace fs = std::filesystem;
+    fs::create_directories(dir);
+
+    const fs::path root(dir);
+    const char* lm_ext = config.binary_lm ? ".binary" : ".arpa";
+    TestAssets assets;
+    assets.dir = dir;
+    assets.tokens_path = (root / "phonelist.csv").string();
+    assets.lexicon_path = (root / "lexicon.txt").string();
+    assets.lm_path = (root / (std::string("kenlm_ipa") + lm_ext)).string();
+    assets.homophones_path = (root / "homophones_dico.jsonl").string();
+    assets.french_lm_path = (root / (std::string("kenlm_fr") + lm_ext)).string();
+    assets.model_path = (root / "cuedspeech_model.tflite").string();
+
+    // Tokens: specials, silence, then phones
+    auto tokens = open_output(assets.tokens_path);
+    for (const char* token : kSpecialTokens) {
+        tokens << token << '\n';
+    }
+    for (int i = 0; i < config.num_phones; ++i) {
+        assets.phones.push_back("p" + std::to_string(i));
+        tokens << assets.phones.back() << '\n';
+    }
+    tokens.close();
+    assets.vocab_size = static_cast<int>(std::size(kSpecialTokens)) + config.num_phones;
+
+    // Lexicon: word<TAB>phone phone ...
+    std::mt19937 rng(config.seed);
+    std::uniform_int_distribution<int> phone_dist(0, config.num_phones - 1);
+    std::uniform_int_distribution<int> length_dist(config.min_word_length, config.max_word_length);
+    std::uniform_int_distribution<int> percent_dist(0, 99);
+    std::set<std::vector<int>> spellings;
+    auto lexicon = open_output(assets.lexicon_path);
+    for (int i = 0; i < config.num_words; ++i) {
+        assets.words.push_back("w" + std::to_string(i));
+        lexicon << assets.words.back() << '\t';
+        std::vector<int> spelling;
+        do {
+            spelling.resize(length_dist(rng));
+            for (int& phone : spelling) {
+                phone = phone_dist(rng);
+            }
+            // Only draw when asked for, so other configs keep their files
+            if (config.doubled_phone_percent > 0 && spelling.size() > 1 &&
+                percent_dist(rng) < config.doubled_phone_percent) {
+                const size_t j = 1 + static_cast<size_t>(rng() % (spelling.size() - 1));
+                spelling[j] = spelling[j - 1];
+            }
+        } while (config.unique_spellings && !spellings.insert(spelling).second);
+        assets.spellings.emplace_back();
+        for (size_t j = 0; j < spelling.size(); ++j) {
+            lexicon << (j > 0 ? " " : "") << assets.phones[spelling[j]];
+            assets.spellings.back().push_back(assets.phones[spelling[j]]);
+        }
+        lexicon << '\n';
+    }
+    lexicon.close();
+
+    // Homophones: each pronunciation maps to homophone_group_size spellings
+    std::vector<std::string> french_words;
+    auto homophones = open_output(assets.homophones_path);
+    for (const auto& word : assets.words) {
+        std::vector<std::string> group;
+        homophones << "{\"ipa\": \"" << word << "\", \"words\": [";
+        for (int j = 0; j < config.homophone_group_size; ++j) {
+            group.push_back(word + "_fr" + std::to_string(j));
+            french_words.push_back(group.back());
+            homophones << (j > 0 ? ", " : "") << '"' << group.back() << '"';
+        }
+        homophones << "]}\n";
+        assets.homophone_groups.push_back(std::move(group));
+    }
+    homophones.close();
+
+    auto write_lm = [&](const std::string& path, const std::vector<std::string>& words) {
+        if (!config.binary_lm) {
+            write_test_arpa(path, words, config.lm_order);
+            return;
+        }
+        const std::string arpa_path = path + ".arpa";
+        write_test_arpa(arpa_path, words, config.lm_order);
+        convert_arpa_to_binary(arpa_path, path);
+        fs::remove(arpa_path);
+    };
+    write_lm(assets.lm_path, assets.words);
+    write_lm(assets.french_lm_path, french_words);
+
+    write_test_tflite_model(assets.model_path, assets.vocab_size, config.seed);
+    return assets;
+}
+
+} // namespace cued_speech
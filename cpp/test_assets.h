@@ -0,0 +1,101 @@
+/**
+ * Cued Speech Decoder - Synthetic test assets
+ *
+ * Generates deterministic stand-ins for the downloaded assets (phone list,
+ * lexicon, KenLM models, homophone dictionary and acoustic TFLite model) so
+ * benchmarks and load tests run on machines without them. Sizes scale with
+ * TestAssetConfig; the same config and seed always produce the same files.
+ */
+
+#ifndef CUED_SPEECH_TEST_ASSETS_H
+#define CUED_SPEECH_TEST_ASSETS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cued_speech {
+
+/**
+ * Size and shape of the generated assets
+ */
+struct TestAssetConfig {
+    int num_phones = 40;             // Phone tokens besides specials and "_"
+    int num_words = 500;             // Lexicon entries
+    int min_word_length = 2;         // Phones per word
+    int max_word_length = 4;
+    int doubled_phone_percent = 0;   // Words whose spelling repeats a phone back to back ("p3 p3")
+    bool unique_spellings = false;   // Redraw spellings another word already has
+    int homophone_group_size = 4;    // French spellings per pronunciation
+    int lm_order = 2;                // 1 or 2
+    bool binary_lm = true;           // Convert the ARPA files to KenLM binary
+    uint32_t seed = 1;
+};
+
+/**
+ * Paths and contents of a generated asset set
+ */
+struct TestAssets {
+    std::string dir;
+    std::string tokens_path;         // phonelist.csv equivalent
+    std::string lexicon_path;        // lexicon.txt equivalent
+    std::string lm_path;             // kenlm_ipa.binary equivalent
+    std::string homophones_path;     // homophones_dico.jsonl equivalent
+    std::string french_lm_path;      // kenlm_fr.bin equivalent
+    std::string model_path;          // Acoustic model with the production signature
+
+    int vocab_size = 0;              // Rows of the model output / decoder vocabulary
+    std::vector<std::string> phones;
+    std::vector<std::string> words;
+    std::vector<std::vector<std::string>> spellings;  // Phones of each word
+    std::vector<std::vector<std::string>> homophone_groups;
+};
+
+/**
+ * Write a complete asset set into dir (created if missing)
+ *
+ * @throws std::invalid_argument for an inconsistent config
+ * @throws std::runtime_error if a file cannot be written
+ */
+TestAssets generate_test_assets(const std::string& dir, const TestAssetConfig& config = {});
+
+/**
+ * Write an ARPA language model over words (unigrams, plus bigrams between
+ * consecutive words when order is 2)
+ */
+void write_test_arpa(const std::string& path, const std::vector<std::string>& words, int order);
+
+/**
+ * Convert an ARPA file to a KenLM probing binary
+ */
+void convert_arpa_to_binary(const std::string& arpa_path, const std::string& binary_path);
+
+/**
+ * Write a TFLite model with the (lips, hand_shape, hand_pos) -> logits
+ * signature and a dynamic time axis
+ *
+ * A single FULLY_CONNECTED layer maps the lip features to vocab_size logits;
+ * the hand streams are declared but unused. The blank logit is biased up so
+ * decoded outputs look like a trained CTC model's.
+ */
+void write_test_tflite_model(const std::string& path, int vocab_size, uint32_t seed = 1);
+
+/**
+ * Write a stateful streaming variant of the test model
+ *
+ * Inputs (lips, hand_shape, hand_pos, state), outputs (state_out, logits):
+ * the state comes before the logits so that it can only be paired by name.
+ * The lip features are summed over time on top of state ([1, 1, 8]) and the
+ * running sum goes through a FULLY_CONNECTED layer; state_out is state plus
+ * the sum of the chunk. Chunks fed in order with the state carried give the
+ * logits of a single pass over the whole sequence.
+ *
+ * @param with_state false drops the state input and state_out: three
+ *                   inputs, outputs (running_sum, logits)
+ */
+void write_test_stateful_tflite_model(const std::string& path, int vocab_size, uint32_t seed = 1,
+                                      bool with_state = true);
+
+} // namespace cued_speech
+
+#endif // CUED_SPEECH_TEST_ASSETS_H
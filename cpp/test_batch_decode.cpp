@@ -0,0 +1,175 @@
+/**
+ * Dropped-frame subtitle test of the batch_decode tool
+ *
+ * Usage:
+ *   test_batch_decode BATCH_DECODE [frames] [seed]
+ *
+ * Writes two feature files with the same DATA rows, one of them with DROP
+ * rows in front, in runs and alone, runs batch_decode on both and compares
+ * the word cues. The DATA rows decode the same way, so each cue of the file
+ * with DROP rows must be the cue of the other file moved onto the rows of
+ * its file: starting on the row of its first valid frame and ending after
+ * the row of its last.
+ */
+
+#include "test_support.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using cued_speech::FrameFeatures;
+using cued_speech::TestAssets;
+using cued_speech::test::check;
+
+namespace {
+
+constexpr double kFps = 30.0;
+
+struct Cue {
+    long long start_ms = 0;
+    long long end_ms = 0;
+    std::string text;
+};
+
+void write_features(const std::string& path, const std::vector<FrameFeatures>& frames,
+                    const std::vector<uint8_t>& valid_mask) {
+    std::ofstream out(path);
+    size_t next = 0;
+    for (size_t row = 0; row < valid_mask.size(); ++row) {
+        if (!valid_mask[row]) {
+            out << "DROP," << row << '\n';
+            continue;
+        }
+        const FrameFeatures& frame = frames[next++];
+        out << "DATA," << row;
+        for (const auto* values : {&frame.hand_shape, &frame.hand_position, &frame.lips}) {
+            for (const float value : *values) {
+                out << ',' << value;
+            }
+        }
+        out << '\n';
+    }
+}
+
+long long parse_timestamp(const std::string& text) {
+    int h = 0;
+    int m = 0;
+    int s = 0;
+    int ms = 0;
+    char sep = 0;
+    std::istringstream in(text);
+    in >> h >> sep >> m >> sep >> s >> sep >> ms;
+    return ((h * 60LL + m) * 60LL + s) * 1000LL + ms;
+}
+
+std::vector<Cue> read_srt(const std::string& path) {
+    std::vector<Cue> cues;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t arrow = line.find(" --> ");
+        if (arrow == std::string::npos) {
+            continue;
+        }
+        Cue cue;
+        cue.start_ms = parse_timestamp(line.substr(0, arrow));
+        cue.end_ms = parse_timestamp(line.substr(arrow + 5));
+        std::getline(in, cue.text);
+        cues.push_back(cue);
+    }
+    return cues;
+}
+
+int frame_of(long long ms) {
+    return static_cast<int>(std::llround(ms * kFps / 1000.0));
+}
+
+long long ms_of(int frame) {
+    return std::llround(frame / kFps * 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " BATCH_DECODE [frames] [seed]" << std::endl;
+        return 1;
+    }
+    const std::string batch_decode = argv[1];
+    const int num_frames = argc > 2 ? std::atoi(argv[2]) : 300;
+    const uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 1;
+
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate()) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+
+    // 45 DROP rows in front, then about one row in ten dropped (some in
+    // runs of up to 25)
+    std::mt19937 rng(seed);
+    std::vector<FrameFeatures> frames;
+    for (int i = 0; i < num_frames; ++i) {
+        frames.push_back(cued_speech::test::random_frame(rng));
+    }
+    std::vector<uint8_t> dropped_mask(45, 0);
+    std::uniform_int_distribution<int> kind_dist(0, 99);
+    std::uniform_int_distribution<int> run_dist(2, 25);
+    for (int valid = 0; valid < num_frames;) {
+        const int kind = kind_dist(rng);
+        if (kind < 7) {
+            dropped_mask.push_back(0);
+        } else if (kind < 10) {
+            dropped_mask.insert(dropped_mask.end(), run_dist(rng), 0);
+        } else {
+            dropped_mask.push_back(1);
+            ++valid;
+        }
+    }
+    const std::vector<uint8_t> plain_mask(num_frames, 1);
+    const std::vector<int> rows =
+        cued_speech::stream_frames_of(dropped_mask.data(), static_cast<int>(dropped_mask.size()));
+
+    write_features(temp.path("dropped.csv"), frames, dropped_mask);
+    write_features(temp.path("plain.csv"), frames, plain_mask);
+    const std::string out_dir = temp.path("out");
+    const std::string command = "\"" + batch_decode + "\" --tokens \"" + assets.tokens_path + "\" --lexicon \"" +
+                                assets.lexicon_path + "\" --lm \"" + assets.lm_path + "\" --model \"" +
+                                assets.model_path + "\" --out \"" + out_dir + "\" --jobs 2 --fps 30 \"" +
+                                temp.path("dropped.csv") + "\" \"" + temp.path("plain.csv") + "\"";
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "batch_decode failed: " << command << std::endl;
+        return 1;
+    }
+
+    const auto expected = read_srt(out_dir + "/plain.srt");
+    const auto actual = read_srt(out_dir + "/dropped.srt");
+    check(!expected.empty(), "the DATA rows decode to words");
+    check(actual.size() == expected.size(), "DROP rows leave the number of cues unchanged");
+    bool on_rows = actual.size() == expected.size();
+    for (size_t i = 0; on_rows && i < expected.size(); ++i) {
+        const int first = frame_of(expected[i].start_ms);
+        const int last = frame_of(expected[i].end_ms) - 1;
+        on_rows = actual[i].text == expected[i].text && first >= 0 && last < num_frames &&
+                  actual[i].start_ms == ms_of(rows[first]) && actual[i].end_ms == ms_of(rows[last] + 1);
+        if (!on_rows) {
+            std::cerr << "  cue " << i << " '" << actual[i].text << "' " << actual[i].start_ms << "-"
+                      << actual[i].end_ms << " ms, valid frames " << first << "-" << last << std::endl;
+        }
+    }
+    check(on_rows, "each cue starts on the row of its first valid frame and ends after its last");
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "batch_decode times " << expected.size() << " cues on the rows of a file with "
+              << dropped_mask.size() - num_frames << " DROP rows (seed " << seed << ")" << std::endl;
+    return 0;
+}
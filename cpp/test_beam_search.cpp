@@ -0,0 +1,226 @@
+/**
+ * Differential test of the native lexicon beam search
+ *
+ * Usage:
+ *   test_beam_search [iterations] [seed]
+ *
+ * Random CTC-like posteriors (blank-dominated frames, peaks on one token and
+ * ambiguous frames) are decoded on synthetic assets by two CTCDecoders that
+ * differ only in DecoderConfig::engine, under several beam, threshold,
+ * scoring, blank-skip and token-pruning settings. The lexicon has spellings
+ * that repeat a phone back to back ("p3 p3"), where a word may be completed
+ * on a CTC repeat. The best hypotheses must have the same path, words and
+ * score, and the n-best lists the same scores and words. Every spelling is
+ * unique, so two hypotheses only tie on their score by accident; hypotheses
+ * tied with the last one kept may be cut differently and are only counted.
+ */
+
+#include "test_support.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::CTCHypothesis;
+using cued_speech::DecoderConfig;
+using cued_speech::DecoderEngine;
+using cued_speech::TestAssets;
+
+namespace {
+
+struct Setting {
+    const char* name;
+    int beam_size;
+    int beam_size_token;
+    float beam_threshold;
+    float lm_weight;
+    float word_score;
+    float unk_score;
+    bool log_add;
+    float blank_skip_threshold;
+    float token_mass;
+};
+
+constexpr float kNoUnk = -std::numeric_limits<float>::infinity();
+constexpr int kNBest = 8;
+
+const Setting kSettings[] = {
+    {"default", 40, -1, 50.0f, 3.23f, 0.0f, kNoUnk, false, 0.0f, 1.0f},
+    {"narrow", 4, 5, 10.0f, 1.0f, -0.5f, kNoUnk, false, 0.0f, 1.0f},
+    {"log_add", 16, -1, 25.0f, 2.0f, 1.0f, kNoUnk, true, 0.0f, 1.0f},
+    {"unk", 20, -1, 30.0f, 0.5f, 0.0f, -5.0f, false, 0.0f, 1.0f},
+    {"blank_skip", 40, -1, 50.0f, 3.23f, 0.0f, kNoUnk, false, -0.05f, 1.0f},
+    {"token_mass", 40, 12, 50.0f, 3.23f, 0.0f, kNoUnk, false, 0.0f, 0.9f},
+};
+
+DecoderConfig make_config(const TestAssets& assets, const Setting& setting, DecoderEngine engine) {
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.nbest = kNBest;
+    config.beam_size = setting.beam_size;
+    config.beam_size_token = setting.beam_size_token;
+    config.beam_threshold = setting.beam_threshold;
+    config.lm_weight = setting.lm_weight;
+    config.word_score = setting.word_score;
+    config.unk_score = setting.unk_score;
+    config.log_add = setting.log_add;
+    config.blank_skip_threshold = setting.blank_skip_threshold;
+    config.token_mass = setting.token_mass;
+    config.engine = engine;
+    return config;
+}
+
+std::vector<float> random_log_probs(std::mt19937& rng, int frames, int vocab) {
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> token_dist(1, vocab - 1);
+    std::uniform_real_distribution<float> peak(0.0f, 12.0f);
+    const int blank_percent = percent(rng);
+
+    std::vector<float> logits(static_cast<size_t>(frames) * vocab);
+    for (int t = 0; t < frames; ++t) {
+        float* row = logits.data() + static_cast<size_t>(t) * vocab;
+        for (int v = 0; v < vocab; ++v) {
+            row[v] = normal(rng);
+        }
+        row[percent(rng) < blank_percent ? 0 : token_dist(rng)] += peak(rng);  // <BLANK> is index 0
+    }
+    std::vector<float> log_probs(logits.size());
+    CTCDecoder::log_softmax(logits.data(), log_probs.data(), frames, vocab);
+    return log_probs;
+}
+
+bool same_score(float expected, float actual) {
+    return std::abs(expected - actual) <= 1e-4f * std::max(1.0f, std::abs(expected));
+}
+
+bool same_hypothesis(const CTCHypothesis& expected, const CTCHypothesis& actual) {
+    return expected.tokens == actual.tokens && expected.words == actual.words &&
+           expected.word_start_frames == actual.word_start_frames &&
+           expected.word_end_frames == actual.word_end_frames && same_score(expected.score, actual.score);
+}
+
+/**
+ * Same scores in order, and the same words for each run of equal scores
+ * (tied hypotheses may come in either order). A run that reaches the end
+ * of the list may have been cut differently, so its words are not compared.
+ */
+bool same_nbest(const std::vector<CTCHypothesis>& expected, const std::vector<CTCHypothesis>& actual) {
+    if (expected.size() != actual.size()) {
+        return false;
+    }
+    size_t run_begin = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (!same_score(expected[i].score, actual[i].score)) {
+            return false;
+        }
+        const bool run_ends = i + 1 == expected.size() || !same_score(expected[i].score, expected[i + 1].score);
+        if (!run_ends) {
+            continue;
+        }
+        if (i + 1 < expected.size()) {
+            std::vector<std::vector<std::string>> a;
+            std::vector<std::vector<std::string>> b;
+            for (size_t j = run_begin; j <= i; ++j) {
+                a.push_back(expected[j].words);
+                b.push_back(actual[j].words);
+            }
+            std::sort(a.begin(), a.end());
+            std::sort(b.begin(), b.end());
+            if (a != b) {
+                return false;
+            }
+        }
+        run_begin = i + 1;
+    }
+    return true;
+}
+
+std::string join(const std::vector<std::string>& words) {
+    std::string out;
+    for (const auto& word : words) {
+        out += (out.empty() ? "" : " ") + word;
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long iterations = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 200;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    cued_speech::TestAssetConfig asset_config;
+    asset_config.doubled_phone_percent = 25;
+    asset_config.unique_spellings = true;
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate(asset_config)) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+
+    struct DecoderPair {
+        std::unique_ptr<CTCDecoder> flashlight;
+        std::unique_ptr<CTCDecoder> native;
+    };
+    std::vector<DecoderPair> decoders;
+    for (const Setting& setting : kSettings) {
+        DecoderPair pair{
+            std::make_unique<CTCDecoder>(make_config(assets, setting, DecoderEngine::Flashlight)),
+            std::make_unique<CTCDecoder>(make_config(assets, setting, DecoderEngine::Native))};
+        if (!pair.flashlight->initialize() || !pair.native->initialize()) {
+            std::cerr << "Failed to initialize decoders for " << setting.name << std::endl;
+            return 1;
+        }
+        decoders.push_back(std::move(pair));
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> frames_dist(1, 300);
+    const int vocab = assets.vocab_size;
+    long failures = 0;
+    for (long i = 0; i < iterations && failures < 10; ++i) {
+        const size_t index = static_cast<size_t>(i) % decoders.size();
+        const int frames = frames_dist(rng);
+        const auto log_probs = random_log_probs(rng, frames, vocab);
+
+        const auto expected = decoders[index].flashlight->decode_log_probs(log_probs.data(), frames, vocab);
+        const auto actual = decoders[index].native->decode_log_probs(log_probs.data(), frames, vocab);
+        if (expected.size() == actual.size() &&
+            (expected.empty() || same_hypothesis(expected[0], actual[0])) && same_nbest(expected, actual)) {
+            continue;
+        }
+
+        ++failures;
+        std::cerr << kSettings[index].name << " mismatch on input " << i << " (" << frames << " frames)\n";
+        for (size_t j = 0; j < std::max(expected.size(), actual.size()); ++j) {
+            if (j < expected.size()) {
+                std::cerr << "  expected " << j << ": \"" << join(expected[j].words) << "\" score "
+                          << expected[j].score << "\n";
+            }
+            if (j < actual.size()) {
+                std::cerr << "  actual   " << j << ": \"" << join(actual[j].words) << "\" score "
+                          << actual[j].score << "\n";
+            }
+        }
+        std::cerr << std::flush;
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " mismatches (seed " << seed << ")" << std::endl;
+        return 1;
+    }
+    std::cout << "Native beam search matches LexiconDecoder on " << iterations << " inputs (seed " << seed
+              << ", " << decoders.size() << " settings)" << std::endl;
+    return 0;
+}
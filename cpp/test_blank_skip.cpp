@@ -0,0 +1,171 @@
+/**
+ * Blank-skip test of CTCDecoder
+ *
+ * Usage:
+ *   test_blank_skip [words] [seed]
+ *
+ * Scripted log-probabilities spell lexicon words (some with a doubled phone)
+ * with long blank runs between phones and words, and are decoded by two
+ * decoders that differ only in blank_skip_threshold, with both engines:
+ * - skip_blank_frames keeps every non-blank frame and the first frame of
+ *   each blank run, in order, with the rows of those frames
+ * - the path decoded over the kept rows is stretched back to T + 2 steps and
+ *   is the path decoded without the skip
+ * - the words and their start and end frames match the decode without the
+ *   skip and fall on the frames where the script spelled them
+ */
+
+#include "test_support.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::CTCHypothesis;
+using cued_speech::DecoderConfig;
+using cued_speech::DecoderEngine;
+using cued_speech::TestAssets;
+using cued_speech::test::check;
+using cued_speech::test::ScriptedPosteriors;
+
+namespace {
+
+constexpr float kSkipThreshold = -0.05f;
+
+void check_frame_map(const CTCDecoder& decoder, const ScriptedPosteriors& script) {
+    const int T = script.frames();
+    const int V = script.vocab();
+    const int blank = decoder.token_to_idx(decoder.config().blank_token);
+    std::vector<float> reduced;
+    std::vector<int> frame_map;
+    const int kept = decoder.skip_blank_frames(script.data(), T, V, reduced, frame_map);
+
+    check(kept < T / 2, "blank runs are merged (" + std::to_string(kept) + " of " + std::to_string(T) +
+                            " rows kept)");
+    check(static_cast<int>(frame_map.size()) == kept && reduced.size() == static_cast<size_t>(kept) * V,
+          "one map entry and one row per kept frame");
+    if (static_cast<int>(frame_map.size()) != kept || reduced.size() != static_cast<size_t>(kept) * V) {
+        return;
+    }
+
+    auto is_blank = [&](int t) { return script.data()[static_cast<size_t>(t) * V + blank] > kSkipThreshold; };
+    size_t next = 0;
+    bool ok = true;
+    for (int t = 0; t < T && ok; ++t) {
+        const bool must_keep = !is_blank(t) || t == 0 || !is_blank(t - 1);
+        const bool kept_here = next < frame_map.size() && frame_map[next] == t;
+        ok = must_keep == kept_here;
+        if (kept_here) {
+            const float* row = script.data() + static_cast<size_t>(t) * V;
+            ok = ok && std::equal(row, row + V, reduced.begin() + static_cast<std::ptrdiff_t>(next) * V);
+            ++next;
+        }
+    }
+    check(ok && next == frame_map.size(),
+          "the kept rows are the non-blank frames and the first frame of each blank run");
+}
+
+void check_decodes(const TestAssets& assets, DecoderEngine engine, const ScriptedPosteriors& script,
+                   const std::vector<std::string>& words, const std::vector<ScriptedPosteriors::Span>& spans) {
+    const std::string label = engine == DecoderEngine::Native ? "native: " : "flashlight: ";
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.engine = engine;
+    CTCDecoder plain(config);
+    config.blank_skip_threshold = kSkipThreshold;
+    CTCDecoder skipping(config);
+    if (!plain.initialize() || !skipping.initialize()) {
+        check(false, label + "initialize the decoders");
+        return;
+    }
+
+    const int T = script.frames();
+    const int V = script.vocab();
+    const auto expected = plain.decode_log_probs(script.data(), T, V);
+    const auto actual = skipping.decode_log_probs(script.data(), T, V);
+    if (expected.empty() || actual.empty()) {
+        check(false, label + "both decoders return a hypothesis");
+        return;
+    }
+    const CTCHypothesis& a = expected[0];
+    const CTCHypothesis& b = actual[0];
+
+    check(b.tokens.size() == static_cast<size_t>(T) + 2,
+          label + "the expanded path has T + 2 steps (" + std::to_string(b.tokens.size()) + " for " +
+              std::to_string(T) + " frames)");
+    check(a.tokens == b.tokens, label + "the expanded path is the path decoded without the skip");
+    check(plain.collapse_tokens(a.tokens) == skipping.collapse_tokens(b.tokens),
+          label + "the collapsed phones match");
+    check(a.words == words, label + "the decode without the skip finds the scripted words");
+    check(b.words == a.words, label + "the words match");
+    check(b.word_start_frames == a.word_start_frames && b.word_end_frames == a.word_end_frames,
+          label + "word frames are mapped back to the original frames");
+
+    bool on_script = b.word_start_frames.size() == spans.size() && b.word_end_frames.size() == spans.size();
+    for (size_t i = 0; on_script && i < spans.size(); ++i) {
+        on_script = b.word_start_frames[i] == spans[i].start && b.word_end_frames[i] == spans[i].end;
+    }
+    check(on_script, label + "each word starts on its first phone and ends on its last");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int num_words = argc > 1 ? std::atoi(argv[1]) : 60;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    cued_speech::TestAssetConfig asset_config;
+    asset_config.doubled_phone_percent = 25;
+    asset_config.unique_spellings = true;
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate(asset_config)) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.blank_skip_threshold = kSkipThreshold;
+    CTCDecoder decoder(config);
+    if (!decoder.initialize()) {
+        std::cerr << "Failed to initialize the decoder" << std::endl;
+        return 1;
+    }
+
+    // Words with 1-12 blank frames after each phone and 0-60 between words
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> word_dist(0, assets.words.size() - 1);
+    std::uniform_int_distribution<int> gap_dist(1, 12);
+    std::uniform_int_distribution<int> pause_dist(0, 60);
+    ScriptedPosteriors script(decoder, seed);
+    std::vector<std::string> words;
+    std::vector<ScriptedPosteriors::Span> spans;
+    script.add(config.blank_token, pause_dist(rng));
+    for (int i = 0; i < num_words; ++i) {
+        const size_t w = word_dist(rng);
+        words.push_back(assets.words[w]);
+        spans.push_back(script.add_word(assets.spellings[w], 1, gap_dist(rng)));
+        script.add(config.blank_token, pause_dist(rng));
+    }
+
+    check_frame_map(decoder, script);
+    check_decodes(assets, DecoderEngine::Flashlight, script, words, spans);
+    check_decodes(assets, DecoderEngine::Native, script, words, spans);
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "Blank skip keeps paths and word frames on " << script.frames() << " frames (seed " << seed << ")"
+              << std::endl;
+    return 0;
+}
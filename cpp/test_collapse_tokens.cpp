@@ -0,0 +1,173 @@
+/**
+ * Differential test of CTCDecoder::collapse_tokens
+ *
+ * Usage:
+ *   test_collapse_tokens [paths] [seed]
+ *
+ * Random decoder paths over a few phones, "_", <UNK>, the dropped tokens
+ * (<BLANK>, <PAD>, <SOS>, <EOS>) and indices outside the vocabulary are
+ * collapsed on integer IDs and by the string pipeline that idxs_to_tokens
+ * used before (drop the first and last step, empty and dropped tokens,
+ * merge repeats, trim trailing "_"); both must give the same tokens. Runs of
+ * one token broken up by dropped tokens are drawn often, so repeats merged
+ * across a dropped token are covered, as are trailing silence runs and
+ * paths of zero, one and two steps.
+ */
+
+#include "test_support.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::DecoderConfig;
+using cued_speech::TestAssets;
+using cued_speech::test::check;
+
+namespace {
+
+/**
+ * idxs_to_tokens as it was before the integer collapse
+ */
+std::vector<std::string> collapse_strings(const CTCDecoder& decoder, const std::vector<int>& indices) {
+    std::vector<std::string> tokens;
+    for (int idx : indices) {
+        tokens.push_back(decoder.idx_to_token(idx));
+    }
+    if (tokens.size() >= 2) {
+        tokens.erase(tokens.begin());
+        tokens.pop_back();
+    }
+
+    std::vector<std::string> filtered;
+    for (const auto& token : tokens) {
+        if (token.empty() || token == "<BLANK>" || token == "<PAD>" || token == "<SOS>" || token == "<EOS>") {
+            continue;
+        }
+        filtered.push_back(token);
+    }
+
+    std::vector<std::string> deduped;
+    for (const auto& token : filtered) {
+        if (deduped.empty() || deduped.back() != token) {
+            deduped.push_back(token);
+        }
+    }
+    while (!deduped.empty() && deduped.back() == "_") {
+        deduped.pop_back();
+    }
+    return deduped;
+}
+
+std::string join(const std::vector<int>& path) {
+    std::string out;
+    for (int idx : path) {
+        out += (out.empty() ? "" : " ") + std::to_string(idx);
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long num_paths = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 1000000;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate()) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    CTCDecoder decoder(config);
+    if (!decoder.initialize()) {
+        std::cerr << "Failed to initialize the decoder" << std::endl;
+        return 1;
+    }
+
+    const int vocab = decoder.get_vocab_size();
+    const int blank = decoder.token_to_idx("<BLANK>");
+    const int sil = decoder.token_to_idx("_");
+    const std::vector<int> dropped = {blank, decoder.token_to_idx("<PAD>"), decoder.token_to_idx("<SOS>"),
+                                      decoder.token_to_idx("<EOS>")};
+    const std::vector<int> phones = {decoder.token_to_idx(assets.phones[0]), decoder.token_to_idx(assets.phones[1]),
+                                     decoder.token_to_idx(assets.phones[2]), decoder.token_to_idx("<UNK>")};
+    const std::vector<int> outside = {-1, vocab, vocab + 7};
+    for (int idx : dropped) {
+        check(idx >= 0, "the dropped tokens are in the vocabulary");
+    }
+
+    // Hand-picked paths (start and end steps included)
+    const int p = phones[0];
+    const int q = phones[1];
+    check(decoder.collapse_tokens({sil, p, blank, p, sil}) == std::vector<int>{p},
+          "a repeat merges across a blank");
+    check(decoder.collapse_tokens({sil, p, dropped[1], dropped[3], p, q, sil}) == std::vector<int>{p, q},
+          "a repeat merges across <PAD> and <EOS>");
+    check(decoder.collapse_tokens({sil, p, sil, p, sil}) == std::vector<int>{p, sil, p},
+          "silence separates repeats and stays inside");
+    check(decoder.collapse_tokens({sil, p, -1, p, sil}) == std::vector<int>{p},
+          "a repeat merges across an index outside the vocabulary");
+    check(decoder.collapse_tokens({sil, p, sil, blank, sil, sil}).size() == 1, "trailing silence is trimmed");
+    check(decoder.collapse_tokens({p}) == std::vector<int>{p}, "a one-step path is kept");
+    check(decoder.collapse_tokens({p, q}).empty(), "a two-step path is only start and end");
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> length_dist(0, 40);
+    std::uniform_int_distribution<int> kind_dist(0, 99);
+    auto pick = [&rng](const std::vector<int>& from) {
+        return from[std::uniform_int_distribution<size_t>(0, from.size() - 1)(rng)];
+    };
+
+    long mismatches = 0;
+    std::vector<int> path;
+    std::vector<int> collapsed;
+    for (long i = 0; i < num_paths && mismatches < 10; ++i) {
+        path.clear();
+        const int length = length_dist(rng);
+        int last_kept = pick(phones);
+        while (static_cast<int>(path.size()) < length) {
+            const int kind = kind_dist(rng);
+            if (kind < 30) {
+                path.push_back(last_kept);  // Repeat, possibly after dropped tokens
+            } else if (kind < 55) {
+                last_kept = pick(phones);
+                path.push_back(last_kept);
+            } else if (kind < 85) {
+                path.push_back(pick(dropped));
+            } else if (kind < 97) {
+                last_kept = sil;
+                path.push_back(sil);
+            } else {
+                path.push_back(pick(outside));
+            }
+        }
+
+        decoder.collapse_tokens(path, collapsed);
+        std::vector<std::string> actual;
+        for (int idx : collapsed) {
+            actual.push_back(decoder.idx_to_token(idx));
+        }
+        const std::vector<std::string> expected = collapse_strings(decoder, path);
+        if (actual == expected && decoder.idxs_to_tokens(path) == expected) {
+            continue;
+        }
+        ++mismatches;
+        check(false, "path [" + join(path) + "] collapses to [" + join(collapsed) + "]");
+    }
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "collapse_tokens matches the string pipeline on " << num_paths << " paths (seed " << seed << ")"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,281 @@
+/**
+ * Daemon round-trip test of the client library
+ *
+ * Usage:
+ *   test_daemon_client DAEMON [frames] [seed]
+ *
+ * Starts the cued_speech_daemon binary on generated assets and streams
+ * random frames (some dropped) with provisional results on:
+ * - every result pushed by the daemon, and the final one, matches the same
+ *   stream run in process through the stream_* functions: frame number,
+ *   flags, confidence, phone token IDs, the unstable tail's token IDs, and
+ *   phonemes spelling those IDs
+ * - streams destroyed while their results are still arriving free them and
+ *   leave the connection usable
+ */
+
+#include "decoder_client.h"
+#include "test_support.h"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using cued_speech::TestAssets;
+using cued_speech::test::check;
+
+namespace {
+
+constexpr int kFeatureSize = 33;
+constexpr int kMaxTokens = 4096;
+
+/**
+ * A result as token IDs, with the phonemes it carried (if any)
+ */
+struct IdResult {
+    TokenResult info{};
+    std::vector<int> tokens;
+    std::vector<int> unstable_tokens;
+    std::vector<std::string> phonemes;
+    std::vector<std::string> unstable_phonemes;
+};
+
+IdResult from_buffers(const TokenResult& info, const std::vector<int>& tokens, const std::vector<int>& unstable) {
+    IdResult result;
+    result.info = info;
+    result.tokens.assign(tokens.begin(), tokens.begin() + std::min(info.tokens_length, kMaxTokens));
+    result.unstable_tokens.assign(unstable.begin(),
+                                  unstable.begin() + std::min(info.unstable_tokens_length, kMaxTokens));
+    return result;
+}
+
+IdResult from_client(const RecognitionResult* result) {
+    std::vector<int> tokens(kMaxTokens);
+    std::vector<int> unstable(kMaxTokens);
+    TokenResult info{};
+    if (!client_result_ids(result, tokens.data(), kMaxTokens, unstable.data(), kMaxTokens, &info)) {
+        check(false, std::string("client_result_ids: ") + client_get_last_error());
+    }
+    IdResult ids = from_buffers(info, tokens, unstable);
+    ids.phonemes.assign(result->phonemes, result->phonemes + result->phonemes_length);
+    ids.unstable_phonemes.assign(result->unstable_phonemes,
+                                 result->unstable_phonemes + result->unstable_phonemes_length);
+    return ids;
+}
+
+/**
+ * Same stream in process, pushed frame by frame as the daemon does
+ */
+std::vector<IdResult> run_in_process(StreamHandle stream, const std::vector<float>& frames,
+                                     const std::vector<uint8_t>& mask) {
+    std::vector<IdResult> results;
+    std::vector<int> tokens(kMaxTokens);
+    std::vector<int> unstable(kMaxTokens);
+    TokenResult info{};
+    const uint8_t invalid = 0;
+    for (size_t i = 0; i < mask.size(); ++i) {
+        const float* row = frames.data() + i * kFeatureSize;
+        const bool ready =
+            mask[i] ? stream_push_frame(stream, row) : stream_push_frames(stream, row, 1, &invalid) > 0;
+        if (ready &&
+            stream_process_window_ids(stream, tokens.data(), kMaxTokens, unstable.data(), kMaxTokens, &info)) {
+            results.push_back(from_buffers(info, tokens, unstable));
+        }
+    }
+    if (stream_finalize_ids(stream, tokens.data(), kMaxTokens, unstable.data(), kMaxTokens, &info)) {
+        results.push_back(from_buffers(info, tokens, unstable));
+    }
+    return results;
+}
+
+std::vector<std::string> spell(DecoderHandle decoder, const std::vector<int>& ids) {
+    std::vector<std::string> tokens;
+    for (const int id : ids) {
+        const char* token = decoder_idx_to_token(decoder, id);
+        tokens.emplace_back(token ? token : "");
+    }
+    return tokens;
+}
+
+void check_same(DecoderHandle decoder, const IdResult& expected, const IdResult& actual, const std::string& what) {
+    const TokenResult& a = expected.info;
+    const TokenResult& b = actual.info;
+    check(a.frame_number == b.frame_number && a.provisional == b.provisional && a.endpoint == b.endpoint,
+          what + ": frame number and flags match");
+    check(std::abs(a.confidence - b.confidence) <= 1e-4f * std::max(1.0f, std::abs(a.confidence)),
+          what + ": confidence matches");
+    check(!a.truncated && !b.truncated && actual.tokens == expected.tokens, what + ": token IDs match");
+    check(actual.unstable_tokens == expected.unstable_tokens, what + ": unstable token IDs match");
+    check(actual.phonemes == spell(decoder, actual.tokens) &&
+              actual.unstable_phonemes == spell(decoder, actual.unstable_tokens),
+          what + ": phonemes spell the token IDs");
+}
+
+/**
+ * Connect once the daemon listens (it loads its assets first)
+ */
+ClientHandle connect_when_ready(const std::string& socket_path, pid_t daemon) {
+    for (int attempt = 0; attempt < 600; ++attempt) {
+        if (ClientHandle client = client_connect(socket_path.c_str())) {
+            return client;
+        }
+        int status = 0;
+        if (::waitpid(daemon, &status, WNOHANG) == daemon) {
+            return nullptr;  // Exited during startup
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " DAEMON [frames] [seed]" << std::endl;
+        return 1;
+    }
+    const std::string daemon_path = argv[1];
+    const int num_frames = argc > 2 ? std::atoi(argv[2]) : 600;
+    const uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 1;
+
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate()) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+    const std::string socket_path = temp.path("daemon.sock");
+
+    const pid_t daemon = ::fork();
+    if (daemon < 0) {
+        std::cerr << "fork() failed" << std::endl;
+        return 1;
+    }
+    if (daemon == 0) {
+        ::execl(daemon_path.c_str(), daemon_path.c_str(), "--socket", socket_path.c_str(), "--tokens",
+                assets.tokens_path.c_str(), "--lexicon", assets.lexicon_path.c_str(), "--lm",
+                assets.lm_path.c_str(), "--model", assets.model_path.c_str(), "--workers", "2",
+                static_cast<char*>(nullptr));
+        std::_Exit(127);
+    }
+    auto stop_daemon = [daemon] {
+        ::kill(daemon, SIGTERM);
+        int status = 0;
+        ::waitpid(daemon, &status, 0);
+    };
+
+    ClientHandle client = connect_when_ready(socket_path, daemon);
+    if (!client) {
+        std::cerr << "Failed to connect to the daemon: " << client_get_last_error() << std::endl;
+        stop_daemon();
+        return 1;
+    }
+
+    ::DecoderConfig config = decoder_config_default();
+    config.tokens_path = assets.tokens_path.c_str();
+    config.lexicon_path = assets.lexicon_path.c_str();
+    config.lm_path = assets.lm_path.c_str();
+    DecoderHandle decoder = decoder_create(&config);
+    StreamHandle local = decoder ? stream_create(decoder) : nullptr;
+    if (!local || !stream_load_tflite_model(local, assets.model_path.c_str())) {
+        std::cerr << "Failed to set up the in-process stream: " << decoder_get_last_error() << std::endl;
+        client_disconnect(client);
+        stop_daemon();
+        return 1;
+    }
+
+    // About one frame in eight dropped
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> drop_dist(0, 7);
+    std::vector<float> frames(static_cast<size_t>(num_frames) * kFeatureSize);
+    std::vector<uint8_t> mask(num_frames);
+    for (float& value : frames) {
+        value = uniform(rng);
+    }
+    for (auto& valid : mask) {
+        valid = drop_dist(rng) != 0;
+    }
+
+    ::WindowingConfig windowing = windowing_config_default();
+    windowing.provisional_interval = 10;
+    stream_set_windowing(local, &windowing);
+    const std::vector<IdResult> expected = run_in_process(local, frames, mask);
+
+    ClientStreamHandle stream = client_stream_create(client);
+    check(stream != nullptr, "the daemon opens a stream");
+    if (stream) {
+        check(client_stream_set_windowing(stream, &windowing), "windowing is sent");
+        check(client_stream_push_frames(stream, frames.data(), num_frames, mask.data()) == num_frames,
+              "frames are sent");
+        RecognitionResult* final_result = client_stream_finalize(stream);
+        check(final_result != nullptr, "the daemon finalizes the stream");
+
+        // Results pushed before the final one are queued by now
+        std::vector<IdResult> actual;
+        while (RecognitionResult* result = client_stream_poll_result(stream, 0)) {
+            actual.push_back(from_client(result));
+            client_free_result(result);
+        }
+        if (final_result) {
+            actual.push_back(from_client(final_result));
+            client_free_result(final_result);
+        }
+
+        check(actual.size() == expected.size(), "one client result per in-process result (" +
+                                                    std::to_string(actual.size()) + " and " +
+                                                    std::to_string(expected.size()) + ")");
+        bool provisional = false;
+        for (size_t i = 0; i < actual.size() && i < expected.size(); ++i) {
+            check_same(decoder, expected[i], actual[i], "result " + std::to_string(i));
+            provisional = provisional || !expected[i].unstable_tokens.empty();
+        }
+        check(provisional, "some results have an unstable tail");
+        client_stream_destroy(stream);
+    }
+
+    // Destroy streams while their window results are still arriving
+    for (int i = 0; i < 20; ++i) {
+        ClientStreamHandle doomed = client_stream_create(client);
+        if (!doomed) {
+            check(false, "the daemon opens a stream to destroy");
+            break;
+        }
+        client_stream_push_frames(doomed, frames.data(), num_frames, mask.data());
+        client_stream_destroy(doomed);
+    }
+    ClientStreamHandle after = client_stream_create(client);
+    check(after != nullptr, "the connection is usable after destroying streams mid-stream");
+    if (after) {
+        client_stream_set_windowing(after, &windowing);
+        client_stream_push_frames(after, frames.data(), num_frames, mask.data());
+        RecognitionResult* result = client_stream_finalize(after);
+        check(result != nullptr && !expected.empty() && from_client(result).tokens == expected.back().tokens,
+              "a later stream decodes like the first");
+        client_free_result(result);
+        client_stream_destroy(after);
+    }
+
+    client_disconnect(client);
+    stream_destroy(local);
+    decoder_destroy(decoder);
+    stop_daemon();
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "Daemon results match the in-process stream on " << num_frames << " frames (seed " << seed
+              << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * Offline-against-streaming test of WindowProcessor::decode_sequence
+ *
+ * Usage:
+ *   test_decode_sequence [frames] [seed]
+ *
+ * Random frames with dropped frames mixed in (alone and in runs) are
+ * streamed through a WindowProcessor (push_frame, process_window on each
+ * ready window, finalize) and decoded in one call, on the stateless model
+ * of test_assets.h and on the synthetic stateful model. For sequences from
+ * one frame to a few hundred:
+ * - decode_sequence() of the frames, on one and on several threads, gives
+ *   the last committed streaming result: the same phones, word timings,
+ *   frame count, confidence and best path
+ * - decode_sequence() of the same frames as a flat block with a valid mask
+ *   gives the same result
+ */
+
+#include "test_support.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::DecoderConfig;
+using cued_speech::FrameFeatures;
+using cued_speech::RecognitionResult;
+using cued_speech::TestAssets;
+using cued_speech::TFLiteSequenceModel;
+using cued_speech::WindowProcessor;
+using cued_speech::WordTiming;
+using cued_speech::test::check;
+
+namespace {
+
+using Frames = std::vector<FrameFeatures>;
+
+/**
+ * Random frames, about one in eight dropped and some dropped in runs
+ */
+Frames random_stream(std::mt19937& rng, int count) {
+    std::uniform_int_distribution<int> kind_dist(0, 99);
+    std::uniform_int_distribution<int> run_dist(2, 12);
+    Frames frames;
+    while (static_cast<int>(frames.size()) < count) {
+        const int kind = kind_dist(rng);
+        if (kind < 10) {
+            frames.emplace_back();
+        } else if (kind < 13) {
+            frames.resize(std::min<size_t>(count, frames.size() + run_dist(rng)));
+        } else {
+            frames.push_back(cued_speech::test::random_frame(rng));
+        }
+    }
+    return frames;
+}
+
+/**
+ * Frames as a flat [count x kFrameFeatureSize] block (zeros for dropped
+ * frames) and their valid mask
+ */
+void flatten(const Frames& frames, std::vector<float>& flat, std::vector<uint8_t>& mask) {
+    flat.assign(frames.size() * cued_speech::kFrameFeatureSize, 0.0f);
+    mask.assign(frames.size(), 0);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!frames[i].is_valid()) {
+            continue;
+        }
+        mask[i] = 1;
+        float* out = flat.data() + i * cued_speech::kFrameFeatureSize;
+        for (const auto* values : {&frames[i].hand_shape, &frames[i].hand_position, &frames[i].lips}) {
+            out = std::copy(values->begin(), values->end(), out);
+        }
+    }
+}
+
+/**
+ * Result and best path of the last committed streaming decode
+ */
+struct Committed {
+    RecognitionResult result;
+    std::vector<int> tokens;
+};
+
+Committed stream(WindowProcessor& processor, const Frames& frames) {
+    Committed committed;
+    committed.result.confidence = 0.0f;
+    processor.reset();
+    auto keep_if_committed = [&](RecognitionResult result, int chunks_before) {
+        if (processor.chunks_processed() > chunks_before) {
+            committed.result = std::move(result);
+            committed.tokens = processor.last_hypothesis().tokens;
+        }
+    };
+    for (const auto& frame : frames) {
+        if (processor.push_frame(frame)) {
+            while (processor.ready_windows() > 0) {
+                const int chunks = processor.chunks_processed();
+                keep_if_committed(processor.process_window(), chunks);
+            }
+        }
+    }
+    const int chunks = processor.chunks_processed();
+    keep_if_committed(processor.finalize(), chunks);
+    committed.result.frame_number = processor.valid_frame_count();
+    return committed;
+}
+
+bool same_timings(const std::vector<WordTiming>& a, const std::vector<WordTiming>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const WordTiming& x, const WordTiming& y) {
+        return x.word == y.word && x.start_frame == y.start_frame && x.end_frame == y.end_frame;
+    });
+}
+
+void check_same(const Committed& expected, const RecognitionResult& actual, const std::vector<int>& tokens,
+                const std::string& what) {
+    check(actual.phoneme_ids == expected.result.phoneme_ids, what + ": phones match the streamed result");
+    check(same_timings(actual.word_timings, expected.result.word_timings),
+          what + ": word timings match the streamed result");
+    check(actual.frame_number == expected.result.frame_number, what + ": frame counts match");
+    const float scale = std::max(1.0f, std::abs(expected.result.confidence));
+    check(std::abs(actual.confidence - expected.result.confidence) <= 1e-4f * scale,
+          what + ": confidence matches the streamed result");
+    check(tokens == expected.tokens, what + ": best paths match");
+}
+
+void check_model(CTCDecoder& decoder, TFLiteSequenceModel& model, const std::string& label,
+                 const std::vector<Frames>& sequences) {
+    WindowProcessor streaming(&decoder, &model);
+    WindowProcessor offline(&decoder, &model);
+    std::vector<float> flat;
+    std::vector<uint8_t> mask;
+    for (const auto& frames : sequences) {
+        const std::string name = label + ", " + std::to_string(frames.size()) + " frames";
+        const Committed expected = stream(streaming, frames);
+        for (const int threads : {1, 4}) {
+            const RecognitionResult actual = offline.decode_sequence(frames, threads);
+            check_same(expected, actual, offline.last_hypothesis().tokens,
+                       name + ", " + std::to_string(threads) + " threads");
+        }
+        flatten(frames, flat, mask);
+        const RecognitionResult actual =
+            offline.decode_sequence(flat.data(), static_cast<int>(frames.size()), mask.data(), 4);
+        check_same(expected, actual, offline.last_hypothesis().tokens, name + ", flat block");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int num_frames = argc > 1 ? std::atoi(argv[1]) : 400;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate()) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+    const std::string stateful_path = temp.path("stateful.tflite");
+    try {
+        cued_speech::write_test_stateful_tflite_model(stateful_path, assets.vocab_size, seed);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to write the stateful test model: " << e.what() << std::endl;
+        return 1;
+    }
+
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.nbest = 1;
+    CTCDecoder decoder(config);
+    TFLiteSequenceModel stateless;
+    TFLiteSequenceModel stateful;
+    if (!decoder.initialize() || !stateless.load(assets.model_path) || !stateful.load(stateful_path)) {
+        std::cerr << "Failed to initialize the decoder or load the models" << std::endl;
+        return 1;
+    }
+
+    // Short sequences end inside the first window or right after it
+    std::mt19937 rng(seed);
+    std::vector<Frames> sequences;
+    for (const int count : {1, 9, 40, 101, num_frames}) {
+        sequences.push_back(random_stream(rng, count));
+    }
+    sequences.push_back(Frames(20));  // Only dropped frames
+
+    check_model(decoder, stateless, "stateless", sequences);
+    check_model(decoder, stateful, "stateful", sequences);
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "decode_sequence matches streaming on sequences of up to " << num_frames << " frames (seed "
+              << seed << ")" << std::endl;
+    return 0;
+}
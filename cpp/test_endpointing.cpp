@@ -0,0 +1,383 @@
+/**
+ * Utterance endpointing test of WindowProcessor
+ *
+ * Usage:
+ *   test_endpointing [seed]
+ *
+ * Streams speech, dropped-frame runs and silence through a WindowProcessor
+ * with endpointing configured and checks every utterance against a decode
+ * of its frames alone, with word timings shifted to valid frames since the
+ * start of the stream:
+ * - a run of endpoint_dropped_frames dropped frames ends an utterance (a
+ *   shorter run does not), once per run
+ * - endpoints buffered before any window runs are rebased as each earlier
+ *   utterance ends
+ * - endpoint_silence_frames committed silent frames end an utterance; a
+ *   history that is silent throughout restarts without an endpoint
+ * - a stateful model restarts from the zero state at each endpoint
+ * - reset() drops pending endpoints and the utterance offset
+ */
+
+#include "test_support.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::DecoderConfig;
+using cued_speech::FrameFeatures;
+using cued_speech::RecognitionResult;
+using cued_speech::TestAssets;
+using cued_speech::TFLiteSequenceModel;
+using cued_speech::WindowingConfig;
+using cued_speech::WindowingPolicy;
+using cued_speech::WindowProcessor;
+using cued_speech::test::check;
+using cued_speech::test::random_frame;
+using cued_speech::WordTiming;
+
+namespace {
+
+constexpr int kDroppedFrames = 10;   // endpoint_dropped_frames
+constexpr int kSilenceFrames = 30;   // endpoint_silence_frames
+
+using Frames = std::vector<FrameFeatures>;
+
+/**
+ * Blank + silence log-probability the (stateless) model gives one frame
+ */
+float silence_of(TFLiteSequenceModel& model, const CTCDecoder& decoder, const FrameFeatures& frame) {
+    const auto logits = model.infer({frame}, 0);
+    const int V = static_cast<int>(logits.size());
+    std::vector<float> log_probs(logits.size());
+    CTCDecoder::log_softmax(logits.data(), log_probs.data(), 1, V);
+    return decoder.silence_log_prob(log_probs.data(), V);
+}
+
+/**
+ * Valid frames of a stream, in order
+ */
+Frames valid_only(const Frames& stream) {
+    Frames valid;
+    std::copy_if(stream.begin(), stream.end(), std::back_inserter(valid),
+                 [](const FrameFeatures& frame) { return frame.is_valid(); });
+    return valid;
+}
+
+Frames slice(const Frames& frames, int begin, int end) {
+    return Frames(frames.begin() + begin, frames.begin() + end);
+}
+
+/**
+ * Decode of valid frames [begin, end) as one utterance from a fresh model,
+ * with word timings counted from valid frame 0
+ */
+struct Expected {
+    std::vector<int> phoneme_ids;
+    std::vector<WordTiming> word_timings;
+};
+
+Expected expected_utterance(CTCDecoder& decoder, TFLiteSequenceModel& model, const Frames& valid,
+                            int begin, int end) {
+    Expected expected;
+    model.reset_state();
+    const auto logits = model.infer(slice(valid, begin, end), 0);
+    const int T = end - begin;
+    const auto hypotheses = decoder.decode(logits.data(), T, static_cast<int>(logits.size()) / T);
+    if (hypotheses.empty()) {
+        return expected;
+    }
+    const auto& best = hypotheses[0];
+    expected.phoneme_ids = decoder.collapse_tokens(best.tokens);
+    for (size_t i = 0; i < best.words.size() && i < best.word_end_frames.size(); ++i) {
+        expected.word_timings.push_back(
+            {best.words[i], begin + best.word_start_frames[i], begin + best.word_end_frames[i]});
+    }
+    return expected;
+}
+
+bool matches(const RecognitionResult& result, const Expected& expected) {
+    if (result.phoneme_ids != expected.phoneme_ids ||
+        result.word_timings.size() != expected.word_timings.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.word_timings.size(); ++i) {
+        const WordTiming& a = result.word_timings[i];
+        const WordTiming& b = expected.word_timings[i];
+        if (a.word != b.word || a.start_frame != b.start_frame || a.end_frame != b.end_frame) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void describe(const RecognitionResult& result, const Expected& expected) {
+    auto print = [](const std::vector<WordTiming>& timings) {
+        for (const auto& timing : timings) {
+            std::cerr << ' ' << timing.word << '[' << timing.start_frame << ',' << timing.end_frame << ']';
+        }
+        std::cerr << std::endl;
+    };
+    std::cerr << "  streamed:";
+    print(result.word_timings);
+    std::cerr << "  expected:";
+    print(expected.word_timings);
+}
+
+void check_result(const RecognitionResult& result, const Expected& expected, const std::string& what) {
+    const bool ok = matches(result, expected);
+    check(ok, what);
+    if (!ok) {
+        describe(result, expected);
+    }
+}
+
+/**
+ * Run every window that is ready
+ */
+void drain(WindowProcessor& processor, std::vector<RecognitionResult>& results) {
+    while (processor.ready_windows() > 0) {
+        results.push_back(processor.process_window());
+    }
+}
+
+std::vector<RecognitionResult> stream(WindowProcessor& processor, const Frames& frames, bool drain_each) {
+    std::vector<RecognitionResult> results;
+    for (const auto& frame : frames) {
+        processor.push_frame(frame);
+        if (drain_each) {
+            drain(processor, results);
+        }
+    }
+    drain(processor, results);
+    results.push_back(processor.finalize());
+    return results;
+}
+
+std::vector<RecognitionResult> endpoints_of(const std::vector<RecognitionResult>& results) {
+    std::vector<RecognitionResult> endpoints;
+    std::copy_if(results.begin(), results.end(), std::back_inserter(endpoints),
+                 [](const RecognitionResult& result) { return result.endpoint; });
+    return endpoints;
+}
+
+void append(Frames& stream, const Frames& frames) {
+    stream.insert(stream.end(), frames.begin(), frames.end());
+}
+
+void append_dropped(Frames& stream, int count) {
+    stream.insert(stream.end(), count, FrameFeatures{});
+}
+
+/**
+ * Speech A (with a dropped run too short to end it), B and C separated by
+ * dropped runs: A ends after 150 valid frames, B after 270
+ */
+Frames dropped_endpoint_stream(std::mt19937& rng) {
+    auto speech = [&rng](int count) {
+        Frames frames;
+        for (int i = 0; i < count; ++i) {
+            frames.push_back(random_frame(rng, 1.0f));
+        }
+        return frames;
+    };
+    Frames frames;
+    append(frames, speech(80));
+    append_dropped(frames, kDroppedFrames / 2);
+    append(frames, speech(70));
+    append_dropped(frames, kDroppedFrames);
+    append(frames, speech(120));
+    append_dropped(frames, 2 * kDroppedFrames + 5);  // One endpoint however long the run
+    append(frames, speech(90));
+    return frames;
+}
+
+void test_dropped_endpoints(CTCDecoder& decoder, TFLiteSequenceModel& model, const Frames& frames,
+                            bool drain_each, const std::string& label) {
+    WindowingConfig windowing;
+    windowing.endpoint_dropped_frames = kDroppedFrames;
+    WindowProcessor processor(&decoder, &model, windowing);
+
+    const Frames valid = valid_only(frames);
+    const int total = static_cast<int>(valid.size());
+    const Expected a = expected_utterance(decoder, model, valid, 0, 150);
+    const Expected b = expected_utterance(decoder, model, valid, 150, 270);
+    const Expected c = expected_utterance(decoder, model, valid, 270, total);
+    check(!b.word_timings.empty() && !c.word_timings.empty(),
+          label + ": later utterances decode to words, so their offsets are checked");
+
+    // Twice: reset() in between must also drop pending endpoints
+    for (int pass = 0; pass < 2; ++pass) {
+        const std::string what = label + " (pass " + std::to_string(pass) + ")";
+        processor.reset();  // The expected decodes left state in the model
+        if (pass == 1) {
+            // Leave two endpoints pending in a processor that is then reset
+            for (const auto& frame : frames) {
+                processor.push_frame(frame);
+            }
+            processor.reset();
+        }
+
+        const auto results = stream(processor, frames, drain_each);
+        const auto endpoints = endpoints_of(results);
+        check(endpoints.size() == 2, what + ": two dropped runs give two endpoints, got " +
+                                         std::to_string(endpoints.size()));
+        if (endpoints.size() == 2) {
+            check_result(endpoints[0], a, what + ": first endpoint decodes utterance A");
+            check_result(endpoints[1], b, what + ": second endpoint decodes utterance B from valid frame 150");
+        }
+        check(!results.back().endpoint, what + ": finalize() is not an endpoint");
+        check_result(results.back(), c, what + ": finalize() decodes utterance C from valid frame 270");
+
+        // Every result after the first endpoint lies within B or C
+        bool after_first = false;
+        bool offsets_ok = true;
+        for (const auto& result : results) {
+            for (const auto& timing : result.word_timings) {
+                offsets_ok = offsets_ok && (!after_first || timing.start_frame >= 150);
+            }
+            after_first = after_first || result.endpoint;
+        }
+        check(offsets_ok, what + ": word timings after an endpoint start after it");
+    }
+}
+
+void test_silence_endpoint(CTCDecoder& decoder, TFLiteSequenceModel& model, std::mt19937& rng) {
+    // The most silent of many loud frames stands for silence; speech frames
+    // are kept only if the endpoint rule does not call them silent
+    FrameFeatures silent;
+    float silent_log_prob = -std::numeric_limits<float>::infinity();
+    for (int i = 0; i < 4000; ++i) {
+        FrameFeatures candidate = random_frame(rng, 3.0f);
+        const float log_prob = silence_of(model, decoder, candidate);
+        if (log_prob > silent_log_prob) {
+            silent = candidate;
+            silent_log_prob = log_prob;
+        }
+    }
+    WindowingConfig windowing;
+    windowing.endpoint_silence_frames = kSilenceFrames;
+    windowing.endpoint_log_prob = silent_log_prob - 0.05f;
+
+    auto speech = [&](int count) {
+        Frames frames;
+        while (static_cast<int>(frames.size()) < count) {
+            FrameFeatures frame = random_frame(rng, 1.0f);
+            if (silence_of(model, decoder, frame) < windowing.endpoint_log_prob - 0.05f) {
+                frames.push_back(frame);
+            }
+        }
+        return frames;
+    };
+    const int speech_frames = 150;
+    const int silent_frames = 240;
+    Frames frames = speech(speech_frames);
+    frames.insert(frames.end(), silent_frames, silent);
+    append(frames, speech(120));
+    const int total = static_cast<int>(frames.size());
+
+    // Restarts happen at the committed frame count of the window that
+    // completes the silent run; predict it from a copy of the policy
+    WindowProcessor processor(&decoder, &model, windowing);
+    std::vector<RecognitionResult> endpoints;
+    std::vector<int> endpoint_frames;
+    int restarts_without_speech = 0;
+    int utterance_start = 0;
+    for (const auto& frame : frames) {
+        processor.push_frame(frame);
+        while (processor.ready_windows() > 0) {
+            WindowingPolicy policy = processor.windowing();
+            const int buffered = processor.valid_frame_count() - utterance_start;
+            int committed = 0;
+            if (buffered >= policy.frames_needed()) {
+                policy.advance(policy.next_window(buffered));
+                committed = policy.committed_frames();
+            }
+            const RecognitionResult result = processor.process_window();
+            if (committed == 0 || processor.windowing().committed_frames() != 0) {
+                check(!result.endpoint, "only a restart reports a silence endpoint");
+                continue;
+            }
+            if (result.endpoint) {
+                check_result(result, expected_utterance(decoder, model, frames, utterance_start,
+                                                        utterance_start + committed),
+                             "silence endpoint decodes its utterance from valid frame " +
+                                 std::to_string(utterance_start));
+                endpoints.push_back(result);
+                endpoint_frames.push_back(utterance_start + committed);
+            } else {
+                ++restarts_without_speech;
+            }
+            utterance_start += committed;
+        }
+    }
+    const RecognitionResult last = processor.finalize();
+
+    check(endpoints.size() == 1, "one silence endpoint, got " + std::to_string(endpoints.size()));
+    if (!endpoint_frames.empty()) {
+        check(endpoint_frames[0] >= speech_frames + kSilenceFrames &&
+                  endpoint_frames[0] <= speech_frames + silent_frames,
+              "the silence endpoint falls in the silence after " + std::to_string(kSilenceFrames) +
+                  " frames (at " + std::to_string(endpoint_frames[0]) + ")");
+    }
+    check(restarts_without_speech >= 1, "silence left after the endpoint restarts without an endpoint");
+    check(utterance_start > speech_frames && utterance_start <= speech_frames + silent_frames,
+          "the last utterance starts in the silence");
+    check_result(last, expected_utterance(decoder, model, frames, utterance_start, total),
+                 "finalize() decodes the last utterance from valid frame " + std::to_string(utterance_start));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint32_t seed = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1;
+
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate()) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+    const std::string stateful_path = temp.path("stateful.tflite");
+    try {
+        cued_speech::write_test_stateful_tflite_model(stateful_path, assets.vocab_size, seed);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to write the stateful test model: " << e.what() << std::endl;
+        return 1;
+    }
+
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.nbest = 1;
+    CTCDecoder decoder(config);
+    TFLiteSequenceModel model;
+    TFLiteSequenceModel stateful;
+    if (!decoder.initialize() || !model.load(assets.model_path) || !stateful.load(stateful_path)) {
+        std::cerr << "Failed to load the decoder or the test models" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+    const Frames frames = dropped_endpoint_stream(rng);
+    test_dropped_endpoints(decoder, model, frames, true, "dropped-frame endpoints");
+    test_dropped_endpoints(decoder, model, frames, false, "buffered dropped-frame endpoints");
+    test_dropped_endpoints(decoder, stateful, frames, true, "stateful dropped-frame endpoints");
+    test_dropped_endpoints(decoder, stateful, frames, false, "stateful buffered dropped-frame endpoints");
+    test_silence_endpoint(decoder, model, rng);
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "Endpoints split the stream into utterances with stream-relative word timings (seed " << seed
+              << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * Producer/consumer test of the shared-memory frame ring
+ *
+ * Usage:
+ *   test_frame_ring [frames] [seed]
+ *
+ * The parent creates a small ring and produces; a forked child opens it by
+ * name and consumes, so both sides run in separate processes as in the
+ * capture/decoder setup:
+ * - frames pass through a ring much smaller than the stream (wrap-around)
+ *   in order, with their frame numbers, valid flags and features
+ * - both sides pause at random points, so the consumer sleeps on an empty
+ *   ring and the producer on a full one until the other side wakes it
+ * - a consumer blocked with no timeout returns once the producer closes,
+ *   after draining what was left
+ * In one process: close() with records still buffered, and the timeouts of
+ * peek() on an empty ring and reserve()/push() on a full one.
+ */
+
+#include "frame_ring.h"
+#include "test_support.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+using cued_speech::FrameRecord;
+using cued_speech::FrameRing;
+using cued_speech::kFrameRecordFeatures;
+using cued_speech::test::check;
+
+namespace {
+
+constexpr uint32_t kCapacity = 8;
+constexpr int kTimeoutMs = 20;
+
+// Features of frame i, so the consumer can check them without the producer
+float feature_value(uint64_t i, int k) {
+    return static_cast<float>(i % 1000) + 0.001f * static_cast<float>(k);
+}
+
+bool frame_valid(uint64_t i) {
+    return i % 7 != 3;
+}
+
+int32_t frame_number(uint64_t i) {
+    return static_cast<int32_t>(2 * i + 1);
+}
+
+std::string ring_name(const char* what) {
+    return "cued_speech_test_" + std::string(what) + "_" + std::to_string(::getpid());
+}
+
+void maybe_pause(std::mt19937& rng) {
+    // Long enough to get past the spin and into the futex wait
+    if (rng() % 512 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+/**
+ * Consumer side in the child; the exit status is the number of mismatches
+ */
+int consume(const std::string& name, uint64_t num_frames, uint32_t seed) {
+    auto ring = FrameRing::open(name);
+    if (!ring) {
+        std::cerr << "Child failed to open " << name << std::endl;
+        return 1;
+    }
+    std::mt19937 rng(seed + 1);
+    int errors = 0;
+    uint64_t received = 0;
+    while (const FrameRecord* record = ring->peek(-1)) {
+        const uint64_t i = received;
+        bool ok = record->sequence == i && record->frame_number == frame_number(i) &&
+                  (record->valid != 0) == frame_valid(i);
+        for (int k = 0; ok && record->valid && k < kFrameRecordFeatures; ++k) {
+            ok = record->features[k] == feature_value(i, k);
+        }
+        if (!ok && ++errors <= 5) {
+            std::cerr << "Child: record " << i << " arrived as sequence " << record->sequence << ", frame "
+                      << record->frame_number << ", valid " << record->valid << std::endl;
+        }
+        ring->release();
+        ++received;
+        maybe_pause(rng);
+    }
+    if (!ring->finished()) {
+        std::cerr << "Child: peek() without timeout returned before the ring finished" << std::endl;
+        ++errors;
+    }
+    if (received != num_frames) {
+        std::cerr << "Child: received " << received << " of " << num_frames << " frames" << std::endl;
+        ++errors;
+    }
+    return std::min(errors, 100);
+}
+
+void test_cross_process(uint64_t num_frames, uint32_t seed) {
+    const std::string name = ring_name("ring");
+    auto ring = FrameRing::create(name, kCapacity);
+    if (!ring) {
+        check(false, "create a shared-memory ring");
+        return;
+    }
+    check(ring->capacity() == kCapacity, "capacity is kept when it is a power of two");
+
+    const pid_t child = ::fork();
+    if (child < 0) {
+        check(false, "fork the consumer");
+        return;
+    }
+    if (child == 0) {
+        // Skip the destructors: the parent owns the ring
+        ::_exit(consume(name, num_frames, seed));
+    }
+
+    std::mt19937 rng(seed);
+    float features[kFrameRecordFeatures];
+    bool pushed_all = true;
+    for (uint64_t i = 0; i < num_frames && pushed_all; ++i) {
+        for (int k = 0; k < kFrameRecordFeatures; ++k) {
+            features[k] = feature_value(i, k);
+        }
+        if (i % 2 == 0) {
+            pushed_all = ring->push(features, frame_number(i), frame_valid(i), -1);
+        } else {
+            // Zero-copy path: fill the record in place
+            FrameRecord* record = ring->reserve(-1);
+            pushed_all = record != nullptr;
+            if (record) {
+                std::copy(features, features + kFrameRecordFeatures, record->features);
+                ring->commit(frame_number(i), frame_valid(i));
+            }
+        }
+        maybe_pause(rng);
+    }
+    check(pushed_all, "push() and reserve() without timeout succeed");
+
+    // Let the consumer drain and fall asleep before the close wakes it
+    std::this_thread::sleep_for(std::chrono::milliseconds(kTimeoutMs));
+    ring->close();
+
+    int status = 0;
+    const bool waited = ::waitpid(child, &status, 0) == child;
+    check(waited && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+          "consumer process receives every frame in order and finishes after close()");
+}
+
+void test_close_and_drain() {
+    const std::string name = ring_name("drain");
+    auto producer = FrameRing::create(name, 5);
+    auto consumer = producer ? FrameRing::open(name) : nullptr;
+    if (!producer || !consumer) {
+        check(false, "create and open a ring in one process");
+        return;
+    }
+    check(producer->capacity() == 8, "capacity rounds up to a power of two");
+
+    float features[kFrameRecordFeatures] = {};
+    for (uint64_t i = 0; i < 5; ++i) {
+        producer->push(features, frame_number(i), true, 0);
+    }
+    producer->close();
+    check(!consumer->finished(), "a closed ring with records left is not finished");
+    check(consumer->available() == 5, "records published before close() stay available");
+
+    uint64_t drained = 0;
+    while (const FrameRecord* record = consumer->peek(-1)) {
+        check(record->frame_number == frame_number(drained), "drained records keep their order");
+        consumer->release();
+        ++drained;
+    }
+    check(drained == 5, "the consumer drains every record after close()");
+    check(consumer->finished(), "a closed and drained ring is finished");
+    check(consumer->peek(kTimeoutMs) == nullptr, "peek() on a finished ring returns nothing");
+}
+
+void test_timeouts() {
+    const std::string name = ring_name("timeout");
+    auto producer = FrameRing::create(name, 4);
+    auto consumer = producer ? FrameRing::open(name) : nullptr;
+    if (!producer || !consumer) {
+        check(false, "create and open a ring in one process");
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+    auto elapsed_ms = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    check(consumer->peek(0) == nullptr, "peek(0) on an empty ring returns at once");
+    auto start = Clock::now();
+    check(consumer->peek(kTimeoutMs) == nullptr, "peek() on an empty ring times out");
+    check(elapsed_ms(start) >= kTimeoutMs * 0.9, "peek() waits for its timeout");
+
+    float features[kFrameRecordFeatures] = {};
+    for (uint64_t i = 0; i < producer->capacity(); ++i) {
+        check(producer->push(features, frame_number(i), true, 0), "push(0) succeeds while there is room");
+    }
+    check(!producer->push(features, 0, true, 0), "push(0) on a full ring fails at once");
+    start = Clock::now();
+    check(producer->reserve(kTimeoutMs) == nullptr, "reserve() on a full ring times out");
+    check(elapsed_ms(start) >= kTimeoutMs * 0.9, "reserve() waits for its timeout");
+
+    // Room again after one release; the ring still works after the timeouts
+    check(consumer->peek(0) != nullptr, "records are there after the producer timed out");
+    consumer->release();
+    check(producer->push(features, 42, false, 0), "push() succeeds once a record is released");
+    check(consumer->available() == producer->capacity(), "the ring holds capacity records again");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint64_t num_frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    test_cross_process(num_frames, seed);
+    test_close_and_drain();
+    test_timeouts();
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "Frame ring passed " << num_frames << " frames between processes through " << kCapacity
+              << " records (seed " << seed << ")" << std::endl;
+    return 0;
+}
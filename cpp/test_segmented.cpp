@@ -0,0 +1,215 @@
+/**
+ * Segmented decoding test of CTCDecoder
+ *
+ * Usage:
+ *   test_segmented [groups] [seed]
+ *
+ * Scripted log-probabilities spell groups of lexicon words separated by
+ * silence gaps, so find_segments() cuts in the gaps. With both engines:
+ * - decode_segmented() on one and on several threads finds the same words,
+ *   word frames and phones as decode_log_probs() over the whole utterance,
+ *   and the words fall on the frames where the script spelled them
+ * - the stitched hypothesis is the per-segment decodes put end to end: the
+ *   path keeps one step per frame plus the start and end steps, word frames
+ *   and timesteps are shifted by the segment start and the scores add up
+ * - without a cut decode_segmented() is decode_log_probs()
+ */
+
+#include "test_support.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::CTCHypothesis;
+using cued_speech::DecoderConfig;
+using cued_speech::DecoderEngine;
+using cued_speech::TestAssets;
+using cued_speech::test::check;
+using cued_speech::test::ScriptedPosteriors;
+
+namespace {
+
+struct Script {
+    std::vector<std::string> words;
+    std::vector<ScriptedPosteriors::Span> spans;
+    std::vector<std::pair<int, int>> gaps;  // Silence between groups, [first, last]
+};
+
+/**
+ * The stitched hypothesis expected from per-segment decodes
+ */
+CTCHypothesis stitch(CTCDecoder& decoder, const float* log_probs, int V, const std::vector<int>& bounds) {
+    CTCHypothesis stitched;
+    stitched.score = 0.0f;
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+        const int start = bounds[i];
+        const auto part = decoder.decode_log_probs(log_probs + static_cast<size_t>(start) * V,
+                                                   bounds[i + 1] - start, V);
+        if (part.empty() || part[0].tokens.size() < 2) {
+            return {};
+        }
+        const CTCHypothesis& best = part[0];
+        if (i == 0) {
+            stitched.tokens.push_back(best.tokens.front());
+        }
+        stitched.tokens.insert(stitched.tokens.end(), best.tokens.begin() + 1, best.tokens.end() - 1);
+        if (i + 2 == bounds.size()) {
+            stitched.tokens.push_back(best.tokens.back());
+        }
+        stitched.words.insert(stitched.words.end(), best.words.begin(), best.words.end());
+        for (const int frame : best.word_start_frames) {
+            stitched.word_start_frames.push_back(start + frame);
+        }
+        for (const int frame : best.word_end_frames) {
+            stitched.word_end_frames.push_back(start + frame);
+        }
+        for (const int step : best.timesteps) {
+            stitched.timesteps.push_back(start + step);
+        }
+        stitched.score += best.score;
+    }
+    return stitched;
+}
+
+void check_engine(const TestAssets& assets, DecoderEngine engine, const ScriptedPosteriors& posteriors,
+                  const Script& script) {
+    const std::string label = engine == DecoderEngine::Native ? "native: " : "flashlight: ";
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.engine = engine;
+    CTCDecoder whole(config);
+    config.segment_frames = 40;
+    config.segment_silence_frames = 10;
+    config.segment_log_prob = -0.05f;
+    CTCDecoder segmented(config);
+    if (!whole.initialize() || !segmented.initialize()) {
+        check(false, label + "initialize the decoders");
+        return;
+    }
+
+    const int T = posteriors.frames();
+    const int V = posteriors.vocab();
+    const std::vector<int> bounds = segmented.find_segments(posteriors.data(), T, V);
+    check(bounds.size() > 3, label + "the gaps cut the input into several segments (" +
+                                 std::to_string(bounds.size() - 1) + ")");
+    bool cuts_in_gaps = true;
+    for (size_t i = 1; i + 1 < bounds.size(); ++i) {
+        bool in_gap = false;
+        for (const auto& gap : script.gaps) {
+            in_gap = in_gap || (bounds[i] >= gap.first && bounds[i] <= gap.second);
+        }
+        cuts_in_gaps = cuts_in_gaps && in_gap;
+    }
+    check(cuts_in_gaps, label + "every cut lies in a silence gap");
+
+    const auto reference = whole.decode_log_probs(posteriors.data(), T, V);
+    if (reference.empty()) {
+        check(false, label + "the whole utterance decodes");
+        return;
+    }
+    const CTCHypothesis& full = reference[0];
+    check(full.words == script.words, label + "the whole utterance decodes to the scripted words");
+    bool on_script = full.word_start_frames.size() == script.spans.size() &&
+                     full.word_end_frames.size() == script.spans.size();
+    for (size_t i = 0; on_script && i < script.spans.size(); ++i) {
+        on_script = full.word_start_frames[i] == script.spans[i].start &&
+                    full.word_end_frames[i] == script.spans[i].end;
+    }
+    check(on_script, label + "each word starts on its first phone and ends on its last");
+
+    const CTCHypothesis expected = stitch(segmented, posteriors.data(), V, bounds);
+    for (const int threads : {1, 4}) {
+        const std::string what = label + std::to_string(threads) + " threads: ";
+        const auto result = segmented.decode_segmented(posteriors.data(), T, V, threads);
+        if (result.size() != 1) {
+            check(false, what + "one stitched hypothesis");
+            continue;
+        }
+        const CTCHypothesis& hyp = result[0];
+        check(hyp.tokens.size() == static_cast<size_t>(T) + 2, what + "the stitched path has T + 2 steps");
+        check(hyp.words == full.words, what + "segmented words match the whole decode");
+        check(hyp.word_start_frames == full.word_start_frames && hyp.word_end_frames == full.word_end_frames,
+              what + "segmented word frames match the whole decode");
+        check(segmented.collapse_tokens(hyp.tokens) == whole.collapse_tokens(full.tokens),
+              what + "segmented phones match the whole decode");
+
+        check(hyp.tokens == expected.tokens, what + "the path is the segment paths end to end");
+        check(hyp.word_start_frames == expected.word_start_frames &&
+                  hyp.word_end_frames == expected.word_end_frames,
+              what + "word frames are shifted by the segment start");
+        check(hyp.timesteps == expected.timesteps, what + "timesteps are shifted by the segment start");
+        check(std::abs(hyp.score - expected.score) <= 1e-4f * std::max(1.0f, std::abs(expected.score)),
+              what + "the score is the sum of the segment scores");
+    }
+
+    // A single segment is the plain decode
+    const auto single = whole.decode_segmented(posteriors.data(), T, V, 4);
+    check(single.size() == 1 && single[0].tokens == full.tokens && single[0].words == full.words &&
+              single[0].score == full.score,
+          label + "without segment_frames the decode is not split");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int num_groups = argc > 1 ? std::atoi(argv[1]) : 12;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    cued_speech::TestAssetConfig asset_config;
+    asset_config.unique_spellings = true;
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate(asset_config)) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    CTCDecoder decoder(config);
+    if (!decoder.initialize()) {
+        std::cerr << "Failed to initialize the decoder" << std::endl;
+        return 1;
+    }
+
+    // Groups of 2-5 words with 1-3 blank frames after each phone (too short
+    // to cut), separated by 20-40 frames of blank
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> word_dist(0, assets.words.size() - 1);
+    std::uniform_int_distribution<int> group_dist(2, 5);
+    std::uniform_int_distribution<int> gap_dist(1, 3);
+    std::uniform_int_distribution<int> pause_dist(20, 40);
+    ScriptedPosteriors posteriors(decoder, seed);
+    Script script;
+    for (int g = 0; g < num_groups; ++g) {
+        for (int n = group_dist(rng); n > 0; --n) {
+            const size_t w = word_dist(rng);
+            script.words.push_back(assets.words[w]);
+            script.spans.push_back(posteriors.add_word(assets.spellings[w], 1, gap_dist(rng)));
+        }
+        const int first = posteriors.frames();
+        posteriors.add(config.blank_token, pause_dist(rng));
+        script.gaps.emplace_back(first, posteriors.frames() - 1);
+    }
+
+    check_engine(assets, DecoderEngine::Flashlight, posteriors, script);
+    check_engine(assets, DecoderEngine::Native, posteriors, script);
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "Segmented decoding matches the whole decode on " << posteriors.frames() << " frames (seed "
+              << seed << ")" << std::endl;
+    return 0;
+}
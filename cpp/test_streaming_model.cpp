@@ -0,0 +1,177 @@
+/**
+ * Stream-equivalence test of stateful sequence models
+ *
+ * Usage:
+ *   test_streaming_model [frames] [seed]
+ *
+ * On the synthetic stateful model of test_assets.h, whose running sum makes
+ * every logit depend on all earlier frames:
+ * - the state input is found and paired with state_out by name, although the
+ *   model lists state_out before the logits
+ * - chunks inferred in order with the carried state give the logits of one
+ *   pass over the whole sequence, and reset_state() starts over
+ * - a WindowProcessor streaming the frames (commit_size new frames per
+ *   window, no overlap) finalizes to the decode of that single pass
+ * - the same graph without the state input (three inputs, two outputs)
+ *   loads as a stateless model
+ */
+
+#include "test_support.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::DecoderConfig;
+using cued_speech::FrameFeatures;
+using cued_speech::RecognitionResult;
+using cued_speech::TestAssets;
+using cued_speech::TFLiteSequenceModel;
+using cued_speech::WindowProcessor;
+using cued_speech::test::check;
+
+namespace {
+
+std::vector<FrameFeatures> random_frames(std::mt19937& rng, int count) {
+    std::vector<FrameFeatures> frames;
+    for (int i = 0; i < count; ++i) {
+        frames.push_back(cued_speech::test::random_frame(rng));
+    }
+    return frames;
+}
+
+/**
+ * Largest difference between two logit blocks, relative to their magnitude
+ */
+float max_relative_error(const std::vector<float>& expected, const std::vector<float>& actual) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < expected.size() && i < actual.size(); ++i) {
+        const float scale = std::max(1.0f, std::abs(expected[i]));
+        worst = std::max(worst, std::abs(expected[i] - actual[i]) / scale);
+    }
+    return worst;
+}
+
+std::vector<float> infer_chunked(TFLiteSequenceModel& model, const std::vector<FrameFeatures>& frames,
+                                 int chunk) {
+    std::vector<float> logits;
+    model.reset_state();
+    for (size_t start = 0; start < frames.size(); start += chunk) {
+        const size_t end = std::min(frames.size(), start + chunk);
+        const std::vector<FrameFeatures> part(frames.begin() + start, frames.begin() + end);
+        const auto part_logits = model.infer(part, 0);
+        logits.insert(logits.end(), part_logits.begin(), part_logits.end());
+    }
+    return logits;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int num_frames = argc > 1 ? std::atoi(argv[1]) : 300;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate()) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+    const std::string stateful_path = temp.path("stateful.tflite");
+    const std::string stateless_path = temp.path("two_outputs.tflite");
+    try {
+        cued_speech::write_test_stateful_tflite_model(stateful_path, assets.vocab_size, seed);
+        cued_speech::write_test_stateful_tflite_model(stateless_path, assets.vocab_size, seed, false);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to write the stateful test models: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+    const auto frames = random_frames(rng, num_frames);
+    const int vocab = assets.vocab_size;
+
+    // Three inputs and two outputs: stateless, logits found by name
+    TFLiteSequenceModel stateless;
+    check(stateless.load(stateless_path), "three-input model with two outputs loads");
+    check(!stateless.is_stateful(), "three-input model is stateless");
+    const auto stateless_logits = stateless.infer(frames, 0);
+    check(stateless.vocab_size() == vocab, "three-input model outputs the logits, not the running sum");
+
+    TFLiteSequenceModel model;
+    if (!model.load(stateful_path)) {
+        std::cerr << "Failed to load the stateful model" << std::endl;
+        return 1;
+    }
+    check(model.is_stateful(), "model with a state input is stateful");
+
+    // One pass from the zero state: the stateless graph computes the same
+    model.reset_state();
+    const auto full = model.infer(frames, 0);
+    check(full.size() == static_cast<size_t>(num_frames) * vocab, "full pass has one row per frame");
+    check(max_relative_error(stateless_logits, full) < 1e-5f, "zero state matches the stateless graph");
+
+    for (const int chunk : {1, 7, 50}) {
+        const auto chunked = infer_chunked(model, frames, chunk);
+        check(chunked.size() == full.size(), "chunks of " + std::to_string(chunk) + " cover every frame");
+        const float error = max_relative_error(full, chunked);
+        check(error < 1e-4f, "chunks of " + std::to_string(chunk) + " match the full pass (error " +
+                                 std::to_string(error) + ")");
+    }
+
+    // Without reset_state() the second pass starts from the carried state
+    model.reset_state();
+    const std::vector<FrameFeatures> head(frames.begin(), frames.begin() + std::min(num_frames, 10));
+    const auto first = model.infer(head, 0);
+    const auto carried = model.infer(head, 0);
+    model.reset_state();
+    const auto restarted = model.infer(head, 0);
+    check(max_relative_error(first, restarted) < 1e-6f, "reset_state() restarts from the zero state");
+    check(max_relative_error(first, carried) > 1e-3f, "state is carried between calls");
+
+    // Streaming WindowProcessor against a decode of the single pass
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.nbest = 1;
+    CTCDecoder decoder(config);
+    if (!decoder.initialize()) {
+        std::cerr << "Failed to initialize the decoder" << std::endl;
+        return 1;
+    }
+    const auto expected = decoder.decode(full.data(), num_frames, vocab);
+
+    WindowProcessor processor(&decoder, &model);
+    check(processor.windowing().streaming(), "a stateful model switches windowing to streaming");
+    for (int pass = 0; pass < 2; ++pass) {
+        processor.reset();  // Also resets the model state
+        int windows = 0;
+        for (const auto& frame : frames) {
+            if (processor.push_frame(frame)) {
+                processor.process_window();
+                ++windows;
+            }
+        }
+        const RecognitionResult result = processor.finalize();
+        check(!expected.empty(), "single pass decodes");
+        if (!expected.empty()) {
+            check(result.phoneme_ids == decoder.collapse_tokens(expected[0].tokens),
+                  "streamed result matches the single pass (pass " + std::to_string(pass) + ", " +
+                      std::to_string(windows) + " windows)");
+        }
+    }
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "Stateful model streams " << num_frames << " frames like a single pass (seed " << seed << ")"
+              << std::endl;
+    return 0;
+}
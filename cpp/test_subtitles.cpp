@@ -0,0 +1,104 @@
+/**
+ * Subtitle timing test of format_subtitles
+ *
+ * Usage:
+ *   test_subtitles
+ *
+ * Results count frames and word timings in valid frames. On a stream whose
+ * valid mask has a gap of dropped frames:
+ * - with SubtitleOptions::stream_frames, word cues (including a word that
+ *   spans the gap and words re-decoded by a later result) and sentence cues
+ *   are timed on the stream, and frames past the map keep their distance to
+ *   its last entry
+ * - without it, frames are taken as stream frames
+ */
+
+#include "decoder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using cued_speech::RecognitionResult;
+using cued_speech::SubtitleFormat;
+using cued_speech::SubtitleOptions;
+using cued_speech::WordTiming;
+
+namespace {
+
+int g_failures = 0;
+
+void check_text(const std::string& actual, const std::string& expected, const std::string& what) {
+    if (actual != expected) {
+        ++g_failures;
+        std::cerr << "FAILED: " << what << "\n  got:\n" << actual << "\n  expected:\n" << expected << std::endl;
+    }
+}
+
+RecognitionResult result(int frame_number, std::vector<WordTiming> timings) {
+    RecognitionResult r;
+    r.frame_number = frame_number;
+    r.confidence = 0.0f;
+    for (const auto& timing : timings) {
+        r.phonemes.push_back(timing.word);
+    }
+    r.word_timings = std::move(timings);
+    return r;
+}
+
+} // namespace
+
+int main() {
+    // 20 valid frames, 30 dropped, 20 valid: valid frame 20 is stream frame 50
+    std::vector<uint8_t> mask(70, 1);
+    std::fill(mask.begin() + 20, mask.begin() + 50, 0);
+    const double fps = 10.0;
+
+    std::deque<RecognitionResult> results;
+    results.push_back(result(20, {{"bonjour", 2, 8}, {"le", 12, 15}}));
+    results.push_back(result(40, {{"chat", 17, 24}, {"dort", 26, 30}}));
+
+    SubtitleOptions options;
+    options.word_timings = true;
+    options.stream_frames = cued_speech::stream_frames_of(mask.data(), static_cast<int>(mask.size()));
+    check_text(cued_speech::format_subtitles(results, fps, options),
+               "1\n00:00:00,200 --> 00:00:00,900\nbonjour\n\n"
+               "2\n00:00:01,200 --> 00:00:01,600\nle\n\n"
+               "3\n00:00:01,700 --> 00:00:05,500\nchat\n\n"
+               "4\n00:00:05,600 --> 00:00:06,100\ndort\n\n",
+               "word cues are timed on the stream across the gap");
+
+    options.format = SubtitleFormat::WebVTT;
+    options.word_timings = false;
+    check_text(cued_speech::format_subtitles(results, fps, options),
+               "WEBVTT\n\n"
+               "00:00:01.900 --> 00:00:06.900\nbonjour le\n\n"
+               "00:00:06.900 --> 00:00:09.900\nchat dort\n\n",
+               "sentence cues start on the stream frame of their last valid frame");
+
+    // Valid frames past the map (here 45, the 6th after its last entry)
+    std::deque<RecognitionResult> late = {result(46, {{"encore", 45, 45}})};
+    options.format = SubtitleFormat::SRT;
+    options.word_timings = true;
+    check_text(cued_speech::format_subtitles(late, fps, options),
+               "1\n00:00:07,500 --> 00:00:07,600\nencore\n\n",
+               "frames past the map follow its last entry");
+
+    options.stream_frames.clear();
+    check_text(cued_speech::format_subtitles(results, fps, options),
+               "1\n00:00:00,200 --> 00:00:00,900\nbonjour\n\n"
+               "2\n00:00:01,200 --> 00:00:01,600\nle\n\n"
+               "3\n00:00:01,700 --> 00:00:02,500\nchat\n\n"
+               "4\n00:00:02,600 --> 00:00:03,100\ndort\n\n",
+               "without stream_frames frames are stream frames");
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "Subtitle cues are timed on the stream" << std::endl;
+    return 0;
+}
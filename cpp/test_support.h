@@ -0,0 +1,186 @@
+/**
+ * Cued Speech Decoder - Shared helpers of the test executables
+ *
+ * Failure counting, random frames, scripted log-probabilities and a
+ * temporary directory of synthetic assets (test_assets.h) that is removed
+ * when the test ends. Each test is one executable that includes this header
+ * once.
+ */
+
+#ifndef CUED_SPEECH_TEST_SUPPORT_H
+#define CUED_SPEECH_TEST_SUPPORT_H
+
+#include "decoder.h"
+#include "test_assets.h"
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace cued_speech {
+namespace test {
+
+/**
+ * Number of failed checks so far
+ */
+inline int g_failures = 0;
+
+/**
+ * Count and report a failed check
+ */
+inline void check(bool condition, const std::string& what) {
+    if (!condition) {
+        ++g_failures;
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+}
+
+/**
+ * Exit status of a test: 1 (after reporting the count) if a check failed
+ */
+inline int exit_status(uint32_t seed) {
+    if (g_failures > 0) {
+        std::cerr << g_failures << " checks failed (seed " << seed << ")" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Valid frame with every feature uniform in [-scale, scale]
+ */
+inline FrameFeatures random_frame(std::mt19937& rng, float scale = 1.0f) {
+    std::uniform_real_distribution<float> uniform(-scale, scale);
+    FrameFeatures frame;
+    frame.hand_shape.resize(7);
+    frame.hand_position.resize(18);
+    frame.lips.resize(8);
+    for (auto* values : {&frame.hand_shape, &frame.hand_position, &frame.lips}) {
+        for (float& v : *values) {
+            v = uniform(rng);
+        }
+    }
+    return frame;
+}
+
+/**
+ * Log-probabilities [frames x vocab] written row by row from a script
+ *
+ * Each row puts almost all of its mass on one token (peak over uniform noise
+ * in [0, 1), so no two candidates tie), which the beam search then follows.
+ */
+class ScriptedPosteriors {
+public:
+    /**
+     * Frames [start, end] of a spelled word, end being the last frame of its
+     * last phone
+     */
+    struct Span {
+        int start = 0;
+        int end = 0;
+    };
+
+    ScriptedPosteriors(const CTCDecoder& decoder, uint32_t seed, float peak = 9.0f)
+        : decoder_(decoder), rng_(seed), peak_(peak), vocab_(decoder.get_vocab_size()) {}
+
+    /**
+     * count rows peaking on token
+     */
+    void add(const std::string& token, int count) {
+        const int index = decoder_.token_to_idx(token);
+        std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+        std::vector<float> logits(vocab_);
+        for (int i = 0; i < count; ++i) {
+            for (float& logit : logits) {
+                logit = noise(rng_);
+            }
+            logits[index] += peak_;
+            const size_t offset = log_probs_.size();
+            log_probs_.resize(offset + vocab_);
+            CTCDecoder::log_softmax(logits.data(), log_probs_.data() + offset, 1, vocab_);
+        }
+    }
+
+    /**
+     * Spell a word: each phone for hold rows followed by gap blank rows (so
+     * doubled phones stay apart), then one "_" row. Single-row phones are
+     * the spikes of a trained CTC model; a last phone held longer costs the
+     * search a frame after the word is emitted.
+     */
+    Span add_word(const std::vector<std::string>& spelling, int hold = 1, int gap = 1) {
+        Span span;
+        span.start = frames();
+        for (const auto& phone : spelling) {
+            add(phone, hold);
+            span.end = frames() - 1;
+            add(decoder_.config().blank_token, gap);
+        }
+        add(decoder_.config().sil_token, 1);
+        return span;
+    }
+
+    const float* data() const { return log_probs_.data(); }
+    int frames() const { return vocab_ > 0 ? static_cast<int>(log_probs_.size() / vocab_) : 0; }
+    int vocab() const { return vocab_; }
+
+private:
+    const CTCDecoder& decoder_;
+    std::mt19937 rng_;
+    float peak_;
+    int vocab_;
+    std::vector<float> log_probs_;
+};
+
+/**
+ * Synthetic assets in a fresh temporary directory, removed with the object
+ */
+class TempAssets {
+public:
+    TempAssets()
+        : dir_(std::filesystem::temp_directory_path() /
+               ("cued_speech_test_" + std::to_string(std::random_device{}()))) {}
+
+    ~TempAssets() {
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    TempAssets(const TempAssets&) = delete;
+    TempAssets& operator=(const TempAssets&) = delete;
+
+    /**
+     * Generate the assets into the directory
+     *
+     * @return false (after printing why) if they could not be written
+     */
+    bool generate(const TestAssetConfig& config = {}) {
+        try {
+            assets_ = generate_test_assets(dir_.string(), config);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to generate test assets: " << e.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Path of a further file in the directory
+     */
+    std::string path(const std::string& name) const { return (dir_ / name).string(); }
+
+    const TestAssets& assets() const { return assets_; }
+
+private:
+    std::filesystem::path dir_;
+    TestAssets assets_;
+};
+
+} // namespace test
+} // namespace cued_speech
+
+#endif // CUED_SPEECH_TEST_SUPPORT_H
@@ -0,0 +1,191 @@
+/**
+ * Differential fuzz test for fold_to_ascii
+ *
+ * Usage:
+ *   test_transliteration [iterations] [seed]
+ *
+ * Random byte strings biased towards accented French, stray UTF-8 lead and
+ * continuation bytes and non-Latin sequences are folded by the table-driven
+ * fold_to_ascii and by the previous remove_accents algorithm (a scan trying
+ * every replacement at every byte). With the original 36 replacements the
+ * outputs must match on text those replacements cover; with the full table
+ * they must match on any input.
+ */
+
+#include "transliteration.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using cued_speech::ascii_fold_of;
+using cued_speech::fold_to_ascii;
+
+namespace {
+
+using ReplacementMap = std::unordered_map<std::string, std::string>;
+
+// Replacements of the original remove_accents
+const ReplacementMap& legacy_replacements() {
+    static const ReplacementMap replacements = {
+        {"\xC3\x80", "A"}, {"\xC3\x81", "A"}, {"\xC3\x82", "A"}, {"\xC3\x83", "A"},
+        {"\xC3\x84", "A"}, {"\xC3\x87", "C"}, {"\xC3\x88", "E"}, {"\xC3\x89", "E"},
+        {"\xC3\x8A", "E"}, {"\xC3\x8B", "E"}, {"\xC3\x8E", "I"}, {"\xC3\x8F", "I"},
+        {"\xC3\x94", "O"}, {"\xC3\x96", "O"}, {"\xC3\x99", "U"}, {"\xC3\x9B", "U"},
+        {"\xC3\x9C", "U"}, {"\xC3\xA0", "a"}, {"\xC3\xA1", "a"}, {"\xC3\xA2", "a"},
+        {"\xC3\xA3", "a"}, {"\xC3\xA4", "a"}, {"\xC3\xA7", "c"}, {"\xC3\xA8", "e"},
+        {"\xC3\xA9", "e"}, {"\xC3\xAA", "e"}, {"\xC3\xAB", "e"}, {"\xC3\xAE", "i"},
+        {"\xC3\xAF", "i"}, {"\xC3\xB4", "o"}, {"\xC3\xB6", "o"}, {"\xC3\xB9", "u"},
+        {"\xC3\xBB", "u"}, {"\xC3\xBC", "u"}, {"\xC5\x92", "OE"}, {"\xC5\x93", "oe"}
+    };
+    return replacements;
+}
+
+// Every two-byte sequence the table folds
+ReplacementMap table_replacements() {
+    ReplacementMap replacements;
+    for (int lead = 0x80; lead <= 0xFF; ++lead) {
+        for (int trail = 0x00; trail <= 0xFF; ++trail) {
+            if (const char* folded = ascii_fold_of(static_cast<unsigned char>(lead),
+                                                   static_cast<unsigned char>(trail))) {
+                replacements[{static_cast<char>(lead), static_cast<char>(trail)}] = folded;
+            }
+        }
+    }
+    return replacements;
+}
+
+// The original remove_accents loop
+std::string reference_fold(const std::string& input, const ReplacementMap& replacements) {
+    std::string output;
+    for (size_t i = 0; i < input.size();) {
+        bool replaced = false;
+        for (const auto& kv : replacements) {
+            const auto& key = kv.first;
+            if (input.compare(i, key.size(), key) == 0) {
+                output.append(kv.second);
+                i += key.size();
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) {
+            output.push_back(input[i]);
+            ++i;
+        }
+    }
+    return output;
+}
+
+std::string random_input(std::mt19937& rng, const std::vector<std::string>& pieces, bool raw_bytes) {
+    std::uniform_int_distribution<int> length_dist(0, 64);
+    std::uniform_int_distribution<size_t> piece_dist(0, pieces.size() - 1);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    std::uniform_int_distribution<int> kind_dist(0, 9);
+
+    std::string input;
+    const int length = length_dist(rng);
+    for (int i = 0; i < length; ++i) {
+        if (raw_bytes && kind_dist(rng) == 0) {
+            input.push_back(static_cast<char>(byte_dist(rng)));
+        } else {
+            input += pieces[piece_dist(rng)];
+        }
+    }
+    return input;
+}
+
+std::string escape(const std::string& text) {
+    static const char* const kHex = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char ch : text) {
+        if (ch >= 0x20 && ch < 0x7F && ch != '\\') {
+            out.push_back(static_cast<char>(ch));
+        } else {
+            out += "\\x";
+            out.push_back(kHex[ch >> 4]);
+            out.push_back(kHex[ch & 0xF]);
+        }
+    }
+    return out;
+}
+
+bool check(const char* name, const std::string& input, const ReplacementMap& replacements) {
+    const std::string expected = reference_fold(input, replacements);
+    const std::string actual = fold_to_ascii(input);
+    if (actual == expected) {
+        return true;
+    }
+    std::cerr << name << " mismatch\n"
+              << "  input:    \"" << escape(input) << "\"\n"
+              << "  expected: \"" << escape(expected) << "\"\n"
+              << "  actual:   \"" << escape(actual) << "\"" << std::endl;
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long iterations = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 200000;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    const ReplacementMap& legacy = legacy_replacements();
+    const ReplacementMap table = table_replacements();
+
+    // The table must keep every original replacement
+    for (const auto& kv : legacy) {
+        auto it = table.find(kv.first);
+        if (it == table.end() || it->second != kv.second) {
+            std::cerr << "Original replacement lost for \"" << escape(kv.first) << "\"" << std::endl;
+            return 1;
+        }
+    }
+
+    // Text the original replacements cover: ASCII, their keys, multi-byte
+    // sequences outside the table and lone lead bytes (no piece starts with a
+    // continuation byte, so pieces never combine into a newly folded pair)
+    std::vector<std::string> legacy_pieces = {
+        "a", "e", " ", ".", "'", "L", "\t", "0",
+        "\xE2\x82\xAC",          // euro sign
+        "\xE2\x80\x99",          // right single quotation mark
+        "\xF0\x9F\x98\x80",      // emoji
+        "\xC3",                  // lead byte followed by ASCII or another lead
+    };
+    for (const auto& kv : legacy) {
+        legacy_pieces.push_back(kv.first);
+    }
+
+    // Anything, including the extended ranges and malformed sequences
+    std::vector<std::string> table_pieces = legacy_pieces;
+    for (const auto& kv : table) {
+        table_pieces.push_back(kv.first);
+    }
+    for (const char* stray : {"\x80", "\xBF", "\xC2", "\xC4", "\xC5", "\xC0", "\xC1", "\xFF"}) {
+        table_pieces.push_back(stray);
+    }
+    table_pieces.push_back(std::string(24, 'x'));  // Long ASCII runs hit the word-at-a-time scan
+
+    std::mt19937 rng(seed);
+    long failures = 0;
+    for (long i = 0; i < iterations && failures < 10; ++i) {
+        const std::string legacy_input = random_input(rng, legacy_pieces, false);
+        if (!check("legacy", legacy_input, legacy)) {
+            ++failures;
+        }
+        if (!check("table", random_input(rng, table_pieces, true), table)) {
+            ++failures;
+        }
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " mismatches (seed " << seed << ")" << std::endl;
+        return 1;
+    }
+    std::cout << "fold_to_ascii matches the reference on " << iterations << " inputs (seed " << seed
+              << ", " << table.size() << " folded sequences)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,251 @@
+/**
+ * Two-pass streaming test of WindowProcessor
+ *
+ * Usage:
+ *   test_two_pass [frames] [seed]
+ *
+ * Streams speech broken up by silences (short ones that become cuts, long
+ * ones made of blank rows) through processors with two_pass_margin 0 (every
+ * window searches the whole history) and > 0:
+ * - every committed two-pass path has one step per committed frame plus the
+ *   start and end steps, also when the search was spliced after the stable
+ *   prefix or extended over blank rows without searching
+ * - some windows search no rows (the last search is reused over blank
+ *   rows) and some only the rows after a cut
+ * - finalize() gives the same result, and the beam search runs over fewer
+ *   rows in total
+ * - provisional updates in between do not change any committed result
+ */
+
+#include "test_support.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using cued_speech::CTCDecoder;
+using cued_speech::CTCHypothesis;
+using cued_speech::DecoderConfig;
+using cued_speech::FrameFeatures;
+using cued_speech::RecognitionResult;
+using cued_speech::TestAssets;
+using cued_speech::TFLiteSequenceModel;
+using cued_speech::WindowingConfig;
+using cued_speech::WindowProcessor;
+using cued_speech::test::check;
+using cued_speech::test::random_frame;
+
+namespace {
+
+constexpr int kMargin = 30;
+
+using Frames = std::vector<FrameFeatures>;
+
+/**
+ * Log-probabilities the model gives one frame
+ */
+std::vector<float> frame_log_probs(TFLiteSequenceModel& model, const FrameFeatures& frame) {
+    const auto logits = model.infer({frame}, 0);
+    std::vector<float> log_probs(logits.size());
+    CTCDecoder::log_softmax(logits.data(), log_probs.data(), 1, static_cast<int>(logits.size()));
+    return log_probs;
+}
+
+/**
+ * One committed or provisional result with the processor's state after it
+ */
+struct Step {
+    RecognitionResult result;
+    int committed_frames = 0;     // Rows of the utterance after the window
+    size_t path_length = 0;       // last_hypothesis().tokens.size()
+    uint64_t searched = 0;        // Rows the window ran through the beam search
+};
+
+struct Run {
+    std::vector<Step> steps;      // Committed windows only
+    RecognitionResult final_result;
+    size_t final_path_length = 0;
+    uint64_t searched_frames = 0;
+    int provisional_results = 0;
+};
+
+Run stream(WindowProcessor& processor, const Frames& frames) {
+    Run run;
+    processor.reset();
+    for (const auto& frame : frames) {
+        if (!processor.push_frame(frame)) {
+            continue;
+        }
+        const uint64_t searched_before = processor.stats().searched_frames;
+        Step step;
+        step.result = processor.process_window();
+        if (step.result.provisional) {
+            ++run.provisional_results;
+            continue;
+        }
+        step.committed_frames = processor.windowing().committed_frames();
+        step.path_length = processor.last_hypothesis().tokens.size();
+        step.searched = processor.stats().searched_frames - searched_before;
+        run.steps.push_back(std::move(step));
+    }
+    run.final_result = processor.finalize();
+    run.final_path_length = processor.last_hypothesis().tokens.size();
+    run.searched_frames = processor.stats().searched_frames;
+    return run;
+}
+
+bool same_result(const RecognitionResult& a, const RecognitionResult& b) {
+    if (a.phoneme_ids != b.phoneme_ids || a.word_timings.size() != b.word_timings.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.word_timings.size(); ++i) {
+        if (a.word_timings[i].word != b.word_timings[i].word ||
+            a.word_timings[i].start_frame != b.word_timings[i].start_frame ||
+            a.word_timings[i].end_frame != b.word_timings[i].end_frame) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int num_frames = argc > 1 ? std::atoi(argv[1]) : 1500;
+    const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+
+    cued_speech::test::TempAssets temp;
+    if (!temp.generate()) {
+        return 1;
+    }
+    const TestAssets& assets = temp.assets();
+
+    TFLiteSequenceModel model;
+    if (!model.load(assets.model_path)) {
+        std::cerr << "Failed to load the test model" << std::endl;
+        return 1;
+    }
+
+    DecoderConfig config;
+    config.tokens_path = assets.tokens_path;
+    config.lexicon_path = assets.lexicon_path;
+    config.lm_path = assets.lm_path;
+    config.nbest = 1;
+    config.segment_silence_frames = 10;
+    CTCDecoder probe(config);
+    if (!probe.initialize()) {
+        std::cerr << "Failed to initialize the decoder" << std::endl;
+        return 1;
+    }
+
+    // The most silent of many loud frames stands for silence; speech frames
+    // are kept only if the cut rule does not call them silent
+    std::mt19937 rng(seed);
+    FrameFeatures silent;
+    float silent_log_prob = -std::numeric_limits<float>::infinity();
+    for (int i = 0; i < 4000; ++i) {
+        const FrameFeatures candidate = random_frame(rng, 3.0f);
+        const auto log_probs = frame_log_probs(model, candidate);
+        const float log_prob = probe.silence_log_prob(log_probs.data(), static_cast<int>(log_probs.size()));
+        if (log_prob > silent_log_prob) {
+            silent = candidate;
+            silent_log_prob = log_prob;
+        }
+    }
+    config.segment_log_prob = silent_log_prob - 0.05f;
+
+    const auto silent_log_probs = frame_log_probs(model, silent);
+    const int silent_token = static_cast<int>(
+        std::max_element(silent_log_probs.begin(), silent_log_probs.end()) - silent_log_probs.begin());
+    check(silent_token == probe.token_to_idx(config.blank_token) ||
+              silent_token == probe.token_to_idx(config.sil_token),
+          "the silent frame's greedy token is blank or silence");
+
+    // Speech runs of 40-120 frames; between them a silence of 15-30 frames
+    // (a cut once speech resumes) or, every third gap, 150 frames that span
+    // whole windows of blank rows
+    Frames frames;
+    std::uniform_int_distribution<int> speech_length(40, 120);
+    std::uniform_int_distribution<int> short_silence(15, 30);
+    for (int gap = 0; static_cast<int>(frames.size()) < num_frames; ++gap) {
+        for (int n = speech_length(rng); n > 0;) {
+            FrameFeatures frame = random_frame(rng, 1.0f);
+            const auto log_probs = frame_log_probs(model, frame);
+            if (probe.silence_log_prob(log_probs.data(), static_cast<int>(log_probs.size())) <
+                config.segment_log_prob - 0.05f) {
+                frames.push_back(frame);
+                --n;
+            }
+        }
+        frames.insert(frames.end(), gap % 3 == 2 ? 150 : short_silence(rng), silent);
+    }
+
+    CTCDecoder decoder(config);
+    if (!decoder.initialize()) {
+        std::cerr << "Failed to initialize the decoder" << std::endl;
+        return 1;
+    }
+
+    WindowingConfig windowing;
+    WindowProcessor full(&decoder, &model, windowing);
+    windowing.two_pass_margin = kMargin;
+    WindowProcessor two_pass(&decoder, &model, windowing);
+    windowing.provisional_interval = 10;
+    WindowProcessor provisional(&decoder, &model, windowing);
+
+    const Run full_run = stream(full, frames);
+    const Run two_pass_run = stream(two_pass, frames);
+    const Run provisional_run = stream(provisional, frames);
+
+    check(same_result(full_run.final_result, two_pass_run.final_result),
+          "finalize() matches with and without two-pass");
+    check(same_result(full_run.final_result, provisional_run.final_result),
+          "finalize() matches after provisional two-pass updates");
+    check(two_pass_run.steps.size() == full_run.steps.size(), "both processors run the same windows");
+    check(provisional_run.provisional_results > 0, "provisional updates ran between windows");
+
+    int reused = 0;
+    int after_cut = 0;
+    for (size_t i = 0; i < two_pass_run.steps.size(); ++i) {
+        const Step& step = two_pass_run.steps[i];
+        const std::string where = "window " + std::to_string(i);
+        check(step.path_length == static_cast<size_t>(step.committed_frames) + 2,
+              where + ": two-pass path has " + std::to_string(step.path_length) + " steps for " +
+                  std::to_string(step.committed_frames) + " frames");
+        for (const auto& timing : step.result.word_timings) {
+            check(timing.start_frame <= timing.end_frame && timing.end_frame < step.committed_frames,
+                  where + ": word timings lie within the committed frames");
+        }
+        reused += step.searched == 0 ? 1 : 0;
+        after_cut += step.searched > 0 && step.searched < static_cast<uint64_t>(step.committed_frames) ? 1 : 0;
+
+        if (i < provisional_run.steps.size()) {
+            const Step& other = provisional_run.steps[i];
+            check(same_result(step.result, other.result) && other.path_length == step.path_length,
+                  where + ": provisional updates leave the committed result unchanged");
+        }
+    }
+    check(provisional_run.steps.size() == two_pass_run.steps.size(),
+          "provisional updates leave the windows unchanged");
+    check(reused > 0, "some windows extend the last search over blank rows");
+    check(after_cut > 0, "some windows only search the rows after a cut");
+    check(full_run.final_path_length == static_cast<size_t>(frames.size()) + 2 &&
+              two_pass_run.final_path_length == full_run.final_path_length,
+          "finalize() paths cover every frame");
+    check(two_pass_run.searched_frames < full_run.searched_frames,
+          "two-pass searches fewer rows (" + std::to_string(two_pass_run.searched_frames) + " vs " +
+              std::to_string(full_run.searched_frames) + ")");
+
+    if (cued_speech::test::exit_status(seed) != 0) {
+        return 1;
+    }
+    std::cout << "Two-pass streaming of " << frames.size() << " frames searched " << two_pass_run.searched_frames
+              << " rows instead of " << full_run.searched_frames << " (" << reused << " windows reused, "
+              << after_cut << " after a cut; seed " << seed << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * Cued Speech Decoder - ASCII transliteration
+ */
+
+#include "transliteration.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace cued_speech {
+
+namespace {
+
+constexpr unsigned char kFirstLead = 0xC2;   // U+0080
+constexpr unsigned char kLastLead = 0xC5;    // U+017F
+
+// Replacements for U+0080..U+017F, indexed by code point - 0x80
+const char* const kFoldTable[256] = {
+    // U+0080: C1 controls
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    // U+00A0: no-break space and French guillemets; other symbols are kept
+    " ",     nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, "\"",    nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, "\"",    nullptr, nullptr, nullptr, nullptr,
+    // U+00C0
+    "A",  "A",  "A",  "A",  "A",  "A",  "AE", "C",  "E",  "E",  "E",  "E",  "I",  "I",  "I",  "I",
+    "D",  "N",  "O",  "O",  "O",  "O",  "O",  nullptr, "O", "U", "U",  "U",  "U",  "Y",  "TH", "ss",
+    // U+00E0
+    "a",  "a",  "a",  "a",  "a",  "a",  "ae", "c",  "e",  "e",  "e",  "e",  "i",  "i",  "i",  "i",
+    "d",  "n",  "o",  "o",  "o",  "o",  "o",  nullptr, "o", "u", "u",  "u",  "u",  "y",  "th", "y",
+    // U+0100: Latin Extended-A
+    "A",  "a",  "A",  "a",  "A",  "a",  "C",  "c",  "C",  "c",  "C",  "c",  "C",  "c",  "D",  "d",
+    "D",  "d",  "E",  "e",  "E",  "e",  "E",  "e",  "E",  "e",  "E",  "e",  "G",  "g",  "G",  "g",
+    "G",  "g",  "G",  "g",  "H",  "h",  "H",  "h",  "I",  "i",  "I",  "i",  "I",  "i",  "I",  "i",
+    "I",  "i",  "IJ", "ij", "J",  "j",  "K",  "k",  "k",  "L",  "l",  "L",  "l",  "L",  "l",  "L",
+    "l",  "L",  "l",  "N",  "n",  "N",  "n",  "N",  "n",  "n",  "N",  "n",  "O",  "o",  "O",  "o",
+    "O",  "o",  "OE", "oe", "R",  "r",  "R",  "r",  "R",  "r",  "S",  "s",  "S",  "s",  "S",  "s",
+    "S",  "s",  "T",  "t",  "T",  "t",  "T",  "t",  "U",  "u",  "U",  "u",  "U",  "u",  "U",  "u",
+    "U",  "u",  "U",  "u",  "W",  "w",  "Y",  "y",  "Y",  "Z",  "z",  "Z",  "z",  "Z",  "z",  "s",
+};
+
+// Length of the leading run of ASCII bytes, checked a word at a time
+size_t ascii_prefix(const char* data, size_t size) {
+    constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if (word & kHighBits) {
+            break;
+        }
+    }
+    while (i < size && static_cast<unsigned char>(data[i]) < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+} // namespace
+
+const char* ascii_fold_of(unsigned char lead, unsigned char trail) {
+    if (lead < kFirstLead || lead > kLastLead || (trail & 0xC0) != 0x80) {
+        return nullptr;
+    }
+    const unsigned code_point = ((lead & 0x1Fu) << 6) | (trail & 0x3Fu);
+    return kFoldTable[code_point - 0x80];
+}
+
+void fold_to_ascii(std::string_view input, std::string& output) {
+    output.reserve(output.size() + input.size());
+
+    const char* data = input.data();
+    const size_t size = input.size();
+    size_t i = 0;
+    while (i < size) {
+        const size_t run = ascii_prefix(data + i, size - i);
+        output.append(data + i, run);
+        i += run;
+        if (i == size) {
+            break;
+        }
+
+        const char* replacement = i + 1 < size
+            ? ascii_fold_of(static_cast<unsigned char>(data[i]), static_cast<unsigned char>(data[i + 1]))
+            : nullptr;
+        if (replacement) {
+            output.append(replacement);
+            i += 2;
+        } else {
+            output.push_back(data[i]);
+            ++i;
+        }
+    }
+}
+
+std::string fold_to_ascii(std::string_view input) {
+    std::string output;
+    fold_to_ascii(input, output);
+    return output;
+}
+
+} // namespace cued_speech
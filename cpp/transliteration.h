@@ -0,0 +1,42 @@
+/**
+ * Cued Speech Decoder - ASCII transliteration
+ *
+ * Folds accented Latin letters and ligatures (Latin-1 Supplement and Latin
+ * Extended-A, U+00A0..U+017F) to ASCII through a table indexed by the UTF-8
+ * lead and trail bytes. ASCII runs are found eight bytes at a time and
+ * copied in bulk, so folding mostly-French text costs about a memcpy. Bytes
+ * outside the table, including malformed UTF-8, pass through unchanged.
+ */
+
+#ifndef CUED_SPEECH_TRANSLITERATION_H
+#define CUED_SPEECH_TRANSLITERATION_H
+
+#include <string>
+#include <string_view>
+
+namespace cued_speech {
+
+/**
+ * ASCII replacement for the two-byte UTF-8 sequence lead, trail
+ *
+ * @return Replacement (possibly two letters, e.g. "oe"), or nullptr when the
+ *         sequence is not folded
+ */
+const char* ascii_fold_of(unsigned char lead, unsigned char trail);
+
+/**
+ * Append the ASCII folding of input to output
+ *
+ * output is not cleared, so one buffer can be reused across calls. The
+ * folded text is never longer than the input.
+ */
+void fold_to_ascii(std::string_view input, std::string& output);
+
+/**
+ * ASCII folding of input as a new string
+ */
+std::string fold_to_ascii(std::string_view input);
+
+} // namespace cued_speech
+
+#endif // CUED_SPEECH_TRANSLITERATION_H
@@ -274,6 +274,36 @@ def download_data(force, quiet):
         raise click.Abort()
 
 
+@cli.command()
+@click.option("--model_path", required=True, help="State dict of a causal CTCModel (.pt)")
+@click.option("--vocab_path", default="download/phonelist.csv", help="Path to vocabulary file")
+@click.option("--output_path", default="output/cuedspeech_model_streaming.tflite", help="Path of the exported TFLite model")
+@click.option("--hidden_dim", default=128, type=int, help="GRU hidden size of the checkpoint")
+@click.option("--n_layers", default=2, type=int, help="GRU layers of the checkpoint")
+@click.option("--chunk", default=25, type=int, help="Frames per chunk when checking the export")
+def export_streaming(model_path, vocab_path, output_path, hidden_dim, n_layers, chunk):
+    """
+    Export a causal model as a stateful streaming TFLite model for the C++ decoder.
+    """
+    try:
+        from .export_streaming import export_streaming_tflite, load_causal_model, verify_streaming_tflite
+
+        model = load_causal_model(model_path, vocab_path, hidden_dim, n_layers)
+        export_streaming_tflite(model, output_path)
+        error = verify_streaming_tflite(model, output_path, chunk=chunk)
+        click.echo(f"✅ Streaming model written to: {output_path}")
+        click.echo(f"📏 Max logit difference, streamed in chunks of {chunk} vs full pass: {error:.2e}")
+        if error > 1e-3:
+            click.echo("⚠️ The streamed logits differ from the full pass", err=True)
+            raise click.Abort()
+
+    except click.Abort:
+        raise
+    except Exception as e:
+        click.echo(f"❌ Error exporting model: {str(e)}", err=True)
+        raise click.Abort()
+
+
 @cli.command()
 def list_data():
     """
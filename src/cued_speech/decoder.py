@@ -123,7 +123,11 @@ def load_vocabulary(vocab_path: str) -> Tuple[Dict[str, int], Dict[int, str]]:
 
 
 class ThreeStreamFusionEncoder(nn.Module):
-    """Three-stream fusion encoder for hand shape, hand position, and lips features."""
+    """Three-stream fusion encoder for hand shape, hand position, and lips features.
+
+    With ``causal=True`` the GRUs are unidirectional, so the encoder can run
+    chunk by chunk with carried hidden states (see ``forward_streaming``).
+    """
 
     def __init__(
         self,
@@ -132,24 +136,29 @@ class ThreeStreamFusionEncoder(nn.Module):
         lips_dim: int,
         hidden_dim: int = 128,
         n_layers: int = 2,
+        causal: bool = False,
     ):
         super().__init__()
+        self.causal = causal
+        bidirectional = not causal
+        directions = 1 if causal else 2
         self.hand_shape_gru = nn.GRU(
-            hand_shape_dim, hidden_dim, n_layers, bidirectional=True, batch_first=True
+            hand_shape_dim, hidden_dim, n_layers, bidirectional=bidirectional, batch_first=True
         )
         self.hand_pos_gru = nn.GRU(
-            hand_pos_dim, hidden_dim, n_layers, bidirectional=True, batch_first=True
+            hand_pos_dim, hidden_dim, n_layers, bidirectional=bidirectional, batch_first=True
         )
         self.lips_gru = nn.GRU(
-            lips_dim, hidden_dim, n_layers, bidirectional=True, batch_first=True
+            lips_dim, hidden_dim, n_layers, bidirectional=bidirectional, batch_first=True
         )
         self.fusion_gru = nn.GRU(
-            hidden_dim * 6,
+            hidden_dim * 3 * directions,
             hidden_dim * 3,
             n_layers,
-            bidirectional=True,
+            bidirectional=bidirectional,
             batch_first=True,
         )
+        self.output_dim = hidden_dim * 3 * directions
 
     def forward(
         self, hand_shape: torch.Tensor, hand_pos: torch.Tensor, lips: torch.Tensor
@@ -161,6 +170,25 @@ class ThreeStreamFusionEncoder(nn.Module):
         fusion_out, _ = self.fusion_gru(combined_features)
         return fusion_out
 
+    def forward_streaming(
+        self,
+        hand_shape: torch.Tensor,
+        hand_pos: torch.Tensor,
+        lips: torch.Tensor,
+        state: Optional[Tuple[torch.Tensor, ...]] = None,
+    ) -> Tuple[torch.Tensor, Tuple[torch.Tensor, ...]]:
+        """Encode a chunk of new frames, carrying (hand_shape, hand_pos, lips, fusion) GRU states."""
+        if not self.causal:
+            raise RuntimeError("Streaming requires a causal (unidirectional) encoder")
+        if state is None:
+            state = (None, None, None, None)
+        hand_shape_out, hs_state = self.hand_shape_gru(hand_shape, state[0])
+        hand_pos_out, hp_state = self.hand_pos_gru(hand_pos, state[1])
+        lips_out, lips_state = self.lips_gru(lips, state[2])
+        combined_features = torch.cat([hand_shape_out, hand_pos_out, lips_out], dim=-1)
+        fusion_out, fusion_state = self.fusion_gru(combined_features, state[3])
+        return fusion_out, (hs_state, hp_state, lips_state, fusion_state)
+
 
 class CTCModel(nn.Module):
     """CTC-only model for cued speech recognition."""
@@ -173,12 +201,13 @@ class CTCModel(nn.Module):
         output_dim: int,
         hidden_dim: int = 128,
         n_layers: int = 2,
+        causal: bool = False,
     ):
         super().__init__()
         self.encoder = ThreeStreamFusionEncoder(
-            hand_shape_dim, hand_pos_dim, lips_dim, hidden_dim, n_layers
+            hand_shape_dim, hand_pos_dim, lips_dim, hidden_dim, n_layers, causal
         )
-        encoder_output_dim = hidden_dim * 6
+        encoder_output_dim = self.encoder.output_dim
         self.ctc_fc = nn.Linear(encoder_output_dim, output_dim)
 
     def forward(
@@ -188,6 +217,21 @@ class CTCModel(nn.Module):
         ctc_logits = self.ctc_fc(encoder_out)
         return ctc_logits
 
+    def forward_streaming(
+        self,
+        hand_shape: torch.Tensor,
+        hand_pos: torch.Tensor,
+        lips: torch.Tensor,
+        state: Optional[Tuple[torch.Tensor, ...]] = None,
+    ) -> Tuple[torch.Tensor, Tuple[torch.Tensor, ...]]:
+        """Logits for a chunk of new frames plus the state to feed with the next chunk.
+
+        This is the signature exported for the C++ stateful sequence model:
+        inputs (lips, hand_shape, hand_pos, *state), outputs (logits, *state).
+        """
+        encoder_out, state = self.encoder.forward_streaming(hand_shape, hand_pos, lips, state)
+        return self.ctc_fc(encoder_out), state
+
 
 def polygon_area(xs: List[float], ys: List[float]) -> float:
     """Calculate polygon area using shoelace formula."""
@@ -0,0 +1,191 @@
+"""Export a causal CTCModel as a stateful streaming TFLite model.
+
+The C++ decoder (``TFLiteSequenceModel``) treats a model with more than three
+inputs as stateful: besides ``lips``, ``hand_shape`` and ``hand_pos`` each
+input ``X`` is a recurrent state whose update is the output ``X_out``, and
+the logits are the output ``logits``. Inputs and outputs are looked up by
+signature key, since the converter neither keeps tensor names nor the output
+order.
+
+The GRUs are rebuilt in TensorFlow from the PyTorch weights (gate order and
+reset-after formulation of ``torch.nn.GRU``) and run over the time axis with
+``tf.scan``. TensorFlow is only needed for the export.
+"""
+
+import os
+import tempfile
+from typing import Dict, List, Optional, Tuple
+
+import numpy as np
+import torch
+
+from .decoder import CTCModel, load_vocabulary
+
+HAND_SHAPE_DIM = 7
+HAND_POS_DIM = 18
+LIPS_DIM = 8
+
+# Encoder GRUs in the order of CTCModel.forward_streaming's state tuple
+STATE_NAMES = ("hand_shape_state", "hand_pos_state", "lips_state", "fusion_state")
+
+
+def _import_tensorflow():
+    try:
+        import tensorflow as tf
+    except ImportError as e:
+        raise RuntimeError(
+            "Exporting a streaming model needs TensorFlow: pip install tensorflow"
+        ) from e
+    return tf
+
+
+def _gru_weights(gru: torch.nn.GRU) -> List[Tuple[np.ndarray, ...]]:
+    """(weight_ih, weight_hh, bias_ih, bias_hh) of each layer."""
+    return [
+        tuple(
+            getattr(gru, f"{name}_l{layer}").detach().cpu().numpy()
+            for name in ("weight_ih", "weight_hh", "bias_ih", "bias_hh")
+        )
+        for layer in range(gru.num_layers)
+    ]
+
+
+def build_streaming_module(model: CTCModel):
+    """tf.Module whose ``stream`` function is ``model.forward_streaming``."""
+    tf = _import_tensorflow()
+    encoder = model.encoder
+    if not encoder.causal:
+        raise RuntimeError("Streaming export requires a causal (unidirectional) model")
+
+    grus = [encoder.hand_shape_gru, encoder.hand_pos_gru, encoder.lips_gru, encoder.fusion_gru]
+    weights = [_gru_weights(gru) for gru in grus]
+    hidden_sizes = [gru.hidden_size for gru in grus]
+    num_layers = encoder.lips_gru.num_layers
+    fc_weight = model.ctc_fc.weight.detach().cpu().numpy()
+    fc_bias = model.ctc_fc.bias.detach().cpu().numpy()
+
+    def gru_layer(x, h0, w_ih, w_hh, b_ih, b_hh):
+        # x [T, in], h0 [H] -> outputs [T, H]; torch gate order is (r, z, n)
+        input_gates = tf.matmul(x, w_ih, transpose_b=True) + b_ih
+
+        def step(h, gates):
+            hidden_gates = tf.linalg.matvec(w_hh, h) + b_hh
+            i_r, i_z, i_n = tf.split(gates, 3)
+            h_r, h_z, h_n = tf.split(hidden_gates, 3)
+            r = tf.sigmoid(i_r + h_r)
+            z = tf.sigmoid(i_z + h_z)
+            n = tf.tanh(i_n + r * h_n)
+            return (1.0 - z) * n + z * h
+
+        return tf.scan(step, input_gates, initializer=h0)
+
+    def gru(x, state, layers):
+        # state [layers, 1, H] as in torch.nn.GRU
+        finals = []
+        for layer, params in enumerate(layers):
+            x = gru_layer(x, state[layer, 0], *[tf.constant(p) for p in params])
+            finals.append(x[-1])
+        return x, tf.expand_dims(tf.stack(finals), 1)
+
+    def feature_spec(dim, name):
+        return tf.TensorSpec([1, None, dim], tf.float32, name=name)
+
+    def state_spec(hidden, name):
+        return tf.TensorSpec([num_layers, 1, hidden], tf.float32, name=name)
+
+    class StreamingModule(tf.Module):
+        @tf.function(
+            input_signature=[
+                feature_spec(LIPS_DIM, "lips"),
+                feature_spec(HAND_SHAPE_DIM, "hand_shape"),
+                feature_spec(HAND_POS_DIM, "hand_pos"),
+            ]
+            + [state_spec(h, name) for h, name in zip(hidden_sizes, STATE_NAMES)]
+        )
+        def stream(self, lips, hand_shape, hand_pos, hand_shape_state, hand_pos_state,
+                   lips_state, fusion_state):
+            hs_out, hs_state = gru(hand_shape[0], hand_shape_state, weights[0])
+            hp_out, hp_state = gru(hand_pos[0], hand_pos_state, weights[1])
+            lips_out, lips_new = gru(lips[0], lips_state, weights[2])
+            fused, fusion_new = gru(tf.concat([hs_out, hp_out, lips_out], -1), fusion_state, weights[3])
+            logits = tf.matmul(fused, fc_weight, transpose_b=True) + fc_bias
+            return {
+                "logits": tf.expand_dims(logits, 0),
+                "hand_shape_state_out": hs_state,
+                "hand_pos_state_out": hp_state,
+                "lips_state_out": lips_new,
+                "fusion_state_out": fusion_new,
+            }
+
+    return StreamingModule()
+
+
+def export_streaming_tflite(model: CTCModel, output_path: str) -> None:
+    """Convert ``model.forward_streaming`` to a TFLite file with one signature."""
+    tf = _import_tensorflow()
+    module = build_streaming_module(model.eval())
+    with tempfile.TemporaryDirectory() as saved_model_dir:
+        tf.saved_model.save(
+            module, saved_model_dir, signatures={"serving_default": module.stream.get_concrete_function()}
+        )
+        converter = tf.lite.TFLiteConverter.from_saved_model(saved_model_dir)
+        tflite_model = converter.convert()
+
+    os.makedirs(os.path.dirname(os.path.abspath(output_path)), exist_ok=True)
+    with open(output_path, "wb") as f:
+        f.write(tflite_model)
+
+
+def run_streaming_tflite(
+    model_path: str,
+    hand_shape: np.ndarray,
+    hand_pos: np.ndarray,
+    lips: np.ndarray,
+    chunk: int,
+    state: Optional[Dict[str, np.ndarray]] = None,
+) -> np.ndarray:
+    """Logits [1, T, V] of an exported model fed ``chunk`` frames at a time, as the C++ stream does."""
+    tf = _import_tensorflow()
+    interpreter = tf.lite.Interpreter(model_path=model_path)
+    runner = interpreter.get_signature_runner("serving_default")
+    if state is None:
+        details = runner.get_input_details()
+        state = {name: np.zeros(details[name]["shape"], np.float32) for name in STATE_NAMES}
+
+    chunks = []
+    for start in range(0, lips.shape[1], chunk):
+        end = start + chunk
+        outputs = runner(
+            lips=lips[:, start:end].astype(np.float32),
+            hand_shape=hand_shape[:, start:end].astype(np.float32),
+            hand_pos=hand_pos[:, start:end].astype(np.float32),
+            **state,
+        )
+        chunks.append(outputs["logits"])
+        state = {name: outputs[name + "_out"] for name in STATE_NAMES}
+    return np.concatenate(chunks, axis=1)
+
+
+def verify_streaming_tflite(model: CTCModel, model_path: str, frames: int = 120, chunk: int = 25,
+                            seed: int = 0) -> float:
+    """Largest difference between the streamed TFLite logits and a full PyTorch pass."""
+    rng = np.random.default_rng(seed)
+    hand_shape = rng.standard_normal((1, frames, HAND_SHAPE_DIM)).astype(np.float32)
+    hand_pos = rng.standard_normal((1, frames, HAND_POS_DIM)).astype(np.float32)
+    lips = rng.standard_normal((1, frames, LIPS_DIM)).astype(np.float32)
+    with torch.no_grad():
+        expected = model.eval()(
+            torch.from_numpy(hand_shape), torch.from_numpy(hand_pos), torch.from_numpy(lips)
+        ).numpy()
+    streamed = run_streaming_tflite(model_path, hand_shape, hand_pos, lips, chunk)
+    return float(np.max(np.abs(streamed - expected)))
+
+
+def load_causal_model(model_path: str, vocab_path: str, hidden_dim: int = 128, n_layers: int = 2) -> CTCModel:
+    """Load a causal CTCModel checkpoint (state dict) with the production feature sizes."""
+    phoneme_to_index, _ = load_vocabulary(vocab_path)
+    model = CTCModel(
+        HAND_SHAPE_DIM, HAND_POS_DIM, LIPS_DIM, len(phoneme_to_index), hidden_dim, n_layers, causal=True
+    )
+    model.load_state_dict(torch.load(model_path, map_location="cpu"))
+    return model.eval()
@@ -51,6 +51,64 @@ class TestDecoder:
         assert hasattr(model, "encoder")
         assert hasattr(model, "ctc_fc")
 
+    def test_causal_streaming_matches_full_sequence(self):
+        """Chunked streaming with carried state must match a full-sequence pass."""
+        torch.manual_seed(0)
+        model = CTCModel(
+            hand_shape_dim=7,
+            hand_pos_dim=18,
+            lips_dim=8,
+            output_dim=12,
+            hidden_dim=16,
+            causal=True,
+        ).eval()
+
+        hand_shape = torch.randn(1, 60, 7)
+        hand_pos = torch.randn(1, 60, 18)
+        lips = torch.randn(1, 60, 8)
+
+        with torch.no_grad():
+            full = model(hand_shape, hand_pos, lips)
+
+            chunks = []
+            state = None
+            for start in range(0, 60, 25):
+                end = start + 25
+                logits, state = model.forward_streaming(
+                    hand_shape[:, start:end], hand_pos[:, start:end], lips[:, start:end], state
+                )
+                chunks.append(logits)
+            streamed = torch.cat(chunks, dim=1)
+
+        assert streamed.shape == full.shape
+        assert torch.allclose(streamed, full, atol=1e-5)
+
+    def test_streaming_export_matches_full_sequence(self):
+        """The exported stateful TFLite model, fed in chunks, must match a full PyTorch pass."""
+        pytest.importorskip("tensorflow")
+        from cued_speech.export_streaming import export_streaming_tflite, verify_streaming_tflite
+
+        torch.manual_seed(0)
+        model = CTCModel(
+            hand_shape_dim=7,
+            hand_pos_dim=18,
+            lips_dim=8,
+            output_dim=12,
+            hidden_dim=16,
+            causal=True,
+        ).eval()
+
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            model_path = os.path.join(tmp_dir, "streaming.tflite")
+            export_streaming_tflite(model, model_path)
+            assert verify_streaming_tflite(model, model_path, frames=60, chunk=25) < 1e-4
+
+    def test_bidirectional_model_rejects_streaming(self):
+        """The default bidirectional model cannot carry state across chunks."""
+        model = CTCModel(hand_shape_dim=7, hand_pos_dim=18, lips_dim=8, output_dim=12, hidden_dim=16)
+        with pytest.raises(RuntimeError):
+            model.forward_streaming(torch.randn(1, 5, 7), torch.randn(1, 5, 18), torch.randn(1, 5, 8))
+
     def test_create_dummy_video(self):
         """Create a dummy video file for testing."""
         with tempfile.NamedTemporaryFile(suffix=".mp4", delete=False) as f: